@@ -0,0 +1,224 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::string const key(32, 'k');
+std::string const nonce(12, 'n');
+
+void buffer_sizes(benchmark::internal::Benchmark * bench)
+{
+    bench->RangeMultiplier(4)->Range(16, 64 * 1024 * 1024);
+}
+
+void encrypter_update(benchmark::State & state)
+{
+    size_t const size = state.range(0);
+    std::vector<char> in(size, 'x');
+    std::vector<char> out(size);
+    aes256gcm::encrypter enc(key, nonce, "");
+
+    for (auto _: state)
+    {
+        enc.update(in.data(), out.data(), size);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+void encrypter_update_inplace(benchmark::State & state)
+{
+    size_t const size = state.range(0);
+    std::vector<char> buffer(size, 'x');
+    aes256gcm::encrypter enc(key, nonce, "");
+
+    for (auto _: state)
+    {
+        enc.update_inplace(buffer.data(), size);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+void decrypter_update(benchmark::State & state)
+{
+    size_t const size = state.range(0);
+    std::vector<char> in(size, 'x');
+    std::vector<char> out(size);
+    aes256gcm::decrypter dec(key, nonce, std::string(16, 't'));
+
+    for (auto _: state)
+    {
+        dec.update(in.data(), out.data(), size);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+void decrypter_finalize(benchmark::State & state)
+{
+    size_t const size = state.range(0);
+    std::vector<char> plaintext(size, 'x');
+    std::vector<char> ciphertext(size);
+    aes256gcm::encrypter enc(key, nonce, "");
+    enc.update(plaintext.data(), ciphertext.data(), size);
+    auto const tag = enc.finalize();
+
+    for (auto _: state)
+    {
+        aes256gcm::decrypter dec(key, nonce, tag);
+        dec.update(ciphertext.data(), plaintext.data(), size);
+        bool const is_okay = dec.finalize();
+        benchmark::DoNotOptimize(is_okay);
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+void pbkdf2(benchmark::State & state, char const * digest)
+{
+    unsigned int const iterations = state.range(0);
+    std::string const salt(8, 's');
+
+    for (auto _: state)
+    {
+        // the key cache would turn all but the first call into a lookup
+        aes256gcm::pbkdf2_cache_clear();
+        auto key = aes256gcm::pbkdf2("secret", salt, digest, iterations);
+        benchmark::DoNotOptimize(key);
+    }
+}
+
+void pbkdf2_cached(benchmark::State & state)
+{
+    std::string const salt(8, 's');
+    aes256gcm::pbkdf2_cache_clear();
+
+    for (auto _: state)
+    {
+        auto key = aes256gcm::pbkdf2("secret", salt, "sha256", 2048);
+        benchmark::DoNotOptimize(key);
+    }
+}
+
+void pbkdf2_batch(benchmark::State & state)
+{
+    std::vector<aes256gcm::pbkdf2_job> jobs(state.range(0));
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        jobs[i] = {"secret", std::string(7, 's') + char(i), "sha256", 2048, ""};
+    }
+
+    for (auto _: state)
+    {
+        aes256gcm::pbkdf2_cache_clear();
+        aes256gcm::pbkdf2_batch(jobs.data(), jobs.size());
+        benchmark::DoNotOptimize(jobs);
+    }
+    state.SetItemsProcessed(state.iterations() * jobs.size());
+}
+
+void argon2id(benchmark::State & state)
+{
+    unsigned int const lanes = state.range(0);
+    std::string const salt(16, 's');
+
+    for (auto _: state)
+    {
+        auto key = aes256gcm::argon2id("secret", salt, 3, 64 * 1024, lanes);
+        benchmark::DoNotOptimize(key);
+    }
+}
+
+void rand(benchmark::State & state)
+{
+    size_t const size = state.range(0);
+    for (auto _: state)
+    {
+        auto data = aes256gcm::rand(size);
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+aes256gcm::kdf_params const pbkdf2_params = {aes256gcm::kdf_pbkdf2, std::string(8, 's'), "sha256", 2048, 0, 0};
+
+void create_encryption_info(benchmark::State & state)
+{
+    std::string const additional_data(state.range(0), 'a');
+    std::vector<char> data;
+
+    for (auto _: state)
+    {
+        data.clear();
+        aes256gcm::proprietary::create_encryption_info(data, pbkdf2_params,
+            nonce, std::string(16, 't'), additional_data);
+        benchmark::DoNotOptimize(data.data());
+    }
+}
+
+void parse_encryption_info(benchmark::State & state)
+{
+    std::string const additional_data(state.range(0), 'a');
+    std::vector<char> data;
+    aes256gcm::proprietary::create_encryption_info(data, pbkdf2_params,
+        nonce, std::string(16, 't'), additional_data);
+
+    for (auto _: state)
+    {
+        aes256gcm::proprietary::encryption_info info;
+        bool const is_okay = aes256gcm::proprietary::parse_encryption_info(data, info);
+        benchmark::DoNotOptimize(is_okay);
+        benchmark::DoNotOptimize(info);
+    }
+}
+
+}
+
+BENCHMARK(encrypter_update)->Apply(buffer_sizes);
+BENCHMARK(encrypter_update_inplace)->Apply(buffer_sizes);
+BENCHMARK(decrypter_update)->Apply(buffer_sizes);
+BENCHMARK(decrypter_finalize)->Arg(16)->Arg(4 * 1024)->Arg(1024 * 1024);
+BENCHMARK_CAPTURE(pbkdf2, sha1, "sha1")->Arg(1024)->Arg(2048)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(pbkdf2, sha256, "sha256")->Arg(1024)->Arg(2048)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(pbkdf2, sha512, "sha512")->Arg(1024)->Arg(2048)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(pbkdf2_cached);
+BENCHMARK(pbkdf2_batch)->Arg(1)->Arg(8)->Arg(16)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(argon2id)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(rand)->Arg(8)->Arg(12)->Arg(32);
+BENCHMARK(create_encryption_info)->Arg(0)->Arg(1024);
+BENCHMARK(parse_encryption_info)->Arg(0)->Arg(1024);
+
+// results are written as JSON unless another format is requested
+int main(int argc, char * argv[])
+{
+    std::vector<char*> args(argv, argv + argc);
+    bool has_format = false;
+    for (int i = 1; i < argc; i++)
+    {
+        has_format |= (0 == strncmp(argv[i], "--benchmark_format", 18));
+    }
+
+    char json_format[] = "--benchmark_format=json";
+    if (!has_format)
+    {
+        args.push_back(json_format);
+    }
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
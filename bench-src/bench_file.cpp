@@ -0,0 +1,542 @@
+#include <aes256gcm/aes256gcm.hpp>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using aes256gcm::proprietary::encrypt_file;
+using aes256gcm::proprietary::encrypt_file_inplace;
+using aes256gcm::proprietary::decrypt_file;
+using aes256gcm::proprietary::decrypt_file_inplace;
+using aes256gcm::proprietary::file_options;
+
+namespace
+{
+
+void print_usage()
+{
+    std::cout << R"(aes256gcm_file_bench
+
+usage:
+    aes256gcm_file_bench [options]
+
+Measures throughput of encrypt_file, decrypt_file, encrypt_file_inplace
+and decrypt_file_inplace on generated files. Results are written as JSON.
+
+Options:
+    -d, --dir      DIR  directory for generated files (default: temp directory)
+    -z, --sizes    LIST comma separated file sizes with optional K, M or G
+                        suffix (default: 4K,1M,64M)
+    -c, --content  TYPE random, sparse or both (default: random)
+    -m, --cache    MODE cold, warm or both (default: both)
+    -s, --segment-size SIZE
+                        segment size passed to the file functions (default: 0)
+    -j, --jobs     N    threads passed to the file functions (default: 1)
+    -o, --output   FILE write results to FILE instead of stdout
+    -b, --baseline FILE compare with results of a previous run and fail
+                        if throughput dropped by more than the tolerance
+    -t, --tolerance PCT allowed throughput drop in percent (default: 10)
+    -h, --help          print this help
+)";
+}
+
+bool parse_size(std::string const & value, uint64_t & result)
+{
+    char * end = nullptr;
+    errno = 0;
+    result = std::strtoull(value.c_str(), &end, 10);
+    if ((errno != 0) || (end == value.c_str()))
+    {
+        return false;
+    }
+
+    std::string const suffix(end);
+    if (suffix == "K") { result <<= 10; }
+    else if (suffix == "M") { result <<= 20; }
+    else if (suffix == "G") { result <<= 30; }
+    else if (!suffix.empty()) { return false; }
+
+    return true;
+}
+
+bool parse_sizes(std::string const & value, std::vector<uint64_t> & result)
+{
+    result.clear();
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        uint64_t size = 0;
+        if (!parse_size(item, size))
+        {
+            return false;
+        }
+        result.push_back(size);
+    }
+
+    return !result.empty();
+}
+
+struct measurement
+{
+    std::string name;
+    std::string operation;
+    uint64_t size;
+    std::string content;
+    std::string cache;
+    double seconds;
+    double mb_per_s;
+    double cpu_seconds;
+    long peak_rss_kb;
+    uint64_t read_syscalls;
+    uint64_t write_syscalls;
+};
+
+struct process_counters
+{
+    double cpu_seconds;
+    long peak_rss_kb;
+    uint64_t read_syscalls;
+    uint64_t write_syscalls;
+};
+
+// Resets the peak resident set size (VmHWM) of the process, so that each
+// case reports its own peak rather than the largest one of all cases so far.
+bool reset_peak_rss()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5" << std::flush;
+    return clear_refs.good();
+}
+
+// syscall counts are taken from /proc/self/io, which needs no privileges;
+// the peak RSS is taken from VmHWM in /proc/self/status, as ru_maxrss
+// cannot be reset
+process_counters read_counters()
+{
+    process_counters result = {0.0, -1, 0, 0};
+
+    rusage usage;
+    if (0 == getrusage(RUSAGE_SELF, &usage))
+    {
+        result.cpu_seconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (0 == line.rfind("VmHWM:", 0))
+        {
+            result.peak_rss_kb = std::stol(line.substr(6));
+        }
+    }
+
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value;
+    while (io >> key >> value)
+    {
+        if (key == "syscr:") { result.read_syscalls = value; }
+        if (key == "syscw:") { result.write_syscalls = value; }
+    }
+
+    return result;
+}
+
+void generate_file(std::string const & filename, uint64_t size, bool sparse)
+{
+    std::filesystem::remove(filename);
+    if (sparse)
+    {
+        std::ofstream(filename, std::ios_base::binary);
+        std::filesystem::resize_file(filename, size);
+        return;
+    }
+
+    std::ofstream out(filename, std::ios_base::binary);
+    std::mt19937_64 random(42);
+    std::vector<uint64_t> buffer(128 * 1024);
+    for (uint64_t pos = 0; pos < size; )
+    {
+        for (auto & value: buffer)
+        {
+            value = random();
+        }
+        size_t const chunk = static_cast<size_t>(std::min<uint64_t>(size - pos, buffer.size() * sizeof(uint64_t)));
+        out.write(reinterpret_cast<char const*>(buffer.data()), chunk);
+        pos += chunk;
+    }
+    if (!out.good())
+    {
+        throw std::runtime_error("failed to generate " + filename);
+    }
+}
+
+void drop_cache(std::string const & filename)
+{
+    int const fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("failed to open " + filename);
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+void warm_cache(std::string const & filename)
+{
+    std::ifstream in(filename, std::ios_base::binary);
+    std::vector<char> buffer(1024 * 1024);
+    while (in.read(buffer.data(), buffer.size()) || (in.gcount() > 0))
+    {
+    }
+}
+
+struct options
+{
+    std::string directory;
+    std::vector<uint64_t> sizes = {4 << 10, 1 << 20, 64 << 20};
+    std::vector<std::string> contents = {"random"};
+    std::vector<std::string> caches = {"cold", "warm"};
+    file_options file;
+    std::string output;
+    std::string baseline;
+    double tolerance = 10.0;
+};
+
+measurement measure(
+    std::string const & operation,
+    uint64_t size,
+    std::string const & content,
+    std::string const & cache,
+    std::string const & input,
+    std::function<void()> const & run)
+{
+    if (cache == "cold")
+    {
+        drop_cache(input);
+    }
+    else
+    {
+        warm_cache(input);
+    }
+
+    // every run pays for key derivation, like a fresh process would
+    aes256gcm::pbkdf2_cache_clear();
+
+    bool const has_peak_rss = reset_peak_rss();
+    auto const before = read_counters();
+    auto const start = std::chrono::steady_clock::now();
+    run();
+    auto const stop = std::chrono::steady_clock::now();
+    auto const after = read_counters();
+
+    measurement result;
+    result.name = operation + "/" + std::to_string(size) + "/" + content + "/" + cache;
+    result.operation = operation;
+    result.size = size;
+    result.content = content;
+    result.cache = cache;
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+    result.mb_per_s = (result.seconds > 0) ? (size / (1024.0 * 1024.0)) / result.seconds : 0.0;
+    result.cpu_seconds = after.cpu_seconds - before.cpu_seconds;
+    // -1 if the peak cannot be reset, as it would include earlier cases
+    result.peak_rss_kb = has_peak_rss ? after.peak_rss_kb : -1;
+    result.read_syscalls = after.read_syscalls - before.read_syscalls;
+    result.write_syscalls = after.write_syscalls - before.write_syscalls;
+    return result;
+}
+
+void check(int exit_code, std::string const & operation)
+{
+    if (exit_code != EXIT_SUCCESS)
+    {
+        throw std::runtime_error(operation + " failed");
+    }
+}
+
+std::vector<measurement> run_benchmarks(options const & opts)
+{
+    std::vector<measurement> results;
+    std::string const password = "benchmark";
+    auto const dir = std::filesystem::path(opts.directory);
+    auto const plain = (dir / "plain").string();
+    auto const encrypted = (dir / "encrypted").string();
+    auto const decrypted = (dir / "decrypted").string();
+    auto const inplace = (dir / "inplace").string();
+
+    for (auto const size: opts.sizes)
+    {
+        for (auto const & content: opts.contents)
+        {
+            generate_file(plain, size, content == "sparse");
+
+            for (auto const & cache: opts.caches)
+            {
+                results.push_back(measure("encrypt_file", size, content, cache, plain, [&]()
+                {
+                    encrypt_file(plain, encrypted, password, "", opts.file);
+                }));
+
+                results.push_back(measure("decrypt_file", size, content, cache, encrypted, [&]()
+                {
+                    check(decrypt_file(encrypted, decrypted, password, opts.file), "decrypt_file");
+                }));
+
+                if (opts.file.segment_size == 0)
+                {
+                    std::filesystem::copy_file(plain, inplace, std::filesystem::copy_options::overwrite_existing);
+                    results.push_back(measure("encrypt_file_inplace", size, content, cache, inplace, [&]()
+                    {
+                        encrypt_file_inplace(inplace, password, "", opts.file);
+                    }));
+
+                    results.push_back(measure("decrypt_file_inplace", size, content, cache, inplace, [&]()
+                    {
+                        check(decrypt_file_inplace(inplace, password, opts.file), "decrypt_file_inplace");
+                    }));
+                }
+            }
+
+            std::filesystem::remove(encrypted);
+            std::filesystem::remove(decrypted);
+            std::filesystem::remove(inplace);
+        }
+        std::filesystem::remove(plain);
+    }
+
+    return results;
+}
+
+void write_results(std::ostream & out, options const & opts, std::vector<measurement> const & results)
+{
+    out << "{\n";
+    out << "  \"context\": {\"directory\": \"" << opts.directory << "\", \"threads\": " << opts.file.threads
+        << ", \"segment_size\": " << opts.file.segment_size << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        auto const & r = results[i];
+        // one result per line, so that baselines can be read back without a JSON parser
+        out << "    {\"name\": \"" << r.name << "\", \"operation\": \"" << r.operation
+            << "\", \"size\": " << r.size << ", \"content\": \"" << r.content
+            << "\", \"cache\": \"" << r.cache << "\", \"seconds\": " << r.seconds
+            << ", \"mb_per_s\": " << r.mb_per_s << ", \"cpu_seconds\": " << r.cpu_seconds
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb << ", \"read_syscalls\": " << r.read_syscalls
+            << ", \"write_syscalls\": " << r.write_syscalls << "}"
+            << ((i + 1 < results.size()) ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+std::map<std::string, double> read_baseline(std::string const & filename)
+{
+    std::ifstream in(filename);
+    if (!in.good())
+    {
+        throw std::runtime_error("failed to open baseline " + filename);
+    }
+
+    std::map<std::string, double> result;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        auto const name_pos = line.find("\"name\": \"");
+        auto const mb_pos = line.find("\"mb_per_s\": ");
+        if ((name_pos == std::string::npos) || (mb_pos == std::string::npos))
+        {
+            continue;
+        }
+
+        auto const name_start = name_pos + 9;
+        auto const name_end = line.find('"', name_start);
+        result[line.substr(name_start, name_end - name_start)] = std::strtod(&line[mb_pos + 12], nullptr);
+    }
+
+    return result;
+}
+
+bool check_regressions(options const & opts, std::vector<measurement> const & results)
+{
+    auto const baseline = read_baseline(opts.baseline);
+    bool is_okay = true;
+    for (auto const & r: results)
+    {
+        auto const it = baseline.find(r.name);
+        if (it == baseline.end())
+        {
+            continue;
+        }
+
+        double const limit = it->second * (1.0 - opts.tolerance / 100.0);
+        if (r.mb_per_s < limit)
+        {
+            std::cerr << "regression: " << r.name << ": " << r.mb_per_s << " MB/s, baseline "
+                << it->second << " MB/s" << std::endl;
+            is_okay = false;
+        }
+    }
+
+    return is_okay;
+}
+
+bool parse_options(int argc, char * argv[], options & opts)
+{
+    static option const long_opts[] = {
+        {"dir"         , required_argument, nullptr, 'd'},
+        {"sizes"       , required_argument, nullptr, 'z'},
+        {"content"     , required_argument, nullptr, 'c'},
+        {"cache"       , required_argument, nullptr, 'm'},
+        {"segment-size", required_argument, nullptr, 's'},
+        {"jobs"        , required_argument, nullptr, 'j'},
+        {"output"      , required_argument, nullptr, 'o'},
+        {"baseline"    , required_argument, nullptr, 'b'},
+        {"tolerance"   , required_argument, nullptr, 't'},
+        {"help"        , no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    optind = 0;
+    int opt;
+    while (-1 != (opt = getopt_long(argc, argv, "d:z:c:m:s:j:o:b:t:h", long_opts, nullptr)))
+    {
+        std::string const value = (optarg != nullptr) ? optarg : "";
+        uint64_t number = 0;
+        switch (opt)
+        {
+            case 'd':
+                opts.directory = value;
+                break;
+            case 'z':
+                if (!parse_sizes(value, opts.sizes))
+                {
+                    std::cerr << "error: invalid sizes" << std::endl;
+                    return false;
+                }
+                break;
+            case 'c':
+                if (value == "both") { opts.contents = {"random", "sparse"}; }
+                else if ((value == "random") || (value == "sparse")) { opts.contents = {value}; }
+                else
+                {
+                    std::cerr << "error: invalid content type" << std::endl;
+                    return false;
+                }
+                break;
+            case 'm':
+                if (value == "both") { opts.caches = {"cold", "warm"}; }
+                else if ((value == "cold") || (value == "warm")) { opts.caches = {value}; }
+                else
+                {
+                    std::cerr << "error: invalid cache mode" << std::endl;
+                    return false;
+                }
+                break;
+            case 's':
+                if (!parse_size(value, number))
+                {
+                    std::cerr << "error: invalid segment size" << std::endl;
+                    return false;
+                }
+                opts.file.segment_size = number;
+                break;
+            case 'j':
+                if ((!parse_size(value, number)) || (number == 0))
+                {
+                    std::cerr << "error: invalid number of jobs" << std::endl;
+                    return false;
+                }
+                opts.file.threads = static_cast<unsigned>(number);
+                break;
+            case 'o':
+                opts.output = value;
+                break;
+            case 'b':
+                opts.baseline = value;
+                break;
+            case 't':
+                opts.tolerance = std::strtod(value.c_str(), nullptr);
+                break;
+            case 'h':
+                // fall-through
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    bool const is_temporary = opts.directory.empty();
+    if (is_temporary)
+    {
+        opts.directory = (std::filesystem::temp_directory_path() / ("aes256gcm_bench_" + std::to_string(getpid()))).string();
+    }
+
+    int exit_code = EXIT_SUCCESS;
+    try
+    {
+        std::filesystem::create_directories(opts.directory);
+        auto const results = run_benchmarks(opts);
+
+        if (opts.output.empty())
+        {
+            write_results(std::cout, opts, results);
+        }
+        else
+        {
+            std::ofstream out(opts.output);
+            write_results(out, opts, results);
+        }
+
+        if ((!opts.baseline.empty()) && (!check_regressions(opts, results)))
+        {
+            exit_code = EXIT_FAILURE;
+        }
+    }
+    catch (std::exception const & ex)
+    {
+        std::cerr << "error: " << ex.what() << std::endl;
+        exit_code = EXIT_FAILURE;
+    }
+
+    if (is_temporary)
+    {
+        std::filesystem::remove_all(opts.directory);
+    }
+
+    return exit_code;
+}
@@ -4,7 +4,17 @@
 #include <aes256gcm/encrypter.hpp>
 #include <aes256gcm/decrypter.hpp>
 #include <aes256gcm/pbkdf2.hpp>
+#include <aes256gcm/kdf.hpp>
+#include <aes256gcm/algorithm.hpp>
+#include <aes256gcm/compression.hpp>
+#include <aes256gcm/context_pool.hpp>
+#include <aes256gcm/records.hpp>
+#include <aes256gcm/cpu_info.hpp>
 
 #include <aes256gcm/proprietary.hpp>
+#include <aes256gcm/encrypted_reader.hpp>
+#include <aes256gcm/encryption_info_view.hpp>
+#include <aes256gcm/metadata_catalog.hpp>
+#include <aes256gcm/batch.hpp>
 
 #endif
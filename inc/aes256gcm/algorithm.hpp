@@ -0,0 +1,54 @@
+#ifndef AES256GCM_ALGORITHM_HPP
+#define AES256GCM_ALGORITHM_HPP
+
+#include <string>
+#include <vector>
+
+namespace aes256gcm
+{
+
+/// @brief Names of the supported AEAD algorithms.
+///
+/// The name is stored as encryption method in the encryption info of
+/// encrypted files. All algorithms use 32 byte keys, 12 byte nonces
+/// and 16 byte tags.
+constexpr char const algorithm_aes256_gcm[] = "AES256-GCM";
+constexpr char const algorithm_chacha20_poly1305[] = "CHACHA20-POLY1305";
+constexpr char const algorithm_aes256_ocb[] = "AES256-OCB";
+constexpr char const algorithm_aes256_gcm_siv[] = "AES256-GCM-SIV";
+
+/// @brief Pseudo algorithm selecting the fastest algorithm of the current CPU.
+constexpr char const algorithm_auto[] = "auto";
+
+/// @brief Returns the names of all known AEAD algorithms.
+std::vector<std::string> aead_algorithms();
+
+/// @brief Checks, if an algorithm is provided by the OpenSSL library in use.
+/// @param name name of the algorithm
+/// @return true, if the algorithm can be used, false otherwise
+bool is_aead_available(std::string const & name);
+
+/// @brief Checks, if an algorithm processes a message in a single update only.
+///
+/// Such algorithms (AES256-GCM-SIV) can only be used for segmented files
+/// and streams, where each segment is encrypted at once.
+///
+/// @param name canonical name of the algorithm
+/// @return true, if the algorithm requires segments, false otherwise
+bool is_single_update_aead(std::string const & name);
+
+/// @brief Resolves the name of an algorithm.
+///
+/// Names are matched case-insensitively. "auto" selects AES256-GCM on
+/// CPUs with hardware AES and carry-less multiplication, and
+/// CHACHA20-POLY1305 otherwise.
+///
+/// @param name name of the algorithm or "auto"
+/// @return canonical name of the algorithm
+/// @throws An invalid_argument is thrown on unknown algorithms.
+///         A runtime_error is thrown if the algorithm is not available.
+std::string select_aead(std::string const & name);
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef AES256GCM_ARENA_HPP
+#define AES256GCM_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace aes256gcm
+{
+
+/// @brief Simple bump allocator for batched operations.
+///
+/// Memory is requested from the system in large blocks and handed out
+/// sequentially. Allocations stay valid until the arena is reset or
+/// destroyed; reset keeps the blocks, so a reused arena does not
+/// allocate at all once it has grown to the working set.
+class arena
+{
+    arena(arena const &) = delete;
+    arena& operator=(arena const &) = delete;
+public:
+    /// @brief Creates an arena.
+    /// @param block_size minimum size of blocks requested from the system
+    explicit arena(size_t block_size = 1024 * 1024);
+
+    ~arena() = default;
+
+    /// @brief Allocates memory aligned to 16 bytes.
+    /// @param size number of bytes to allocate
+    /// @return pointer to the allocated memory
+    /// @throws std::bad_alloc is thrown if memory cannot be allocated.
+    char * allocate(size_t size);
+
+    /// @brief Allocates an array of trivial objects.
+    template <typename T>
+    T * allocate_array(size_t count)
+    {
+        static_assert(alignof(T) <= 16, "unsupported alignment");
+        return reinterpret_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    /// @brief Releases all allocations, but keeps the memory for reuse.
+    void reset() noexcept;
+
+    /// @brief Returns the number of bytes currently allocated.
+    size_t used() const noexcept;
+
+    /// @brief Returns the number of bytes requested from the system.
+    size_t capacity() const noexcept;
+
+private:
+    struct block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t m_block_size;
+    std::vector<block> m_blocks;
+    size_t m_current;
+    size_t m_offset;
+    size_t m_used;
+};
+
+}
+
+#endif
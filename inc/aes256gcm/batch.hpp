@@ -0,0 +1,78 @@
+#ifndef AES256GCM_BATCH_HPP
+#define AES256GCM_BATCH_HPP
+
+#include <aes256gcm/proprietary.hpp>
+
+#include <string>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Operation applied to all files of a batch.
+enum class batch_operation
+{
+    encrypt,
+    decrypt,
+    verify      ///< authenticate files without writing (see verify_file); output names are ignored
+};
+
+/// @brief File of a batch.
+struct batch_job
+{
+    std::string input_filename;     ///< path of the file to process
+    std::string output_filename;    ///< path of the result; empty to process the file inplace
+};
+
+/// @brief Failure of a single file of a batch.
+struct batch_failure
+{
+    std::string filename;           ///< path of the file that failed
+    std::string message;            ///< reason of the failure
+};
+
+/// @brief Encrypts, decrypts or verifies many files in parallel.
+///
+/// Files are processed by a work-stealing thread pool, largest files
+/// first. A failing file does not abort the batch; all failures are
+/// returned once all files are processed.
+///
+/// @param operation operation to apply
+/// @param jobs files to process
+/// @param password password to encrypt / decrypt files
+/// @param workers number of files processed in parallel
+/// @param options options used for each file
+/// @return failures of the batch; empty if all files succeeded
+std::vector<batch_failure> run_batch(
+    batch_operation operation,
+    std::vector<batch_job> const & jobs,
+    std::string const & password,
+    unsigned int workers,
+    file_options const & options = {});
+
+/// @brief Creates jobs for all regular files in a directory tree.
+///
+/// @param input_directory directory to scan recursively
+/// @param output_directory directory where results are stored using the same
+///                         relative paths; empty to process files inplace
+/// @return jobs of all regular files
+/// @throws A filesystem_error is thrown if the directory cannot be read.
+std::vector<batch_job> scan_directory(
+    std::string const & input_directory,
+    std::string const & output_directory);
+
+/// @brief Reads jobs from a manifest file.
+///
+/// Each non-empty line contains an input path, optionally followed by
+/// a tab character and an output path. Lines without an output path
+/// are processed inplace.
+///
+/// @param manifest_filename path of the manifest
+/// @return jobs listed in the manifest
+/// @throws A runtime_error is thrown if the manifest cannot be read.
+std::vector<batch_job> read_manifest(
+    std::string const & manifest_filename);
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef AES256GCM_COMPRESSION_HPP
+#define AES256GCM_COMPRESSION_HPP
+
+#include <string>
+#include <vector>
+
+namespace aes256gcm
+{
+
+/// @brief Names of the supported compression codecs.
+///
+/// The name and level are stored in the encryption info of compressed
+/// files. Codecs are optional dependencies; use is_compression_available
+/// to check, if a codec was found at build time.
+constexpr char const compression_zstd[] = "ZSTD";
+constexpr char const compression_lz4[] = "LZ4";
+constexpr char const compression_zlib[] = "ZLIB";
+
+/// @brief Returns the names of all known compression codecs.
+std::vector<std::string> compression_codecs();
+
+/// @brief Checks, if a compression codec is available in this build.
+/// @param name name of the codec
+/// @return true, if the codec can be used, false otherwise
+bool is_compression_available(std::string const & name);
+
+/// @brief Resolves the name of a compression codec.
+///
+/// Names are matched case-insensitively.
+///
+/// @param name name of the codec
+/// @return canonical name of the codec
+/// @throws An invalid_argument is thrown on unknown codecs.
+///         A runtime_error is thrown if the codec is not available.
+std::string select_compression(std::string const & name);
+
+/// @brief Checks a compression level against the range of a codec.
+///
+/// Levels are 1-22 for ZSTD, 1-9 for ZLIB and 1-12 for LZ4, where level 1
+/// is LZ4's fast mode and higher levels use LZ4 HC. Level 0 selects the
+/// codec's default.
+///
+/// @param codec canonical name of the codec (see select_compression)
+/// @param level compression level
+/// @throws An invalid_argument is thrown if the level is out of range.
+///         A runtime_error is thrown if the codec is not available.
+void check_compression_level(std::string const & codec, int level);
+
+}
+
+#endif
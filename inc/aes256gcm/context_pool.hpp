@@ -0,0 +1,72 @@
+#ifndef AES256GCM_CONTEXT_POOL_HPP
+#define AES256GCM_CONTEXT_POOL_HPP
+
+#include <aes256gcm/encrypter.hpp>
+#include <aes256gcm/decrypter.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace aes256gcm
+{
+
+/// @brief Returns a non-secret id of a key for the pooled contexts.
+///
+/// The id is a keyed hash of the key using a random secret of the process,
+/// so the pools keep no copy of the key besides the context itself.
+///
+/// @throws An openssl_error is thrown on error of underlying OpenSSL function calls.
+std::string context_key_id(std::string_view key);
+
+/// @brief Returns an encryption context of the calling thread.
+///
+/// Each thread keeps contexts for a small number of recently used keys
+/// and algorithms.
+/// When a context for the key exists, it is reset to the given nonce,
+/// so neither a new context nor a new key schedule is needed.
+///
+/// @note The returned context is valid until the next call of
+///       pooled_encrypter or context_pool_clear in the same thread.
+/// @note The caller is responsible to never reuse a nonce with the same key.
+///
+/// @param key_id string uniquely identifying the key (see context_key_id)
+/// @param key Key used for encryption.
+/// @param nonce Nonce / Initialization Vector used for encryption.
+/// @param additional_data Additional authenticated data.
+/// @param algorithm AEAD algorithm used for encryption.
+/// @throws A logic error is thrown on invalid key or nonce size.
+///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+encrypter & pooled_encrypter(
+    std::string const & key_id,
+    std::string_view key,
+    std::string const & nonce,
+    std::string const & additional_data = "",
+    std::string const & algorithm = algorithm_aes256_gcm);
+
+/// @brief Returns a decryption context of the calling thread.
+///
+/// @note The returned context is valid until the next call of
+///       pooled_decrypter or context_pool_clear in the same thread.
+///
+/// @param key_id string uniquely identifying the key (see context_key_id)
+/// @param key Key used for decryption.
+/// @param nonce None used for encryption.
+/// @param tag Tag used to verify that decrytion was successful.
+/// @param additional_data Additional authenticated data.
+/// @param algorithm AEAD algorithm used for encryption.
+/// @throws A logic error is thrown on invalid key, nonce or tag size.
+///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+decrypter & pooled_decrypter(
+    std::string const & key_id,
+    std::string_view key,
+    std::string const & nonce,
+    std::string const & tag,
+    std::string const & additional_data = {},
+    std::string const & algorithm = algorithm_aes256_gcm);
+
+/// @brief Releases all pooled contexts of the calling thread.
+void context_pool_clear();
+
+}
+
+#endif
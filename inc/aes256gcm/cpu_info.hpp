@@ -0,0 +1,38 @@
+#ifndef AES256GCM_CPU_INFO_HPP
+#define AES256GCM_CPU_INFO_HPP
+
+#include <string>
+
+namespace aes256gcm
+{
+
+/// @brief Instruction set extensions relevant for encryption.
+///
+/// Extensions using AVX or AVX-512 registers are only reported if the
+/// operating system saves the corresponding register state.
+struct cpu_features
+{
+    bool aes;           ///< AES-NI
+    bool pclmulqdq;     ///< carry-less multiplication
+    bool avx2;
+    bool avx512f;
+    bool avx512bw;
+    bool vaes;          ///< vector AES
+    bool vpclmulqdq;    ///< vector carry-less multiplication
+};
+
+/// @brief Detects the features of the CPU (once per process).
+cpu_features const & detect_cpu_features() noexcept;
+
+/// @brief Returns the name of the AES256-GCM implementation in use.
+///
+/// encrypter / decrypter use an in-project VAES / VPCLMULQDQ kernel on
+/// CPUs supporting it and OpenSSL otherwise. Setting the environment
+/// variable AES256GCM_DISABLE_NATIVE forces OpenSSL.
+///
+/// @return "native-vaes-avx512" or "openssl"
+std::string gcm_implementation();
+
+}
+
+#endif
@@ -1,15 +1,23 @@
 #ifndef AES256GCM_DECRYPTER_HPP
 #define AES256GCM_DECRYPTER_HPP
 
+#include <aes256gcm/algorithm.hpp>
+
 #include <openssl/evp.h>
 
 #include <string>
+#include <string_view>
 #include <memory>
 
 namespace aes256gcm
 {
 
+class native_gcm;
+
 /// @brief AES256-GCM decryption context.
+///
+/// AES256-GCM uses an in-project VAES / VPCLMULQDQ kernel on CPUs
+/// supporting it (see cpu_info.hpp) and OpenSSL otherwise.
 class decrypter
 {
 public:
@@ -19,13 +27,16 @@ public:
     /// @param nonce None used for encryption.
     /// @param tag Tag used to verify that decrytion was successful.
     /// @param additional_data Additional authenticated data.
+    /// @param algorithm AEAD algorithm used for encryption (see algorithm.hpp).
     /// @throws A logic error is thrown on invalid key size.
+    ///         An invalid_argument or runtime_error is thrown on unknown or unavailable algorithms.
     ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
     decrypter(
-        std::string const & key,
+        std::string_view key,
         std::string const & nonce,
         std::string const & tag,
-        std::string const & additional_data = {});
+        std::string const & additional_data = {},
+        std::string const & algorithm = algorithm_aes256_gcm);
 
     /// @brief Cleans up the decryption context.
     ~decrypter() = default;
@@ -33,6 +44,9 @@ public:
     /// @brief Decrypts some data.
     ///
     /// @note input and output buffer are of equal size.
+    /// @note For block based algorithms (AES256-OCB), a size which is not
+    ///       a multiple of the block size completes the decryption; only
+    ///       empty updates may follow.
     ///
     /// @param in buffer containing the encrypted data.
     /// @param out buffer where to store the decrypted data.
@@ -48,6 +62,21 @@ public:
     ///         A runtime_error is thrown on mismatch of output buffer size.
     void update_inplace(char * buffer, size_t buffer_size);
 
+    /// @brief Starts a new decryption with the same key.
+    ///
+    /// The key schedule of the previous decryption is kept, which makes
+    /// this considerably cheaper than creating a new context.
+    ///
+    /// @param nonce None used for encryption.
+    /// @param tag Tag used to verify that decrytion was successful.
+    /// @param additional_data Additional authenticated data.
+    /// @throws A logic error is thrown on invalid nonce or tag size.
+    ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+    void reset(
+        std::string const & nonce,
+        std::string const & tag,
+        std::string const & additional_data = {});
+
     /// @brief Finalized the encrytion and checks if decryption was successful.
     ///
     /// @note All decrypted data is invalid, if the check was not successful.
@@ -56,7 +85,17 @@ public:
     /// @return true, if decryption was successful, false otherwise.
     bool finalize();
 private:
+    void set_tag(std::string const & tag);
+    void add_additional_data(std::string const & additional_data);
+    void finalize_partial_block(char const * in, char * out, size_t size);
+    bool finish(char * out);
+
     std::unique_ptr<EVP_CIPHER_CTX, void (*) (EVP_CIPHER_CTX*)> m_ctx;
+    std::unique_ptr<native_gcm, void (*) (native_gcm*)> m_native;
+    size_t m_block_size;
+    bool m_is_finalized;
+    bool m_is_authentic;
+    std::string m_tag;
 };
 
 }
@@ -0,0 +1,77 @@
+#ifndef AES256GCM_ENCRYPTED_READER_HPP
+#define AES256GCM_ENCRYPTED_READER_HPP
+
+#include <aes256gcm/proprietary.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace aes256gcm
+{
+
+class secure_buffer;
+
+}
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Random access reader of segmented encrypted files.
+///
+/// Only the segments covering a requested range are read and decrypted.
+/// Each segment is authenticated before any of its data is returned.
+/// The key is derived once on construction and kept in locked memory.
+///
+/// @note Reading is thread-safe; multiple threads may call read
+///       concurrently on the same reader.
+class encrypted_reader
+{
+    encrypted_reader(encrypted_reader const &) = delete;
+    encrypted_reader& operator=(encrypted_reader const &) = delete;
+    encrypted_reader(encrypted_reader &&) = delete;
+    encrypted_reader& operator=(encrypted_reader &&) = delete;
+public:
+    /// @brief Opens an encrypted file for reading.
+    ///
+    /// @param filename path of the encrypted file
+    /// @param password password to decrypt the file
+    /// @throws A runtime_error is thrown if the file cannot be opened, has no
+    ///         valid encryption info, is not segmented or if the password
+    ///         does not match the key check value of the file.
+    ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+    encrypted_reader(
+        std::string const & filename,
+        std::string const & password);
+
+    /// @brief Closes the file and wipes the key.
+    ~encrypted_reader();
+
+    /// @brief Reads and decrypts a range of the file.
+    ///
+    /// @param offset offset within the decrypted data
+    /// @param length number of bytes to read
+    /// @param out buffer of at least length bytes to store the decrypted data
+    /// @return number of bytes read; less than length at end of file
+    /// @throws A runtime_error is thrown on I/O errors or if a segment
+    ///         fails authentication.
+    size_t read(uint64_t offset, size_t length, char * out) const;
+
+    /// @brief Returns the size of the decrypted data.
+    uint64_t size() const noexcept;
+
+    /// @brief Returns the encryption info of the file.
+    encryption_info const & info() const noexcept;
+
+private:
+    int m_fd;
+    encryption_info m_info;
+    std::unique_ptr<secure_buffer> m_key;
+    std::string m_key_id;
+    uint64_t m_segment_count;
+    uint64_t m_size;
+};
+
+}
+
+#endif
@@ -1,15 +1,23 @@
 #ifndef AES256GCM_ENCRYPTER_HPP
 #define AES256GCM_ENCRYPTER_HPP
 
+#include <aes256gcm/algorithm.hpp>
+
 #include <openssl/evp.h>
 
 #include <string>
+#include <string_view>
 #include <memory>
 
 namespace aes256gcm
 {
 
+class native_gcm;
+
 /// @brief AES256-GCM encryption context.
+///
+/// AES256-GCM uses an in-project VAES / VPCLMULQDQ kernel on CPUs
+/// supporting it (see cpu_info.hpp) and OpenSSL otherwise.
 class encrypter
 {
 public:
@@ -20,8 +28,25 @@ public:
     /// @throws A logic error is thrown on invalid key size.
     ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
     encrypter(
-        std::string const & key,
+        std::string_view key,
         std::string const & additional_data = "");
+
+    /// @brief Creates a new AES256-GCM encryption context using a given nonce.
+    ///
+    /// @note The caller is responsible to never reuse a nonce with the same key.
+    ///
+    /// @param key Key used for encryption.
+    /// @param nonce Nonce / Initialization Vector used for encryption.
+    /// @param additional_data Additional authenticated data.
+    /// @param algorithm AEAD algorithm used for encryption (see algorithm.hpp).
+    /// @throws A logic error is thrown on invalid key or nonce size.
+    ///         An invalid_argument or runtime_error is thrown on unknown or unavailable algorithms.
+    ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+    encrypter(
+        std::string_view key,
+        std::string const & nonce,
+        std::string const & additional_data,
+        std::string const & algorithm = algorithm_aes256_gcm);
     
     /// @brief Cleans up the encryption context.
     ~encrypter() = default;
@@ -29,6 +54,9 @@ public:
     /// @brief Encrypts some data.
     ///
     /// @note input and output buffer are of equal size.
+    /// @note For block based algorithms (AES256-OCB), a size which is not
+    ///       a multiple of the block size completes the encryption; only
+    ///       empty updates may follow.
     ///
     /// @param in buffer of the unencrypted data.
     /// @param out buffer to store the encrypted data.
@@ -49,13 +77,36 @@ public:
     /// @throws An openssl_error is thrown on error of underlying OpenSSL function calls.
     std::string finalize();
 
+    /// @brief Starts a new encryption with the same key.
+    ///
+    /// The key schedule of the previous encryption is kept, which makes
+    /// this considerably cheaper than creating a new context.
+    ///
+    /// @note The caller is responsible to never reuse a nonce with the same key.
+    ///
+    /// @param nonce Nonce / Initialization Vector used for encryption.
+    /// @param additional_data Additional authenticated data.
+    /// @throws A logic error is thrown on invalid nonce size.
+    ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+    void reset(
+        std::string const & nonce,
+        std::string const & additional_data = "");
+
     /// @brief Returns the Nonce / Initialization Vector of the encryption.
     /// @return Nonce / Initialization Vector of the encryption.
     std::string const & nonce() const noexcept;
 
 private:
+    void add_additional_data(std::string const & additional_data);
+    void finalize_partial_block(char const * in, char * out, size_t size);
+    std::string finish(char * out);
+
     std::unique_ptr<EVP_CIPHER_CTX, void (*) (EVP_CIPHER_CTX*)> m_ctx;
+    std::unique_ptr<native_gcm, void (*) (native_gcm*)> m_native;
     std::string m_nonce;
+    size_t m_block_size;
+    bool m_is_finalized;
+    std::string m_tag;
 };
     
 
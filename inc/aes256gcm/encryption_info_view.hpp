@@ -0,0 +1,117 @@
+#ifndef AES256GCM_ENCRYPTION_INFO_VIEW_HPP
+#define AES256GCM_ENCRYPTION_INFO_VIEW_HPP
+
+#include <aes256gcm/proprietary.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Key derivation parameters referring to the buffer of an encryption_info_view.
+struct kdf_params_view
+{
+    std::string_view algorithm;     ///< key derivation function, "PBKDF2" or "ARGON2ID"
+    std::string_view salt;          ///< salt for key derivation
+    std::string_view digest;        ///< digest used by PBKDF2; empty for Argon2id
+    unsigned int iterations;        ///< PBKDF2: iterations; Argon2id: time cost (passes)
+    unsigned int memory_cost;       ///< Argon2id: memory in KiB; 0 for PBKDF2
+    unsigned int lanes;             ///< Argon2id: degree of parallelism; 0 for PBKDF2
+};
+
+/// @brief Encryption info whose fields refer to the raw encryption info.
+///
+/// Reading the encryption info of a file takes a single pread of the end
+/// of the file into a buffer inside the view, unless the encryption info
+/// is larger than the buffer (e.g. because of segment digests). No field
+/// is copied; the fields are valid as long as the view is neither changed
+/// nor destroyed.
+///
+/// @note The fields match the fields of encryption_info (see proprietary.hpp).
+class encryption_info_view
+{
+    encryption_info_view(encryption_info_view const &) = delete;
+    encryption_info_view& operator=(encryption_info_view const &) = delete;
+    encryption_info_view(encryption_info_view &&) = delete;
+    encryption_info_view& operator=(encryption_info_view &&) = delete;
+public:
+    /// @brief Size of the buffer inside the view.
+    static constexpr size_t const inline_size = 1024;
+
+    encryption_info_view() noexcept;
+
+    /// @brief Reads the encryption info of a file.
+    ///
+    /// @param filename path of the encrypted file
+    /// @return nullptr on success, otherwise why the file has no valid encryption info
+    /// @throws A runtime_error is thrown if the file cannot be opened or read.
+    char const * read(std::string const & filename);
+
+    /// @brief Reads the encryption info of an open file.
+    ///
+    /// @param fd file descriptor of the encrypted file
+    /// @param file_size size of the file
+    /// @return nullptr on success, otherwise why the file has no valid encryption info
+    /// @throws A runtime_error is thrown if the file cannot be read.
+    char const * read(int fd, uint64_t file_size);
+
+    /// @brief Parses a raw encryption info, ending with the ENC-INFO signature.
+    ///
+    /// @note The data is not copied and must outlive the use of the fields.
+    ///
+    /// @return nullptr on success, otherwise why the data is no valid encryption info
+    char const * parse(char const * data, size_t size);
+
+    /// @brief Copies all fields to an encryption_info.
+    void copy_to(encryption_info & info) const;
+
+    size_t size;                        ///< size of the encryption info in the encrypted file
+    kdf_params_view kdf;                ///< key derivation
+    std::string_view encryption_method; ///< AEAD algorithm, e.g. "AES256-GCM"
+    std::string_view nonce;             ///< nonce / initialization vector for encryption
+    std::string_view tag;               ///< tag to check authenticity
+    std::string_view additional_data;   ///< additional authenticated but unencrypted data
+    size_t segment_size;                ///< size of plaintext segments; 0 if the file has a single tag
+    bool is_stream;                     ///< true for the streaming format
+    std::string_view compression;       ///< compression codec; empty if not compressed
+    int compression_level;              ///< compression level used to encrypt the file
+    std::string_view segment_digests;   ///< keyed digests of the plaintext segments; empty if not stored
+    std::string_view key_check;         ///< check value of the derived key; empty in files without one
+
+private:
+    char * allocate(size_t size);
+
+    char m_inline[inline_size];
+    std::vector<char> m_buffer;
+};
+
+/// @brief Encryption info of a scanned file.
+struct scanned_encryption_info
+{
+    std::string filename;           ///< path of the file
+    std::string error;              ///< why the file has no valid encryption info; empty on success
+    encryption_info info;           ///< encryption info; only valid if error is empty
+};
+
+/// @brief Reads the encryption info of many files in parallel.
+///
+/// Each file is read using a single pread (see encryption_info_view).
+/// Files without valid encryption info, including files that cannot be
+/// read, do not abort the scan but are reported in the result.
+///
+/// @param filenames paths of the files to scan
+/// @param threads number of files read in parallel
+/// @param catalog catalog to look up files first; nullptr to read all files
+/// @return encryption info of all files in the order of filenames
+std::vector<scanned_encryption_info> scan_encryption_info(
+    std::vector<std::string> const & filenames,
+    unsigned int threads,
+    metadata_catalog * catalog = nullptr);
+
+}
+
+#endif
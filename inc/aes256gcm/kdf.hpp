@@ -0,0 +1,95 @@
+#ifndef AES256GCM_KDF_HPP
+#define AES256GCM_KDF_HPP
+
+#include <chrono>
+#include <string>
+
+namespace aes256gcm
+{
+
+constexpr char const kdf_pbkdf2[] = "PBKDF2";
+constexpr char const kdf_argon2id[] = "ARGON2ID";
+
+/// @brief Parameters of a key derivation, as stored in the encryption info.
+struct kdf_params
+{
+    std::string algorithm;          ///< key derivation function, "PBKDF2" or "ARGON2ID"
+    std::string salt;               ///< salt for key derivation
+    std::string digest;             ///< digest used by PBKDF2; empty for Argon2id
+    unsigned int iterations;        ///< PBKDF2: iterations; Argon2id: time cost (passes)
+    unsigned int memory_cost;       ///< Argon2id: memory in KiB; 0 for PBKDF2
+    unsigned int lanes;             ///< Argon2id: degree of parallelism; 0 for PBKDF2
+};
+
+/// @brief Time and memory cost of Argon2id.
+struct argon2_cost
+{
+    unsigned int time_cost;         ///< number of passes over the memory
+    unsigned int memory_cost;       ///< memory in KiB
+};
+
+/// @brief Derives a key from a password using Argon2id (RFC 9106).
+///
+/// Uses OpenSSL's implementation if provided (OpenSSL 3.2 and later),
+/// an in-project implementation otherwise. Lanes are filled in parallel
+/// using up to min(lanes, number of cores) threads; the result does not
+/// depend on the number of threads.
+///
+/// @param password    password to derive key from
+/// @param salt        salt of password; at least 8 bytes
+/// @param time_cost   number of passes, at least 1
+/// @param memory_cost memory in KiB, at least 8 * lanes
+/// @param lanes       degree of parallelism, 1 to 255
+/// @return derived 32 byte key
+/// @throws An invalid_argument is thrown on invalid parameters.
+std::string argon2id(
+    std::string const & password,
+    std::string const & salt,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes);
+
+/// @brief Determines the cost of Argon2id to take a given time on this host.
+///
+/// Memory is increased first, as memory hardness is the main defense
+/// against dedicated hardware, then the number of passes.
+///
+/// @param target      targeted duration of a key derivation
+/// @param lanes       degree of parallelism used for key derivation
+/// @param max_memory_cost upper bound of the memory in KiB
+/// @return cost taking about the targeted duration, but at least one pass
+///         over 8 MiB of memory
+argon2_cost calibrate_argon2id(
+    std::chrono::milliseconds target,
+    unsigned int lanes,
+    unsigned int max_memory_cost = 1024 * 1024);
+
+/// @brief Generates parameters of a new key derivation, including a random salt.
+///
+/// @param algorithm   key derivation function, "PBKDF2" or "ARGON2ID" (case insensitive)
+/// @param time_cost   Argon2id time cost; 0 selects the default (3)
+/// @param memory_cost Argon2id memory in KiB; 0 selects the default (64 MiB)
+/// @param lanes       Argon2id lanes; 0 selects the number of cores (at most 16)
+/// @throws An invalid_argument is thrown on unknown algorithms.
+///         An openssl_error is thrown on error creating random salt.
+kdf_params generate_kdf_params(
+    std::string const & algorithm = kdf_pbkdf2,
+    unsigned int time_cost = 0,
+    unsigned int memory_cost = 0,
+    unsigned int lanes = 0);
+
+/// @brief Derives a key using the given parameters.
+///
+/// Derived keys are cached (see pbkdf2).
+///
+/// @note The returned key is a copy, which the caller has to wipe.
+///
+/// @throws An invalid_argument is thrown on unknown algorithms or invalid parameters.
+///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+std::string derive_key(
+    std::string const & password,
+    kdf_params const & params);
+
+}
+
+#endif
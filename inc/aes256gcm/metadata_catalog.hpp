@@ -0,0 +1,109 @@
+#ifndef AES256GCM_METADATA_CATALOG_HPP
+#define AES256GCM_METADATA_CATALOG_HPP
+
+#include <aes256gcm/proprietary.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief On-disk cache of the encryption info of many files.
+///
+/// Entries are keyed by device and inode of a file and are valid as long
+/// as size and modification time of the file do not change. Stale entries
+/// are revalidated lazily on lookup by reading the encryption info of the
+/// file again, so a catalog never returns outdated encryption info, even
+/// if files are changed without updating it.
+///
+/// @note All member functions are thread-safe, so a catalog may be shared
+///       by the workers of a batch (see file_options::catalog).
+class metadata_catalog
+{
+    metadata_catalog(metadata_catalog const &) = delete;
+    metadata_catalog& operator=(metadata_catalog const &) = delete;
+    metadata_catalog(metadata_catalog &&) = delete;
+    metadata_catalog& operator=(metadata_catalog &&) = delete;
+public:
+    /// @brief Loads a catalog.
+    ///
+    /// A missing or invalid catalog file results in an empty catalog,
+    /// which is rebuilt by lookups and written by save.
+    ///
+    /// @param filename path of the catalog file
+    explicit metadata_catalog(std::string const & filename);
+
+    ~metadata_catalog();
+
+    /// @brief Gets the encryption info of a file.
+    ///
+    /// The encryption info is read from the file only if the catalog has no
+    /// valid entry; the entry is updated then.
+    ///
+    /// @param filename path of the encrypted file
+    /// @param info Result where to store the encryption info.
+    /// @return nullptr on success, otherwise why the file has no valid encryption info
+    /// @throws A runtime_error is thrown if the file cannot be accessed or read.
+    char const * lookup(std::string const & filename, encryption_info & info);
+
+    /// @brief Stores the encryption info of a file just written.
+    ///
+    /// @throws A runtime_error is thrown if the file cannot be accessed.
+    void update(std::string const & filename, encryption_info const & info);
+
+    /// @brief Writes the catalog, if it was changed since it was loaded.
+    ///
+    /// The catalog is written to a temporary file, which replaces the
+    /// catalog file, so readers never see a partially written catalog.
+    ///
+    /// @throws A runtime_error is thrown if the catalog cannot be written.
+    void save();
+
+    /// @brief Returns the number of entries.
+    size_t size() const;
+
+private:
+    struct file_id
+    {
+        uint64_t device;
+        uint64_t inode;
+
+        bool operator==(file_id const & other) const noexcept
+        {
+            return (device == other.device) && (inode == other.inode);
+        }
+    };
+
+    struct file_id_hash
+    {
+        size_t operator()(file_id const & id) const noexcept
+        {
+            return std::hash<uint64_t>()(id.inode) ^ (std::hash<uint64_t>()(id.device) << 1);
+        }
+    };
+
+    /// @brief Encryption info of a file, serialized as in the file (see encryption_info_view).
+    struct entry
+    {
+        uint64_t size;              ///< size of the file
+        int64_t mtime;              ///< modification time of the file in nanoseconds
+        uint32_t info_size;         ///< size of the encryption info in the file
+        bool is_stream;             ///< true for the streaming format
+        std::string raw_info;       ///< encryption info without size and is_stream
+    };
+
+    void load();
+
+    std::string m_filename;
+    mutable std::mutex m_mutex;
+    std::unordered_map<file_id, entry, file_id_hash> m_entries;
+    bool m_modified;
+};
+
+}
+
+#endif
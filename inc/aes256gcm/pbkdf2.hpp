@@ -1,6 +1,8 @@
 #ifndef AES256GCM_PBKDF2_HPP
 #define AES256GCM_PBKDF2_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace aes256gcm
@@ -8,6 +10,10 @@ namespace aes256gcm
 
 /// @brief Derives a key from a password using PBKDF2 method.
 ///
+/// Derived keys are cached, so that repeated calls with the same
+/// parameters return without running the key derivation again.
+/// The cache is bounded, thread-safe and keeps keys in locked memory.
+///
 /// @note The key size is 32 bytes, which is needed for
 ///       AES256-GCM, but might be insufficient for other
 ///       algorithms.
@@ -24,6 +30,43 @@ std::string pbkdf2(
     std::string const & digest,
     unsigned int iterations);
 
+/// @brief A single key derivation of pbkdf2_batch.
+struct pbkdf2_job
+{
+    std::string password;       ///< password to derive key from
+    std::string salt;           ///< salt of password
+    std::string digest;         ///< name of the algorithm used to hash the password
+    unsigned int iterations;    ///< number of iterations to derive key
+    std::string key;            ///< derived key; set by pbkdf2_batch
+};
+
+/// @brief Derives the keys of many independent jobs.
+///
+/// The result of each job is identical to pbkdf2() with the same
+/// parameters and uses the same cache. Jobs using SHA-256 with equal
+/// iterations are run in lockstep, 16 at a time using AVX-512 or 8 at a
+/// time using AVX2 (multi-buffer SHA-256). Remaining jobs are derived
+/// one by one, like pbkdf2() does.
+///
+/// @param jobs    jobs to derive keys for
+/// @param count   number of jobs
+/// @param threads maximum number of threads to use; 0 or 1 runs sequentially
+/// @throws An openssl_error is thrown on error of underlying OpenSSL function calls.
+void pbkdf2_batch(pbkdf2_job * jobs, size_t count, unsigned int threads = 1);
+
+/// @brief Counters of the pbkdf2 key cache.
+struct pbkdf2_cache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+};
+
+/// @brief Returns the hit and miss counters of the pbkdf2 key cache.
+pbkdf2_cache_stats pbkdf2_cache_statistics();
+
+/// @brief Wipes all cached keys and resets the counters.
+void pbkdf2_cache_clear();
+
 /// @brief Generates parameters for key derivation
 /// @param salt random salt to generate
 /// @param digest store digest
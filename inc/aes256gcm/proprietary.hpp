@@ -1,25 +1,156 @@
 #ifndef AES256GCM_PROPRIETARY_HPP
 #define AES256GCM_PROPRIETARY_HPP
 
+#include <aes256gcm/algorithm.hpp>
+#include <aes256gcm/kdf.hpp>
+
+#include <cstdint>
+#include <iosfwd>
 #include <string>
 
 namespace aes256gcm::proprietary
 {
 
+class metadata_catalog;
+
 /// @brief Encryption Information.
 struct encryption_info
 {
     size_t size;                    ///< size of the encryption info in the encrypted file
-    struct {
-        std::string algorithm;      ///< algorithm used for key derivation, always "PBKDF2"
-        std::string salt;           ///< salt for key derivation
-        std::string digest;         ///< digest used for key derivation
-        unsigned int iterations;    ///< iterations used for key derivation    
-    } kdf;
-    std::string encryption_method;  ///< encryption method, always "AES256-GCM"
+    kdf_params kdf;                 ///< key derivation, "PBKDF2" or "ARGON2ID" (see kdf.hpp)
+    std::string encryption_method;  ///< AEAD algorithm, e.g. "AES256-GCM" (see algorithm.hpp)
     std::string nonce;              ///< none / initialization vector for encryption
     std::string tag;                ///< tag to check authenticity
     std::string additional_data;    ///< additional authenticated but unencrypted data
+    size_t segment_size;            ///< size of plaintext segments; 0 if the file has a single tag
+    bool is_stream;                 ///< true for the streaming format (header first, see encrypt_stream)
+    std::string compression;        ///< compression codec, e.g. "ZSTD" (see compression.hpp); empty if not compressed
+    int compression_level;          ///< compression level used to encrypt the file
+    std::string segment_digests;    ///< keyed digests of the plaintext segments; empty if not stored
+    std::string key_check;          ///< check value of the derived key; empty in files without one
+};
+
+
+/// @brief I/O engine used to read and write files.
+enum class io_engine
+{
+    automatic,  ///< iostream when copying files, mmap when operating inplace
+    iostream,   ///< std::ifstream / std::ofstream
+    pread,      ///< pread / pwrite system calls
+    mmap,       ///< memory mapped windows
+    io_uring    ///< io_uring using registered buffers
+};
+
+
+/// @brief Options of file encryption and decryption.
+struct file_options
+{
+    /// @brief Size of plaintext segments.
+    ///
+    /// If non-zero, the file is split into segments of the given size,
+    /// each having its own nonce and tag (segmented file format).
+    /// Segmented files can be encrypted and decrypted using multiple
+    /// threads. If zero, the file is encrypted using a single tag.
+    size_t segment_size = 0;
+
+    /// @brief Maximum number of threads used to encrypt / decrypt a file.
+    ///
+    /// Segmented files are processed segment-wise; files with a single
+    /// tag are processed using a parallel GCM implementation when
+    /// encrypted / decrypted inplace.
+    unsigned int threads = 1;
+
+    /// @brief Size of the memory mapped window used for inplace operation.
+    ///
+    /// Bounds the memory used to encrypt / decrypt a file inplace,
+    /// independent of the file size.
+    size_t window_size = 64 * 1024 * 1024;
+
+    /// @brief I/O engine used to read and write files.
+    io_engine engine = io_engine::automatic;
+
+    /// @brief Bypass the page cache using O_DIRECT.
+    ///
+    /// Only used by the pread and io_uring engines. I/O is done
+    /// using aligned buffers.
+    bool direct_io = false;
+
+    /// @brief AEAD algorithm used to encrypt files.
+    ///
+    /// One of the names in algorithm.hpp or "auto". The algorithm is
+    /// stored in the encryption info, so decryption does not need it.
+    std::string algorithm = algorithm_aes256_gcm;
+
+    /// @brief Key derivation function used to encrypt files.
+    ///
+    /// "PBKDF2" or "ARGON2ID". The parameters are stored in the
+    /// encryption info, so decryption does not need them.
+    std::string kdf = kdf_pbkdf2;
+
+    /// @brief Argon2id time cost (passes); 0 selects the default.
+    unsigned int kdf_time_cost = 0;
+
+    /// @brief Argon2id memory cost in KiB; 0 selects the default.
+    unsigned int kdf_memory_cost = 0;
+
+    /// @brief Argon2id lanes; 0 selects the number of cores.
+    ///
+    /// Lanes are derived in parallel, so the derivation uses all cores
+    /// at the same cost in wall-clock time.
+    unsigned int kdf_lanes = 0;
+
+    /// @brief Size of the buffers used to read and write files.
+    size_t buffer_size = 100 * 1024;
+
+    /// @brief Overlap reading, encryption and writing of files.
+    ///
+    /// If set, files are read, encrypted / decrypted and written by
+    /// separate threads connected by bounded queues.
+    bool pipelined = false;
+
+    /// @brief Compression codec applied before encryption.
+    ///
+    /// One of the names in compression.hpp or empty to store the
+    /// plaintext uncompressed. Data is compressed in independent blocks
+    /// using up to threads threads; blocks which do not compress are
+    /// stored as they are. The codec is stored in the encryption info,
+    /// so decryption does not need it. Compressed files are always stored
+    /// in segments (of 1 MiB if segment_size is 0), so that
+    /// only authenticated data is decompressed.
+    ///
+    /// @note Compression is not supported inplace and for streams.
+    std::string compression;
+
+    /// @brief Compression level; 0 selects the codec's default.
+    int compression_level = 0;
+
+    /// @brief Store keyed digests of the plaintext segments.
+    ///
+    /// Allows update_encrypted_file to find changed segments without
+    /// decrypting the file. Requires a segment size and no compression;
+    /// the digests take 16 bytes per segment in the encryption info.
+    bool segment_digests = false;
+
+    /// @brief Verify files before decrypting them inplace.
+    ///
+    /// Inplace decryption overwrites the ciphertext before the tag is
+    /// checked, so a wrong password or corrupted data destroys the file.
+    /// If set, the file is authenticated first (see verify_file) and left
+    /// as it is on failure, at the cost of reading it twice.
+    bool verify_inplace = false;
+
+    /// @brief Number of buffers in flight.
+    ///
+    /// Used by the io_uring engine and in pipelined mode.
+    unsigned int queue_depth = 4;
+
+    /// @brief Catalog caching the encryption info of files (see metadata_catalog.hpp).
+    ///
+    /// If set, encrypted files are added to the catalog and the encryption
+    /// info of files is looked up in the catalog where only the encryption
+    /// info is needed, e.g. to derive keys ahead in batches. Not owned; the
+    /// catalog has to be saved by the caller.
+    metadata_catalog * catalog = nullptr;
 };
 
 
@@ -46,11 +177,13 @@ bool get_encryption_info(
 /// @param password password to encrypt the file
 /// @param additional_data additional data that is stored unencrypted but
 ///                        authenticated in the encrypted file
+/// @param options options of encryption
 void encrypt_file(
     std::string const & input_filename,
     std::string const & output_filename,
     std::string const & password,
-    std::string const & additional_data = "");
+    std::string const & additional_data = "",
+    file_options const & options = {});
 
 
 /// @brief Encrypt a given file inplace.
@@ -59,14 +192,20 @@ void encrypt_file(
 ///       in order to store encryption information and
 ///       additional data.
 ///
+/// @note Segmented files cannot be encrypted inplace.
+///
 /// @param filename path of the file to encrypt
 /// @param password password to encrypt the file
 /// @param additional_data additional data that is stored unencrypted but
 ///                        authenticated in the encrypted file
+/// @param options options of encryption; if multiple threads are
+///                used, the file is encrypted using a parallel GCM
+///                implementation producing the same single tag format
 void encrypt_file_inplace(
     std::string const & filename,
     std::string const & password,
-    std::string const & additional_data = "");
+    std::string const & additional_data = "",
+    file_options const & options = {});
 
 
 /// @brief Decrypts a given file.
@@ -80,13 +219,170 @@ void encrypt_file_inplace(
 /// @param input_filename path of encrypted file
 /// @param output_filename path where the decrypted file is stored to
 /// @param password password to decrypt file
+/// @param options options of decryption; the segment size is read from the file
 /// @return 0 on success, otherwise failure.
 int decrypt_file(
     std::string const & input_filename,
     std::string const & output_filename,
+    std::string const & password,
+    file_options const & options = {});
+
+
+/// @brief Statistics of update_encrypted_file.
+struct update_statistics
+{
+    uint64_t segments;              ///< number of segments of the updated file
+    uint64_t rewritten_segments;    ///< number of segments encrypted and written
+};
+
+
+/// @brief Updates an encrypted file to match a new plaintext.
+///
+/// Only segments whose plaintext changed are encrypted again, using fresh
+/// random nonces, and written; unchanged segments are left as they are.
+/// Afterwards the encryption info is rewritten and the file is resized.
+/// Changed segments are found using the segment digests stored in the
+/// file (see file_options::segment_digests). Files without digests are
+/// compared segment by segment with their decrypted content and get
+/// digests by the update.
+///
+/// @note Only segmented, uncompressed files can be updated.
+///
+/// @note The old content of every overwritten or truncated range is saved
+///       in a journal next to the file (filename.journal) before it is
+///       written, which costs a sync per batch of segments. If the update
+///       is interrupted, e.g. by a crash, the file is rolled back by the
+///       next update or append or by recover_encrypted_file.
+///
+/// @param plaintext_filename path of the new plaintext
+/// @param encrypted_filename path of the encrypted file to update
+/// @param password password of the encrypted file
+/// @param options options of the update (threads); the segment size is read from the file
+/// @param statistics if not null, statistics of the update are stored here
+/// @return 0 on success, otherwise failure.
+/// @throws A runtime_error is thrown on I/O errors.
+int update_encrypted_file(
+    std::string const & plaintext_filename,
+    std::string const & encrypted_filename,
+    std::string const & password,
+    file_options const & options = {},
+    update_statistics * statistics = nullptr);
+
+
+/// @brief Appends data to an encrypted file.
+///
+/// The data is encrypted in new segments at the end of the file, each
+/// authenticated on its own using a fresh random nonce. Only the former
+/// last segment is encrypted again, as it loses its last flag, and the
+/// encryption info is rewritten; the cost is independent of the size of
+/// the existing file. Truncation and reordering of segments are detected
+/// on decryption as for any segmented file.
+///
+/// @note Only segmented, uncompressed files can be appended to.
+///
+/// @note The former last segment and the encryption info are saved in a
+///       journal next to the file (filename.journal) before they are
+///       overwritten. If appending is interrupted, e.g. by a crash, the file
+///       is rolled back by the next append or by recover_encrypted_file.
+///
+/// @param filename path of the encrypted file
+/// @param in stream to read the data to append from
+/// @param password password of the encrypted file
+/// @param options options of encryption (threads); the segment size is read from the file
+/// @return 0 on success, otherwise failure.
+/// @throws A runtime_error is thrown on I/O errors.
+int append_encrypted(
+    std::string const & filename,
+    std::istream & in,
+    std::string const & password,
+    file_options const & options = {});
+
+
+/// @brief Appends data to an encrypted file.
+///
+/// @see append_encrypted(std::string const &, std::istream &, std::string const &, file_options const &)
+int append_encrypted(
+    std::string const & filename,
+    std::string const & data,
+    std::string const & password,
+    file_options const & options = {});
+
+
+/// @brief Rolls back an interrupted append to or update of an encrypted file.
+///
+/// Restores the content and size the file had before the interrupted
+/// operation from its journal (see append_encrypted and
+/// update_encrypted_file) and removes the journal. Does nothing if there
+/// is no journal.
+///
+/// @param filename path of the encrypted file
+/// @return true if the file was rolled back
+/// @throws A runtime_error is thrown on I/O errors or if the journal is invalid.
+bool recover_encrypted_file(
+    std::string const & filename);
+
+
+/// @brief Encrypts a stream, e.g. stdin to stdout.
+///
+/// @note The stream is encrypted in a streaming variant of the proprietary
+///       file format: encryption info is stored in a header in front of
+///       the payload, followed by length-prefixed frames which are
+///       authenticated on their own. Encryption and decryption therefore
+///       work on pipes using constant memory.
+///
+/// @param in stream to read plaintext from
+/// @param out stream to write the encrypted stream to
+/// @param password password to encrypt the stream
+/// @param additional_data additional data that is stored unencrypted but
+///                        authenticated in the encrypted stream
+/// @param options options of encryption; segment_size is used as frame
+///                size (default: 1 MiB), I/O options are ignored
+/// @throws A runtime_error is thrown on I/O errors.
+void encrypt_stream(
+    std::istream & in,
+    std::ostream & out,
+    std::string const & password,
+    std::string const & additional_data = "",
+    file_options const & options = {});
+
+
+/// @brief Decrypts a stream produced by encrypt_stream.
+///
+/// Each frame is written to the output as soon as it is authenticated.
+///
+/// @note If decryption fails, the output contains the frames
+///       authenticated so far and should not be used.
+///
+/// @param in stream to read the encrypted stream from
+/// @param out stream to write plaintext to
+/// @param password password to decrypt the stream
+/// @return 0 on success, otherwise failure.
+int decrypt_stream(
+    std::istream & in,
+    std::ostream & out,
     std::string const & password);
 
 
+/// @brief Verifies a given file without decrypting it.
+///
+/// Authenticates the payload using a single sequential read and no
+/// writes, e.g. to scrub archives. Files with a single AES256-GCM tag
+/// are authenticated by a GHASH-only pass over the ciphertext; other
+/// files are decrypted into scratch buffers which are discarded.
+///
+/// @param filename path of the encrypted file
+/// @param password password to decrypt file
+/// @param options options of verification (threads, I/O engine, buffer
+///                size, pipelining); by default the file is read using
+///                pread with readahead
+/// @return 0, if the file is authentic, otherwise failure.
+/// @throws A runtime_error is thrown on I/O errors.
+int verify_file(
+    std::string const & filename,
+    std::string const & password,
+    file_options const & options = {});
+
+
 /// @brief Decrypt a given file inplace.
 ///
 /// @note The input file uses the proprietary file format
@@ -95,12 +391,17 @@ int decrypt_file(
 /// @note The file might be corrupted if decryption
 ///       fails.
 ///
+/// @note Segmented files cannot be decrypted inplace.
+///
 /// @param filename path of the file to decrypt
 /// @param password password to decrypt file
+/// @param options options of decryption; set verify_inplace to keep
+///                the file intact if it is not authentic
 /// @return 0 on success, otherwise failure.
 int decrypt_file_inplace(
     std::string const & filename,
-    std::string const & password);    
+    std::string const & password,
+    file_options const & options = {});
 
 }
 
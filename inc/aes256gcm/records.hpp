@@ -0,0 +1,72 @@
+#ifndef AES256GCM_RECORDS_HPP
+#define AES256GCM_RECORDS_HPP
+
+#include <aes256gcm/arena.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace aes256gcm
+{
+
+/// @brief Plain text record.
+struct record
+{
+    char const * data;
+    size_t size;
+};
+
+/// @brief Encrypted record.
+///
+/// All pointers refer to memory of the arena passed to encrypt_records.
+struct sealed_record
+{
+    char const * nonce;         ///< nonce (12 bytes)
+    char const * ciphertext;    ///< encrypted data (size bytes)
+    size_t size;
+    char const * tag;           ///< tag (16 bytes)
+};
+
+/// @brief Encrypts a batch of small records.
+///
+/// Each record is encrypted with its own random nonce and gets its own
+/// tag. One cipher context is used for the whole batch and all output
+/// is allocated from the arena: nonces, tags and ciphertexts are each
+/// stored contiguously, so there are no per-record heap allocations.
+///
+/// @param key Key used for encryption.
+/// @param records records to encrypt
+/// @param count number of records
+/// @param out arena to allocate the output from
+/// @param additional_data additional authenticated data used for all records
+/// @return array of count encrypted records allocated from the arena
+/// @throws A logic error is thrown on invalid key size.
+///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+sealed_record const * encrypt_records(
+    std::string const & key,
+    record const * records,
+    size_t count,
+    arena & out,
+    std::string const & additional_data = "");
+
+/// @brief Decrypts a batch of records encrypted by encrypt_records.
+///
+/// @param key Key used for decryption.
+/// @param records records to decrypt
+/// @param count number of records
+/// @param out arena to allocate the output from
+/// @param additional_data additional authenticated data used for all records
+/// @return array of count decrypted records allocated from the arena
+/// @throws A logic error is thrown on invalid key size.
+///         A runtime_error is thrown if a record fails authentication.
+///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+record const * decrypt_records(
+    std::string const & key,
+    sealed_record const * records,
+    size_t count,
+    arena & out,
+    std::string const & additional_data = "");
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "aes256gcm/arena.hpp"
+
+#include <algorithm>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+constexpr size_t const arena_alignment = 16;
+
+constexpr size_t align(size_t value)
+{
+    return (value + arena_alignment - 1) & ~(arena_alignment - 1);
+}
+
+}
+
+arena::arena(size_t block_size)
+: m_block_size(align(block_size > 0 ? block_size : arena_alignment))
+, m_current(0)
+, m_offset(0)
+, m_used(0)
+{
+
+}
+
+char * arena::allocate(size_t size)
+{
+    size = align(size > 0 ? size : 1);
+
+    while ((m_current < m_blocks.size()) && (m_offset + size > m_blocks[m_current].size))
+    {
+        m_current++;
+        m_offset = 0;
+    }
+
+    if (m_current == m_blocks.size())
+    {
+        size_t const block_size = std::max(size, m_block_size);
+        // operator new[] aligns to at least __STDCPP_DEFAULT_NEW_ALIGNMENT__ (16)
+        m_blocks.push_back({std::unique_ptr<char[]>(new char[block_size]), block_size});
+        m_offset = 0;
+    }
+
+    char * const result = &m_blocks[m_current].data[m_offset];
+    m_offset += size;
+    m_used += size;
+    return result;
+}
+
+void arena::reset() noexcept
+{
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t arena::used() const noexcept
+{
+    return m_used;
+}
+
+size_t arena::capacity() const noexcept
+{
+    size_t result = 0;
+    for (auto const & b: m_blocks)
+    {
+        result += b.size;
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,761 @@
+#include "aes256gcm/argon2.hpp"
+#include "aes256gcm/kdf.hpp"
+#include "aes256gcm/parallel_for.hpp"
+#include "aes256gcm/openssl_error.hpp"
+#include "aes256gcm/constants.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/kdf.h>
+#include <openssl/params.h>
+#include <openssl/core_names.h>
+#if defined(OSSL_KDF_PARAM_ARGON2_LANES)
+#include <openssl/thread.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+uint64_t load64(unsigned char const * data)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < 8; i++)
+    {
+        result |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return result;
+}
+
+void store64(unsigned char * data, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        data[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+void store32(unsigned char * data, uint32_t value)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        data[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+uint64_t rotr64(uint64_t value, unsigned int bits)
+{
+    return (value >> bits) | (value << (64 - bits));
+}
+
+// BLAKE2b (RFC 7693) with variable output size and without key, as
+// required by Argon2; OpenSSL 3.0 only provides BLAKE2b-512.
+class blake2b
+{
+public:
+    static constexpr size_t const block_size = 128;
+    static constexpr size_t const max_output_size = 64;
+
+    explicit blake2b(size_t output_size)
+    : m_counter(0)
+    , m_buffer_size(0)
+    , m_output_size(output_size)
+    {
+        for (size_t i = 0; i < 8; i++)
+        {
+            m_state[i] = iv[i];
+        }
+        m_state[0] ^= 0x01010000 ^ output_size;
+    }
+
+    ~blake2b()
+    {
+        OPENSSL_cleanse(m_state, sizeof(m_state));
+        OPENSSL_cleanse(m_buffer, sizeof(m_buffer));
+    }
+
+    void update(void const * data, size_t size)
+    {
+        auto const * bytes = static_cast<unsigned char const*>(data);
+        while (size > 0)
+        {
+            // the last block is compressed on finalization
+            if (m_buffer_size == block_size)
+            {
+                m_counter += block_size;
+                compress(false);
+                m_buffer_size = 0;
+            }
+
+            size_t const chunk_size = std::min(size, block_size - m_buffer_size);
+            memcpy(&m_buffer[m_buffer_size], bytes, chunk_size);
+            m_buffer_size += chunk_size;
+            bytes += chunk_size;
+            size -= chunk_size;
+        }
+    }
+
+    void update_u32(uint32_t value)
+    {
+        unsigned char data[4];
+        store32(data, value);
+        update(data, sizeof(data));
+    }
+
+    void finalize(void * out)
+    {
+        m_counter += m_buffer_size;
+        memset(&m_buffer[m_buffer_size], 0, block_size - m_buffer_size);
+        compress(true);
+
+        unsigned char result[max_output_size];
+        for (size_t i = 0; i < 8; i++)
+        {
+            store64(&result[i * 8], m_state[i]);
+        }
+        memcpy(out, result, m_output_size);
+        OPENSSL_cleanse(result, sizeof(result));
+    }
+
+private:
+    static constexpr uint64_t const iv[8] =
+    {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+    };
+
+    static constexpr uint8_t const sigma[12][16] =
+    {
+        { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+        {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+        {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+        { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+        { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+        { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+        {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+        {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+        { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+        {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0},
+        { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+        {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3}
+    };
+
+    static void mix(uint64_t * v, size_t a, size_t b, size_t c, size_t d, uint64_t x, uint64_t y)
+    {
+        v[a] = v[a] + v[b] + x;
+        v[d] = rotr64(v[d] ^ v[a], 32);
+        v[c] = v[c] + v[d];
+        v[b] = rotr64(v[b] ^ v[c], 24);
+        v[a] = v[a] + v[b] + y;
+        v[d] = rotr64(v[d] ^ v[a], 16);
+        v[c] = v[c] + v[d];
+        v[b] = rotr64(v[b] ^ v[c], 63);
+    }
+
+    void compress(bool is_last)
+    {
+        uint64_t m[16];
+        for (size_t i = 0; i < 16; i++)
+        {
+            m[i] = load64(&m_buffer[i * 8]);
+        }
+
+        uint64_t v[16];
+        for (size_t i = 0; i < 8; i++)
+        {
+            v[i] = m_state[i];
+            v[i + 8] = iv[i];
+        }
+        v[12] ^= m_counter;
+        if (is_last)
+        {
+            v[14] = ~v[14];
+        }
+
+        for (auto const & s: sigma)
+        {
+            mix(v, 0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+            mix(v, 1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+            mix(v, 2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+            mix(v, 3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+            mix(v, 0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+            mix(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            mix(v, 2, 7,  8, 13, m[s[12]], m[s[13]]);
+            mix(v, 3, 4,  9, 14, m[s[14]], m[s[15]]);
+        }
+
+        for (size_t i = 0; i < 8; i++)
+        {
+            m_state[i] ^= v[i] ^ v[i + 8];
+        }
+        OPENSSL_cleanse(m, sizeof(m));
+        OPENSSL_cleanse(v, sizeof(v));
+    }
+
+    uint64_t m_state[8];
+    uint64_t m_counter;     // messages are far below 2^64 bytes
+    unsigned char m_buffer[block_size];
+    size_t m_buffer_size;
+    size_t m_output_size;
+};
+
+constexpr size_t const block_words = 128;
+constexpr size_t const block_bytes = block_words * 8;
+constexpr unsigned int const sync_points = 4;
+constexpr uint32_t const argon2_version = 0x13;
+constexpr uint32_t const argon2_type_id = 2;
+
+struct block
+{
+    uint64_t v[block_words];
+};
+
+// variable-length hash function H' (RFC 9106, section 3.3)
+void hash_long(void const * in, size_t in_size, unsigned char * out, size_t out_size)
+{
+    if (out_size <= blake2b::max_output_size)
+    {
+        blake2b hash(out_size);
+        hash.update_u32(static_cast<uint32_t>(out_size));
+        hash.update(in, in_size);
+        hash.finalize(out);
+        return;
+    }
+
+    unsigned char v[blake2b::max_output_size];
+    {
+        blake2b hash(blake2b::max_output_size);
+        hash.update_u32(static_cast<uint32_t>(out_size));
+        hash.update(in, in_size);
+        hash.finalize(v);
+    }
+
+    size_t pos = 0;
+    while (out_size - pos > blake2b::max_output_size)
+    {
+        memcpy(&out[pos], v, 32);
+        pos += 32;
+
+        size_t const next_size = std::min(blake2b::max_output_size, out_size - pos);
+        if (out_size - pos > blake2b::max_output_size)
+        {
+            blake2b hash(blake2b::max_output_size);
+            hash.update(v, sizeof(v));
+            hash.finalize(v);
+        }
+        else
+        {
+            blake2b hash(next_size);
+            hash.update(v, sizeof(v));
+            hash.finalize(&out[pos]);
+            pos = out_size;
+        }
+    }
+    OPENSSL_cleanse(v, sizeof(v));
+}
+
+uint64_t blamka(uint64_t x, uint64_t y)
+{
+    return x + y + 2 * (x & 0xffffffff) * (y & 0xffffffff);
+}
+
+void mix(uint64_t & a, uint64_t & b, uint64_t & c, uint64_t & d)
+{
+    a = blamka(a, b);
+    d = rotr64(d ^ a, 32);
+    c = blamka(c, d);
+    b = rotr64(b ^ c, 24);
+    a = blamka(a, b);
+    d = rotr64(d ^ a, 16);
+    c = blamka(c, d);
+    b = rotr64(b ^ c, 63);
+}
+
+// permutation P applied to 16 words
+void permute(
+    uint64_t & v0, uint64_t & v1, uint64_t & v2, uint64_t & v3,
+    uint64_t & v4, uint64_t & v5, uint64_t & v6, uint64_t & v7,
+    uint64_t & v8, uint64_t & v9, uint64_t & v10, uint64_t & v11,
+    uint64_t & v12, uint64_t & v13, uint64_t & v14, uint64_t & v15)
+{
+    mix(v0, v4, v8, v12);
+    mix(v1, v5, v9, v13);
+    mix(v2, v6, v10, v14);
+    mix(v3, v7, v11, v15);
+    mix(v0, v5, v10, v15);
+    mix(v1, v6, v11, v12);
+    mix(v2, v7, v8, v13);
+    mix(v3, v4, v9, v14);
+}
+
+// compression function G; with_xor is used for passes after the first
+void fill_block(block const & previous, block const & reference, block & next, bool with_xor)
+{
+    block r;
+    block result;
+    for (size_t i = 0; i < block_words; i++)
+    {
+        r.v[i] = previous.v[i] ^ reference.v[i];
+        result.v[i] = with_xor ? (r.v[i] ^ next.v[i]) : r.v[i];
+    }
+
+    uint64_t * v = r.v;
+    for (size_t i = 0; i < 8; i++)
+    {
+        uint64_t * row = &v[16 * i];
+        permute(row[0], row[1], row[2], row[3], row[4], row[5], row[6], row[7],
+            row[8], row[9], row[10], row[11], row[12], row[13], row[14], row[15]);
+    }
+    for (size_t i = 0; i < 8; i++)
+    {
+        size_t const c = 2 * i;
+        permute(v[c], v[c + 1], v[c + 16], v[c + 17], v[c + 32], v[c + 33], v[c + 48], v[c + 49],
+            v[c + 64], v[c + 65], v[c + 80], v[c + 81], v[c + 96], v[c + 97], v[c + 112], v[c + 113]);
+    }
+
+    for (size_t i = 0; i < block_words; i++)
+    {
+        next.v[i] = result.v[i] ^ r.v[i];
+    }
+}
+
+class argon2_instance
+{
+public:
+    argon2_instance(unsigned int time_cost, unsigned int memory_cost, unsigned int lanes)
+    : m_passes(time_cost)
+    , m_lanes(lanes)
+    , m_lane_length((memory_cost / (sync_points * lanes)) * sync_points)
+    , m_segment_length(m_lane_length / sync_points)
+    , m_memory(static_cast<size_t>(m_lane_length) * lanes)
+    {
+    }
+
+    ~argon2_instance()
+    {
+        OPENSSL_cleanse(m_memory.data(), m_memory.size() * sizeof(block));
+    }
+
+    void initialize(unsigned char const * h0)
+    {
+        unsigned char input[blake2b::max_output_size + 8];
+        memcpy(input, h0, blake2b::max_output_size);
+
+        unsigned char bytes[block_bytes];
+        for (uint32_t lane = 0; lane < m_lanes; lane++)
+        {
+            for (uint32_t column = 0; column < 2; column++)
+            {
+                store32(&input[blake2b::max_output_size], column);
+                store32(&input[blake2b::max_output_size + 4], lane);
+                hash_long(input, sizeof(input), bytes, block_bytes);
+
+                block & b = at(lane, column);
+                for (size_t i = 0; i < block_words; i++)
+                {
+                    b.v[i] = load64(&bytes[i * 8]);
+                }
+            }
+        }
+        OPENSSL_cleanse(input, sizeof(input));
+        OPENSSL_cleanse(bytes, sizeof(bytes));
+    }
+
+    void fill(unsigned int threads)
+    {
+        for (uint32_t pass = 0; pass < m_passes; pass++)
+        {
+            for (uint32_t slice = 0; slice < sync_points; slice++)
+            {
+                // segments of the same slice are independent of each other
+                parallel_for(m_lanes, threads, [this, pass, slice](size_t lane)
+                {
+                    fill_segment(pass, static_cast<uint32_t>(lane), slice);
+                });
+            }
+        }
+    }
+
+    void finalize(unsigned char * out, size_t out_size)
+    {
+        block result = at(0, m_lane_length - 1);
+        for (uint32_t lane = 1; lane < m_lanes; lane++)
+        {
+            block const & last = at(lane, m_lane_length - 1);
+            for (size_t i = 0; i < block_words; i++)
+            {
+                result.v[i] ^= last.v[i];
+            }
+        }
+
+        unsigned char bytes[block_bytes];
+        for (size_t i = 0; i < block_words; i++)
+        {
+            store64(&bytes[i * 8], result.v[i]);
+        }
+        hash_long(bytes, sizeof(bytes), out, out_size);
+        OPENSSL_cleanse(bytes, sizeof(bytes));
+        OPENSSL_cleanse(&result, sizeof(result));
+    }
+
+private:
+    block & at(uint32_t lane, uint32_t column)
+    {
+        return m_memory[static_cast<size_t>(lane) * m_lane_length + column];
+    }
+
+    uint32_t reference_index(uint32_t pass, uint32_t slice, uint32_t index, uint32_t pseudo_rand, bool same_lane) const
+    {
+        uint32_t area_size;
+        if (pass == 0)
+        {
+            if (slice == 0)
+            {
+                area_size = index - 1;
+            }
+            else if (same_lane)
+            {
+                area_size = slice * m_segment_length + index - 1;
+            }
+            else
+            {
+                area_size = slice * m_segment_length - ((index == 0) ? 1 : 0);
+            }
+        }
+        else
+        {
+            if (same_lane)
+            {
+                area_size = m_lane_length - m_segment_length + index - 1;
+            }
+            else
+            {
+                area_size = m_lane_length - m_segment_length - ((index == 0) ? 1 : 0);
+            }
+        }
+
+        uint64_t relative = pseudo_rand;
+        relative = (relative * relative) >> 32;
+        relative = area_size - 1 - ((area_size * relative) >> 32);
+
+        uint32_t const start = ((pass != 0) && (slice != sync_points - 1)) ? (slice + 1) * m_segment_length : 0;
+        return static_cast<uint32_t>((start + relative) % m_lane_length);
+    }
+
+    void fill_segment(uint32_t pass, uint32_t lane, uint32_t slice)
+    {
+        // Argon2id uses data-independent addressing in the first half of the first pass
+        bool const is_data_independent = (pass == 0) && (slice < sync_points / 2);
+
+        block zero = {};
+        block input = {};
+        block addresses = {};
+        if (is_data_independent)
+        {
+            input.v[0] = pass;
+            input.v[1] = lane;
+            input.v[2] = slice;
+            input.v[3] = m_memory.size();
+            input.v[4] = m_passes;
+            input.v[5] = argon2_type_id;
+        }
+
+        auto const next_addresses = [&]()
+        {
+            input.v[6]++;
+            fill_block(zero, input, addresses, false);
+            fill_block(zero, addresses, addresses, false);
+        };
+
+        uint32_t start = 0;
+        if ((pass == 0) && (slice == 0))
+        {
+            start = 2;
+            if (is_data_independent)
+            {
+                next_addresses();
+            }
+        }
+
+        for (uint32_t index = start; index < m_segment_length; index++)
+        {
+            uint32_t const column = slice * m_segment_length + index;
+            uint32_t const previous_column = (column == 0) ? (m_lane_length - 1) : (column - 1);
+
+            uint64_t pseudo_rand;
+            if (is_data_independent)
+            {
+                if ((index % block_words) == 0)
+                {
+                    next_addresses();
+                }
+                pseudo_rand = addresses.v[index % block_words];
+            }
+            else
+            {
+                pseudo_rand = at(lane, previous_column).v[0];
+            }
+
+            uint32_t reference_lane = static_cast<uint32_t>((pseudo_rand >> 32) % m_lanes);
+            if ((pass == 0) && (slice == 0))
+            {
+                reference_lane = lane;
+            }
+
+            uint32_t const reference_column = reference_index(pass, slice, index,
+                static_cast<uint32_t>(pseudo_rand & 0xffffffff), reference_lane == lane);
+
+            fill_block(at(lane, previous_column), at(reference_lane, reference_column), at(lane, column), pass != 0);
+        }
+    }
+
+    uint32_t m_passes;
+    uint32_t m_lanes;
+    uint32_t m_lane_length;
+    uint32_t m_segment_length;
+    std::vector<block> m_memory;
+};
+
+void check_params(
+    std::string const & salt,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes)
+{
+    if ((lanes < 1) || (lanes > 0xffffff))
+    {
+        throw std::invalid_argument("invalid argon2 lanes");
+    }
+
+    if (time_cost < 1)
+    {
+        throw std::invalid_argument("invalid argon2 time cost");
+    }
+
+    if ((memory_cost < 8 * lanes) || (memory_cost > max_argon2_memory_cost))
+    {
+        throw std::invalid_argument("invalid argon2 memory cost");
+    }
+
+    if (salt.size() < 8)
+    {
+        throw std::invalid_argument("argon2 salt too short");
+    }
+}
+
+unsigned int default_threads(unsigned int lanes)
+{
+    unsigned int const cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::min(lanes, cores);
+}
+
+#if defined(OSSL_KDF_PARAM_ARGON2_LANES)
+
+// OpenSSL 3.2 and later provide Argon2id; nullptr if not provided
+EVP_KDF * fetch_argon2id()
+{
+    static auto const kdf = []()
+    {
+        EVP_KDF * raw_kdf = EVP_KDF_fetch(nullptr, "ARGON2ID", nullptr);
+        if (nullptr == raw_kdf)
+        {
+            ERR_clear_error();
+        }
+        return std::unique_ptr<EVP_KDF, void (*) (EVP_KDF*)>(raw_kdf, EVP_KDF_free);
+    }();
+
+    return kdf.get();
+}
+
+bool openssl_argon2id(
+    std::string const & password,
+    std::string const & salt,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes,
+    char * key)
+{
+    EVP_KDF * kdf = fetch_argon2id();
+    if (nullptr == kdf)
+    {
+        return false;
+    }
+
+    EVP_KDF_CTX * raw_ctx = EVP_KDF_CTX_new(kdf);
+    if (nullptr == raw_ctx)
+    {
+        throw openssl_error();
+    }
+    auto ctx = std::unique_ptr<EVP_KDF_CTX, void (*) (EVP_KDF_CTX*)>(raw_ctx, EVP_KDF_CTX_free);
+
+    // OpenSSL only uses threads up to the process-wide limit
+    uint32_t threads = default_threads(lanes);
+    if (OSSL_get_max_threads(nullptr) < threads)
+    {
+        OSSL_set_max_threads(nullptr, threads);
+    }
+    threads = std::max<uint32_t>(1, std::min<uint64_t>(threads, OSSL_get_max_threads(nullptr)));
+
+    uint32_t iterations = time_cost;
+    uint32_t memory = memory_cost;
+    uint32_t parallelism = lanes;
+    OSSL_PARAM const params[] =
+    {
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, const_cast<char*>(password.data()), password.size()),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, const_cast<char*>(salt.data()), salt.size()),
+        OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ITER, &iterations),
+        OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_MEMCOST, &memory),
+        OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_LANES, &parallelism),
+        OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_THREADS, &threads),
+        OSSL_PARAM_construct_end()
+    };
+
+    int const rc = EVP_KDF_derive(ctx.get(), reinterpret_cast<unsigned char*>(key), key_size, params);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    return true;
+}
+
+#endif
+
+void derive_native(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & secret,
+    std::string const & associated_data,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes,
+    unsigned int threads,
+    unsigned char * tag,
+    size_t tag_size)
+{
+    unsigned char h0[blake2b::max_output_size];
+    {
+        blake2b hash(blake2b::max_output_size);
+        hash.update_u32(lanes);
+        hash.update_u32(static_cast<uint32_t>(tag_size));
+        hash.update_u32(memory_cost);
+        hash.update_u32(time_cost);
+        hash.update_u32(argon2_version);
+        hash.update_u32(argon2_type_id);
+        hash.update_u32(static_cast<uint32_t>(password.size()));
+        hash.update(password.data(), password.size());
+        hash.update_u32(static_cast<uint32_t>(salt.size()));
+        hash.update(salt.data(), salt.size());
+        hash.update_u32(static_cast<uint32_t>(secret.size()));
+        hash.update(secret.data(), secret.size());
+        hash.update_u32(static_cast<uint32_t>(associated_data.size()));
+        hash.update(associated_data.data(), associated_data.size());
+        hash.finalize(h0);
+    }
+
+    argon2_instance instance(time_cost, memory_cost, lanes);
+    instance.initialize(h0);
+    OPENSSL_cleanse(h0, sizeof(h0));
+
+    instance.fill(threads);
+    instance.finalize(tag, tag_size);
+}
+
+}
+
+std::string argon2id_native(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & secret,
+    std::string const & associated_data,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes,
+    size_t tag_size,
+    unsigned int threads)
+{
+    check_params(salt, time_cost, memory_cost, lanes);
+
+    std::string tag(tag_size, '\0');
+    derive_native(password, salt, secret, associated_data, time_cost, memory_cost, lanes, threads,
+        reinterpret_cast<unsigned char*>(&tag[0]), tag_size);
+    return tag;
+}
+
+void argon2id(
+    std::string const & password,
+    std::string const & salt,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes,
+    char * key)
+{
+    check_params(salt, time_cost, memory_cost, lanes);
+
+#if defined(OSSL_KDF_PARAM_ARGON2_LANES)
+    if (openssl_argon2id(password, salt, time_cost, memory_cost, lanes, key))
+    {
+        return;
+    }
+#endif
+
+    derive_native(password, salt, "", "", time_cost, memory_cost, lanes, default_threads(lanes),
+        reinterpret_cast<unsigned char*>(key), key_size);
+}
+
+std::string argon2id(
+    std::string const & password,
+    std::string const & salt,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes)
+{
+    std::string key(key_size, '\0');
+    argon2id(password, salt, time_cost, memory_cost, lanes, &key[0]);
+    return key;
+}
+
+argon2_cost calibrate_argon2id(
+    std::chrono::milliseconds target,
+    unsigned int lanes,
+    unsigned int max_memory_cost)
+{
+    std::string const salt(argon2_salt_size, 's');
+    argon2_cost cost = {1, std::max(argon2_min_calibration_memory_cost, 8 * lanes)};
+    max_memory_cost = std::max(std::min(max_memory_cost, max_argon2_memory_cost), cost.memory_cost);
+
+    auto const measure = [&]()
+    {
+        auto const start = std::chrono::steady_clock::now();
+        argon2id("calibration", salt, cost.time_cost, cost.memory_cost, lanes);
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    };
+
+    // the duration grows about linearly in memory and passes
+    auto duration = measure();
+    while ((duration * 2 <= target) && (cost.memory_cost <= max_memory_cost / 2))
+    {
+        cost.memory_cost *= 2;
+        duration = measure();
+    }
+
+    if (duration.count() > 0)
+    {
+        auto const passes = std::chrono::duration_cast<std::chrono::microseconds>(target).count() / duration.count();
+        cost.time_cost = static_cast<unsigned int>(std::max<long long>(1, passes));
+    }
+
+    return cost;
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef AES256GCM_ARGON2_HPP
+#define AES256GCM_ARGON2_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace aes256gcm
+{
+
+/// @brief In-project Argon2id (RFC 9106, version 0x13).
+///
+/// Exposes the optional secret and associated data of RFC 9106, which are
+/// not used by the file format, e.g. to check the RFC's test vectors.
+///
+/// @param threads number of threads filling lanes in parallel
+std::string argon2id_native(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & secret,
+    std::string const & associated_data,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes,
+    size_t tag_size,
+    unsigned int threads);
+
+/// @brief Derives a key using Argon2id (see argon2id) into a buffer of key_size bytes.
+void argon2id(
+    std::string const & password,
+    std::string const & salt,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes,
+    char * key);
+
+}
+
+#endif
@@ -0,0 +1,173 @@
+#include "aes256gcm/cipher.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/openssl_error.hpp"
+
+#include <openssl/err.h>
+
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+struct aead_entry
+{
+    char const * name;
+    char const * cipher_name;
+    bool single_update;
+};
+
+constexpr aead_entry const aeads[] =
+{
+    {algorithm_aes256_gcm, "AES-256-GCM", false},
+    {algorithm_chacha20_poly1305, "ChaCha20-Poly1305", false},
+    {algorithm_aes256_ocb, "AES-256-OCB", false},
+    // the synthetic IV is computed from the whole message, so OpenSSL
+    // accepts only a single update per message
+    {algorithm_aes256_gcm_siv, "AES-256-GCM-SIV", true}
+};
+
+constexpr size_t const aead_count = sizeof(aeads) / sizeof(aeads[0]);
+
+struct cipher_deleter
+{
+    void operator()(EVP_CIPHER * cipher) const
+    {
+        EVP_CIPHER_free(cipher);
+    }
+};
+
+size_t find_aead(std::string const & name)
+{
+    for (size_t i = 0; i < aead_count; i++)
+    {
+        if (name == aeads[i].name)
+        {
+            return i;
+        }
+    }
+
+    return aead_count;
+}
+
+EVP_CIPHER const * fetch(size_t index)
+{
+    static std::once_flag once[aead_count];
+    static std::unique_ptr<EVP_CIPHER, cipher_deleter> ciphers[aead_count];
+
+    // unavailable algorithms are looked up once as well
+    std::call_once(once[index], [index]()
+    {
+        ciphers[index].reset(EVP_CIPHER_fetch(nullptr, aeads[index].cipher_name, nullptr));
+        if (nullptr == ciphers[index])
+        {
+            ERR_clear_error();
+        }
+    });
+
+    return ciphers[index].get();
+}
+
+bool has_hardware_aes()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul");
+#elif defined(__aarch64__)
+    auto const hwcap = getauxval(AT_HWCAP);
+    return ((hwcap & HWCAP_AES) != 0) && ((hwcap & HWCAP_PMULL) != 0);
+#else
+    return false;
+#endif
+}
+
+std::string to_upper(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+    {
+        return static_cast<char>(std::toupper(c));
+    });
+    return value;
+}
+
+}
+
+EVP_CIPHER const * find_aead_cipher(std::string const & name)
+{
+    size_t const index = find_aead(name);
+    return (index < aead_count) ? fetch(index) : nullptr;
+}
+
+EVP_CIPHER const * aead_cipher(std::string const & name)
+{
+    size_t const index = find_aead(name);
+    if (index == aead_count)
+    {
+        throw std::invalid_argument("unknown algorithm: " + name);
+    }
+
+    auto const * cipher = fetch(index);
+    if (nullptr == cipher)
+    {
+        throw std::runtime_error("algorithm not available: " + name);
+    }
+
+    return cipher;
+}
+
+EVP_CIPHER const * aes256gcm_cipher()
+{
+    auto const * cipher = fetch(0);
+    if (nullptr == cipher)
+    {
+        throw openssl_error();
+    }
+
+    return cipher;
+}
+
+std::vector<std::string> aead_algorithms()
+{
+    std::vector<std::string> result;
+    for (auto const & entry: aeads)
+    {
+        result.push_back(entry.name);
+    }
+    return result;
+}
+
+bool is_aead_available(std::string const & name)
+{
+    return (nullptr != find_aead_cipher(name));
+}
+
+bool is_single_update_aead(std::string const & name)
+{
+    size_t const index = find_aead(name);
+    return (index < aead_count) && aeads[index].single_update;
+}
+
+std::string select_aead(std::string const & name)
+{
+    auto const upper = to_upper(name);
+    if (upper == "AUTO")
+    {
+        return has_hardware_aes() ? algorithm_aes256_gcm : algorithm_chacha20_poly1305;
+    }
+
+    aead_cipher(upper);
+    return upper;
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef AES256GCM_CIPHER_HPP
+#define AES256GCM_CIPHER_HPP
+
+#include <openssl/evp.h>
+
+#include <string>
+
+namespace aes256gcm
+{
+
+/// @brief Returns the OpenSSL cipher implementing an AEAD algorithm.
+///
+/// Ciphers are fetched explicitly once per process, so that creating
+/// contexts does not pay for an implicit fetch each time.
+///
+/// @param name name of the algorithm, as stored in the encryption info
+/// @return cipher or nullptr, if the algorithm is unknown or not provided
+EVP_CIPHER const * find_aead_cipher(std::string const & name);
+
+/// @brief Returns the OpenSSL cipher implementing an AEAD algorithm.
+///
+/// @throws An invalid_argument is thrown on unknown algorithms.
+///         A runtime_error is thrown if the algorithm is not available.
+EVP_CIPHER const * aead_cipher(std::string const & name);
+
+/// @brief Returns the AES256-GCM cipher implementation.
+///
+/// @throws An openssl_error is thrown if the cipher cannot be fetched.
+EVP_CIPHER const * aes256gcm_cipher();
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef AES256GCM_CODEC_HPP
+#define AES256GCM_CODEC_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace aes256gcm
+{
+
+/// @brief Returns the level used if no level is given (level 0).
+/// @param codec canonical name of the codec (see compression.hpp)
+int default_compression_level(std::string const & codec);
+
+/// @brief Compresses a single block.
+///
+/// @param codec canonical name of the codec
+/// @param level compression level; 0 selects the default level
+/// @param in data to compress
+/// @param size size of data
+/// @param out buffer to store the compressed block
+/// @param capacity size of out
+/// @return size of the compressed block or 0 if it does not fit into out
+/// @throws An invalid_argument is thrown on invalid levels (see check_compression_level).
+///         A runtime_error is thrown if the codec is not available or fails.
+size_t compress_block(
+    std::string const & codec,
+    int level,
+    char const * in,
+    size_t size,
+    char * out,
+    size_t capacity);
+
+/// @brief Decompresses a single block of known size.
+///
+/// @param codec canonical name of the codec
+/// @param in compressed block
+/// @param size size of the compressed block
+/// @param out buffer to store the decompressed block
+/// @param raw_size size of the decompressed block
+/// @return true, if the block was decompressed to exactly raw_size bytes
+/// @throws A runtime_error is thrown if the codec is not available.
+bool decompress_block(
+    std::string const & codec,
+    char const * in,
+    size_t size,
+    char * out,
+    size_t raw_size);
+
+}
+
+#endif
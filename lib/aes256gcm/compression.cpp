@@ -0,0 +1,242 @@
+#include "aes256gcm/compression.hpp"
+#include "aes256gcm/codec.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+#if defined(AES256GCM_HAVE_ZSTD)
+#include <zstd.h>
+#include <zstd_errors.h>
+#endif
+
+#if defined(AES256GCM_HAVE_LZ4)
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#if defined(AES256GCM_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+// codecs are optional dependencies, see CMakeLists.txt
+struct codec_entry
+{
+    char const * name;
+    bool available;
+    int default_level;
+    int min_level;
+    int max_level;
+};
+
+constexpr codec_entry const codecs[] =
+{
+#if defined(AES256GCM_HAVE_ZSTD)
+    {compression_zstd, true, 3, 1, 22},
+#else
+    {compression_zstd, false, 0, 1, 22},
+#endif
+#if defined(AES256GCM_HAVE_LZ4)
+    {compression_lz4, true, 1, 1, 12},
+#else
+    {compression_lz4, false, 0, 1, 12},
+#endif
+#if defined(AES256GCM_HAVE_ZLIB)
+    {compression_zlib, true, 6, 1, 9},
+#else
+    {compression_zlib, false, 0, 1, 9},
+#endif
+};
+
+std::string to_upper(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+    {
+        return static_cast<char>(std::toupper(c));
+    });
+    return value;
+}
+
+codec_entry const * find_codec(std::string const & name)
+{
+    for (auto const & entry: codecs)
+    {
+        if (name == entry.name)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+codec_entry const & available_codec(std::string const & name)
+{
+    auto const * entry = find_codec(name);
+    if ((nullptr == entry) || (!entry->available))
+    {
+        throw std::runtime_error("compression not available: " + name);
+    }
+    return *entry;
+}
+
+}
+
+std::vector<std::string> compression_codecs()
+{
+    std::vector<std::string> result;
+    for (auto const & entry: codecs)
+    {
+        result.emplace_back(entry.name);
+    }
+    return result;
+}
+
+bool is_compression_available(std::string const & name)
+{
+    auto const * entry = find_codec(to_upper(name));
+    return (nullptr != entry) && (entry->available);
+}
+
+std::string select_compression(std::string const & name)
+{
+    auto const upper = to_upper(name);
+    if (nullptr == find_codec(upper))
+    {
+        throw std::invalid_argument("unknown compression: " + name);
+    }
+
+    available_codec(upper);
+    return upper;
+}
+
+void check_compression_level(std::string const & codec, int level)
+{
+    auto const & entry = available_codec(codec);
+    if ((level != 0) && ((level < entry.min_level) || (level > entry.max_level)))
+    {
+        throw std::invalid_argument("invalid compression level for " + codec + ": " + std::to_string(level)
+            + " (" + std::to_string(entry.min_level) + "-" + std::to_string(entry.max_level) + ")");
+    }
+}
+
+int default_compression_level(std::string const & codec)
+{
+    return available_codec(codec).default_level;
+}
+
+size_t compress_block(
+    std::string const & codec,
+    int level,
+    char const * in,
+    size_t size,
+    char * out,
+    size_t capacity)
+{
+    check_compression_level(codec, level);
+    if (level == 0)
+    {
+        level = available_codec(codec).default_level;
+    }
+
+#if defined(AES256GCM_HAVE_ZSTD)
+    if (codec == compression_zstd)
+    {
+        size_t const result = ZSTD_compress(out, capacity, in, size, level);
+        if (ZSTD_isError(result))
+        {
+            if (ZSTD_getErrorCode(result) == ZSTD_error_dstSize_tooSmall)
+            {
+                return 0;
+            }
+            throw std::runtime_error(std::string("failed to compress block: ") + ZSTD_getErrorName(result));
+        }
+        return result;
+    }
+#endif
+
+#if defined(AES256GCM_HAVE_LZ4)
+    if (codec == compression_lz4)
+    {
+        // level 1 is LZ4's fast mode, higher levels use LZ4 HC; both write
+        // the same block format. LZ4 fails only if the output does not fit.
+        int const result = (level == 1)
+            ? LZ4_compress_default(in, out, static_cast<int>(size), static_cast<int>(capacity))
+            : LZ4_compress_HC(in, out, static_cast<int>(size), static_cast<int>(capacity), level);
+        return (result > 0) ? static_cast<size_t>(result) : 0;
+    }
+#endif
+
+#if defined(AES256GCM_HAVE_ZLIB)
+    if (codec == compression_zlib)
+    {
+        uLongf result = static_cast<uLongf>(capacity);
+        int const rc = compress2(reinterpret_cast<Bytef*>(out), &result,
+            reinterpret_cast<Bytef const*>(in), static_cast<uLong>(size), level);
+        if (rc == Z_BUF_ERROR)
+        {
+            return 0;
+        }
+        if (rc != Z_OK)
+        {
+            throw std::runtime_error("failed to compress block: zlib error " + std::to_string(rc));
+        }
+        return static_cast<size_t>(result);
+    }
+#endif
+
+    (void) level;
+    (void) in;
+    (void) size;
+    (void) out;
+    (void) capacity;
+    throw std::runtime_error("compression not available: " + codec);
+}
+
+bool decompress_block(
+    std::string const & codec,
+    char const * in,
+    size_t size,
+    char * out,
+    size_t raw_size)
+{
+#if defined(AES256GCM_HAVE_ZSTD)
+    if (codec == compression_zstd)
+    {
+        size_t const result = ZSTD_decompress(out, raw_size, in, size);
+        return (!ZSTD_isError(result)) && (result == raw_size);
+    }
+#endif
+
+#if defined(AES256GCM_HAVE_LZ4)
+    if (codec == compression_lz4)
+    {
+        int const result = LZ4_decompress_safe(in, out, static_cast<int>(size), static_cast<int>(raw_size));
+        return (result >= 0) && (static_cast<size_t>(result) == raw_size);
+    }
+#endif
+
+#if defined(AES256GCM_HAVE_ZLIB)
+    if (codec == compression_zlib)
+    {
+        uLongf result = static_cast<uLongf>(raw_size);
+        int const rc = uncompress(reinterpret_cast<Bytef*>(out), &result,
+            reinterpret_cast<Bytef const*>(in), static_cast<uLong>(size));
+        return (rc == Z_OK) && (result == raw_size);
+    }
+#endif
+
+    (void) in;
+    (void) size;
+    (void) out;
+    (void) raw_size;
+    throw std::runtime_error("compression not available: " + codec);
+}
+
+}
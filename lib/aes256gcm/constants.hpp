@@ -14,6 +14,28 @@ constexpr unsigned int const kdf_iterations = 2048;
 constexpr char const kdf_digest[] = "sha256";
 constexpr char const pbkdf2_algorithm[] = "PBKDF2";
 constexpr char const encryption_method[] = "AES256-GCM";
+
+// maximum size passed to a single OpenSSL update call (sizes are int)
+constexpr size_t const max_update_size = 1024 * 1024 * 1024;
+
+// largest block size of the supported algorithms; streaming buffers are
+// multiples of it, so that only the last chunk may end in a partial block
+constexpr size_t const max_block_size = 16;
+
+// Argon2id defaults (RFC 9106, second recommended option) and limits;
+// memory costs are given in KiB
+constexpr size_t const argon2_salt_size = 16;
+constexpr unsigned int const argon2_time_cost = 3;
+constexpr unsigned int const argon2_memory_cost = 64 * 1024;
+constexpr unsigned int const argon2_max_default_lanes = 16;
+constexpr unsigned int const argon2_min_calibration_memory_cost = 8 * 1024;
+constexpr unsigned int const max_argon2_memory_cost = 4 * 1024 * 1024;
+
+// number of derived keys kept by pbkdf2
+constexpr size_t const kdf_cache_capacity = 16;
+
+// number of keys per thread kept by the context pool
+constexpr size_t const context_pool_capacity = 8;
     
 }
 
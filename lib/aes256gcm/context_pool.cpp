@@ -0,0 +1,145 @@
+#include "aes256gcm/context_pool.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/openssl_error.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+secure_buffer const & key_id_secret()
+{
+    static secure_buffer const secret = []()
+    {
+        auto buffer = secure_pool::instance().allocate_key(key_size);
+        if (1 != RAND_bytes(reinterpret_cast<unsigned char*>(buffer.get()), static_cast<int>(key_size)))
+        {
+            throw openssl_error();
+        }
+        return buffer;
+    }();
+
+    return secret;
+}
+
+template <typename Context>
+class context_pool
+{
+public:
+    template <typename Create, typename Reset>
+    Context & get(std::string const & key_id, std::string const & algorithm, Create create, Reset reset)
+    {
+        m_clock++;
+
+        for (auto & entry: m_entries)
+        {
+            if ((entry.key_id == key_id) && (entry.algorithm == algorithm))
+            {
+                entry.last_used = m_clock;
+                reset(*entry.context);
+                return *entry.context;
+            }
+        }
+
+        auto context = create();
+        if (m_entries.size() < context_pool_capacity)
+        {
+            m_entries.push_back({key_id, algorithm, std::move(context), m_clock});
+            return *m_entries.back().context;
+        }
+
+        auto * oldest = &m_entries.front();
+        for (auto & entry: m_entries)
+        {
+            if (entry.last_used < oldest->last_used)
+            {
+                oldest = &entry;
+            }
+        }
+        *oldest = {key_id, algorithm, std::move(context), m_clock};
+        return *oldest->context;
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+    }
+
+private:
+    struct entry
+    {
+        std::string key_id;
+        std::string algorithm;
+        std::unique_ptr<Context> context;
+        uint64_t last_used;
+    };
+
+    std::vector<entry> m_entries;
+    uint64_t m_clock = 0;
+};
+
+thread_local context_pool<encrypter> encrypters;
+thread_local context_pool<decrypter> decrypters;
+
+}
+
+std::string context_key_id(std::string_view key)
+{
+    auto const & secret = key_id_secret();
+
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_size = 0;
+    auto const * result = HMAC(EVP_sha256(),
+        secret.get(), static_cast<int>(secret.size()),
+        reinterpret_cast<unsigned char const*>(key.data()), key.size(),
+        hash, &hash_size);
+    if (nullptr == result)
+    {
+        throw openssl_error();
+    }
+
+    return std::string(reinterpret_cast<char const*>(hash), hash_size);
+}
+
+encrypter & pooled_encrypter(
+    std::string const & key_id,
+    std::string_view key,
+    std::string const & nonce,
+    std::string const & additional_data,
+    std::string const & algorithm)
+{
+    return encrypters.get(key_id, algorithm,
+        [&]() { return std::make_unique<encrypter>(key, nonce, additional_data, algorithm); },
+        [&](encrypter & enc) { enc.reset(nonce, additional_data); });
+}
+
+decrypter & pooled_decrypter(
+    std::string const & key_id,
+    std::string_view key,
+    std::string const & nonce,
+    std::string const & tag,
+    std::string const & additional_data,
+    std::string const & algorithm)
+{
+    return decrypters.get(key_id, algorithm,
+        [&]() { return std::make_unique<decrypter>(key, nonce, tag, additional_data, algorithm); },
+        [&](decrypter & dec) { dec.reset(nonce, tag, additional_data); });
+}
+
+void context_pool_clear()
+{
+    encrypters.clear();
+    decrypters.clear();
+}
+
+}
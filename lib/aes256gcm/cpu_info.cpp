@@ -0,0 +1,102 @@
+#include "aes256gcm/cpu_info.hpp"
+#include "aes256gcm/native_gcm.hpp"
+#include "aes256gcm/native_dispatch.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+#if defined(__x86_64__) || defined(__i386__)
+
+uint64_t read_xcr0()
+{
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+cpu_features detect() noexcept
+{
+    cpu_features result = {};
+
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    if (0 == __get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return result;
+    }
+
+    result.aes = (ecx & bit_AES) != 0;
+    result.pclmulqdq = (ecx & bit_PCLMUL) != 0;
+
+    bool const has_xsave = ((ecx & bit_OSXSAVE) != 0) && ((ecx & bit_AVX) != 0);
+    uint64_t const xcr0 = has_xsave ? read_xcr0() : 0;
+    bool const has_avx_state = (xcr0 & 0x06) == 0x06;          // XMM, YMM
+    bool const has_avx512_state = (xcr0 & 0xe6) == 0xe6;       // XMM, YMM, opmask, ZMM
+
+    if (0 == __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return result;
+    }
+
+    result.avx2 = has_avx_state && ((ebx & bit_AVX2) != 0);
+    result.avx512f = has_avx512_state && ((ebx & bit_AVX512F) != 0);
+    result.avx512bw = has_avx512_state && ((ebx & bit_AVX512BW) != 0);
+    result.vaes = has_avx_state && ((ecx & bit_VAES) != 0);
+    result.vpclmulqdq = has_avx_state && ((ecx & bit_VPCLMULQDQ) != 0);
+
+    return result;
+}
+
+#else
+
+cpu_features detect() noexcept
+{
+    return {};
+}
+
+#endif
+
+}
+
+cpu_features const & detect_cpu_features() noexcept
+{
+    static cpu_features const features = detect();
+    return features;
+}
+
+bool native_gcm::is_supported() noexcept
+{
+#if defined(__x86_64__)
+    auto const & features = detect_cpu_features();
+    return features.aes && features.pclmulqdq && features.avx512f && features.avx512bw
+        && features.vaes && features.vpclmulqdq;
+#else
+    return false;
+#endif
+}
+
+bool use_native_gcm() noexcept
+{
+    static bool const result = (nullptr == std::getenv("AES256GCM_DISABLE_NATIVE")) && native_gcm::is_supported();
+    return result;
+}
+
+std::string gcm_implementation()
+{
+    return use_native_gcm() ? "native-vaes-avx512" : "openssl";
+}
+
+}
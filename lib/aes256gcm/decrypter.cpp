@@ -3,16 +3,28 @@
 #include "aes256gcm/pbkdf2.hpp"
 #include "aes256gcm/openssl_error.hpp"
 #include "aes256gcm/constants.hpp"
+#include "aes256gcm/cipher.hpp"
+#include "aes256gcm/native_gcm.hpp"
+#include "aes256gcm/native_dispatch.hpp"
+
+#include <openssl/crypto.h>
+
+#include <algorithm>
 
 namespace aes256gcm
 {
 
 decrypter::decrypter(
-    std::string const & key,
+    std::string_view key,
     std::string const & nonce,
     std::string const & tag,
-    std::string const & additional_data)
+    std::string const & additional_data,
+    std::string const & algorithm)
 : m_ctx(nullptr, EVP_CIPHER_CTX_free)
+, m_native(nullptr, native_gcm::free)
+, m_block_size(1)
+, m_is_finalized(false)
+, m_is_authentic(false)
 {
     if (key.size() != key_size)
     {
@@ -29,6 +41,17 @@ decrypter::decrypter(
         throw std::logic_error("invalid tag size");
     }
 
+    auto const * cipher = aead_cipher(algorithm);
+    m_block_size = EVP_CIPHER_get_block_size(cipher);
+
+    if ((cipher == aes256gcm_cipher()) && (use_native_gcm()))
+    {
+        m_native.reset(new native_gcm(key.data()));
+        m_native->start(nonce.data(), additional_data.data(), additional_data.size());
+        m_tag = tag;
+        return;
+    }
+
     EVP_CIPHER_CTX * raw_ctx = EVP_CIPHER_CTX_new();
     if (nullptr == raw_ctx)
     {
@@ -36,7 +59,7 @@ decrypter::decrypter(
     }
     m_ctx.reset(raw_ctx);
 
-    int rc = EVP_DecryptInit_ex(m_ctx.get(), EVP_aes_256_gcm(), nullptr, 
+    int rc = EVP_DecryptInit_ex(m_ctx.get(), cipher, nullptr, 
         reinterpret_cast<unsigned char const*>(key.data()), 
         reinterpret_cast<unsigned char const *>(nonce.data()));
     if (rc != 1)
@@ -44,16 +67,63 @@ decrypter::decrypter(
         throw openssl_error();
     }
 
-    rc = EVP_CIPHER_CTX_ctrl(m_ctx.get(), EVP_CTRL_GCM_SET_TAG, tag.size(), 
+    set_tag(tag);
+    add_additional_data(additional_data);
+}
+
+void decrypter::reset(
+    std::string const & nonce,
+    std::string const & tag,
+    std::string const & additional_data)
+{
+    if (nonce.size() != nonce_size)
+    {
+        throw std::logic_error("invalid nonce size");
+    }
+
+    if (tag.size() != tag_size)
+    {
+        throw std::logic_error("invalid tag size");
+    }
+
+    m_is_finalized = false;
+    m_is_authentic = false;
+
+    if (m_native)
+    {
+        m_native->start(nonce.data(), additional_data.data(), additional_data.size());
+        m_tag = tag;
+        return;
+    }
+
+    // passing no cipher and no key keeps the key schedule
+    int const rc = EVP_DecryptInit_ex(m_ctx.get(), nullptr, nullptr, nullptr,
+        reinterpret_cast<unsigned char const *>(nonce.data()));
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    set_tag(tag);
+    add_additional_data(additional_data);
+}
+
+void decrypter::set_tag(std::string const & tag)
+{
+    int const rc = EVP_CIPHER_CTX_ctrl(m_ctx.get(), EVP_CTRL_AEAD_SET_TAG, tag.size(), 
         const_cast<char*>(tag.data()));
     if (rc != 1)
     {
         throw openssl_error();
     }
+}
 
+void decrypter::add_additional_data(std::string const & additional_data)
+{
     if (!additional_data.empty())
     {
-        rc = EVP_DecryptUpdate(m_ctx.get(), nullptr, 0, 
+        int out_size = 0;
+        int const rc = EVP_DecryptUpdate(m_ctx.get(), nullptr, &out_size, 
             reinterpret_cast<unsigned char const*>(additional_data.data()),
             additional_data.size());
         if (rc != 1)
@@ -65,44 +135,88 @@ decrypter::decrypter(
 
 void decrypter::update(char const * in, char * out, size_t size)
 {
-    int out_size = static_cast<int>(size);
+    if ((m_is_finalized) && (size > 0))
+    {
+        throw std::logic_error("update after partial block");
+    }
 
-    int const rc = EVP_DecryptUpdate(m_ctx.get(), 
-        reinterpret_cast<unsigned char*>(out), &out_size, 
-        reinterpret_cast<unsigned char const*>(in), size);
-    if (rc != 1)
+    if (m_native)
     {
-        throw openssl_error();
+        m_native->decrypt(in, out, size);
+        return;
     }
 
-    if (size != out_size)
+    // block based algorithms buffer a trailing partial block until
+    // finalization, which would leave the output buffer incomplete
+    size_t const partial_size = size % m_block_size;
+    size -= partial_size;
+
+    for (size_t pos = 0; pos < size; pos += max_update_size)
     {
-        throw std::runtime_error("output buffer size mismatch");
+        int const chunk_size = static_cast<int>(std::min(max_update_size, size - pos));
+        int out_size = chunk_size;
+
+        int const rc = EVP_DecryptUpdate(m_ctx.get(), 
+            reinterpret_cast<unsigned char*>(&out[pos]), &out_size, 
+            reinterpret_cast<unsigned char const*>(&in[pos]), chunk_size);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+
+        if (chunk_size != out_size)
+        {
+            throw std::runtime_error("output buffer size mismatch");
+        }
+    }
+
+    if (partial_size > 0)
+    {
+        finalize_partial_block(&in[size], &out[size], partial_size);
     }
 }
 
-void decrypter::update_inplace(char * buffer, size_t buffer_size)
+void decrypter::finalize_partial_block(char const * in, char * out, size_t size)
 {
-    int out_size = buffer_size;
-
-    int const rc = EVP_DecryptUpdate(m_ctx.get(), 
-        reinterpret_cast<unsigned char*>(buffer), &out_size, 
-        reinterpret_cast<unsigned char const*>(buffer), buffer_size);
+    int out_size = 0;
+    int const rc = EVP_DecryptUpdate(m_ctx.get(),
+        reinterpret_cast<unsigned char*>(out), &out_size,
+        reinterpret_cast<unsigned char const*>(in), static_cast<int>(size));
     if (rc != 1)
     {
         throw openssl_error();
     }
 
-    if (buffer_size != out_size)
+    m_is_authentic = finish(&out[out_size]);
+    m_is_finalized = true;
+}
+
+void decrypter::update_inplace(char * buffer, size_t buffer_size)
+{
+    update(buffer, buffer, buffer_size);
+}
+
+bool decrypter::finalize()
+{
+    if (m_is_finalized)
     {
-        throw std::runtime_error("output buffer size mismatch");
+        return m_is_authentic;
     }
+
+    return finish(nullptr);
 }
 
-bool decrypter::finalize()
+bool decrypter::finish(char * out)
 {
+    if (m_native)
+    {
+        char tag[tag_size];
+        m_native->finish(tag);
+        return (0 == CRYPTO_memcmp(tag, m_tag.data(), tag_size));
+    }
+
     int out_size = 0;
-    int const rc = EVP_DecryptFinal_ex(m_ctx.get(), nullptr, &out_size);
+    int const rc = EVP_DecryptFinal_ex(m_ctx.get(), reinterpret_cast<unsigned char*>(out), &out_size);
     return (rc == 1);
 }
 
@@ -2,21 +2,54 @@
 #include "aes256gcm/rand.hpp"
 #include "aes256gcm/openssl_error.hpp"
 #include "aes256gcm/constants.hpp"
+#include "aes256gcm/cipher.hpp"
+#include "aes256gcm/native_gcm.hpp"
+#include "aes256gcm/native_dispatch.hpp"
+
+#include <algorithm>
 
 namespace aes256gcm
 {
 
 encrypter::encrypter(
-    std::string const & key,
+    std::string_view key,
     std::string const & additional_data)
+: encrypter(key, rand(nonce_size), additional_data)
+{
+
+}
+
+encrypter::encrypter(
+    std::string_view key,
+    std::string const & nonce,
+    std::string const & additional_data,
+    std::string const & algorithm)
 : m_ctx(nullptr, EVP_CIPHER_CTX_free)
-, m_nonce(rand(nonce_size))
+, m_native(nullptr, native_gcm::free)
+, m_nonce(nonce)
+, m_block_size(1)
+, m_is_finalized(false)
 {
     if (key.size() != key_size)
     {
         throw std::logic_error("invalid key size");
     }
 
+    if (m_nonce.size() != nonce_size)
+    {
+        throw std::logic_error("invalid nonce size");
+    }
+
+    auto const * cipher = aead_cipher(algorithm);
+    m_block_size = EVP_CIPHER_get_block_size(cipher);
+
+    if ((cipher == aes256gcm_cipher()) && (use_native_gcm()))
+    {
+        m_native.reset(new native_gcm(key.data()));
+        m_native->start(m_nonce.data(), additional_data.data(), additional_data.size());
+        return;
+    }
+
     EVP_CIPHER_CTX * raw_ctx = EVP_CIPHER_CTX_new();
     if (nullptr == raw_ctx)
     {
@@ -24,7 +57,7 @@ encrypter::encrypter(
     }
     m_ctx.reset(raw_ctx);
 
-    int rc = EVP_EncryptInit_ex(m_ctx.get(), EVP_aes_256_gcm(), nullptr, 
+    int rc = EVP_EncryptInit_ex(m_ctx.get(), cipher, nullptr, 
         reinterpret_cast<unsigned char const*>(key.data()), 
         reinterpret_cast<unsigned char const *>(m_nonce.data()));
     if (rc != 1)
@@ -32,9 +65,44 @@ encrypter::encrypter(
         throw openssl_error();
     }
 
+    add_additional_data(additional_data);
+}
+
+void encrypter::reset(
+    std::string const & nonce,
+    std::string const & additional_data)
+{
+    if (nonce.size() != nonce_size)
+    {
+        throw std::logic_error("invalid nonce size");
+    }
+    m_nonce = nonce;
+    m_is_finalized = false;
+    m_tag.clear();
+
+    if (m_native)
+    {
+        m_native->start(m_nonce.data(), additional_data.data(), additional_data.size());
+        return;
+    }
+
+    // passing no cipher and no key keeps the key schedule
+    int const rc = EVP_EncryptInit_ex(m_ctx.get(), nullptr, nullptr, nullptr,
+        reinterpret_cast<unsigned char const *>(m_nonce.data()));
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    add_additional_data(additional_data);
+}
+
+void encrypter::add_additional_data(std::string const & additional_data)
+{
     if (!additional_data.empty())
     {
-        rc = EVP_EncryptUpdate(m_ctx.get(), nullptr, 0, 
+        int out_size = 0;
+        int const rc = EVP_EncryptUpdate(m_ctx.get(), nullptr, &out_size, 
             reinterpret_cast<unsigned char const*>(additional_data.data()),
             additional_data.size());
         if (rc != 1)
@@ -46,51 +114,94 @@ encrypter::encrypter(
 
 void encrypter::update(char const * in, char * out, size_t size)
 {
-    int out_size = static_cast<int>(size);
+    if ((m_is_finalized) && (size > 0))
+    {
+        throw std::logic_error("update after partial block");
+    }
 
-    int const rc = EVP_EncryptUpdate(m_ctx.get(), 
-        reinterpret_cast<unsigned char*>(out), &out_size, 
-        reinterpret_cast<unsigned char const*>(in), size);
-    if (rc != 1)
+    if (m_native)
     {
-        throw openssl_error();
+        m_native->encrypt(in, out, size);
+        return;
     }
 
-    if (size != out_size)
+    // block based algorithms buffer a trailing partial block until
+    // finalization, which would leave the output buffer incomplete
+    size_t const partial_size = size % m_block_size;
+    size -= partial_size;
+
+    for (size_t pos = 0; pos < size; pos += max_update_size)
     {
-        throw std::runtime_error("output buffer size mismatch");
+        int const chunk_size = static_cast<int>(std::min(max_update_size, size - pos));
+        int out_size = chunk_size;
+
+        int const rc = EVP_EncryptUpdate(m_ctx.get(), 
+            reinterpret_cast<unsigned char*>(&out[pos]), &out_size, 
+            reinterpret_cast<unsigned char const*>(&in[pos]), chunk_size);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+
+        if (chunk_size != out_size)
+        {
+            throw std::runtime_error("output buffer size mismatch");
+        }
+    }
+
+    if (partial_size > 0)
+    {
+        finalize_partial_block(&in[size], &out[size], partial_size);
     }
 }
 
 void encrypter::update_inplace(char * buffer, size_t buffer_size)
 {
-    int out_size = buffer_size;
+    update(buffer, buffer, buffer_size);
+}
 
-    int const rc = EVP_EncryptUpdate(m_ctx.get(), 
-        reinterpret_cast<unsigned char*>(buffer), &out_size, 
-        reinterpret_cast<unsigned char const*>(buffer), buffer_size);
+void encrypter::finalize_partial_block(char const * in, char * out, size_t size)
+{
+    int out_size = 0;
+    int const rc = EVP_EncryptUpdate(m_ctx.get(),
+        reinterpret_cast<unsigned char*>(out), &out_size,
+        reinterpret_cast<unsigned char const*>(in), static_cast<int>(size));
     if (rc != 1)
     {
         throw openssl_error();
     }
 
-    if (buffer_size != out_size)
+    m_tag = finish(&out[out_size]);
+    m_is_finalized = true;
+}
+
+std::string encrypter::finalize()
+{
+    if (m_is_finalized)
     {
-        throw std::runtime_error("output buffer size mismatch");
+        return m_tag;
     }
+
+    return finish(nullptr);
 }
 
-std::string encrypter::finalize()
+std::string encrypter::finish(char * out)
 {
+    char tag[tag_size];
+    if (m_native)
+    {
+        m_native->finish(tag);
+        return std::string(tag, tag_size);
+    }
+
     int out_size = 0;
-    int rc = EVP_EncryptFinal_ex(m_ctx.get(), nullptr, &out_size);
+    int rc = EVP_EncryptFinal_ex(m_ctx.get(), reinterpret_cast<unsigned char*>(out), &out_size);
     if (rc != 1)
     {
         throw openssl_error();
     }
 
-    char tag[tag_size];
-    rc = EVP_CIPHER_CTX_ctrl(m_ctx.get(), EVP_CTRL_GCM_GET_TAG, tag_size,
+    rc = EVP_CIPHER_CTX_ctrl(m_ctx.get(), EVP_CTRL_AEAD_GET_TAG, tag_size,
             reinterpret_cast<unsigned char*>(tag));
     if (rc != 1)
     {
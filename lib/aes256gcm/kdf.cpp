@@ -0,0 +1,104 @@
+#include "aes256gcm/kdf.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/argon2.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/key_cache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <thread>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+key_cache & argon2_cache()
+{
+    static key_cache instance(kdf_cache_capacity);
+    return instance;
+}
+
+bool equals_ignore_case(std::string const & value, char const * name)
+{
+    return std::equal(value.begin(), value.end(), name, name + std::char_traits<char>::length(name),
+        [](char a, char b) { return std::toupper(static_cast<unsigned char>(a)) == b; });
+}
+
+}
+
+kdf_params generate_kdf_params(
+    std::string const & algorithm,
+    unsigned int time_cost,
+    unsigned int memory_cost,
+    unsigned int lanes)
+{
+    kdf_params params = {};
+    if (equals_ignore_case(algorithm, kdf_pbkdf2))
+    {
+        params.algorithm = kdf_pbkdf2;
+        pbkdf2_generate_params(params.salt, params.digest, params.iterations);
+        return params;
+    }
+
+    if (!equals_ignore_case(algorithm, kdf_argon2id))
+    {
+        throw std::invalid_argument("unknown key derivation function: " + algorithm);
+    }
+
+    if (lanes == 0)
+    {
+        lanes = std::clamp(std::thread::hardware_concurrency(), 1u, argon2_max_default_lanes);
+    }
+
+    params.algorithm = kdf_argon2id;
+    params.salt = rand(argon2_salt_size);
+    params.iterations = (time_cost > 0) ? time_cost : argon2_time_cost;
+    params.memory_cost = std::max((memory_cost > 0) ? memory_cost : argon2_memory_cost, 8 * lanes);
+    params.lanes = lanes;
+    return params;
+}
+
+std::string derive_key(
+    std::string const & password,
+    kdf_params const & params)
+{
+    auto const key = derive_secure_key(password, params);
+    return std::string(key.view());
+}
+
+secure_buffer derive_secure_key(
+    std::string const & password,
+    kdf_params const & params)
+{
+    auto key = secure_pool::instance().allocate_key(key_size);
+
+    // files written before Argon2id support may lack the algorithm
+    if ((params.algorithm.empty()) || (params.algorithm == kdf_pbkdf2))
+    {
+        pbkdf2(password, params.salt, params.digest, params.iterations, key.get());
+        return key;
+    }
+
+    if (params.algorithm != kdf_argon2id)
+    {
+        throw std::invalid_argument("unsupported key derivation function: " + params.algorithm);
+    }
+
+    // memory cost and lanes take the place of the digest in the cache
+    std::string const cost = std::string(kdf_argon2id) + ":" + std::to_string(params.memory_cost)
+        + ":" + std::to_string(params.lanes);
+
+    if (!argon2_cache().find(password, params.salt, cost, params.iterations, key.get()))
+    {
+        argon2id(password, params.salt, params.iterations, params.memory_cost, params.lanes, key.get());
+        argon2_cache().insert(password, params.salt, cost, params.iterations, key.view());
+    }
+    return key;
+}
+
+}
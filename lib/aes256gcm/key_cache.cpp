@@ -0,0 +1,172 @@
+#include "aes256gcm/key_cache.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/openssl_error.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include <cstring>
+
+namespace aes256gcm
+{
+
+key_cache::key_cache(size_t capacity)
+: m_capacity(capacity)
+, m_slab(secure_pool::instance().allocate_key(capacity * key_size))
+, m_secret(secure_pool::instance().allocate_key(key_size))
+, m_hits(0)
+, m_misses(0)
+{
+    if (1 != RAND_bytes(reinterpret_cast<unsigned char*>(m_secret.get()), static_cast<int>(key_size)))
+    {
+        throw openssl_error();
+    }
+}
+
+key_cache::~key_cache()
+{
+    // slab and secret are wiped when they are returned to the pool
+}
+
+bool key_cache::find(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations,
+    char * key)
+{
+    auto const password_hash = hash_password(password);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const it = lookup(password_hash, salt, digest, iterations);
+    if (it == m_entries.end())
+    {
+        m_misses++;
+        return false;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    m_hits++;
+    memcpy(key, slot_address(it->slot), key_size);
+    return true;
+}
+
+bool key_cache::find(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations,
+    std::string & key)
+{
+    std::string result(key_size, '\0');
+    if (!find(password, salt, digest, iterations, &result[0]))
+    {
+        return false;
+    }
+
+    key.swap(result);
+    OPENSSL_cleanse(&result[0], result.size());
+    return true;
+}
+
+void key_cache::insert(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations,
+    std::string_view key)
+{
+    if ((m_capacity == 0) || (key.size() != key_size))
+    {
+        return;
+    }
+
+    auto const password_hash = hash_password(password);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = lookup(password_hash, salt, digest, iterations);
+    if (it == m_entries.end())
+    {
+        size_t slot = m_entries.size();
+        if (m_entries.size() >= m_capacity)
+        {
+            slot = m_entries.back().slot;
+            OPENSSL_cleanse(slot_address(slot), key_size);
+            m_entries.pop_back();
+        }
+        m_entries.push_front({password_hash, salt, digest, iterations, slot});
+        it = m_entries.begin();
+    }
+    else
+    {
+        m_entries.splice(m_entries.begin(), m_entries, it);
+    }
+
+    key.copy(slot_address(it->slot), key_size);
+}
+
+void key_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    OPENSSL_cleanse(m_slab.get(), m_slab.size());
+    m_entries.clear();
+    m_hits = 0;
+    m_misses = 0;
+}
+
+uint64_t key_cache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+uint64_t key_cache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+std::string key_cache::hash_password(std::string const & password) const
+{
+    // keyed with a per-process secret, so entries cannot be matched
+    // against precomputed password hashes
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_size = 0;
+    auto const * result = HMAC(EVP_sha256(),
+        m_secret.get(), static_cast<int>(m_secret.size()),
+        reinterpret_cast<unsigned char const*>(password.data()), password.size(),
+        hash, &hash_size);
+    if (nullptr == result)
+    {
+        throw openssl_error();
+    }
+
+    return std::string(reinterpret_cast<char const*>(hash), hash_size);
+}
+
+std::list<key_cache::entry>::iterator key_cache::lookup(
+    std::string const & password_hash,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); it++)
+    {
+        if ((it->iterations == iterations) && (it->password_hash == password_hash)
+            && (it->salt == salt) && (it->digest == digest))
+        {
+            return it;
+        }
+    }
+
+    return m_entries.end();
+}
+
+char * key_cache::slot_address(size_t slot) const
+{
+    return m_slab.get() + (slot * key_size);
+}
+
+}
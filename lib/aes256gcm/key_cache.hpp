@@ -0,0 +1,97 @@
+#ifndef AES256GCM_KEY_CACHE_HPP
+#define AES256GCM_KEY_CACHE_HPP
+
+#include "aes256gcm/secure_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace aes256gcm
+{
+
+/// @brief Bounded LRU cache of derived keys.
+///
+/// Entries are identified by a keyed hash of the password, the salt,
+/// the digest and the iteration count; the password itself is never
+/// stored. Derived keys live in a single slab of the secure pool, which
+/// is locked into memory, excluded from core dumps and wiped whenever an
+/// entry is evicted or the cache is cleared.
+///
+/// @note Keys returned by find are copies, which the caller has to wipe;
+///       internal callers pass a key buffer of the secure pool instead.
+class key_cache
+{
+    key_cache(key_cache const &) = delete;
+    key_cache& operator=(key_cache const &) = delete;
+public:
+    explicit key_cache(size_t capacity);
+    ~key_cache();
+
+    /// @brief Looks up a key and marks it as most recently used.
+    /// @param key buffer of key_size bytes receiving the derived key on hit
+    /// @return true on hit, false otherwise
+    bool find(
+        std::string const & password,
+        std::string const & salt,
+        std::string const & digest,
+        unsigned int iterations,
+        char * key);
+
+    /// @brief Looks up a key and marks it as most recently used.
+    /// @param key receives the derived key on hit
+    /// @return true on hit, false otherwise
+    bool find(
+        std::string const & password,
+        std::string const & salt,
+        std::string const & digest,
+        unsigned int iterations,
+        std::string & key);
+
+    /// @brief Stores a derived key, evicting the least recently used one if full.
+    void insert(
+        std::string const & password,
+        std::string const & salt,
+        std::string const & digest,
+        unsigned int iterations,
+        std::string_view key);
+
+    /// @brief Wipes and removes all entries; counters are reset.
+    void clear();
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct entry
+    {
+        std::string password_hash;
+        std::string salt;
+        std::string digest;
+        unsigned int iterations;
+        size_t slot;
+    };
+
+    std::string hash_password(std::string const & password) const;
+    std::list<entry>::iterator lookup(
+        std::string const & password_hash,
+        std::string const & salt,
+        std::string const & digest,
+        unsigned int iterations);
+    char * slot_address(size_t slot) const;
+
+    size_t const m_capacity;
+    secure_buffer m_slab;
+    secure_buffer m_secret;
+    std::list<entry> m_entries;
+    uint64_t m_hits;
+    uint64_t m_misses;
+    mutable std::mutex m_mutex;
+};
+
+}
+
+#endif
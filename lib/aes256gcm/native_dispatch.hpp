@@ -0,0 +1,14 @@
+#ifndef AES256GCM_NATIVE_DISPATCH_HPP
+#define AES256GCM_NATIVE_DISPATCH_HPP
+
+namespace aes256gcm
+{
+
+/// @brief Checks, if encrypter / decrypter should use the native GCM kernel.
+///
+/// True if the CPU supports the kernel and AES256GCM_DISABLE_NATIVE is not set.
+bool use_native_gcm() noexcept;
+
+}
+
+#endif
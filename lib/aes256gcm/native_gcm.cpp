@@ -0,0 +1,446 @@
+#include "aes256gcm/native_gcm.hpp"
+
+#include <openssl/crypto.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+// this translation unit is built for AVX-512 (see CMakeLists.txt), while
+// the rest of the library uses the baseline ISA; its code must only be
+// reached after native_gcm::is_supported returned true.
+// It must not instantiate templates or inline functions of the standard
+// library (e.g. std::min): their weak definitions would be built for
+// AVX-512 as well and the linker may pick them for the whole program.
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+size_t min_size(size_t a, size_t b)
+{
+    return (a < b) ? a : b;
+}
+
+__m128i reverse_mask()
+{
+    return _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+}
+
+__m128i load(unsigned char const * data)
+{
+    return _mm_load_si128(reinterpret_cast<__m128i const*>(data));
+}
+
+void store(unsigned char * data, __m128i value)
+{
+    _mm_store_si128(reinterpret_cast<__m128i*>(data), value);
+}
+
+// AES-256 key expansion, see Intel's AES-NI white paper
+__m128i expand_even(__m128i key, __m128i assist)
+{
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    __m128i temp = _mm_slli_si128(key, 4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 4);
+    key = _mm_xor_si128(key, temp);
+    return _mm_xor_si128(key, assist);
+}
+
+__m128i expand_odd(__m128i even, __m128i key)
+{
+    __m128i const assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(even, 0x00), 0xaa);
+    __m128i temp = _mm_slli_si128(key, 4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 4);
+    key = _mm_xor_si128(key, temp);
+    return _mm_xor_si128(key, assist);
+}
+
+#define AES256GCM_EXPAND_ROUND(index, rcon) \
+    k0 = expand_even(k0, _mm_aeskeygenassist_si128(k1, rcon)); \
+    keys[index] = k0; \
+    if (index < 14) \
+    { \
+        k1 = expand_odd(k0, k1); \
+        keys[index + 1] = k1; \
+    }
+
+void expand_key(unsigned char const * key, __m128i * keys)
+{
+    __m128i k0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(key));
+    __m128i k1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&key[16]));
+    keys[0] = k0;
+    keys[1] = k1;
+
+    AES256GCM_EXPAND_ROUND(2, 0x01)
+    AES256GCM_EXPAND_ROUND(4, 0x02)
+    AES256GCM_EXPAND_ROUND(6, 0x04)
+    AES256GCM_EXPAND_ROUND(8, 0x08)
+    AES256GCM_EXPAND_ROUND(10, 0x10)
+    AES256GCM_EXPAND_ROUND(12, 0x20)
+    AES256GCM_EXPAND_ROUND(14, 0x40)
+}
+
+#undef AES256GCM_EXPAND_ROUND
+
+__m128i encrypt_block(unsigned char const (*round_keys)[16], __m128i block)
+{
+    block = _mm_xor_si128(block, load(round_keys[0]));
+    for (size_t i = 1; i < 14; i++)
+    {
+        block = _mm_aesenc_si128(block, load(round_keys[i]));
+    }
+    return _mm_aesenclast_si128(block, load(round_keys[14]));
+}
+
+// Reduces a 256 bit carry-less product of byte-reflected operands modulo
+// the GCM polynomial. The product is shifted left by one bit first to
+// account for the bit reflection, see Intel's carry-less multiplication
+// white paper (algorithm 5).
+__m128i reduce(__m128i lo, __m128i hi)
+{
+    __m128i t7 = _mm_srli_epi32(lo, 31);
+    __m128i t8 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+
+    __m128i t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    lo = _mm_or_si128(lo, t7);
+    hi = _mm_or_si128(hi, t8);
+    hi = _mm_or_si128(hi, t9);
+
+    t7 = _mm_slli_epi32(lo, 31);
+    t8 = _mm_slli_epi32(lo, 30);
+    t9 = _mm_slli_epi32(lo, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    lo = _mm_xor_si128(lo, t7);
+
+    __m128i t2 = _mm_srli_epi32(lo, 1);
+    __m128i const t4 = _mm_srli_epi32(lo, 2);
+    __m128i const t5 = _mm_srli_epi32(lo, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    lo = _mm_xor_si128(lo, t2);
+    return _mm_xor_si128(hi, lo);
+}
+
+__m128i gfmul(__m128i a, __m128i b)
+{
+    __m128i lo = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    __m128i hi = _mm_clmulepi64_si128(a, b, 0x11);
+
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+    return reduce(lo, hi);
+}
+
+__m128i fold(__m512i value)
+{
+    __m128i const a = _mm_xor_si128(_mm512_extracti32x4_epi32(value, 0), _mm512_extracti32x4_epi32(value, 1));
+    __m128i const b = _mm_xor_si128(_mm512_extracti32x4_epi32(value, 2), _mm512_extracti32x4_epi32(value, 3));
+    return _mm_xor_si128(a, b);
+}
+
+// accumulates the unreduced products of four block / power pairs
+void multiply(__m512i data, __m512i h_power, __m512i & lo, __m512i & mid, __m512i & hi)
+{
+    lo = _mm512_xor_si512(lo, _mm512_clmulepi64_epi128(data, h_power, 0x00));
+    mid = _mm512_ternarylogic_epi64(mid, _mm512_clmulepi64_epi128(data, h_power, 0x01),
+        _mm512_clmulepi64_epi128(data, h_power, 0x10), 0x96);
+    hi = _mm512_xor_si512(hi, _mm512_clmulepi64_epi128(data, h_power, 0x11));
+}
+
+__m128i reduce_wide(__m512i lo, __m512i mid, __m512i hi)
+{
+    __m128i const mid128 = fold(mid);
+    return reduce(_mm_xor_si128(fold(lo), _mm_slli_si128(mid128, 8)),
+        _mm_xor_si128(fold(hi), _mm_srli_si128(mid128, 8)));
+}
+
+}
+
+native_gcm::native_gcm(char const * key)
+: m_counter(0)
+, m_partial(0)
+, m_aad_size(0)
+, m_data_size(0)
+{
+    __m128i keys[15];
+    expand_key(reinterpret_cast<unsigned char const*>(key), keys);
+    for (size_t i = 0; i < 15; i++)
+    {
+        store(m_round_keys[i], keys[i]);
+    }
+
+    __m128i const h = _mm_shuffle_epi8(encrypt_block(m_round_keys, _mm_setzero_si128()), reverse_mask());
+    __m128i power = h;
+    for (size_t i = 0; i < 16; i++)
+    {
+        store(m_h_powers[15 - i], power);
+        power = gfmul(power, h);
+    }
+
+    OPENSSL_cleanse(keys, sizeof(keys));
+    memset(m_hash, 0, sizeof(m_hash));
+    memset(m_buffer, 0, sizeof(m_buffer));
+}
+
+void native_gcm::free(native_gcm * gcm) noexcept
+{
+    delete gcm;
+}
+
+native_gcm::~native_gcm()
+{
+    OPENSSL_cleanse(m_round_keys, sizeof(m_round_keys));
+    OPENSSL_cleanse(m_h_powers, sizeof(m_h_powers));
+    OPENSSL_cleanse(m_j0, sizeof(m_j0));
+    OPENSSL_cleanse(m_keystream, sizeof(m_keystream));
+}
+
+void native_gcm::start(char const * nonce, char const * additional_data, size_t additional_data_size)
+{
+    memcpy(m_counter_block, nonce, 12);
+    m_counter_block[12] = 0;
+    m_counter_block[13] = 0;
+    m_counter_block[14] = 0;
+    m_counter_block[15] = 1;
+    store(m_j0, encrypt_block(m_round_keys, load(m_counter_block)));
+    m_counter = 2;
+
+    m_partial = 0;
+    m_aad_size = additional_data_size;
+    m_data_size = 0;
+
+    __m128i const mask = reverse_mask();
+    __m128i const h = load(m_h_powers[15]);
+    __m128i hash = _mm_setzero_si128();
+    for (size_t pos = 0; pos < additional_data_size; pos += 16)
+    {
+        alignas(16) unsigned char block[16] = {0};
+        memcpy(block, &additional_data[pos], min_size(16, additional_data_size - pos));
+        hash = gfmul(_mm_xor_si128(hash, _mm_shuffle_epi8(load(block), mask)), h);
+    }
+    store(m_hash, hash);
+}
+
+void native_gcm::encrypt(char const * in, char * out, size_t size)
+{
+    process<true>(in, out, size);
+}
+
+void native_gcm::decrypt(char const * in, char * out, size_t size)
+{
+    process<false>(in, out, size);
+}
+
+template <bool Encrypt>
+void native_gcm::process(char const * in, char * out, size_t size)
+{
+    __m128i const mask = reverse_mask();
+    __m128i const h = load(m_h_powers[15]);
+    __m128i hash = load(m_hash);
+    m_data_size += size;
+
+    // continue a partially used key stream block
+    while ((m_partial > 0) && (size > 0))
+    {
+        unsigned char const c = static_cast<unsigned char>(*in);
+        unsigned char const p = c ^ m_keystream[m_partial];
+        m_buffer[m_partial] = Encrypt ? p : c;
+        *out = static_cast<char>(p);
+        in++;
+        out++;
+        size--;
+        m_partial = (m_partial + 1) % 16;
+        if (m_partial == 0)
+        {
+            hash = gfmul(_mm_xor_si128(hash, _mm_shuffle_epi8(load(m_buffer), mask)), h);
+        }
+    }
+
+    if (size >= 256)
+    {
+        __m512i const mask512 = _mm512_broadcast_i32x4(mask);
+        __m512i round_keys[15];
+        for (size_t i = 0; i < 15; i++)
+        {
+            round_keys[i] = _mm512_broadcast_i32x4(load(m_round_keys[i]));
+        }
+        __m512i const h_powers[4] =
+        {
+            _mm512_loadu_si512(m_h_powers[0]),
+            _mm512_loadu_si512(m_h_powers[4]),
+            _mm512_loadu_si512(m_h_powers[8]),
+            _mm512_loadu_si512(m_h_powers[12])
+        };
+
+        // counter blocks are kept byte-reflected, so that the big-endian
+        // counter becomes the lowest 32 bit lane and can be incremented
+        __m128i const base = _mm_shuffle_epi8(load(m_counter_block), mask);
+        __m512i counters = _mm512_add_epi32(_mm512_broadcast_i32x4(_mm_insert_epi32(base, static_cast<int>(m_counter), 0)),
+            _mm512_set_epi32(0, 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 0));
+        __m512i const four = _mm512_set_epi32(0, 0, 0, 4, 0, 0, 0, 4, 0, 0, 0, 4, 0, 0, 0, 4);
+
+        // the blocks of one iteration are hashed during the next one, so
+        // that VPCLMULQDQ and VAES work in parallel
+        __m512i pending[4];
+        bool has_pending = false;
+        while (size >= 256)
+        {
+            __m512i blocks[4];
+            for (size_t i = 0; i < 4; i++)
+            {
+                blocks[i] = _mm512_xor_si512(_mm512_shuffle_epi8(counters, mask512), round_keys[0]);
+                counters = _mm512_add_epi32(counters, four);
+            }
+
+            __m512i lo = _mm512_setzero_si512();
+            __m512i mid = _mm512_setzero_si512();
+            __m512i hi = _mm512_setzero_si512();
+            for (size_t r = 1; r < 14; r++)
+            {
+                for (size_t i = 0; i < 4; i++)
+                {
+                    blocks[i] = _mm512_aesenc_epi128(blocks[i], round_keys[r]);
+                }
+                if ((has_pending) && (r <= 4))
+                {
+                    multiply(pending[r - 1], h_powers[r - 1], lo, mid, hi);
+                }
+            }
+            if (has_pending)
+            {
+                hash = reduce_wide(lo, mid, hi);
+            }
+
+            for (size_t i = 0; i < 4; i++)
+            {
+                __m512i const input = _mm512_loadu_si512(&in[i * 64]);
+                __m512i const output = _mm512_xor_si512(input, _mm512_aesenclast_epi128(blocks[i], round_keys[14]));
+                _mm512_storeu_si512(&out[i * 64], output);
+                pending[i] = _mm512_shuffle_epi8(Encrypt ? output : input, mask512);
+            }
+            pending[0] = _mm512_xor_si512(pending[0], _mm512_zextsi128_si512(hash));
+            has_pending = true;
+
+            m_counter += 16;
+            in += 256;
+            out += 256;
+            size -= 256;
+        }
+
+        __m512i lo = _mm512_setzero_si512();
+        __m512i mid = _mm512_setzero_si512();
+        __m512i hi = _mm512_setzero_si512();
+        for (size_t i = 0; i < 4; i++)
+        {
+            multiply(pending[i], h_powers[i], lo, mid, hi);
+        }
+        hash = reduce_wide(lo, mid, hi);
+    }
+
+    while (size > 0)
+    {
+        m_counter_block[12] = static_cast<unsigned char>(m_counter >> 24);
+        m_counter_block[13] = static_cast<unsigned char>(m_counter >> 16);
+        m_counter_block[14] = static_cast<unsigned char>(m_counter >> 8);
+        m_counter_block[15] = static_cast<unsigned char>(m_counter);
+        m_counter++;
+        __m128i const keystream = encrypt_block(m_round_keys, load(m_counter_block));
+
+        if (size >= 16)
+        {
+            __m128i const input = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in));
+            __m128i const output = _mm_xor_si128(input, keystream);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), output);
+            hash = gfmul(_mm_xor_si128(hash, _mm_shuffle_epi8(Encrypt ? output : input, mask)), h);
+            in += 16;
+            out += 16;
+            size -= 16;
+        }
+        else
+        {
+            // keep the key stream for the next update
+            store(m_keystream, keystream);
+            memset(m_buffer, 0, sizeof(m_buffer));
+            for (size_t i = 0; i < size; i++)
+            {
+                unsigned char const c = static_cast<unsigned char>(in[i]);
+                unsigned char const p = c ^ m_keystream[i];
+                m_buffer[i] = Encrypt ? p : c;
+                out[i] = static_cast<char>(p);
+            }
+            m_partial = size;
+            size = 0;
+        }
+    }
+
+    store(m_hash, hash);
+}
+
+void native_gcm::finish(char * tag)
+{
+    __m128i const mask = reverse_mask();
+    __m128i const h = load(m_h_powers[15]);
+    __m128i hash = load(m_hash);
+
+    if (m_partial > 0)
+    {
+        hash = gfmul(_mm_xor_si128(hash, _mm_shuffle_epi8(load(m_buffer), mask)), h);
+        m_partial = 0;
+    }
+
+    __m128i const lengths = _mm_set_epi64x(static_cast<long long>(m_aad_size * 8), static_cast<long long>(m_data_size * 8));
+    hash = gfmul(_mm_xor_si128(hash, lengths), h);
+
+    __m128i const result = _mm_xor_si128(_mm_shuffle_epi8(hash, mask), load(m_j0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(tag), result);
+}
+
+}
+
+
+#else
+
+namespace aes256gcm
+{
+
+native_gcm::native_gcm(char const *)
+{
+    throw std::logic_error("native GCM is not supported on this CPU");
+}
+
+void native_gcm::free(native_gcm * gcm) noexcept
+{
+    delete gcm;
+}
+
+native_gcm::~native_gcm() = default;
+
+void native_gcm::start(char const *, char const *, size_t) { }
+void native_gcm::encrypt(char const *, char *, size_t) { }
+void native_gcm::decrypt(char const *, char *, size_t) { }
+void native_gcm::finish(char *) { }
+
+}
+
+#endif
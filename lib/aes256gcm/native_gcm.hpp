@@ -0,0 +1,72 @@
+#ifndef AES256GCM_NATIVE_GCM_HPP
+#define AES256GCM_NATIVE_GCM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aes256gcm
+{
+
+/// @brief In-project AES256-GCM kernel using VAES and VPCLMULQDQ.
+///
+/// Processes 16 blocks per iteration using 512 bit vectors: counter
+/// blocks are encrypted with VAES and the ciphertext is hashed with
+/// VPCLMULQDQ against precomputed powers of H, reducing once per
+/// iteration. Only usable on CPUs with AVX-512 (F, BW), VAES and
+/// VPCLMULQDQ; see is_supported.
+///
+/// Produces the same ciphertext and tag as OpenSSL's AES-256-GCM for
+/// 12 byte nonces. Updates of any size are allowed.
+class native_gcm
+{
+    native_gcm(native_gcm const &) = delete;
+    native_gcm& operator=(native_gcm const &) = delete;
+public:
+    /// @brief Checks, if the CPU and the operating system support the kernel.
+    static bool is_supported() noexcept;
+
+    /// @brief Expands the key and computes the powers of H.
+    /// @note Must only be called if is_supported returned true.
+    /// @param key 32 byte key
+    explicit native_gcm(char const * key);
+
+    /// @brief Wipes key material.
+    ~native_gcm();
+
+    /// @brief Starts a new message.
+    /// @param nonce 12 byte nonce
+    /// @param additional_data additional authenticated data
+    /// @param additional_data_size size of additional authenticated data
+    void start(char const * nonce, char const * additional_data, size_t additional_data_size);
+
+    void encrypt(char const * in, char * out, size_t size);
+    void decrypt(char const * in, char * out, size_t size);
+
+    /// @brief Finishes the message and computes its tag.
+    /// @param tag buffer to store the 16 byte tag
+    void finish(char * tag);
+
+    /// @brief Deleter for use with std::unique_ptr.
+    static void free(native_gcm * gcm) noexcept;
+
+private:
+    template <bool Encrypt>
+    void process(char const * in, char * out, size_t size);
+
+    // GHASH operands are stored byte-reflected
+    alignas(64) unsigned char m_round_keys[15][16];
+    alignas(64) unsigned char m_h_powers[16][16];   ///< H^16 ... H^1
+    alignas(16) unsigned char m_j0[16];             ///< encrypted initial counter block
+    alignas(16) unsigned char m_counter_block[16];  ///< nonce | be32(counter)
+    alignas(16) unsigned char m_hash[16];
+    alignas(16) unsigned char m_keystream[16];
+    alignas(16) unsigned char m_buffer[16];         ///< ciphertext of a partial block
+    uint32_t m_counter;
+    size_t m_partial;
+    uint64_t m_aad_size;
+    uint64_t m_data_size;
+};
+
+}
+
+#endif
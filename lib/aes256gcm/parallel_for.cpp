@@ -0,0 +1,73 @@
+#include "aes256gcm/parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aes256gcm
+{
+
+void parallel_for(
+    size_t count,
+    unsigned int threads,
+    std::function<void(size_t)> const & fn)
+{
+    size_t const worker_count = std::min(static_cast<size_t>(std::max(threads, 1u)), count);
+    if (worker_count <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto const worker = [&]()
+    {
+        size_t i;
+        while ((!failed) && ((i = next++) < count))
+        {
+            try
+            {
+                fn(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count - 1);
+    for (size_t i = 1; i < worker_count; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+
+    for (auto & t: workers)
+    {
+        t.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef AES256GCM_PARALLEL_FOR_HPP
+#define AES256GCM_PARALLEL_FOR_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace aes256gcm
+{
+
+/// @brief Calls a function for each index in [0, count) using multiple threads.
+///
+/// Indices are handed out dynamically, so that workers finishing early
+/// pick up remaining work. The calling thread participates as a worker.
+///
+/// @param count number of work items
+/// @param threads maximum number of threads to use; 0 or 1 runs sequentially
+/// @param fn function called once per index
+/// @throws The first exception thrown by fn is re-thrown after all workers finished.
+void parallel_for(
+    size_t count,
+    unsigned int threads,
+    std::function<void(size_t)> const & fn);
+
+}
+
+#endif
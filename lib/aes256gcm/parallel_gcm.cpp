@@ -0,0 +1,377 @@
+#include "aes256gcm/parallel_gcm.hpp"
+#include "aes256gcm/parallel_for.hpp"
+#include "aes256gcm/openssl_error.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/cipher.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+constexpr size_t const block_size = 16;
+
+// GCM limits the plaintext to 2^32 - 2 blocks
+constexpr uint64_t const max_data_size = ((uint64_t(1) << 32) - 2) * block_size;
+
+// ranges smaller than this are not worth a thread of their own
+constexpr size_t const min_range_size = 1024 * 1024;
+
+using cipher_ctx = std::unique_ptr<EVP_CIPHER_CTX, void (*) (EVP_CIPHER_CTX*)>;
+
+cipher_ctx new_cipher_ctx()
+{
+    EVP_CIPHER_CTX * raw_ctx = EVP_CIPHER_CTX_new();
+    if (nullptr == raw_ctx)
+    {
+        throw openssl_error();
+    }
+    return cipher_ctx(raw_ctx, EVP_CIPHER_CTX_free);
+}
+
+}
+
+// GF(2^128) arithmetic as specified in NIST SP 800-38D.
+// This is only used to combine partial hashes, bulk hashing is done by OpenSSL.
+namespace
+{
+
+using block = parallel_gcm::block;
+
+block to_block(unsigned char const * data)
+{
+    block result = {0, 0};
+    for (size_t i = 0; i < 8; i++)
+    {
+        result.hi = (result.hi << 8) | data[i];
+        result.lo = (result.lo << 8) | data[i + 8];
+    }
+    return result;
+}
+
+void from_block(block const & value, unsigned char * data)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        data[i]     = static_cast<unsigned char>(value.hi >> (56 - i * 8));
+        data[i + 8] = static_cast<unsigned char>(value.lo >> (56 - i * 8));
+    }
+}
+
+block operator^(block const & a, block const & b)
+{
+    return {a.hi ^ b.hi, a.lo ^ b.lo};
+}
+
+block multiply(block const & x, block const & y)
+{
+    block z = {0, 0};
+    block v = y;
+    for (size_t i = 0; i < 128; i++)
+    {
+        uint64_t const word = (i < 64) ? x.hi : x.lo;
+        if ((word >> (63 - (i % 64))) & 1)
+        {
+            z = z ^ v;
+        }
+
+        bool const carry = (v.lo & 1) != 0;
+        v.lo = (v.lo >> 1) | (v.hi << 63);
+        v.hi >>= 1;
+        if (carry)
+        {
+            v.hi ^= uint64_t(0xe1) << 56;
+        }
+    }
+    return z;
+}
+
+block power(block const & x, uint64_t exponent)
+{
+    block result = {uint64_t(1) << 63, 0};
+    block base = x;
+    while (exponent > 0)
+    {
+        if (exponent & 1)
+        {
+            result = multiply(result, base);
+        }
+        base = multiply(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+block inverse(block const & x)
+{
+    // x^(2^128 - 2)
+    block result = {uint64_t(1) << 63, 0};
+    for (size_t i = 0; i < 128; i++)
+    {
+        result = multiply(result, result);
+        if (i < 127)
+        {
+            result = multiply(result, x);
+        }
+    }
+    return result;
+}
+
+block length_block(uint64_t aad_size, uint64_t data_size)
+{
+    return {aad_size * 8, data_size * 8};
+}
+
+uint64_t block_count(uint64_t size)
+{
+    return (size + block_size - 1) / block_size;
+}
+
+block encrypt_block(std::string_view key, block const & value)
+{
+    auto ctx = new_cipher_ctx();
+    int rc = EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_ecb(), nullptr,
+        reinterpret_cast<unsigned char const*>(key.data()), nullptr);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+    EVP_CIPHER_CTX_set_padding(ctx.get(), 0);
+
+    unsigned char in[block_size];
+    unsigned char out[block_size];
+    from_block(value, in);
+    int out_size = 0;
+    rc = EVP_EncryptUpdate(ctx.get(), out, &out_size, in, block_size);
+    if ((rc != 1) || (out_size != block_size))
+    {
+        throw openssl_error();
+    }
+
+    return to_block(out);
+}
+
+}
+
+parallel_gcm::parallel_gcm(
+    std::string_view key,
+    std::string const & nonce,
+    std::string const & additional_data,
+    unsigned int threads)
+: m_key(secure_pool::instance().allocate_key(key_size))
+, m_nonce(nonce)
+, m_threads(std::max(threads, 1u))
+, m_aad_size(additional_data.size())
+, m_data_size(0)
+, m_aligned(true)
+{
+    if (key.size() != key_size)
+    {
+        throw std::logic_error("invalid key size");
+    }
+
+    if (nonce.size() != nonce_size)
+    {
+        throw std::logic_error("invalid nonce size");
+    }
+    key.copy(m_key.get(), key_size);
+
+    m_h = encrypt_block(m_key.view(), {0, 0});
+    m_h_inverse = inverse(m_h);
+    m_gmac_mask = encrypt_block(m_key.view(), {0, 1});
+
+    unsigned char j0[block_size] = {0};
+    std::copy(m_nonce.begin(), m_nonce.end(), j0);
+    j0[block_size - 1] = 1;
+    m_tag_mask = encrypt_block(m_key.view(), to_block(j0));
+
+    m_hash = ghash(additional_data.data(), additional_data.size());
+}
+
+parallel_gcm::~parallel_gcm()
+{
+    // the key is wiped when it is returned to the pool
+    OPENSSL_cleanse(&m_h, sizeof(m_h));
+    OPENSSL_cleanse(&m_h_inverse, sizeof(m_h_inverse));
+}
+
+void parallel_gcm::encrypt_inplace(char * buffer, size_t buffer_size)
+{
+    process(buffer, buffer_size, mode::encrypt);
+}
+
+void parallel_gcm::decrypt_inplace(char * buffer, size_t buffer_size)
+{
+    process(buffer, buffer_size, mode::decrypt);
+}
+
+void parallel_gcm::authenticate(char const * buffer, size_t buffer_size)
+{
+    // the buffer is only read, as the CTR pass is skipped
+    process(const_cast<char*>(buffer), buffer_size, mode::authenticate);
+}
+
+std::string parallel_gcm::tag() const
+{
+    block const s = multiply(m_hash ^ length_block(m_aad_size, m_data_size), m_h);
+
+    unsigned char tag[block_size];
+    from_block(s ^ m_tag_mask, tag);
+    return std::string(reinterpret_cast<char*>(tag), tag_size);
+}
+
+bool parallel_gcm::verify(std::string const & expected_tag) const
+{
+    auto const actual_tag = tag();
+    return (expected_tag.size() == actual_tag.size())
+        && (0 == CRYPTO_memcmp(expected_tag.data(), actual_tag.data(), actual_tag.size()));
+}
+
+void parallel_gcm::process(char * buffer, size_t buffer_size, mode m)
+{
+    if (buffer_size == 0)
+    {
+        return;
+    }
+
+    if (!m_aligned)
+    {
+        throw std::logic_error("unaligned update");
+    }
+
+    if ((buffer_size > max_data_size) || (m_data_size > (max_data_size - buffer_size)))
+    {
+        throw std::logic_error("maximum data size exceeded");
+    }
+
+    size_t const blocks = block_count(buffer_size);
+    size_t const range_count = std::max<size_t>(1, std::min<size_t>(m_threads, buffer_size / min_range_size));
+    size_t const blocks_per_range = (blocks + range_count - 1) / range_count;
+    uint64_t const first_block = m_data_size / block_size;
+
+    std::vector<block> hashes(range_count);
+    parallel_for(range_count, m_threads, [&](size_t range)
+    {
+        size_t const offset = std::min(range * blocks_per_range * block_size, buffer_size);
+        size_t const size = std::min(blocks_per_range * block_size, buffer_size - offset);
+        char * const data = &buffer[offset];
+
+        if (m != mode::encrypt)
+        {
+            hashes[range] = ghash(data, size);
+        }
+
+        if (m == mode::authenticate)
+        {
+            return;
+        }
+
+        // GCM encrypts data block i using counter nonce || (i + 2)
+        uint32_t const counter = static_cast<uint32_t>(first_block + range * blocks_per_range + 2);
+        unsigned char iv[block_size];
+        std::copy(m_nonce.begin(), m_nonce.end(), iv);
+        iv[12] = static_cast<unsigned char>(counter >> 24);
+        iv[13] = static_cast<unsigned char>(counter >> 16);
+        iv[14] = static_cast<unsigned char>(counter >> 8);
+        iv[15] = static_cast<unsigned char>(counter);
+
+        auto ctx = new_cipher_ctx();
+        int rc = EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_ctr(), nullptr,
+            reinterpret_cast<unsigned char const*>(m_key.get()), iv);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+
+        for (size_t pos = 0; pos < size; pos += max_update_size)
+        {
+            int const chunk_size = static_cast<int>(std::min(max_update_size, size - pos));
+            int out_size = 0;
+            rc = EVP_EncryptUpdate(ctx.get(),
+                reinterpret_cast<unsigned char*>(&data[pos]), &out_size,
+                reinterpret_cast<unsigned char const*>(&data[pos]), chunk_size);
+            if ((rc != 1) || (out_size != chunk_size))
+            {
+                throw openssl_error();
+            }
+        }
+
+        if (m == mode::encrypt)
+        {
+            hashes[range] = ghash(data, size);
+        }
+    });
+
+    // hash = hash * H^blocks + sum(hash[range] * H^(blocks after range))
+    block hash = multiply(m_hash, power(m_h, blocks));
+    for (size_t range = 0; range < range_count; range++)
+    {
+        size_t const end = std::min((range + 1) * blocks_per_range, blocks);
+        hash = hash ^ multiply(hashes[range], power(m_h, blocks - end));
+    }
+
+    m_hash = hash;
+    m_data_size += buffer_size;
+    m_aligned = ((buffer_size % block_size) == 0);
+}
+
+parallel_gcm::block parallel_gcm::ghash(char const * data, size_t size) const
+{
+    if (size == 0)
+    {
+        return {0, 0};
+    }
+
+    // GMAC of data (as additional data) with a zero nonce is
+    // ((GHASH(data) ^ L) * H) ^ E(K, 0^96 || 1), where L is the
+    // length block. Solve for GHASH(data).
+    auto ctx = new_cipher_ctx();
+    unsigned char const iv[nonce_size] = {0};
+    int rc = EVP_EncryptInit_ex(ctx.get(), aes256gcm_cipher(), nullptr,
+        reinterpret_cast<unsigned char const*>(m_key.get()), iv);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    for (size_t pos = 0; pos < size; pos += max_update_size)
+    {
+        int const chunk_size = static_cast<int>(std::min(max_update_size, size - pos));
+        int out_size = 0;
+        rc = EVP_EncryptUpdate(ctx.get(), nullptr, &out_size,
+            reinterpret_cast<unsigned char const*>(&data[pos]), chunk_size);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+    }
+
+    int out_size = 0;
+    rc = EVP_EncryptFinal_ex(ctx.get(), nullptr, &out_size);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    unsigned char tag[block_size];
+    rc = EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, block_size, tag);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    block const s = to_block(tag) ^ m_gmac_mask;
+    return multiply(s, m_h_inverse) ^ length_block(size, 0);
+}
+
+}
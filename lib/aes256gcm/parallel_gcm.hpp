@@ -0,0 +1,120 @@
+#ifndef AES256GCM_PARALLEL_GCM_HPP
+#define AES256GCM_PARALLEL_GCM_HPP
+
+#include "aes256gcm/secure_pool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace aes256gcm
+{
+
+/// @brief Multi-threaded AES256-GCM encryption and decryption context.
+///
+/// Produces the same ciphertext and tag as encrypter / decrypter, but
+/// splits the data into block aligned ranges that are processed on
+/// multiple threads: each range is encrypted in CTR mode starting at the
+/// counter of its first block, and the GHASH of each range is computed
+/// independently. The partial hashes are combined using powers of the
+/// hash key H.
+class parallel_gcm
+{
+public:
+    /// @brief Creates a new context.
+    ///
+    /// @param key Key used for encryption.
+    /// @param nonce Nonce / Initialization Vector used for encryption.
+    /// @param additional_data Additional authenticated data.
+    /// @param threads maximum number of threads to use
+    /// @throws A logic error is thrown on invalid key or nonce size.
+    ///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+    parallel_gcm(
+        std::string_view key,
+        std::string const & nonce,
+        std::string const & additional_data,
+        unsigned int threads);
+
+    /// @brief Wipes the key and the hash key.
+    ~parallel_gcm();
+
+    /// @brief Encrypts some data inplace.
+    ///
+    /// @note All but the last call must pass a multiple of the block size (16 bytes).
+    ///
+    /// @param buffer buffer to encrypt.
+    /// @param buffer_size Size of the buffer.
+    /// @throws An openssl_error is thrown on error of underlying OpenSSL function call.
+    ///         A logic_error is thrown on unaligned updates or if the maximum
+    ///         data size of GCM is exceeded.
+    void encrypt_inplace(char * buffer, size_t buffer_size);
+
+    /// @brief Decrypts some data inplace.
+    ///
+    /// @note All but the last call must pass a multiple of the block size (16 bytes).
+    ///
+    /// @param buffer buffer containing encrypted data and to store the unencrypted data.
+    /// @param buffer_size Size of the buffer.
+    /// @throws An openssl_error is thrown on error of underlying OpenSSL function call.
+    ///         A logic_error is thrown on unaligned updates or if the maximum
+    ///         data size of GCM is exceeded.
+    void decrypt_inplace(char * buffer, size_t buffer_size);
+
+    /// @brief Authenticates some encrypted data without decrypting it.
+    ///
+    /// Only computes the GHASH of the ciphertext, skipping the CTR pass,
+    /// so the tag can be checked using verify without producing plaintext.
+    ///
+    /// @note All but the last call must pass a multiple of the block size (16 bytes).
+    ///
+    /// @param buffer buffer containing encrypted data.
+    /// @param buffer_size Size of the buffer.
+    /// @throws An openssl_error is thrown on error of underlying OpenSSL function call.
+    ///         A logic_error is thrown on unaligned updates or if the maximum
+    ///         data size of GCM is exceeded.
+    void authenticate(char const * buffer, size_t buffer_size);
+
+    /// @brief Returns the tag of all data processed so far.
+    /// @return Encryption tag.
+    /// @throws An openssl_error is thrown on error of underlying OpenSSL function calls.
+    std::string tag() const;
+
+    /// @brief Checks the tag of all data processed so far.
+    /// @param expected_tag tag to check against
+    /// @return true, if the tag matches, false otherwise.
+    bool verify(std::string const & expected_tag) const;
+
+    /// @brief Element of GF(2^128) in GCM bit order.
+    struct block
+    {
+        uint64_t hi;
+        uint64_t lo;
+    };
+
+private:
+    enum class mode
+    {
+        encrypt,
+        decrypt,
+        authenticate
+    };
+
+    void process(char * buffer, size_t buffer_size, mode m);
+    block ghash(char const * data, size_t size) const;
+
+    secure_buffer m_key;
+    std::string m_nonce;
+    unsigned int m_threads;
+    block m_h;
+    block m_h_inverse;
+    block m_gmac_mask;
+    block m_tag_mask;
+    block m_hash;
+    uint64_t m_aad_size;
+    uint64_t m_data_size;
+    bool m_aligned;
+};
+
+}
+
+#endif
@@ -2,30 +2,59 @@
 #include "aes256gcm/rand.hpp"
 #include "aes256gcm/constants.hpp"
 #include "aes256gcm/openssl_error.hpp"
+#include "aes256gcm/key_cache.hpp"
+#include "aes256gcm/cpu_info.hpp"
+#include "aes256gcm/parallel_for.hpp"
+#include "aes256gcm/sha256_mb.hpp"
+#include "aes256gcm/secure_kdf.hpp"
 
+#include <openssl/crypto.h>
 #include <openssl/kdf.h>
 #include <openssl/params.h>
 #include <openssl/core_names.h>
 
+#include <algorithm>
 #include <memory>
+#include <strings.h>
+#include <vector>
 
 namespace aes256gcm
 {
 
-std::string pbkdf2(
+namespace
+{
+
+key_cache & cache()
+{
+    static key_cache instance(kdf_cache_capacity);
+    return instance;
+}
+
+EVP_KDF * fetch_kdf()
+{
+    // fetching is expensive, so the algorithm is fetched once per process;
+    // a failed fetch is retried on the next call
+    static auto const kdf = []()
+    {
+        EVP_KDF * raw_kdf = EVP_KDF_fetch(nullptr, pbkdf2_algorithm, nullptr);
+        if (nullptr == raw_kdf)
+        {
+            throw openssl_error();
+        }
+        return std::unique_ptr<EVP_KDF, void (*) (EVP_KDF*)>(raw_kdf, EVP_KDF_free);
+    }();
+
+    return kdf.get();
+}
+
+void derive(
     std::string const & password,
     std::string const & salt,
     std::string const & digest,
-    unsigned int iterations)
+    unsigned int iterations,
+    char * key)
 {
-    EVP_KDF * raw_kdf = EVP_KDF_fetch(nullptr, pbkdf2_algorithm, nullptr);
-    if (nullptr == raw_kdf)
-    {
-        throw openssl_error();
-    }
-    auto kdf = std::unique_ptr<EVP_KDF, void (*) (EVP_KDF*)>(raw_kdf, EVP_KDF_free);
-
-    EVP_KDF_CTX * raw_ctx = EVP_KDF_CTX_new(kdf.get());
+    EVP_KDF_CTX * raw_ctx = EVP_KDF_CTX_new(fetch_kdf());
     if (nullptr == raw_ctx)
     {
         throw openssl_error();
@@ -41,14 +70,179 @@ std::string pbkdf2(
         OSSL_PARAM_construct_end()
     };
 
-    char key[key_size];
     int const rc = EVP_KDF_derive(ctx.get(), reinterpret_cast<unsigned char*>(key), key_size, params);
     if (rc != 1)
     {
         throw openssl_error();
     }
+}
+
+void derive(pbkdf2_job & job)
+{
+    job.key.assign(key_size, '\0');
+    derive(job.password, job.salt, job.digest, job.iterations, &job.key[0]);
+}
+
+bool is_sha256(std::string const & digest)
+{
+    return (0 == strcasecmp(digest.c_str(), "sha256")) || (0 == strcasecmp(digest.c_str(), "sha2-256"));
+}
+
+// derives the keys of up to width jobs sharing the number of iterations
+void derive_lockstep(pbkdf2_job * const * jobs, size_t count, size_t width)
+{
+    if (width == 1)
+    {
+        derive(*jobs[0]);
+        return;
+    }
+
+    std::vector<pbkdf2_lane> lanes(width);
+    for (size_t i = 0; i < count; i++)
+    {
+        pbkdf2_prepare(lanes[i], jobs[i]->password, jobs[i]->salt);
+    }
+    // unused lanes repeat the first job
+    std::fill(lanes.begin() + count, lanes.end(), lanes[0]);
+
+    if (width == avx512_lanes)
+    {
+        pbkdf2_iterate_avx512(lanes.data(), jobs[0]->iterations);
+    }
+    else
+    {
+        pbkdf2_iterate_avx2(lanes.data(), jobs[0]->iterations);
+    }
+
+    for (size_t i = 0; i < width; i++)
+    {
+        std::string key = pbkdf2_finish(lanes[i]);
+        if (i < count)
+        {
+            jobs[i]->key = std::move(key);
+        }
+        else
+        {
+            OPENSSL_cleanse(key.data(), key.size());
+        }
+    }
+}
 
-    return std::string(key, key_size);
+// a single job is left to OpenSSL, which uses the SHA extensions if
+// available; lockstep pays off from two jobs with AVX-512 and three with AVX2
+size_t lockstep_width(size_t count)
+{
+    auto const & features = detect_cpu_features();
+    if (features.avx512f && (count >= 2))
+    {
+        return avx512_lanes;
+    }
+    if (features.avx2 && (count >= 3))
+    {
+        return avx2_lanes;
+    }
+    return 1;
+}
+
+}
+
+std::string pbkdf2(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations)
+{
+    std::string key(key_size, '\0');
+    pbkdf2(password, salt, digest, iterations, &key[0]);
+    return key;
+}
+
+void pbkdf2(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations,
+    char * key)
+{
+    if (cache().find(password, salt, digest, iterations, key))
+    {
+        return;
+    }
+
+    derive(password, salt, digest, iterations, key);
+    cache().insert(password, salt, digest, iterations, std::string_view(key, key_size));
+}
+
+void pbkdf2_batch(pbkdf2_job * jobs, size_t count, unsigned int threads)
+{
+    std::vector<pbkdf2_job*> pending;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto & job = jobs[i];
+        if (cache().find(job.password, job.salt, job.digest, job.iterations, job.key))
+        {
+            continue;
+        }
+
+        if (is_sha256(job.digest) && job.iterations > 0)
+        {
+            pending.push_back(&job);
+        }
+        else
+        {
+            derive(job);
+            cache().insert(job.password, job.salt, job.digest, job.iterations, job.key);
+        }
+    }
+
+    // lanes run the same number of iterations, so jobs are grouped by them
+    std::stable_sort(pending.begin(), pending.end(),
+        [](pbkdf2_job const * lhs, pbkdf2_job const * rhs) { return lhs->iterations < rhs->iterations; });
+
+    struct group
+    {
+        size_t offset;
+        size_t count;
+        size_t width;
+    };
+    std::vector<group> groups;
+    for (size_t begin = 0; begin < pending.size();)
+    {
+        size_t end = begin;
+        while ((end < pending.size()) && (pending[end]->iterations == pending[begin]->iterations))
+        {
+            end++;
+        }
+
+        for (size_t offset = begin; offset < end;)
+        {
+            size_t const width = lockstep_width(end - offset);
+            size_t const size = std::min(width, end - offset);
+            groups.push_back({offset, size, width});
+            offset += size;
+        }
+        begin = end;
+    }
+
+    parallel_for(groups.size(), threads, [&](size_t i)
+    {
+        derive_lockstep(&pending[groups[i].offset], groups[i].count, groups[i].width);
+    });
+
+    for (auto const * job: pending)
+    {
+        cache().insert(job->password, job->salt, job->digest, job->iterations, job->key);
+    }
+}
+
+pbkdf2_cache_stats pbkdf2_cache_statistics()
+{
+    return {cache().hits(), cache().misses()};
+}
+
+void pbkdf2_cache_clear()
+{
+    cache().clear();
 }
 
 void pbkdf2_generate_params(
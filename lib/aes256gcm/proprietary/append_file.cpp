@@ -0,0 +1,201 @@
+#include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+#include "aes256gcm/proprietary/undo_journal.hpp"
+#include "aes256gcm/parallel_for.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+// reads until the buffer is full or the stream ends
+size_t read_stream(std::istream & in, char * buffer, size_t size)
+{
+    size_t total = 0;
+    while ((total < size) && (in.good()))
+    {
+        in.read(&buffer[total], size - total);
+        total += in.gcount();
+    }
+
+    if (in.bad())
+    {
+        throw std::runtime_error("failed to read from stream");
+    }
+
+    return total;
+}
+
+}
+
+int append_encrypted(
+    std::string const & filename,
+    std::istream & in,
+    std::string const & password,
+    file_options const & options)
+{
+    undo_journal::recover(filename);
+
+    encryption_info info;
+    if (!get_encryption_info(filename, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if ((info.is_stream) || (info.segment_size == 0) || (!info.compression.empty()))
+    {
+        std::cerr << "error: only segmented, uncompressed files can be appended to" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (info.segment_size > max_segment_size)
+    {
+        std::cerr << "error: invalid segment size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!is_aead_available(info.encryption_method))
+    {
+        std::cerr << "error: unsupported encryption method: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t const segment_size = info.segment_size;
+    size_t const stored_size = segment_size + segment_overhead;
+    uint64_t const payload_size = std::filesystem::file_size(filename) - info.size;
+    uint64_t const old_count = stored_segment_count(payload_size, segment_size);
+    if (old_count == 0)
+    {
+        std::cerr << "error: invalid payload size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto const key_buffer = derive_secure_key(password, info.kdf);
+    auto const key = key_buffer.view();
+    if (!check_key(key, info))
+    {
+        std::cerr << "error: wrong password" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    file_descriptor file(filename, O_RDWR);
+
+    auto const key_id = context_key_id(key);
+    size_t const batch_size = std::max(options.threads, 1u) * segments_per_thread;
+    std::vector<char> plain(batch_size * segment_size);
+    std::vector<char> stored(batch_size * stored_size);
+
+    // The former last segment is decrypted and becomes the start of the
+    // appended data, as it has to be encrypted again without the last flag.
+    // This also checks the password before anything is written.
+    uint64_t first = old_count - 1;
+    size_t const tail_size = static_cast<size_t>(payload_size - first * stored_size);
+    size_t filled = tail_size - segment_overhead;
+    if ((read_at(file.get(), stored.data(), tail_size, first * stored_size) != tail_size)
+        || (!decrypt_segment(key, key_id, segment_additional_data(info.additional_data, first, true),
+                stored.data(), tail_size, plain.data(), info.encryption_method)))
+    {
+        std::cerr << "error: failed to decrypt file" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    filled += read_stream(in, &plain[filled], plain.size() - filled);
+    if (filled == tail_size - segment_overhead)
+    {
+        // nothing to append
+        return EXIT_SUCCESS;
+    }
+
+    // the former last segment and the encryption info are overwritten
+    undo_journal journal(filename, file.get());
+    journal.save(first * stored_size, payload_size - first * stored_size + info.size);
+    journal.sync();
+
+    // digests are kept up to date if the file stores them
+    bool const has_digests = (info.segment_digests.size() == old_count * segment_digest_size);
+    auto const digest_key = has_digests ? segment_digest_key(key) : secure_buffer();
+    info.segment_digests.resize(has_digests ? first * segment_digest_size : 0);
+
+    uint64_t new_payload_size = first * stored_size;
+    bool is_final = false;
+    while (!is_final)
+    {
+        is_final = (filled < plain.size()) || (in.peek() == std::istream::traits_type::eof());
+        size_t const count = static_cast<size_t>(segment_count(filled, segment_size));
+        if (has_digests)
+        {
+            info.segment_digests.resize((first + count) * segment_digest_size);
+        }
+
+        parallel_for(count, options.threads, [&](size_t i)
+        {
+            uint64_t const index = first + i;
+            size_t const offset = i * segment_size;
+            size_t const size = std::min(segment_size, filled - offset);
+            bool const is_last = (is_final) && (i + 1 == count);
+
+            // fresh nonces, as the derived nonces of these segments may have
+            // been used before, e.g. for the former last segment
+            encrypt_segment(key, key_id, rand(nonce_size), segment_additional_data(info.additional_data, index, is_last),
+                &plain[offset], size, &stored[i * stored_size], info.encryption_method);
+            if (has_digests)
+            {
+                segment_digest(digest_key.view(), index, &plain[offset], size, &info.segment_digests[index * segment_digest_size]);
+            }
+        });
+
+        size_t const size = filled + count * segment_overhead;
+        write_at(file.get(), stored.data(), size, first * stored_size);
+        new_payload_size = first * stored_size + size;
+
+        first += count;
+        filled = is_final ? 0 : read_stream(in, plain.data(), plain.size());
+    }
+
+    if (info.segment_digests.size() > max_segment_digests_size)
+    {
+        // too many segments; updates fall back to comparing decrypted segments
+        info.segment_digests.clear();
+    }
+
+    std::vector<char> data;
+    create_encryption_info(data, info);
+    write_at(file.get(), data.data(), data.size(), new_payload_size);
+    if (0 != ftruncate(file.get(), static_cast<off_t>(new_payload_size + data.size())))
+    {
+        throw std::runtime_error("failed to resize file");
+    }
+    journal.commit();
+    file.close();
+
+    return EXIT_SUCCESS;
+}
+
+int append_encrypted(
+    std::string const & filename,
+    std::string const & data,
+    std::string const & password,
+    file_options const & options)
+{
+    std::istringstream in(data);
+    return append_encrypted(filename, in, password, options);
+}
+
+}
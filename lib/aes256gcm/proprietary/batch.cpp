@@ -0,0 +1,284 @@
+#include "aes256gcm/batch.hpp"
+#include "aes256gcm/metadata_catalog.hpp"
+#include "aes256gcm/work_stealing_pool.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/kdf.hpp"
+#include "aes256gcm/constants.hpp"
+
+#include <openssl/crypto.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+void process(
+    batch_operation operation,
+    batch_job const & job,
+    std::string const & password,
+    file_options const & options)
+{
+    if (operation == batch_operation::verify)
+    {
+        if (verify_file(job.input_filename, password, options) != EXIT_SUCCESS)
+        {
+            throw std::runtime_error("failed to verify file");
+        }
+        return;
+    }
+
+    if (!job.output_filename.empty())
+    {
+        auto const parent = std::filesystem::path(job.output_filename).parent_path();
+        if (!parent.empty())
+        {
+            std::filesystem::create_directories(parent);
+        }
+    }
+
+    if (operation == batch_operation::encrypt)
+    {
+        if (job.output_filename.empty())
+        {
+            encrypt_file_inplace(job.input_filename, password, "", options);
+        }
+        else
+        {
+            encrypt_file(job.input_filename, job.output_filename, password, "", options);
+        }
+        return;
+    }
+
+    int const rc = job.output_filename.empty()
+        ? decrypt_file_inplace(job.input_filename, password, options)
+        : decrypt_file(job.input_filename, job.output_filename, password, options);
+    if (rc != EXIT_SUCCESS)
+    {
+        throw std::runtime_error("failed to decrypt file");
+    }
+}
+
+using ordered_job = std::pair<uintmax_t, batch_job const *>;
+
+// derives the PBKDF2 keys of encrypted files in lockstep, so that the
+// workers find them in the key cache
+void derive_keys(
+    ordered_job const * begin,
+    ordered_job const * end,
+    std::string const & password,
+    unsigned int workers,
+    metadata_catalog * catalog)
+{
+    std::vector<pbkdf2_job> kdf_jobs;
+    for (auto const * entry = begin; entry != end; entry++)
+    {
+        encryption_info info;
+        try
+        {
+            bool const has_info = (nullptr != catalog)
+                ? (nullptr == catalog->lookup(entry->second->input_filename, info))
+                : get_encryption_info(entry->second->input_filename, info);
+            if (has_info
+                && (info.kdf.algorithm.empty() || (info.kdf.algorithm == kdf_pbkdf2)))
+            {
+                kdf_jobs.push_back({password, info.kdf.salt, info.kdf.digest, info.kdf.iterations, ""});
+            }
+        }
+        catch (...)
+        {
+            // reported when the file is processed
+        }
+    }
+
+    try
+    {
+        pbkdf2_batch(kdf_jobs.data(), kdf_jobs.size(), workers);
+    }
+    catch (...)
+    {
+        // keys are derived again when the files are processed
+    }
+
+    for (auto & job: kdf_jobs)
+    {
+        OPENSSL_cleanse(job.key.data(), job.key.size());
+    }
+}
+
+}
+
+std::vector<batch_failure> run_batch(
+    batch_operation operation,
+    std::vector<batch_job> const & jobs,
+    std::string const & password,
+    unsigned int workers,
+    file_options const & options)
+{
+    // largest files first, so that small files fill the gaps at the end
+    std::vector<ordered_job> ordered;
+    ordered.reserve(jobs.size());
+    for (auto const & job: jobs)
+    {
+        std::error_code ec;
+        auto const size = std::filesystem::file_size(job.input_filename, ec);
+        ordered.emplace_back(ec ? 0 : size, &job);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+        [](auto const & a, auto const & b) { return a.first > b.first; });
+
+    std::vector<batch_failure> failures;
+    std::mutex failures_mutex;
+    auto const add_failure = [&](batch_job const & job, std::string const & message)
+    {
+        std::lock_guard<std::mutex> lock(failures_mutex);
+        failures.push_back({job.input_filename, message});
+    };
+
+    auto const run = [&](batch_job const & job)
+    {
+        try
+        {
+            process(operation, job, password, options);
+        }
+        catch (std::exception const & ex)
+        {
+            add_failure(job, ex.what());
+        }
+        catch (...)
+        {
+            add_failure(job, "unexpected error");
+        }
+    };
+
+    // When decrypting or verifying, keys are derived ahead in windows of half
+    // the key cache: the keys of the next window are derived while the files
+    // of the current one are processed, and a window is derived only after
+    // the files two windows back are done, so no key is evicted before use.
+    bool const derives_ahead = (operation != batch_operation::encrypt);
+    size_t const window = derives_ahead ? std::max(kdf_cache_capacity / 2, size_t(1))
+        : std::max(ordered.size(), size_t(1));
+    size_t const window_count = (ordered.size() + window - 1) / window;
+    std::vector<size_t> remaining(window_count, 0);
+    std::mutex remaining_mutex;
+    std::condition_variable window_done;
+    {
+        work_stealing_pool pool(workers);
+        for (size_t w = 0; w < window_count; w++)
+        {
+            auto const * const begin = ordered.data() + w * window;
+            auto const * const end = ordered.data() + std::min((w + 1) * window, ordered.size());
+            if (derives_ahead)
+            {
+                if (w >= 2)
+                {
+                    std::unique_lock<std::mutex> lock(remaining_mutex);
+                    window_done.wait(lock, [&]() { return remaining[w - 2] == 0; });
+                }
+                derive_keys(begin, end, password, workers, options.catalog);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(remaining_mutex);
+                remaining[w] = static_cast<size_t>(end - begin);
+            }
+            for (auto const * entry = begin; entry != end; entry++)
+            {
+                pool.submit([&, w, job = entry->second]()
+                {
+                    run(*job);
+
+                    bool done = false;
+                    {
+                        std::lock_guard<std::mutex> lock(remaining_mutex);
+                        done = (--remaining[w] == 0);
+                    }
+                    if (done)
+                    {
+                        window_done.notify_all();
+                    }
+                });
+            }
+        }
+        pool.wait();
+    }
+
+    return failures;
+}
+
+std::vector<batch_job> scan_directory(
+    std::string const & input_directory,
+    std::string const & output_directory)
+{
+    std::vector<batch_job> jobs;
+    for (auto const & entry: std::filesystem::recursive_directory_iterator(input_directory))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+
+        batch_job job;
+        job.input_filename = entry.path().string();
+        if (!output_directory.empty())
+        {
+            auto const relative = std::filesystem::relative(entry.path(), input_directory);
+            job.output_filename = (std::filesystem::path(output_directory) / relative).string();
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+std::vector<batch_job> read_manifest(
+    std::string const & manifest_filename)
+{
+    std::ifstream manifest(manifest_filename);
+    if (!manifest)
+    {
+        throw std::runtime_error("failed to open manifest");
+    }
+
+    std::vector<batch_job> jobs;
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        if ((!line.empty()) && (line.back() == '\r'))
+        {
+            line.pop_back();
+        }
+
+        if (line.empty())
+        {
+            continue;
+        }
+
+        batch_job job;
+        auto const separator = line.find('\t');
+        job.input_filename = line.substr(0, separator);
+        if (separator != std::string::npos)
+        {
+            job.output_filename = line.substr(separator + 1);
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    if (manifest.bad())
+    {
+        throw std::runtime_error("failed to read manifest");
+    }
+
+    return jobs;
+}
+
+}
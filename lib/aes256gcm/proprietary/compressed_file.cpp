@@ -0,0 +1,283 @@
+#include "aes256gcm/proprietary/compressed_file.hpp"
+#include "aes256gcm/codec.hpp"
+#include "aes256gcm/parallel_for.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+// a prefix of each block is compressed first; if it does not shrink, the
+// block is stored without compressing the rest
+constexpr size_t const compression_sample_size = 64 * 1024;
+
+void store_be32(uint32_t value, char * data)
+{
+    data[0] = static_cast<char>(value >> 24);
+    data[1] = static_cast<char>(value >> 16);
+    data[2] = static_cast<char>(value >> 8);
+    data[3] = static_cast<char>(value);
+}
+
+uint32_t load_be32(char const * data)
+{
+    return (static_cast<uint32_t>(static_cast<unsigned char>(data[0])) << 24)
+        | (static_cast<uint32_t>(static_cast<unsigned char>(data[1])) << 16)
+        | (static_cast<uint32_t>(static_cast<unsigned char>(data[2])) << 8)
+        | static_cast<uint32_t>(static_cast<unsigned char>(data[3]));
+}
+
+class compressing_input: public input_file
+{
+public:
+    compressing_input(
+        std::unique_ptr<input_file> in,
+        std::string const & compression,
+        int level,
+        unsigned int threads)
+    : m_in(std::move(in))
+    , m_compression(compression)
+    , m_level(level)
+    , m_threads(std::max(threads, 1u))
+    , m_raw(m_threads * compression_block_size)
+    , m_raw_sizes(m_threads)
+    , m_blocks(m_threads)
+    , m_offset(0)
+    , m_eof(false)
+    {
+    }
+
+    size_t read(char * buffer, size_t size) override
+    {
+        size_t total = 0;
+        while (total < size)
+        {
+            if (m_offset == m_pending.size())
+            {
+                if (m_eof)
+                {
+                    break;
+                }
+                fill();
+                continue;
+            }
+
+            size_t const chunk = std::min(size - total, m_pending.size() - m_offset);
+            memcpy(&buffer[total], &m_pending[m_offset], chunk);
+            m_offset += chunk;
+            total += chunk;
+        }
+
+        return total;
+    }
+
+private:
+    void fill()
+    {
+        size_t count = 0;
+        while ((count < m_threads) && (!m_eof))
+        {
+            size_t const bytes_read = m_in->read(&m_raw[count * compression_block_size], compression_block_size);
+            if (bytes_read > 0)
+            {
+                m_raw_sizes[count++] = bytes_read;
+            }
+            m_eof = (bytes_read < compression_block_size);
+        }
+
+        parallel_for(count, m_threads, [this](size_t i) { compress(i); });
+
+        m_pending.clear();
+        m_offset = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            m_pending.insert(m_pending.end(), m_blocks[i].begin(), m_blocks[i].end());
+        }
+    }
+
+    void compress(size_t index)
+    {
+        char const * raw = &m_raw[index * compression_block_size];
+        size_t const raw_size = m_raw_sizes[index];
+        auto & block = m_blocks[index];
+
+        // compressed blocks must save at least 1/64 of their size
+        block.resize(compression_block_header_size + raw_size);
+        char * stored = &block[compression_block_header_size];
+        size_t stored_size = 0;
+        if ((raw_size < 2 * compression_sample_size)
+            || (0 != compress_block(m_compression, m_level, raw, compression_sample_size, stored,
+                    compression_sample_size - compression_sample_size / 64)))
+        {
+            stored_size = compress_block(m_compression, m_level, raw, raw_size, stored, raw_size - raw_size / 64);
+        }
+
+        uint32_t flags = 0;
+        if (stored_size == 0)
+        {
+            memcpy(stored, raw, raw_size);
+            stored_size = raw_size;
+            flags = stored_uncompressed_flag;
+        }
+
+        store_be32(static_cast<uint32_t>(raw_size), &block[0]);
+        store_be32(static_cast<uint32_t>(stored_size) | flags, &block[4]);
+        block.resize(compression_block_header_size + stored_size);
+    }
+
+    std::unique_ptr<input_file> m_in;
+    std::string const m_compression;
+    int const m_level;
+    unsigned int const m_threads;
+    std::vector<char> m_raw;
+    std::vector<size_t> m_raw_sizes;
+    std::vector<std::vector<char>> m_blocks;
+    std::vector<char> m_pending;
+    size_t m_offset;
+    bool m_eof;
+};
+
+class decompressing_output: public output_file
+{
+public:
+    decompressing_output(
+        std::unique_ptr<output_file> out,
+        std::string const & compression,
+        unsigned int threads)
+    : m_out(std::move(out))
+    , m_compression(compression)
+    , m_threads(std::max(threads, 1u))
+    , m_raw(m_threads)
+    {
+    }
+
+    void write(char const * data, size_t size) override
+    {
+        m_pending.insert(m_pending.end(), data, &data[size]);
+        process(false);
+    }
+
+    void close() override
+    {
+        process(true);
+        if (!m_pending.empty())
+        {
+            throw compression_error("truncated compressed data");
+        }
+        m_out->close();
+    }
+
+private:
+    struct block
+    {
+        size_t offset;          ///< offset of the stored data in m_pending
+        size_t raw_size;
+        size_t stored_size;
+        bool is_compressed;
+    };
+
+    // decompresses complete blocks, once there are enough to keep all threads busy
+    void process(bool is_final)
+    {
+        size_t consumed = 0;
+        while (true)
+        {
+            std::vector<block> blocks;
+            size_t offset = consumed;
+            while ((blocks.size() < m_threads) && (m_pending.size() - offset >= compression_block_header_size))
+            {
+                size_t const raw_size = load_be32(&m_pending[offset]);
+                uint32_t const stored = load_be32(&m_pending[offset + 4]);
+                size_t const stored_size = stored & ~stored_uncompressed_flag;
+                bool const is_compressed = (stored & stored_uncompressed_flag) == 0;
+                if ((raw_size > max_compression_block_size) || (stored_size > max_compression_block_size)
+                    || ((!is_compressed) && (stored_size != raw_size)))
+                {
+                    throw compression_error("invalid compressed block");
+                }
+
+                if (m_pending.size() - offset - compression_block_header_size < stored_size)
+                {
+                    break;
+                }
+
+                blocks.push_back({offset + compression_block_header_size, raw_size, stored_size, is_compressed});
+                offset += compression_block_header_size + stored_size;
+            }
+
+            if ((blocks.empty()) || ((blocks.size() < m_threads) && (!is_final)))
+            {
+                break;
+            }
+
+            parallel_for(blocks.size(), m_threads, [&](size_t i)
+            {
+                auto const & b = blocks[i];
+                if (b.is_compressed)
+                {
+                    m_raw[i].resize(b.raw_size);
+                    if (!decompress_block(m_compression, &m_pending[b.offset], b.stored_size, m_raw[i].data(), b.raw_size))
+                    {
+                        throw compression_error("invalid compressed block");
+                    }
+                }
+            });
+
+            for (size_t i = 0; i < blocks.size(); i++)
+            {
+                auto const & b = blocks[i];
+                m_out->write(b.is_compressed ? m_raw[i].data() : &m_pending[b.offset], b.raw_size);
+            }
+            consumed = offset;
+        }
+
+        m_pending.erase(m_pending.begin(), m_pending.begin() + consumed);
+    }
+
+    std::unique_ptr<output_file> m_out;
+    std::string const m_compression;
+    unsigned int const m_threads;
+    std::vector<std::vector<char>> m_raw;
+    std::vector<char> m_pending;
+};
+
+}
+
+std::string compression_additional_data(
+    std::string const & additional_data,
+    std::string const & compression)
+{
+    if (compression.empty())
+    {
+        return additional_data;
+    }
+
+    std::string result = additional_data;
+    result.push_back('\0');
+    result.append(compression);
+    return result;
+}
+
+std::unique_ptr<input_file> compress_input(
+    std::unique_ptr<input_file> in,
+    std::string const & compression,
+    int level,
+    unsigned int threads)
+{
+    return std::make_unique<compressing_input>(std::move(in), compression, level, threads);
+}
+
+std::unique_ptr<output_file> decompress_output(
+    std::unique_ptr<output_file> out,
+    std::string const & compression,
+    unsigned int threads)
+{
+    return std::make_unique<decompressing_output>(std::move(out), compression, threads);
+}
+
+}
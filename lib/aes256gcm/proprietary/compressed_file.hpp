@@ -0,0 +1,75 @@
+#ifndef AES256GCM_PROPRIETARY_COMPRESSED_FILE_HPP
+#define AES256GCM_PROPRIETARY_COMPRESSED_FILE_HPP
+
+#include "aes256gcm/proprietary/io_engine.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace aes256gcm::proprietary
+{
+
+// A compressed payload is compressed before encryption as a sequence of
+// independent blocks. Each block is stored as the big-endian 32 bit size of
+// the uncompressed data, the big-endian 32 bit size of the stored data and
+// the stored data. Blocks which do not compress are stored uncompressed,
+// marked by the most significant bit of the stored size.
+
+constexpr size_t const compression_block_size = 1024 * 1024;
+constexpr size_t const max_compression_block_size = 16 * 1024 * 1024;
+constexpr size_t const compression_block_header_size = 8;
+constexpr uint32_t const stored_uncompressed_flag = 0x80000000;
+
+/// @brief Thrown on malformed compressed data.
+class compression_error: public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// @brief Returns the additional authenticated data of a compressed payload.
+///
+/// Binds the codec to the ciphertext, so that removing the compression
+/// from the encryption info fails authentication instead of returning
+/// the compressed data.
+///
+/// @param additional_data additional data of the file
+/// @param compression canonical name of the codec; empty if not compressed
+std::string compression_additional_data(
+    std::string const & additional_data,
+    std::string const & compression);
+
+/// @brief Wraps a file, so that reading returns its compressed blocks.
+///
+/// Blocks are compressed using up to the given number of threads.
+///
+/// @param in file to read uncompressed data from
+/// @param compression canonical name of the codec
+/// @param level compression level; 0 selects the codec's default
+/// @param threads maximum number of threads to use
+std::unique_ptr<input_file> compress_input(
+    std::unique_ptr<input_file> in,
+    std::string const & compression,
+    int level,
+    unsigned int threads);
+
+/// @brief Wraps a file, so that written compressed blocks are stored decompressed.
+///
+/// Memory is bounded by the number of threads times the block size,
+/// independent of the size of the file.
+///
+/// @note write and close throw a compression_error on malformed blocks.
+///
+/// @param out file to write decompressed data to
+/// @param compression canonical name of the codec
+/// @param threads maximum number of threads to use
+std::unique_ptr<output_file> decompress_output(
+    std::unique_ptr<output_file> out,
+    std::string const & compression,
+    unsigned int threads);
+
+}
+
+#endif
@@ -1,66 +1,118 @@
 #include "aes256gcm/proprietary.hpp"
 #include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/proprietary/transform_file.hpp"
+#include "aes256gcm/proprietary/compressed_file.hpp"
+#include "aes256gcm/proprietary/verify.hpp"
 #include "aes256gcm/decrypter.hpp"
-#include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/compression.hpp"
+#include "aes256gcm/secure_pool.hpp"
 
-#include <fstream>
+#include <algorithm>
 #include <stdexcept>
 #include <filesystem>
+#include <fstream>
 
 #include <iostream>
 
 namespace aes256gcm::proprietary
 {
 
-    
-int decrypt_file(
+namespace
+{
+
+std::unique_ptr<output_file> open_output(
+    std::string const & filename,
+    encryption_info const & info,
+    file_options const & options)
+{
+    auto out = open_output_file(filename, options);
+    if (!info.compression.empty())
+    {
+        out = decompress_output(std::move(out), info.compression, options.threads);
+    }
+    return out;
+}
+
+int decrypt_payload(
     std::string const & input_filename,
     std::string const & output_filename,
-    std::string const & password)
+    std::string const & password,
+    encryption_info const & info,
+    file_options const & options)
 {
-    encryption_info info;
-    if (!get_encryption_info(input_filename, info))
+    auto const key_buffer = derive_secure_key(password, info.kdf);
+    auto const key = key_buffer.view();
+    if (!check_key(key, info))
     {
+        std::cerr << "error: wrong password" << std::endl;
         return EXIT_FAILURE;
     }
 
-    auto const key = pbkdf2(password, info.kdf.salt, info.kdf.digest, info.kdf.iterations);
-    decrypter dec(key, info.nonce, info.tag, info.additional_data);
-
     auto const file_size = std::filesystem::file_size(input_filename);
-    auto remaining = file_size - info.size;
 
-    {
-        std::ifstream in(input_filename);
-        std::ofstream out(output_filename);
+    auto authenticated_info = info;
+    authenticated_info.additional_data = compression_additional_data(info.additional_data, info.compression);
 
-        constexpr size_t const buffer_size = 100 * 1024;
-        std::vector<char> in_buffer(buffer_size);
-        std::vector<char> out_buffer(buffer_size);
-
-        while ((in) && (out) && (remaining > 0))
+    if (info.segment_size > 0)
+    {
+        if (info.segment_size > max_segment_size)
         {
-            auto const chunk_size = std::min(remaining, buffer_size);
-            in.read(in_buffer.data(), chunk_size);
-            auto const bytes_read = in.gcount();
+            std::cerr << "error: invalid segment size" << std::endl;
+            return EXIT_FAILURE;
+        }
 
-            if (bytes_read > 0)
-            {
-                dec.update(in_buffer.data(), out_buffer.data(), bytes_read);
-                out.write(out_buffer.data(), bytes_read);
-                remaining -= bytes_read;
-            }
+        bool is_authentic = false;
+        {
+            auto in = open_input_file(input_filename, options);
+            auto out = open_output(output_filename, info, options);
+            is_authentic = decrypt_segments(*in, *out, key, authenticated_info, file_size - info.size, options);
+            out->close();
         }
 
-        if (in.bad())
+        if (!is_authentic)
         {
-            throw std::runtime_error("failed to read from file");        
+            std::filesystem::remove(output_filename);
+            std::cerr << "error: failed to decrypt file" << std::endl;
+            return EXIT_FAILURE;
         }
 
-        if (out.bad())
+        return EXIT_SUCCESS;
+    }
+
+    // A single tag is checked after the whole payload is decrypted, so the
+    // codec would parse unauthenticated data. Compressed files written
+    // without segments are therefore authenticated before decrypting them.
+    if ((!info.compression.empty()) && (!verify_payload(input_filename, key, info, options)))
+    {
+        std::cerr << "error: failed to decrypt file" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    decrypter dec(key, info.nonce, info.tag, authenticated_info.additional_data, info.encryption_method);
+    auto const data_size = file_size - info.size;
+
+    {
+        auto in = open_input_file(input_filename, options);
+        auto out = open_output(output_filename, info, options);
+
+        size_t const buffer_size = align_to_block(options.buffer_size);
+        auto const bytes_read = transform_file(*in, *out, data_size, buffer_size, buffer_size,
+            [&dec](char const * in_buffer, size_t size, char * out_buffer)
+            {
+                dec.update(in_buffer, out_buffer, size);
+                return size;
+            }, options);
+
+        if (bytes_read != data_size)
         {
-            throw std::runtime_error("failed to write to file");
+            throw std::runtime_error("failed to read from file");
         }
+
+        out->close();
     }
 
     if (!dec.finalize())
@@ -73,5 +125,65 @@ int decrypt_file(
     return EXIT_SUCCESS;
 }
 
+}
+
+int decrypt_file(
+    std::string const & input_filename,
+    std::string const & output_filename,
+    std::string const & password,
+    file_options const & options)
+{
+    encryption_info info;
+    if (!get_encryption_info(input_filename, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (info.is_stream)
+    {
+        int result = EXIT_FAILURE;
+        {
+            std::ifstream in(input_filename, std::ios_base::binary);
+            std::ofstream out(output_filename, std::ios_base::binary | std::ios_base::trunc);
+            result = decrypt_stream(in, out, password);
+        }
+
+        if (result != EXIT_SUCCESS)
+        {
+            std::filesystem::remove(output_filename);
+        }
+        return result;
+    }
+
+    if (!is_aead_available(info.encryption_method))
+    {
+        std::cerr << "error: unsupported encryption method: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if ((info.segment_size == 0) && is_single_update_aead(info.encryption_method))
+    {
+        std::cerr << "error: encryption method requires segments: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if ((!info.compression.empty()) && (!is_compression_available(info.compression)))
+    {
+        std::cerr << "error: unsupported compression: " << info.compression << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        return decrypt_payload(input_filename, output_filename, password, info, options);
+    }
+    catch (compression_error const & ex)
+    {
+        std::filesystem::remove(output_filename);
+        std::cerr << "error: failed to decrypt file: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
 
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "aes256gcm/proprietary.hpp"
 #include "aes256gcm/proprietary/encryption_info.hpp"
-#include "aes256gcm/proprietary/memmapped_file.hpp"
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/proprietary/verify.hpp"
 
 #include "aes256gcm/decrypter.hpp"
-#include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/parallel_gcm.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/secure_pool.hpp"
 
 #include <iostream>
 #include <filesystem>
@@ -14,7 +18,8 @@ namespace aes256gcm::proprietary
 
 int decrypt_file_inplace(
     std::string const & filename,
-    std::string const & password)
+    std::string const & password,
+    file_options const & options)
 {
     encryption_info info;
     if (!get_encryption_info(filename, info))
@@ -22,19 +27,84 @@ int decrypt_file_inplace(
         return EXIT_FAILURE;
     }
 
-    auto const key = pbkdf2(password, info.kdf.salt, info.kdf.digest, info.kdf.iterations);
-    decrypter dec(key, info.nonce, info.tag, info.additional_data);
+    if (info.is_stream)
+    {
+        std::cerr << "error: streams cannot be decrypted inplace" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (info.segment_size > 0)
+    {
+        std::cerr << "error: segmented files cannot be decrypted inplace" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!info.compression.empty())
+    {
+        std::cerr << "error: compressed files cannot be decrypted inplace" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!is_aead_available(info.encryption_method))
+    {
+        std::cerr << "error: unsupported encryption method: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if ((info.segment_size == 0) && is_single_update_aead(info.encryption_method))
+    {
+        std::cerr << "error: encryption method requires segments: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto const key_buffer = derive_secure_key(password, info.kdf);
+    auto const key = key_buffer.view();
+    if (!check_key(key, info))
+    {
+        std::cerr << "error: wrong password" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if ((options.verify_inplace) && (!verify_payload(filename, key, info, options)))
+    {
+        std::cerr << "error: failed to verify file (file data corrupted or wrong password), file left unchanged" << std::endl;
+        return EXIT_FAILURE;
+    }
 
     auto const file_size = std::filesystem::file_size(filename);
     auto const data_size = file_size - info.size;
-    std::filesystem::resize_file(filename, data_size);
 
+    bool is_authentic = false;
+    if ((options.threads > 1) && (info.encryption_method == algorithm_aes256_gcm))
+    {
+        parallel_gcm gcm(key, info.nonce, info.additional_data, options.threads);
+        std::filesystem::resize_file(filename, data_size);
+        {
+            auto file = open_inplace_file(filename, options);
+            do
+            {
+                gcm.decrypt_inplace(file->address(), file->size());
+            } while (file->next());
+            file->close();
+        }
+        is_authentic = gcm.verify(info.tag);
+    }
+    else
     {
-        memmapped_file file(filename);
-        dec.update_inplace(file.address(), file.size());
+        decrypter dec(key, info.nonce, info.tag, info.additional_data, info.encryption_method);
+        std::filesystem::resize_file(filename, data_size);
+        {
+            auto file = open_inplace_file(filename, options);
+            do
+            {
+                dec.update_inplace(file->address(), file->size());
+            } while (file->next());
+            file->close();
+        }
+        is_authentic = dec.finalize();
     }
 
-    if (!dec.finalize())
+    if (!is_authentic)
     {
         std::cerr << "error: failed to decrypt file (file data corrupted)" << std::endl;
         return EXIT_FAILURE;
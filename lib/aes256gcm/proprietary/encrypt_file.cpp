@@ -1,11 +1,23 @@
 #include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/metadata_catalog.hpp"
 #include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/proprietary/transform_file.hpp"
+#include "aes256gcm/proprietary/compressed_file.hpp"
 #include "aes256gcm/encrypter.hpp"
-#include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/compression.hpp"
+#include "aes256gcm/codec.hpp"
+#include "aes256gcm/secure_pool.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <fstream>
 #include <filesystem>
+#include <stdexcept>
 
 namespace aes256gcm::proprietary
 {
@@ -14,62 +26,127 @@ void encrypt_file(
     std::string const & input_filename,
     std::string const & output_filename,
     std::string const & password,
-    std::string const & additional_data)
+    std::string const & additional_data,
+    file_options const & options)
 {
-    try
+    if (options.segment_size > max_segment_size)
     {
-        std::string salt;
-        std::string digest;
-        unsigned int iterations;
-        pbkdf2_generate_params(salt, digest, iterations);
+        throw std::logic_error("invalid segment size");
+    }
 
-        auto const key = pbkdf2(password, salt, digest, iterations);
+    if ((options.segment_size == 0) && (!options.compression.empty()))
+    {
+        // compressed data is always stored in segments, so that decryption
+        // only passes authenticated segments to the codec
+        auto segmented = options;
+        segmented.segment_size = default_segment_size;
+        encrypt_file(input_filename, output_filename, password, additional_data, segmented);
+        return;
+    }
 
-        encrypter enc(key, additional_data);
+    if ((options.segment_size == 0) && is_single_update_aead(select_aead(options.algorithm)))
+    {
+        throw std::logic_error("algorithm requires a segment size: " + options.algorithm);
+    }
 
-        std::ifstream in(input_filename);    
-        std::ofstream out(output_filename);
+    if (options.segment_digests)
+    {
+        if ((options.segment_size == 0) || (!options.compression.empty()))
+        {
+            throw std::logic_error("segment digests require a segment size and no compression");
+        }
 
-        std::vector<char> in_buffer;
-        std::vector<char> out_buffer;
+        if (segment_count(std::filesystem::file_size(input_filename), options.segment_size) * segment_digest_size
+            > max_segment_digests_size)
+        {
+            throw std::logic_error("too many segments to store segment digests");
+        }
+    }
 
-        while (in)
+    encryption_info info = {};
+    try
+    {
+        auto const kdf = generate_kdf_params(options.kdf, options.kdf_time_cost, options.kdf_memory_cost, options.kdf_lanes);
+        auto const key_buffer = derive_secure_key(password, kdf);
+        auto const key = key_buffer.view();
+        auto const algorithm = select_aead(options.algorithm);
+        auto const compression = options.compression.empty() ? std::string() : select_compression(options.compression);
+        if (!compression.empty())
         {
-            constexpr size_t const buffer_size = 100 * 1024;
-            in_buffer.resize(buffer_size);
-            in.read(in_buffer.data(), in_buffer.size());
-            in_buffer.resize(in.gcount());
+            check_compression_level(compression, options.compression_level);
+        }
+        auto const compression_level = ((compression.empty()) || (options.compression_level != 0))
+            ? options.compression_level : default_compression_level(compression);
+        auto const authenticated_data = compression_additional_data(additional_data, compression);
 
-            if (!in_buffer.empty())
-            {
-                out_buffer.resize(in_buffer.size());
-                enc.update(in_buffer.data(), out_buffer.data(), in_buffer.size());
-                out.write(out_buffer.data(), out_buffer.size());
-            }
+        auto in = open_input_file(input_filename, options);
+        auto out = open_output_file(output_filename, options);
+        if (!compression.empty())
+        {
+            in = compress_input(std::move(in), compression, compression_level, options.threads);
         }
 
-        if (in.bad())
+        std::string nonce;
+        std::string tag;
+        std::string digests;
+        if (options.segment_size > 0)
         {
-            throw std::runtime_error("failed to read from file");
+            nonce = rand(nonce_size);
+            encrypt_segments(*in, *out, key, nonce, authenticated_data, algorithm,
+                compression.empty() ? std::filesystem::file_size(input_filename) : unknown_data_size, options,
+                options.segment_digests ? &digests : nullptr);
         }
+        else
+        {
+            encrypter enc(key, rand(nonce_size), authenticated_data, algorithm);
 
-        auto const tag = enc.finalize();
-        auto const & nonce = enc.nonce();
+            uint64_t const expected_size = compression.empty() ? std::filesystem::file_size(input_filename) : 0;
+            size_t const buffer_size = align_to_block(options.buffer_size);
+            uint64_t const bytes_read = transform_file(*in, *out, UINT64_MAX, buffer_size, buffer_size,
+                [&enc](char const * in_buffer, size_t size, char * out_buffer)
+                {
+                    enc.update(in_buffer, out_buffer, size);
+                    return size;
+                }, options);
 
-        std::vector<char> info;
-        create_encryption_info(info, salt, digest, iterations, nonce, tag, additional_data);
-        out.write(info.data(), info.size());
+            // a file truncated or extended while it is read would otherwise
+            // be encrypted partially without notice
+            if (compression.empty() && (bytes_read != expected_size))
+            {
+                throw std::runtime_error("failed to read input file");
+            }
 
-        if (out.fail())
-        {
-            throw std::runtime_error("failed to write to file");
+            tag = enc.finalize();
+            nonce = enc.nonce();
         }
+
+        info.kdf = kdf;
+        info.encryption_method = algorithm;
+        info.nonce = nonce;
+        info.tag = tag;
+        info.additional_data = additional_data;
+        info.segment_size = options.segment_size;
+        info.compression = compression;
+        info.compression_level = compression_level;
+        info.segment_digests = digests;
+        info.key_check = key_check_value(key);
+
+        std::vector<char> data;
+        create_encryption_info(data, info);
+        out->write(data.data(), data.size());
+        out->close();
+        info.size = data.size();
     }
     catch (...)
     {
         std::filesystem::remove(output_filename);
         throw;
     }
+
+    if (nullptr != options.catalog)
+    {
+        options.catalog->update(output_filename, info);
+    }
 }
     
 
@@ -1,9 +1,15 @@
 #include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/metadata_catalog.hpp"
 #include "aes256gcm/proprietary/encryption_info.hpp"
-#include "aes256gcm/proprietary/memmapped_file.hpp"
+#include "aes256gcm/proprietary/io_engine.hpp"
 
 #include "aes256gcm/encrypter.hpp"
-#include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/parallel_gcm.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/secure_pool.hpp"
 
 #include <filesystem>
 #include <fstream>
@@ -14,34 +20,85 @@ namespace aes256gcm::proprietary
 void encrypt_file_inplace(
     std::string const & filename,
     std::string const & password,
-    std::string const & additional_data)
+    std::string const & additional_data,
+    file_options const & options)
 {
-    std::string salt;
-    std::string digest;
-    unsigned int iterations;
-    pbkdf2_generate_params(salt, digest, iterations);
-    auto const key = pbkdf2(password, salt, digest, iterations);
+    if (options.segment_size > 0)
+    {
+        throw std::logic_error("segmented files cannot be encrypted inplace");
+    }
 
-    encrypter enc(key, additional_data);
+    if (!options.compression.empty())
+    {
+        throw std::logic_error("files cannot be compressed inplace");
+    }
 
+    if (is_single_update_aead(select_aead(options.algorithm)))
     {
-        memmapped_file file(filename);
-        enc.update_inplace(file.address(), file.size());
+        throw std::logic_error("algorithm cannot be used inplace: " + options.algorithm);
     }
 
-    auto const tag = enc.finalize();
-    auto const & nonce = enc.nonce();
+    auto const kdf = generate_kdf_params(options.kdf, options.kdf_time_cost, options.kdf_memory_cost, options.kdf_lanes);
+    auto const key_buffer = derive_secure_key(password, kdf);
+    auto const key = key_buffer.view();
+    auto const algorithm = select_aead(options.algorithm);
+
+    std::string tag;
+    std::string nonce;
+    if ((options.threads > 1) && (algorithm == algorithm_aes256_gcm))
+    {
+        nonce = rand(nonce_size);
+        parallel_gcm gcm(key, nonce, additional_data, options.threads);
+        {
+            auto file = open_inplace_file(filename, options);
+            do
+            {
+                gcm.encrypt_inplace(file->address(), file->size());
+            } while (file->next());
+            file->close();
+        }
+        tag = gcm.tag();
+    }
+    else
+    {
+        encrypter enc(key, rand(nonce_size), additional_data, algorithm);
+        {
+            auto file = open_inplace_file(filename, options);
+            do
+            {
+                enc.update_inplace(file->address(), file->size());
+            } while (file->next());
+            file->close();
+        }
+        tag = enc.finalize();
+        nonce = enc.nonce();
+    }
 
     std::ofstream file(filename, std::ios_base::binary | std::ios_base::app);
 
-    std::vector<char> info;
-    create_encryption_info(info, salt, digest, iterations, nonce, tag, additional_data);
-    file.write(info.data(), info.size());
+    encryption_info info = {};
+    info.kdf = kdf;
+    info.encryption_method = algorithm;
+    info.nonce = nonce;
+    info.tag = tag;
+    info.additional_data = additional_data;
+    info.key_check = key_check_value(key);
+
+    std::vector<char> data;
+    create_encryption_info(data, info);
+    file.write(data.data(), data.size());
+    file.close();
 
     if (file.fail())
     {
         throw std::runtime_error("failed to write to file");
     }
+
+    if (nullptr != options.catalog)
+    {
+        info.size = data.size();
+        options.catalog->update(filename, info);
+    }
 }
     
 
@@ -0,0 +1,124 @@
+#include "aes256gcm/encrypted_reader.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/algorithm.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+encrypted_reader::encrypted_reader(
+    std::string const & filename,
+    std::string const & password)
+{
+    if (!get_encryption_info(filename, m_info))
+    {
+        throw std::runtime_error("missing encryption info");
+    }
+
+    if ((m_info.is_stream) || (m_info.segment_size == 0) || (m_info.segment_size > max_segment_size))
+    {
+        throw std::runtime_error("random access requires a segmented file");
+    }
+
+    if (!m_info.compression.empty())
+    {
+        throw std::runtime_error("random access is not supported for compressed files");
+    }
+
+    if (!is_aead_available(m_info.encryption_method))
+    {
+        throw std::runtime_error("unsupported encryption method: " + m_info.encryption_method);
+    }
+
+    auto const payload_size = std::filesystem::file_size(filename) - m_info.size;
+    m_segment_count = stored_segment_count(payload_size, m_info.segment_size);
+    if (m_segment_count == 0)
+    {
+        throw std::runtime_error("invalid payload size");
+    }
+    m_size = payload_size - m_segment_count * segment_overhead;
+
+    // on error, the key is wiped when the member is destroyed
+    m_key = std::make_unique<secure_buffer>(derive_secure_key(password, m_info.kdf));
+    if (!check_key(m_key->view(), m_info))
+    {
+        throw std::runtime_error("wrong password");
+    }
+    m_key_id = context_key_id(m_key->view());
+
+    m_fd = open(filename.c_str(), O_RDONLY);
+    if (m_fd < 0)
+    {
+        throw std::runtime_error("failed to open file");
+    }
+}
+
+encrypted_reader::~encrypted_reader()
+{
+    close(m_fd);
+}
+
+size_t encrypted_reader::read(uint64_t offset, size_t length, char * out) const
+{
+    if (offset >= m_size)
+    {
+        return 0;
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, m_size - offset));
+
+    size_t const segment_size = m_info.segment_size;
+    size_t const stored_size = segment_size + segment_overhead;
+    std::vector<char> stored(stored_size);
+    std::vector<char> plain(segment_size);
+
+    size_t done = 0;
+    while (done < length)
+    {
+        uint64_t const position = offset + done;
+        uint64_t const index = position / segment_size;
+        size_t const segment_offset = static_cast<size_t>(position % segment_size);
+        size_t const plain_size = static_cast<size_t>(std::min<uint64_t>(segment_size, m_size - index * segment_size));
+
+        if (read_at(m_fd, stored.data(), plain_size + segment_overhead, index * stored_size) != plain_size + segment_overhead)
+        {
+            throw std::runtime_error("unexpected end of file");
+        }
+
+        bool const is_last = (index + 1 == m_segment_count);
+        if (!decrypt_segment(m_key->view(), m_key_id, segment_additional_data(m_info.additional_data, index, is_last),
+            stored.data(), plain_size + segment_overhead, plain.data(), m_info.encryption_method))
+        {
+            throw std::runtime_error("segment " + std::to_string(index) + " corrupted");
+        }
+
+        size_t const chunk_size = std::min(plain_size - segment_offset, length - done);
+        memcpy(&out[done], &plain[segment_offset], chunk_size);
+        done += chunk_size;
+    }
+
+    return done;
+}
+
+uint64_t encrypted_reader::size() const noexcept
+{
+    return m_size;
+}
+
+encryption_info const & encrypted_reader::info() const noexcept
+{
+    return m_info;
+}
+
+}
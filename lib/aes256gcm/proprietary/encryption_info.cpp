@@ -1,6 +1,14 @@
 #include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/encryption_info_view.hpp"
 #include "aes256gcm/constants.hpp"
+#include "aes256gcm/openssl_error.hpp"
 
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <charconv>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <vector>
@@ -14,11 +22,17 @@ constexpr char const kdf_algorithm_id = 'k';
 constexpr char const kdf_salt_id = 's';
 constexpr char const kdf_digest_id = 'd';
 constexpr char const kdf_interations_id = 'i';
+constexpr char const kdf_memory_cost_id = 'c';
+constexpr char const kdf_lanes_id = 'l';
 
 constexpr char const encryption_method_id = 'm';
 constexpr char const nonce_id = 'n';
 constexpr char const tag_id = 't';
 constexpr char const additional_data_id = 'a';
+constexpr char const segment_size_id = 'g';
+constexpr char const compression_id = 'z';
+constexpr char const segment_digests_id = 'h';
+constexpr char const key_check_id = 'v';
 
 constexpr char const end_of_info_id = 0x0;
 constexpr char const invalid_id = 0xff;
@@ -26,6 +40,9 @@ constexpr char const invalid_id = 0xff;
 namespace
 {
 
+constexpr char const key_check_label[] = "aes256gcm key check";
+constexpr size_t const key_check_size = 16;
+
 void add_signature(std::vector<char> & data, std::string const & signature)
 {
     data.insert(data.end(), signature.begin(), signature.end());
@@ -61,6 +78,10 @@ void add_field_u32(std::vector<char> & data, char id, uint32_t value)
 void add_end_of_info(std::vector<char> & data)
 {
     size_t const size = data.size() + 4 + sizeof(signature);
+    if (size > max_info_size)
+    {
+        throw std::runtime_error("encryption info too large");
+    }
 
     data.push_back( end_of_info_id);
     data.push_back( (size >> 16) & 0xff );
@@ -70,56 +91,123 @@ void add_end_of_info(std::vector<char> & data)
     add_signature(data, std::string(signature, sizeof(signature)));
 }
 
-char parse_next(std::vector<char> const & data, size_t &pos, std::string & value)
+uint32_t parse_u24(char const * data)
+{
+    return ((static_cast<uint32_t>(data[0]) & 0xff) << 16)
+        | ((static_cast<uint32_t>(data[1]) & 0xff) << 8)
+        | (static_cast<uint32_t>(data[2]) & 0xff);
+}
+
+bool parse_uint(std::string_view value, unsigned int & result)
 {
-    auto const id = data.at(pos++);
-    if (id != end_of_info_id)
+    if (value.size() < 4)
     {
-        size_t size = (((size_t) (data.at(pos++)) & 0xff) << 16) |
-               (((size_t) (data.at(pos++)) & 0xff) <<  8) |
-                ((size_t) (data.at(pos++)) & 0xff);
-        if ((pos + size) >= data.size())
-        {
-            return 0xff;
-        }
+        return false;
+    }
 
-        value = std::string(&data.data()[pos], size);
-        pos += size;
+    result = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        result <<= 8;
+        result |= (value[i] & 0xff);
     }
+    return true;
+}
 
-    return id;
 }
 
-unsigned int parse_uint(std::string const & value)
+std::string key_check_value(std::string_view key)
 {
-    unsigned int result = 0;
-    for (size_t i = 0; i < 4; i++)
+    unsigned char result[EVP_MAX_MD_SIZE];
+    unsigned int result_size = 0;
+    if (nullptr == HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+            reinterpret_cast<unsigned char const*>(key_check_label), sizeof(key_check_label) - 1,
+            result, &result_size))
     {
-        result <<= 8;
-        result |= (value.at(i) & 0xff);
+        throw openssl_error();
     }
-    return result;
+
+    return std::string(reinterpret_cast<char*>(result), key_check_size);
 }
 
+bool check_key(std::string_view key, encryption_info const & info)
+{
+    if (info.key_check.empty())
+    {
+        return true;
+    }
+
+    auto const expected = key_check_value(key);
+    return (info.key_check.size() == expected.size())
+        && (0 == CRYPTO_memcmp(info.key_check.data(), expected.data(), expected.size()));
 }
 
 void create_encryption_info(
     std::vector<char> & data,
-    std::string const & salt,
-    std::string const & digest,
-    unsigned int iterations,
+    kdf_params const & kdf,
     std::string const & nonce,
     std::string const & tag,
-    std::string const & additional_data)
-{
-    add_field_str(data,kdf_algorithm_id, pbkdf2_algorithm);
-    add_field_str(data, kdf_salt_id, salt);
-    add_field_str(data, kdf_digest_id, digest);
-    add_field_u32(data, kdf_interations_id, iterations);
-    add_field_str(data, encryption_method_id, encryption_method);
-    add_field_str(data, nonce_id, nonce);
-    add_field_str(data, tag_id, tag);
-    add_field_str(data, additional_data_id, additional_data);
+    std::string const & additional_data,
+    size_t segment_size,
+    std::string const & method,
+    std::string const & compression,
+    int compression_level)
+{
+    encryption_info info = {};
+    info.kdf = kdf;
+    info.encryption_method = method;
+    info.nonce = nonce;
+    info.tag = tag;
+    info.additional_data = additional_data;
+    info.segment_size = segment_size;
+    info.compression = compression;
+    info.compression_level = compression_level;
+    create_encryption_info(data, info);
+}
+
+void create_encryption_info(
+    std::vector<char> & data,
+    encryption_info const & info)
+{
+    add_field_str(data,kdf_algorithm_id, info.kdf.algorithm);
+    add_field_str(data, kdf_salt_id, info.kdf.salt);
+    if (!info.kdf.digest.empty())
+    {
+        add_field_str(data, kdf_digest_id, info.kdf.digest);
+    }
+    add_field_u32(data, kdf_interations_id, info.kdf.iterations);
+    if (info.kdf.memory_cost > 0)
+    {
+        add_field_u32(data, kdf_memory_cost_id, info.kdf.memory_cost);
+    }
+    if (info.kdf.lanes > 0)
+    {
+        add_field_u32(data, kdf_lanes_id, info.kdf.lanes);
+    }
+    add_field_str(data, encryption_method_id, info.encryption_method);
+    add_field_str(data, nonce_id, info.nonce);
+    if (!info.tag.empty())
+    {
+        add_field_str(data, tag_id, info.tag);
+    }
+    add_field_str(data, additional_data_id, info.additional_data);
+    if (info.segment_size > 0)
+    {
+        add_field_u32(data, segment_size_id, info.segment_size);
+    }
+    if (!info.compression.empty())
+    {
+        // codec and level, e.g. "ZSTD:3"
+        add_field_str(data, compression_id, info.compression + ":" + std::to_string(info.compression_level));
+    }
+    if (!info.segment_digests.empty())
+    {
+        add_field_str(data, segment_digests_id, info.segment_digests);
+    }
+    if (!info.key_check.empty())
+    {
+        add_field_str(data, key_check_id, info.key_check);
+    }
     add_end_of_info(data);
 }
 
@@ -129,53 +217,167 @@ bool parse_encryption_info(
     std::vector<char> const & data,
     encryption_info & info)
 {
-    info.size = data.size();
+    encryption_info_view view;
+    auto const error = view.parse(data.data(), data.size());
+    if (nullptr != error)
+    {
+        std::cerr << "error: " << error << std::endl;
+        return false;
+    }
+
+    view.copy_to(info);
+    return true;
+}
+
+encryption_info_view::encryption_info_view() noexcept
+: size(0)
+, kdf{{}, {}, {}, 0, 0, 0}
+, segment_size(0)
+, is_stream(false)
+, compression_level(0)
+{
+}
+
+char const * encryption_info_view::parse(char const * data, size_t data_size)
+{
+    size = data_size;
+    kdf = {{}, {}, {}, 0, 0, 0};
+    encryption_method = {};
+    nonce = {};
+    tag = {};
+    additional_data = {};
+    segment_size = 0;
+    is_stream = false;
+    compression = {};
+    compression_level = 0;
+    segment_digests = {};
+    key_check = {};
 
     size_t pos = 0;
-    bool done = false;
-    while (!done)
+    while (true)
     {
-        std::string value;
-        auto const c = parse_next(data, pos, value);
-        switch (c)
+        if ((data_size < 4) || (pos > data_size - 4))
+        {
+            return "missing end of encryption info";
+        }
+
+        auto const id = data[pos];
+        size_t const field_size = parse_u24(&data[pos + 1]);
+        pos += 4;
+        if (id == end_of_info_id)
+        {
+            break;
+        }
+
+        if ((pos + field_size) >= data_size)
+        {
+            return "invalid field size";
+        }
+
+        std::string_view const value(&data[pos], field_size);
+        pos += field_size;
+
+        unsigned int number = 0;
+        switch (id)
         {
-            case end_of_info_id:
-                done = true;
-                break;
             case kdf_algorithm_id:
-                info.kdf.algorithm = value;
+                kdf.algorithm = value;
                 break;
             case kdf_salt_id:
-                info.kdf.salt = value;
+                kdf.salt = value;
                 break;
             case kdf_digest_id:
-                info.kdf.digest = value;
+                kdf.digest = value;
                 break;
             case kdf_interations_id:
-                info.kdf.iterations = parse_uint(value);
+                if (!parse_uint(value, kdf.iterations))
+                {
+                    return "invalid field size";
+                }
+                break;
+            case kdf_memory_cost_id:
+                if (!parse_uint(value, kdf.memory_cost))
+                {
+                    return "invalid field size";
+                }
+                break;
+            case kdf_lanes_id:
+                if (!parse_uint(value, kdf.lanes))
+                {
+                    return "invalid field size";
+                }
                 break;
             case encryption_method_id:
-                info.encryption_method = value;
+                encryption_method = value;
                 break;
             case nonce_id:
-                info.nonce = value;
+                nonce = value;
                 break;
             case tag_id:
-                info.tag = value;
+                tag = value;
                 break;
             case additional_data_id:
-                info.additional_data = value;
+                additional_data = value;
+                break;
+            case segment_size_id:
+                if (!parse_uint(value, number))
+                {
+                    return "invalid field size";
+                }
+                segment_size = number;
+                break;
+            case compression_id:
+            {
+                // codec and level, e.g. "ZSTD:3"
+                auto const separator = value.find(':');
+                if ((separator == std::string_view::npos) || (separator == 0))
+                {
+                    return "invalid compression";
+                }
+                compression = value.substr(0, separator);
+                auto const level = value.substr(separator + 1);
+                auto const parsed = std::from_chars(level.data(), level.data() + level.size(), compression_level);
+                if (parsed.ec != std::errc())
+                {
+                    compression_level = 0;
+                }
+                break;
+            }
+            case segment_digests_id:
+                segment_digests = value;
+                break;
+            case key_check_id:
+                key_check = value;
                 break;
             case invalid_id:
                 // fall-through
             default:
-                std::cerr << "error: invalid id" << std::endl;
-                return false;                    
+                return "invalid id";
         }
     }
 
-    return true;
+    return nullptr;
 }
-    
 
-}
\ No newline at end of file
+void encryption_info_view::copy_to(encryption_info & info) const
+{
+    info.size = size;
+    info.kdf.algorithm = kdf.algorithm;
+    info.kdf.salt = kdf.salt;
+    info.kdf.digest = kdf.digest;
+    info.kdf.iterations = kdf.iterations;
+    info.kdf.memory_cost = kdf.memory_cost;
+    info.kdf.lanes = kdf.lanes;
+    info.encryption_method = encryption_method;
+    info.nonce = nonce;
+    info.tag = tag;
+    info.additional_data = additional_data;
+    info.segment_size = segment_size;
+    info.is_stream = is_stream;
+    info.compression = compression;
+    info.compression_level = compression_level;
+    info.segment_digests = segment_digests;
+    info.key_check = key_check;
+}
+
+}
@@ -2,6 +2,9 @@
 #define AES256GCM_PROPRIETARY_ENCRYPTION_INFO_HPP
 
 #include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/constants.hpp"
+#include <iosfwd>
+#include <string_view>
 #include <vector>
 
 namespace aes256gcm::proprietary
@@ -9,16 +12,42 @@ namespace aes256gcm::proprietary
 
 constexpr char const signature[8] = {'E', 'N','C','-','I','N','F','O'};
 constexpr size_t const end_of_info_size = 4 + sizeof(signature);
-constexpr size_t const max_info_size = 1 * 1024 * 1024;
+constexpr size_t const max_info_size = 16 * 1024 * 1024 - 1;
+
+// A stream starts with stream_signature, the big-endian 32 bit size of
+// the encryption info and the encryption info itself (without tag).
+constexpr char const stream_signature[8] = {'E', 'N','C','-','S','T','R','M'};
+constexpr size_t const stream_header_prefix_size = 4 + sizeof(stream_signature);
 
 void create_encryption_info(
     std::vector<char> & data,
-    std::string const & salt,
-    std::string const & digest,
-    unsigned int iterations,
+    kdf_params const & kdf,
     std::string const & nonce,
     std::string const & tag,
-    std::string const & additional_data);
+    std::string const & additional_data,
+    size_t segment_size = 0,
+    std::string const & method = encryption_method,
+    std::string const & compression = "",
+    int compression_level = 0);
+
+
+/// @brief Computes the key check value of a derived key.
+///
+/// The value is an HMAC over a constant using the derived key, stored in
+/// the encryption info to reject wrong passwords right after the key
+/// derivation, before any data is decrypted.
+std::string key_check_value(std::string_view key);
+
+
+/// @brief Checks a derived key against the key check value of a file.
+/// @return true, if the key matches or the file has no key check value, false otherwise
+bool check_key(std::string_view key, encryption_info const & info);
+
+
+/// @brief Serializes all fields of an encryption info but size and is_stream.
+void create_encryption_info(
+    std::vector<char> & data,
+    encryption_info const & info);
 
 
 bool parse_encryption_info(
@@ -26,6 +55,12 @@ bool parse_encryption_info(
     encryption_info & info);
 
 
+/// @brief Reads the header of a stream, including its signature.
+bool read_stream_header(
+    std::istream & in,
+    encryption_info & info);
+
+
 }
 
 
@@ -0,0 +1,158 @@
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+namespace aes256gcm::proprietary
+{
+
+file_descriptor::file_descriptor(std::string const & filename, int flags, int mode)
+: m_fd(open(filename.c_str(), flags | O_CLOEXEC, mode))
+{
+    if (m_fd < 0)
+    {
+        throw std::runtime_error("failed to open file");
+    }
+}
+
+file_descriptor::file_descriptor(file_descriptor && other) noexcept
+: m_fd(other.m_fd)
+{
+    other.m_fd = -1;
+}
+
+file_descriptor& file_descriptor::operator=(file_descriptor && other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+        m_fd = other.m_fd;
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+file_descriptor::~file_descriptor()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+int file_descriptor::get() const noexcept
+{
+    return m_fd;
+}
+
+void file_descriptor::close()
+{
+    if (m_fd >= 0)
+    {
+        int const rc = ::close(m_fd);
+        m_fd = -1;
+        if (rc != 0)
+        {
+            throw std::runtime_error("failed to close file");
+        }
+    }
+}
+
+void file_descriptor::disable_direct_io()
+{
+    int const flags = fcntl(m_fd, F_GETFL);
+    if ((flags < 0) || (fcntl(m_fd, F_SETFL, flags & ~O_DIRECT) < 0))
+    {
+        throw std::runtime_error("failed to disable direct I/O");
+    }
+}
+
+size_t read_at(int fd, char * buffer, size_t size, uint64_t offset)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t const rc = pread(fd, &buffer[done], size - done, static_cast<off_t>(offset + done));
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("failed to read from file");
+        }
+
+        if (rc == 0)
+        {
+            break;
+        }
+
+        done += static_cast<size_t>(rc);
+    }
+
+    return done;
+}
+
+size_t read_block_at(int fd, char * buffer, size_t size, uint64_t offset)
+{
+    while (true)
+    {
+        ssize_t const rc = pread(fd, buffer, size, static_cast<off_t>(offset));
+        if (rc >= 0)
+        {
+            return static_cast<size_t>(rc);
+        }
+
+        if (errno != EINTR)
+        {
+            throw std::runtime_error("failed to read from file");
+        }
+    }
+}
+
+void write_at(int fd, char const * data, size_t size, uint64_t offset)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t const rc = pwrite(fd, &data[done], size - done, static_cast<off_t>(offset + done));
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("failed to write to file");
+        }
+
+        done += static_cast<size_t>(rc);
+    }
+}
+
+void sync_file(int fd)
+{
+    while (0 != fdatasync(fd))
+    {
+        if (errno != EINTR)
+        {
+            throw std::runtime_error("failed to sync file");
+        }
+    }
+}
+
+aligned_buffer allocate_aligned(size_t size)
+{
+    // pages are aligned for O_DIRECT; the size covers aligned reads of a tail
+    return secure_pool::instance().allocate(align_up(std::max<size_t>(size, 1), direct_io_alignment));
+}
+
+}
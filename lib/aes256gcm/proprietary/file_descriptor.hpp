@@ -0,0 +1,83 @@
+#ifndef AES256GCM_PROPRIETARY_FILE_DESCRIPTOR_HPP
+#define AES256GCM_PROPRIETARY_FILE_DESCRIPTOR_HPP
+
+#include "aes256gcm/secure_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Alignment of buffers, offsets and sizes used with O_DIRECT.
+constexpr size_t const direct_io_alignment = 4096;
+
+/// @brief Owning wrapper of a POSIX file descriptor.
+class file_descriptor
+{
+    file_descriptor(file_descriptor const &) = delete;
+    file_descriptor& operator=(file_descriptor const &) = delete;
+public:
+    /// @brief Opens a file.
+    /// @throws A runtime_error is thrown if the file cannot be opened.
+    file_descriptor(std::string const & filename, int flags, int mode = 0666);
+    file_descriptor(file_descriptor && other) noexcept;
+    file_descriptor& operator=(file_descriptor && other) noexcept;
+    ~file_descriptor();
+
+    int get() const noexcept;
+
+    /// @brief Closes the file descriptor.
+    /// @throws A runtime_error is thrown if closing fails (e.g. on deferred write errors).
+    void close();
+
+    /// @brief Clears O_DIRECT, e.g. to write an unaligned tail.
+    /// @throws A runtime_error is thrown on failure.
+    void disable_direct_io();
+
+private:
+    int m_fd;
+};
+
+/// @brief Reads from a file until size bytes are read or end of file is reached.
+/// @return number of bytes read
+/// @throws A runtime_error is thrown on I/O errors.
+size_t read_at(int fd, char * buffer, size_t size, uint64_t offset);
+
+/// @brief Reads from a file using a single read request.
+///
+/// @note Suitable for O_DIRECT, where a request continuing a short read
+///       would be unaligned. For regular files a short read means end of file.
+///
+/// @return number of bytes read
+/// @throws A runtime_error is thrown on I/O errors.
+size_t read_block_at(int fd, char * buffer, size_t size, uint64_t offset);
+
+/// @brief Writes all data to a file.
+/// @throws A runtime_error is thrown on I/O errors.
+void write_at(int fd, char const * data, size_t size, uint64_t offset);
+
+/// @brief Flushes the data of a file to disk (see fdatasync).
+/// @throws A runtime_error is thrown on I/O errors.
+void sync_file(int fd);
+
+using aligned_buffer = secure_buffer;
+
+/// @brief Allocates a buffer aligned for O_DIRECT.
+///
+/// Buffers are taken from the secure pool, so they are locked into memory
+/// (if permitted), excluded from core dumps, wiped on release and reused
+/// by the next file.
+aligned_buffer allocate_aligned(size_t size);
+
+/// @brief Rounds size up to a multiple of alignment.
+constexpr size_t align_up(size_t size, size_t alignment)
+{
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+}
+
+#endif
@@ -1,71 +1,147 @@
 #include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/encryption_info_view.hpp"
 #include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
 
-#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
 
-#include <fstream>
-#include <filesystem>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 namespace aes256gcm::proprietary
 {
 
-bool get_encryption_info(
-    std::string const & filename,
-    encryption_info & info)
+namespace
+{
+
+uint32_t parse_u32(char const * data)
+{
+    uint32_t result = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        result <<= 8;
+        result |= static_cast<uint32_t>(data[i]) & 0xff;
+    }
+    return result;
+}
+
+}
+
+char const * encryption_info_view::read(std::string const & filename)
+{
+    file_descriptor file(filename, O_RDONLY);
+
+    struct stat status;
+    if (0 != fstat(file.get(), &status))
+    {
+        throw std::runtime_error("failed to get file size");
+    }
+
+    return read(file.get(), static_cast<uint64_t>(status.st_size));
+}
+
+char const * encryption_info_view::read(int fd, uint64_t file_size)
 {
-    auto const file_size = std::filesystem::file_size(filename);
     if (file_size < end_of_info_size)
     {
-        std::cerr << "error: file too small" << std::endl;
-        return false;
+        return "file too small";
     }
 
-    auto const end_of_info_pos = file_size - end_of_info_size;
-    std::ifstream file(filename);
-    file.seekg(end_of_info_pos);
+    // Most files have their encryption info at the end, so a single read of
+    // the tail is enough. Streams are recognized only if the signature at the
+    // end is missing.
+    size_t const tail_size = static_cast<size_t>(std::min<uint64_t>(file_size, inline_size));
+    if (read_at(fd, m_inline, tail_size, file_size - tail_size) != tail_size)
+    {
+        return "failed to read encryption info";
+    }
+
+    char const * const end_of_info = &m_inline[tail_size - end_of_info_size];
+    if (0 == memcmp(&end_of_info[4], signature, sizeof(signature)))
+    {
+        uint32_t const info_size = parse_u32(end_of_info);
+        if ((info_size < end_of_info_size) || (info_size > file_size) || (info_size > max_info_size))
+        {
+            return "invalid info size";
+        }
+
+        if (info_size <= tail_size)
+        {
+            return parse(&m_inline[tail_size - info_size], info_size);
+        }
 
-    char end_of_info[end_of_info_size];
-    file.read(end_of_info, end_of_info_size);
+        char * const buffer = allocate(info_size);
+        if (read_at(fd, buffer, info_size, file_size - info_size) != info_size)
+        {
+            return "failed to read encryption info";
+        }
+        return parse(buffer, info_size);
+    }
 
-    if (end_of_info_size != file.gcount())
+    // streams start with their encryption info
+    size_t const head_size = tail_size;
+    if ((tail_size < file_size) && (read_at(fd, m_inline, head_size, 0) != head_size))
     {
-        std::cerr << "error: failed to read encryption info" << std::endl;
-        return false;
+        return "failed to read encryption info";
     }
 
-    if (0 != strncmp(&end_of_info[4], signature, sizeof(signature)))
+    if ((head_size < stream_header_prefix_size) || (0 != memcmp(m_inline, stream_signature, sizeof(stream_signature))))
     {
-        std::cerr << "error: invalid signature " << std::endl;
-        return false;
+        return "invalid signature";
     }
 
-    uint32_t info_size = 0;
-    for (size_t i = 0; i < 4; i++)
+    uint32_t const info_size = parse_u32(&m_inline[sizeof(stream_signature)]);
+    if ((info_size < end_of_info_size) || (info_size > max_info_size)
+        || (info_size > file_size - stream_header_prefix_size))
     {
-        info_size <<= 8;
-        info_size += ((uint32_t) end_of_info[i]) & 0xff;
+        return "invalid info size";
     }
 
-    if ((info_size > file_size) || (info_size > max_info_size))
+    char const * data = &m_inline[stream_header_prefix_size];
+    if (stream_header_prefix_size + info_size > head_size)
     {
-        std::cerr << "error: invalid info size" << info_size << std::endl;
-        return false;
+        char * const buffer = allocate(info_size);
+        if (read_at(fd, buffer, info_size, stream_header_prefix_size) != info_size)
+        {
+            return "failed to read encryption info";
+        }
+        data = buffer;
+    }
+
+    auto const error = parse(data, info_size);
+    if (nullptr != error)
+    {
+        return error;
     }
 
-    auto const info_pos = file_size - info_size;
-    std::vector<char> raw_info(info_size);
-    file.seekg(info_pos);
-    file.read(raw_info.data(), raw_info.size());
+    size = stream_header_prefix_size + info_size;
+    is_stream = true;
+    return nullptr;
+}
+
+char * encryption_info_view::allocate(size_t size)
+{
+    m_buffer.resize(size);
+    return m_buffer.data();
+}
 
-    if (file.gcount() != info_size)
+bool get_encryption_info(
+    std::string const & filename,
+    encryption_info & info)
+{
+    encryption_info_view view;
+    auto const error = view.read(filename);
+    if (nullptr != error)
     {
-        std::cerr << "error: failed to read encryption info" << std::endl;
+        std::cerr << "error: " << error << std::endl;
         return false;
     }
 
-    return parse_encryption_info(raw_info, info);
+    view.copy_to(info);
+    return true;
 }
-    
 
-}
\ No newline at end of file
+}
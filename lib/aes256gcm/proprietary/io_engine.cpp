@@ -0,0 +1,575 @@
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/proprietary/io_uring_file.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+#include "aes256gcm/proprietary/memmapped_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+int direct_flag(file_options const & options)
+{
+    return options.direct_io ? O_DIRECT : 0;
+}
+
+uint64_t file_size_of(int fd)
+{
+    struct stat st;
+    if (0 != fstat(fd, &st))
+    {
+        throw std::runtime_error("failed to stat file");
+    }
+    return static_cast<uint64_t>(st.st_size);
+}
+
+size_t page_aligned(size_t size)
+{
+    size_t const page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return std::max(page_size, align_up(size, page_size));
+}
+
+// --- iostream ---
+
+class iostream_input: public input_file
+{
+public:
+    explicit iostream_input(std::string const & filename)
+    : m_in(filename, std::ios_base::binary)
+    {
+        if (!m_in)
+        {
+            throw std::runtime_error("failed to open file");
+        }
+    }
+
+    size_t read(char * buffer, size_t size) override
+    {
+        m_in.read(buffer, size);
+        if (m_in.bad())
+        {
+            throw std::runtime_error("failed to read from file");
+        }
+        return static_cast<size_t>(m_in.gcount());
+    }
+
+private:
+    std::ifstream m_in;
+};
+
+class iostream_output: public output_file
+{
+public:
+    explicit iostream_output(std::string const & filename)
+    : m_out(filename, std::ios_base::binary | std::ios_base::trunc)
+    {
+        if (!m_out)
+        {
+            throw std::runtime_error("failed to open file");
+        }
+    }
+
+    void write(char const * data, size_t size) override
+    {
+        m_out.write(data, size);
+        if (m_out.fail())
+        {
+            throw std::runtime_error("failed to write to file");
+        }
+    }
+
+    void close() override
+    {
+        m_out.close();
+        if (m_out.fail())
+        {
+            throw std::runtime_error("failed to write to file");
+        }
+    }
+
+private:
+    std::ofstream m_out;
+};
+
+// --- pread / pwrite ---
+
+class pread_input: public input_file
+{
+public:
+    pread_input(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_RDONLY | direct_flag(options))
+    , m_direct(options.direct_io)
+    , m_buffer()
+    , m_capacity(align_up(options.buffer_size, direct_io_alignment))
+    , m_offset(0)
+    , m_position(0)
+    , m_fill(0)
+    , m_eof(false)
+    {
+        posix_fadvise(m_fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (m_direct)
+        {
+            m_buffer = allocate_aligned(m_capacity);
+        }
+    }
+
+    size_t read(char * buffer, size_t size) override
+    {
+        if (!m_direct)
+        {
+            size_t const bytes_read = read_at(m_fd.get(), buffer, size, m_offset);
+            m_offset += bytes_read;
+
+            // read ahead the next chunk while the caller processes this one
+            if (bytes_read == size)
+            {
+                posix_fadvise(m_fd.get(), static_cast<off_t>(m_offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+            }
+            return bytes_read;
+        }
+
+        // O_DIRECT requires aligned buffers and offsets: read through an aligned buffer
+        size_t done = 0;
+        while (done < size)
+        {
+            if (m_position == m_fill)
+            {
+                if (m_eof)
+                {
+                    break;
+                }
+
+                m_fill = read_block_at(m_fd.get(), m_buffer.get(), m_capacity, m_offset);
+                m_offset += m_fill;
+                m_position = 0;
+                m_eof = (m_fill < m_capacity);
+                if (m_fill == 0)
+                {
+                    break;
+                }
+            }
+
+            size_t const chunk_size = std::min(size - done, m_fill - m_position);
+            memcpy(&buffer[done], &m_buffer.get()[m_position], chunk_size);
+            m_position += chunk_size;
+            done += chunk_size;
+        }
+
+        return done;
+    }
+
+private:
+    file_descriptor m_fd;
+    bool m_direct;
+    aligned_buffer m_buffer;
+    size_t m_capacity;
+    uint64_t m_offset;
+    size_t m_position;
+    size_t m_fill;
+    bool m_eof;
+};
+
+class pwrite_output: public output_file
+{
+public:
+    pwrite_output(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_WRONLY | O_CREAT | O_TRUNC | direct_flag(options))
+    , m_direct(options.direct_io)
+    , m_buffer()
+    , m_capacity(align_up(options.buffer_size, direct_io_alignment))
+    , m_offset(0)
+    , m_fill(0)
+    {
+        if (m_direct)
+        {
+            m_buffer = allocate_aligned(m_capacity);
+        }
+    }
+
+    void write(char const * data, size_t size) override
+    {
+        if (!m_direct)
+        {
+            write_at(m_fd.get(), data, size, m_offset);
+            m_offset += size;
+            return;
+        }
+
+        while (size > 0)
+        {
+            size_t const chunk_size = std::min(size, m_capacity - m_fill);
+            memcpy(&m_buffer.get()[m_fill], data, chunk_size);
+            m_fill += chunk_size;
+            data += chunk_size;
+            size -= chunk_size;
+
+            if (m_fill == m_capacity)
+            {
+                flush();
+            }
+        }
+    }
+
+    void close() override
+    {
+        if (m_fill > 0)
+        {
+            if ((m_fill % direct_io_alignment) != 0)
+            {
+                m_fd.disable_direct_io();
+            }
+            flush();
+        }
+        m_fd.close();
+    }
+
+private:
+    void flush()
+    {
+        write_at(m_fd.get(), m_buffer.get(), m_fill, m_offset);
+        m_offset += m_fill;
+        m_fill = 0;
+    }
+
+    file_descriptor m_fd;
+    bool m_direct;
+    aligned_buffer m_buffer;
+    size_t m_capacity;
+    uint64_t m_offset;
+    size_t m_fill;
+};
+
+// --- mmap ---
+
+class mmap_input: public input_file
+{
+public:
+    mmap_input(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_RDONLY)
+    , m_file_size(file_size_of(m_fd.get()))
+    , m_window_size(page_aligned(options.window_size))
+    , m_offset(0)
+    , m_position(0)
+    , m_size(0)
+    , m_address(nullptr)
+    {
+    }
+
+    ~mmap_input() override
+    {
+        unmap();
+    }
+
+    size_t read(char * buffer, size_t size) override
+    {
+        size_t done = 0;
+        while (done < size)
+        {
+            if (m_position == m_size)
+            {
+                if (!map_next())
+                {
+                    break;
+                }
+            }
+
+            size_t const chunk_size = std::min(size - done, m_size - m_position);
+            memcpy(&buffer[done], &m_address[m_position], chunk_size);
+            m_position += chunk_size;
+            done += chunk_size;
+        }
+
+        return done;
+    }
+
+private:
+    bool map_next()
+    {
+        uint64_t const offset = m_offset + m_size;
+        unmap();
+        if (offset >= m_file_size)
+        {
+            return false;
+        }
+
+        size_t const size = static_cast<size_t>(std::min<uint64_t>(m_window_size, m_file_size - offset));
+        void * address = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd.get(), static_cast<off_t>(offset));
+        if (MAP_FAILED == address)
+        {
+            throw std::runtime_error("failed to memmap file");
+        }
+        madvise(address, size, MADV_SEQUENTIAL);
+        madvise(address, size, MADV_WILLNEED);
+
+        m_address = reinterpret_cast<char*>(address);
+        m_offset = offset;
+        m_size = size;
+        m_position = 0;
+        return true;
+    }
+
+    void unmap() noexcept
+    {
+        if (nullptr != m_address)
+        {
+            munmap(m_address, m_size);
+            m_address = nullptr;
+        }
+    }
+
+    file_descriptor m_fd;
+    uint64_t m_file_size;
+    size_t m_window_size;
+    uint64_t m_offset;
+    size_t m_position;
+    size_t m_size;
+    char * m_address;
+};
+
+class mmap_output: public output_file
+{
+public:
+    mmap_output(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_RDWR | O_CREAT | O_TRUNC)
+    , m_window_size(page_aligned(options.window_size))
+    , m_offset(0)
+    , m_position(0)
+    , m_address(nullptr)
+    {
+    }
+
+    ~mmap_output() override
+    {
+        unmap();
+    }
+
+    void write(char const * data, size_t size) override
+    {
+        while (size > 0)
+        {
+            if (nullptr == m_address)
+            {
+                map();
+            }
+
+            size_t const chunk_size = std::min(size, m_window_size - m_position);
+            memcpy(&m_address[m_position], data, chunk_size);
+            m_position += chunk_size;
+            data += chunk_size;
+            size -= chunk_size;
+
+            if (m_position == m_window_size)
+            {
+                unmap();
+                m_offset += m_window_size;
+                m_position = 0;
+            }
+        }
+    }
+
+    void close() override
+    {
+        unmap();
+        if (0 != ftruncate(m_fd.get(), static_cast<off_t>(m_offset + m_position)))
+        {
+            throw std::runtime_error("failed to write to file");
+        }
+        m_fd.close();
+    }
+
+private:
+    void map()
+    {
+        if (0 != ftruncate(m_fd.get(), static_cast<off_t>(m_offset + m_window_size)))
+        {
+            throw std::runtime_error("failed to write to file");
+        }
+
+        void * address = mmap(nullptr, m_window_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd.get(), static_cast<off_t>(m_offset));
+        if (MAP_FAILED == address)
+        {
+            throw std::runtime_error("failed to memmap file");
+        }
+        madvise(address, m_window_size, MADV_SEQUENTIAL);
+        m_address = reinterpret_cast<char*>(address);
+    }
+
+    void unmap() noexcept
+    {
+        if (nullptr != m_address)
+        {
+            msync(m_address, m_window_size, MS_ASYNC);
+            munmap(m_address, m_window_size);
+            m_address = nullptr;
+        }
+    }
+
+    file_descriptor m_fd;
+    size_t m_window_size;
+    uint64_t m_offset;
+    size_t m_position;
+    char * m_address;
+};
+
+// --- inplace using pread / pwrite ---
+
+class buffered_inplace_file: public inplace_file
+{
+public:
+    buffered_inplace_file(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_RDWR | direct_flag(options))
+    , m_direct(options.direct_io)
+    , m_file_size(file_size_of(m_fd.get()))
+    , m_window_size(align_up(std::max<size_t>(options.window_size, 1), direct_io_alignment))
+    , m_buffer(allocate_aligned(static_cast<size_t>(std::min<uint64_t>(m_window_size, m_file_size))))
+    , m_offset(0)
+    , m_size(0)
+    {
+        posix_fadvise(m_fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        load();
+    }
+
+    char * address() const noexcept override
+    {
+        return m_buffer.get();
+    }
+
+    size_t size() const noexcept override
+    {
+        return m_size;
+    }
+
+    bool next() override
+    {
+        store();
+        m_offset += m_size;
+        if (m_offset >= m_file_size)
+        {
+            m_size = 0;
+            return false;
+        }
+
+        load();
+        return true;
+    }
+
+    void close() override
+    {
+        store();
+        m_size = 0;
+        m_fd.close();
+    }
+
+private:
+    void load()
+    {
+        size_t const size = static_cast<size_t>(std::min<uint64_t>(m_window_size, m_file_size - m_offset));
+        size_t const bytes_read = m_direct
+            ? read_block_at(m_fd.get(), m_buffer.get(), align_up(size, direct_io_alignment), m_offset)
+            : read_at(m_fd.get(), m_buffer.get(), size, m_offset);
+        if (bytes_read != size)
+        {
+            throw std::runtime_error("failed to read from file");
+        }
+        m_size = size;
+    }
+
+    void store()
+    {
+        if (m_size > 0)
+        {
+            if ((m_size % direct_io_alignment) != 0)
+            {
+                // only the last window is unaligned
+                m_fd.disable_direct_io();
+            }
+            write_at(m_fd.get(), m_buffer.get(), m_size, m_offset);
+        }
+    }
+
+    file_descriptor m_fd;
+    bool m_direct;
+    uint64_t m_file_size;
+    size_t m_window_size;
+    aligned_buffer m_buffer;
+    uint64_t m_offset;
+    size_t m_size;
+};
+
+}
+
+std::unique_ptr<input_file> open_input_file(
+    std::string const & filename,
+    file_options const & options)
+{
+    switch (options.engine)
+    {
+        case io_engine::pread:
+            return std::make_unique<pread_input>(filename, options);
+        case io_engine::mmap:
+            return std::make_unique<mmap_input>(filename, options);
+        case io_engine::io_uring:
+            return open_io_uring_input_file(filename, options);
+        case io_engine::automatic:
+            // fall-through
+        case io_engine::iostream:
+            // fall-through
+        default:
+            return std::make_unique<iostream_input>(filename);
+    }
+}
+
+std::unique_ptr<output_file> open_output_file(
+    std::string const & filename,
+    file_options const & options)
+{
+    switch (options.engine)
+    {
+        case io_engine::pread:
+            return std::make_unique<pwrite_output>(filename, options);
+        case io_engine::mmap:
+            return std::make_unique<mmap_output>(filename, options);
+        case io_engine::io_uring:
+            return open_io_uring_output_file(filename, options);
+        case io_engine::automatic:
+            // fall-through
+        case io_engine::iostream:
+            // fall-through
+        default:
+            return std::make_unique<iostream_output>(filename);
+    }
+}
+
+std::unique_ptr<inplace_file> open_inplace_file(
+    std::string const & filename,
+    file_options const & options)
+{
+    switch (options.engine)
+    {
+        case io_engine::automatic:
+            // fall-through
+        case io_engine::mmap:
+            return std::make_unique<memmapped_file>(filename, options.window_size);
+        case io_engine::iostream:
+            // fall-through
+        case io_engine::pread:
+            // fall-through
+        case io_engine::io_uring:
+            // fall-through
+        default:
+            return std::make_unique<buffered_inplace_file>(filename, options);
+    }
+}
+
+}
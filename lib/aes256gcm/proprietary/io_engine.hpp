@@ -0,0 +1,79 @@
+#ifndef AES256GCM_PROPRIETARY_IO_ENGINE_HPP
+#define AES256GCM_PROPRIETARY_IO_ENGINE_HPP
+
+#include "aes256gcm/proprietary.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Sequentially readable file.
+class input_file
+{
+public:
+    virtual ~input_file() = default;
+
+    /// @brief Reads up to size bytes.
+    /// @return number of bytes read; less than size only at end of file
+    /// @throws A runtime_error is thrown on I/O errors.
+    virtual size_t read(char * buffer, size_t size) = 0;
+};
+
+/// @brief Sequentially writable file.
+class output_file
+{
+public:
+    virtual ~output_file() = default;
+
+    /// @brief Writes data to the file.
+    /// @throws A runtime_error is thrown on I/O errors.
+    virtual void write(char const * data, size_t size) = 0;
+
+    /// @brief Flushes pending writes and closes the file.
+    /// @throws A runtime_error is thrown on I/O errors.
+    virtual void close() = 0;
+};
+
+/// @brief File modified inplace, window by window.
+class inplace_file
+{
+public:
+    virtual ~inplace_file() = default;
+
+    /// @brief Returns the address of the current window.
+    virtual char * address() const noexcept = 0;
+
+    /// @brief Returns the size of the current window.
+    virtual size_t size() const noexcept = 0;
+
+    /// @brief Writes back the current window and loads the next one.
+    /// @return false, if there is no further window, true otherwise
+    /// @throws A runtime_error is thrown on I/O errors.
+    virtual bool next() = 0;
+
+    /// @brief Writes back the current window.
+    /// @throws A runtime_error is thrown on I/O errors.
+    virtual void close() = 0;
+};
+
+/// @brief Opens a file for sequential reading using the engine selected in options.
+std::unique_ptr<input_file> open_input_file(
+    std::string const & filename,
+    file_options const & options);
+
+/// @brief Creates or truncates a file for sequential writing using the engine selected in options.
+std::unique_ptr<output_file> open_output_file(
+    std::string const & filename,
+    file_options const & options);
+
+/// @brief Opens a file for inplace modification using the engine selected in options.
+std::unique_ptr<inplace_file> open_inplace_file(
+    std::string const & filename,
+    file_options const & options);
+
+}
+
+#endif
@@ -0,0 +1,521 @@
+#include "aes256gcm/proprietary/io_uring_file.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+// Minimal io_uring wrapper using the raw system call interface
+// (one submitter, one consumer).
+class ring
+{
+    ring(ring const &) = delete;
+    ring& operator=(ring const &) = delete;
+public:
+    struct completion
+    {
+        uint64_t user_data;
+        int32_t result;
+    };
+
+    explicit ring(unsigned int entries)
+    : m_fd(-1)
+    , m_sq_ring(MAP_FAILED)
+    , m_cq_ring(MAP_FAILED)
+    , m_sqes(MAP_FAILED)
+    , m_fixed_buffers(false)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("io_uring not available");
+        }
+
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+
+        m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        m_cq_ring = single_mmap ? m_sq_ring
+            : mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        m_sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        if ((MAP_FAILED == m_sq_ring) || (MAP_FAILED == m_cq_ring) || (MAP_FAILED == m_sqes))
+        {
+            release();
+            throw std::runtime_error("io_uring not available");
+        }
+
+        char * sq = reinterpret_cast<char*>(m_sq_ring);
+        m_sq_head = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+        m_sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+
+        char * cq = reinterpret_cast<char*>(m_cq_ring);
+        m_cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~ring()
+    {
+        release();
+    }
+
+    /// @brief Registers buffers; falls back to unregistered buffers on failure.
+    void register_buffers(std::vector<iovec> const & buffers)
+    {
+        long const rc = syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS,
+            buffers.data(), static_cast<unsigned int>(buffers.size()));
+        m_fixed_buffers = (rc == 0);
+    }
+
+    void submit(bool write, int fd, char * buffer, unsigned int size, uint64_t offset, unsigned int buffer_index)
+    {
+        unsigned int const tail = *m_sq_tail;
+        unsigned int const index = tail & m_sq_mask;
+
+        io_uring_sqe & sqe = reinterpret_cast<io_uring_sqe*>(m_sqes)[index];
+        memset(&sqe, 0, sizeof(sqe));
+        if (m_fixed_buffers)
+        {
+            sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe.buf_index = static_cast<uint16_t>(buffer_index);
+        }
+        else
+        {
+            sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+        }
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = size;
+        sqe.off = offset;
+        sqe.user_data = buffer_index;
+
+        m_sq_array[index] = index;
+        __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        while (syscall(__NR_io_uring_enter, m_fd, 1, 0, 0, nullptr, 0) < 0)
+        {
+            if (errno != EINTR)
+            {
+                throw std::runtime_error("failed to submit I/O request");
+            }
+        }
+    }
+
+    completion wait()
+    {
+        while (true)
+        {
+            unsigned int const head = *m_cq_head;
+            unsigned int const tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+            if (head != tail)
+            {
+                io_uring_cqe const & cqe = m_cqes[head & m_cq_mask];
+                completion const result = {cqe.user_data, cqe.res};
+                __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+                return result;
+            }
+
+            if ((syscall(__NR_io_uring_enter, m_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) && (errno != EINTR))
+            {
+                throw std::runtime_error("failed to wait for I/O request");
+            }
+        }
+    }
+
+private:
+    void release() noexcept
+    {
+        if (MAP_FAILED != m_sqes)
+        {
+            munmap(m_sqes, m_sqes_size);
+        }
+        if ((MAP_FAILED != m_cq_ring) && (m_cq_ring != m_sq_ring))
+        {
+            munmap(m_cq_ring, m_cq_ring_size);
+        }
+        if (MAP_FAILED != m_sq_ring)
+        {
+            munmap(m_sq_ring, m_sq_ring_size);
+        }
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    int m_fd;
+    void * m_sq_ring;
+    void * m_cq_ring;
+    void * m_sqes;
+    size_t m_sq_ring_size;
+    size_t m_cq_ring_size;
+    size_t m_sqes_size;
+    unsigned int * m_sq_head;
+    unsigned int * m_sq_tail;
+    unsigned int m_sq_mask;
+    unsigned int * m_sq_array;
+    unsigned int * m_cq_head;
+    unsigned int * m_cq_tail;
+    unsigned int m_cq_mask;
+    io_uring_cqe * m_cqes;
+    bool m_fixed_buffers;
+};
+
+// Buffers shared by reader and writer: queue_depth aligned buffers,
+// registered with the ring.
+class ring_buffers
+{
+public:
+    explicit ring_buffers(file_options const & options)
+    : m_depth(std::max(options.queue_depth, 1u))
+    , m_buffer_size(align_up(std::min<size_t>(std::max<size_t>(options.buffer_size, 1), max_request_size), direct_io_alignment))
+    , m_memory(allocate_aligned(m_depth * m_buffer_size))
+    , m_ring(m_depth)
+    , m_in_flight(m_depth, false)
+    , m_results(m_depth, 0)
+    , m_pending(0)
+    {
+        std::vector<iovec> buffers(m_depth);
+        for (size_t i = 0; i < m_depth; i++)
+        {
+            buffers[i].iov_base = buffer(i);
+            buffers[i].iov_len = m_buffer_size;
+        }
+        m_ring.register_buffers(buffers);
+    }
+
+    ~ring_buffers()
+    {
+        // buffers must not be released while the kernel uses them
+        try
+        {
+            while (m_pending > 0)
+            {
+                complete_one();
+            }
+        }
+        catch (...)
+        {
+        }
+    }
+
+    char * buffer(size_t index) const noexcept
+    {
+        return &m_memory.get()[index * m_buffer_size];
+    }
+
+    size_t depth() const noexcept
+    {
+        return m_depth;
+    }
+
+    size_t buffer_size() const noexcept
+    {
+        return m_buffer_size;
+    }
+
+    void submit(bool write, int fd, size_t index, size_t size, uint64_t offset)
+    {
+        submit(write, fd, index, 0, size, offset);
+    }
+
+    /// @brief Submits a request for the part of a buffer starting at position.
+    void submit(bool write, int fd, size_t index, size_t position, size_t size, uint64_t offset)
+    {
+        m_ring.submit(write, fd, &buffer(index)[position], static_cast<unsigned int>(size), offset,
+            static_cast<unsigned int>(index));
+        m_in_flight[index] = true;
+        m_pending++;
+    }
+
+    /// @brief Waits until the given buffer is no longer in flight.
+    /// @return result of the last request of this buffer
+    int32_t wait(size_t index)
+    {
+        while (m_in_flight[index])
+        {
+            complete_one();
+        }
+        return m_results[index];
+    }
+
+    void wait_all()
+    {
+        while (m_pending > 0)
+        {
+            complete_one();
+        }
+    }
+
+    int32_t result(size_t index) const noexcept
+    {
+        return m_results[index];
+    }
+
+private:
+    // requests are limited to unsigned int
+    static constexpr size_t const max_request_size = 1024 * 1024 * 1024;
+
+    void complete_one()
+    {
+        auto const c = m_ring.wait();
+        m_in_flight[c.user_data] = false;
+        m_results[c.user_data] = c.result;
+        m_pending--;
+    }
+
+    size_t m_depth;
+    size_t m_buffer_size;
+    aligned_buffer m_memory;
+    ring m_ring;
+    std::vector<bool> m_in_flight;
+    std::vector<int32_t> m_results;
+    size_t m_pending;
+};
+
+class io_uring_input: public input_file
+{
+public:
+    io_uring_input(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_RDONLY | (options.direct_io ? O_DIRECT : 0))
+    , m_direct_io(options.direct_io)
+    , m_buffers(options)
+    , m_offsets(m_buffers.depth(), 0)
+    , m_file_size(0)
+    , m_next_offset(0)
+    , m_current(0)
+    , m_available(0)
+    , m_complete(false)
+    , m_position(0)
+    , m_eof(false)
+    {
+        struct stat status;
+        if (0 != fstat(m_fd.get(), &status))
+        {
+            throw std::runtime_error("failed to get file size");
+        }
+        m_file_size = static_cast<uint64_t>(status.st_size);
+
+        posix_fadvise(m_fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (size_t i = 0; i < m_buffers.depth(); i++)
+        {
+            submit(i);
+        }
+    }
+
+    size_t read(char * buffer, size_t size) override
+    {
+        size_t done = 0;
+        while ((done < size) && (!m_eof))
+        {
+            size_t const available = wait_current();
+            size_t const chunk_size = std::min(size - done, available - m_position);
+            memcpy(&buffer[done], &m_buffers.buffer(m_current)[m_position], chunk_size);
+            m_position += chunk_size;
+            done += chunk_size;
+
+            if (m_position == available)
+            {
+                if (available < m_buffers.buffer_size())
+                {
+                    m_eof = true;
+                    break;
+                }
+
+                submit(m_current);
+                m_current = (m_current + 1) % m_buffers.depth();
+                m_available = 0;
+                m_complete = false;
+                m_position = 0;
+            }
+        }
+
+        return done;
+    }
+
+private:
+    void submit(size_t index)
+    {
+        m_buffers.submit(false, m_fd.get(), index, m_buffers.buffer_size(), m_next_offset);
+        m_offsets[index] = m_next_offset;
+        m_next_offset += m_buffers.buffer_size();
+    }
+
+    // Waits until the current buffer is full or holds the end of the file and
+    // returns the number of bytes it holds. Reads may return fewer bytes than
+    // requested before the end of the file (e.g. on signals or network file
+    // systems), so the remainder is requested again. The end of the file is
+    // reached on an empty read or at the size the file had when it was opened.
+    size_t wait_current()
+    {
+        while (!m_complete)
+        {
+            int32_t const result = m_buffers.wait(m_current);
+            if (result < 0)
+            {
+                throw std::runtime_error("failed to read from file");
+            }
+
+            m_available += static_cast<size_t>(result);
+            uint64_t const end = m_offsets[m_current] + m_available;
+            m_complete = (m_available == m_buffers.buffer_size()) || (result == 0) || (end >= m_file_size);
+            if (!m_complete)
+            {
+                if (m_direct_io && ((m_available % direct_io_alignment) != 0))
+                {
+                    // an unaligned remainder cannot be read using O_DIRECT
+                    m_buffers.wait_all();
+                    m_fd.disable_direct_io();
+                    m_direct_io = false;
+                }
+                m_buffers.submit(false, m_fd.get(), m_current, m_available,
+                    m_buffers.buffer_size() - m_available, end);
+            }
+        }
+
+        return m_available;
+    }
+
+    file_descriptor m_fd;
+    bool m_direct_io;
+    ring_buffers m_buffers;
+    std::vector<uint64_t> m_offsets;
+    uint64_t m_file_size;
+    uint64_t m_next_offset;
+    size_t m_current;
+    size_t m_available;
+    bool m_complete;
+    size_t m_position;
+    bool m_eof;
+};
+
+class io_uring_output: public output_file
+{
+public:
+    io_uring_output(std::string const & filename, file_options const & options)
+    : m_fd(filename, O_WRONLY | O_CREAT | O_TRUNC | (options.direct_io ? O_DIRECT : 0))
+    , m_buffers(options)
+    , m_sizes(m_buffers.depth(), 0)
+    , m_offset(0)
+    , m_current(0)
+    , m_fill(0)
+    {
+    }
+
+    void write(char const * data, size_t size) override
+    {
+        while (size > 0)
+        {
+            size_t const chunk_size = std::min(size, m_buffers.buffer_size() - m_fill);
+            memcpy(&m_buffers.buffer(m_current)[m_fill], data, chunk_size);
+            m_fill += chunk_size;
+            data += chunk_size;
+            size -= chunk_size;
+
+            if (m_fill == m_buffers.buffer_size())
+            {
+                submit();
+                m_current = (m_current + 1) % m_buffers.depth();
+                check(m_current);
+            }
+        }
+    }
+
+    void close() override
+    {
+        if ((m_fill % direct_io_alignment) != 0)
+        {
+            // an unaligned tail cannot be written using O_DIRECT
+            m_buffers.wait_all();
+            m_fd.disable_direct_io();
+        }
+
+        if (m_fill > 0)
+        {
+            submit();
+        }
+
+        m_buffers.wait_all();
+        for (size_t i = 0; i < m_buffers.depth(); i++)
+        {
+            check(i);
+        }
+        m_fd.close();
+    }
+
+private:
+    void submit()
+    {
+        m_buffers.submit(true, m_fd.get(), m_current, m_fill, m_offset);
+        m_sizes[m_current] = m_fill;
+        m_offset += m_fill;
+        m_fill = 0;
+    }
+
+    void check(size_t index)
+    {
+        if (m_sizes[index] == 0)
+        {
+            return;
+        }
+
+        int32_t const result = m_buffers.wait(index);
+        if ((result < 0) || (static_cast<size_t>(result) != m_sizes[index]))
+        {
+            throw std::runtime_error("failed to write to file");
+        }
+        m_sizes[index] = 0;
+    }
+
+    file_descriptor m_fd;
+    ring_buffers m_buffers;
+    std::vector<size_t> m_sizes;
+    uint64_t m_offset;
+    size_t m_current;
+    size_t m_fill;
+};
+
+}
+
+std::unique_ptr<input_file> open_io_uring_input_file(
+    std::string const & filename,
+    file_options const & options)
+{
+    return std::make_unique<io_uring_input>(filename, options);
+}
+
+std::unique_ptr<output_file> open_io_uring_output_file(
+    std::string const & filename,
+    file_options const & options)
+{
+    return std::make_unique<io_uring_output>(filename, options);
+}
+
+}
@@ -0,0 +1,29 @@
+#ifndef AES256GCM_PROPRIETARY_IO_URING_FILE_HPP
+#define AES256GCM_PROPRIETARY_IO_URING_FILE_HPP
+
+#include "aes256gcm/proprietary/io_engine.hpp"
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Opens a file for sequential reading using io_uring.
+///
+/// Keeps queue_depth reads of buffer_size bytes in flight ahead of the reader.
+///
+/// @throws A runtime_error is thrown if io_uring is not available.
+std::unique_ptr<input_file> open_io_uring_input_file(
+    std::string const & filename,
+    file_options const & options);
+
+/// @brief Creates or truncates a file for sequential writing using io_uring.
+///
+/// Keeps up to queue_depth writes of buffer_size bytes in flight.
+///
+/// @throws A runtime_error is thrown if io_uring is not available.
+std::unique_ptr<output_file> open_io_uring_output_file(
+    std::string const & filename,
+    file_options const & options);
+
+}
+
+#endif
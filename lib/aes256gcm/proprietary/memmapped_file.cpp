@@ -4,20 +4,21 @@
 #include <unistd.h>
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <stdexcept>
 
 namespace aes256gcm::proprietary
 {
 
-memmapped_file::memmapped_file(std::string const & filename)
+memmapped_file::memmapped_file(std::string const & filename, size_t window_size)
+: m_offset(0)
+, m_size(0)
+, m_address(nullptr)
 {
-    auto const file_size = std::filesystem::file_size(filename);
-    if (file_size > SIZE_MAX)
-    {
-        throw std::runtime_error("file too large");
-    }
-    m_size = static_cast<size_t>(file_size);
+    size_t const page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    m_window_size = std::max(page_size, ((window_size + page_size - 1) / page_size) * page_size);
+    m_file_size = std::filesystem::file_size(filename);
 
     m_fd = open(filename.c_str(), O_RDWR);
     if (m_fd < 0)
@@ -25,18 +26,21 @@ memmapped_file::memmapped_file(std::string const & filename)
         throw std::runtime_error("failed to open file");
     }
 
-    m_address = reinterpret_cast<char*>(mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0));
-    if (nullptr == m_address)
+    try
     {
-        close(m_fd);
-        throw std::runtime_error("failed to memmap file");
+        map(0);
+    }
+    catch (...)
+    {
+        ::close(m_fd);
+        throw;
     }
 }
 
 memmapped_file::~memmapped_file()
 {
-    munmap(m_address, m_size);
-    close(m_fd);
+    unmap();
+    ::close(m_fd);
 }
 
 char * memmapped_file::address() const noexcept
@@ -49,5 +53,75 @@ size_t memmapped_file::size() const noexcept
     return m_size;
 }
 
+uint64_t memmapped_file::offset() const noexcept
+{
+    return m_offset;
+}
+
+uint64_t memmapped_file::file_size() const noexcept
+{
+    return m_file_size;
+}
+
+bool memmapped_file::next()
+{
+    uint64_t const next_offset = m_offset + m_size;
+    if (next_offset >= m_file_size)
+    {
+        return false;
+    }
+
+    unmap();
+    map(next_offset);
+    return true;
+}
+
+void memmapped_file::close()
+{
+    unmap();
+}
+
+void memmapped_file::map(uint64_t offset)
+{
+    m_offset = offset;
+    m_size = static_cast<size_t>(std::min<uint64_t>(m_window_size, m_file_size - offset));
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    void * address = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(offset));
+    if (MAP_FAILED == address)
+    {
+        m_size = 0;
+        throw std::runtime_error("failed to memmap file");
+    }
+    m_address = reinterpret_cast<char*>(address);
 
-}
\ No newline at end of file
+    // hints only, failure is not an error
+    madvise(m_address, m_size, MADV_SEQUENTIAL);
+    madvise(m_address, m_size, MADV_WILLNEED);
+
+    // the next window is not mapped yet, so it is read ahead through the
+    // page cache while this one is processed
+    uint64_t const next_offset = offset + m_size;
+    if (next_offset < m_file_size)
+    {
+        posix_fadvise(m_fd, static_cast<off_t>(next_offset),
+            static_cast<off_t>(std::min<uint64_t>(m_window_size, m_file_size - next_offset)), POSIX_FADV_WILLNEED);
+    }
+}
+
+void memmapped_file::unmap() noexcept
+{
+    if (nullptr != m_address)
+    {
+        // start write back and release pages before moving on
+        msync(m_address, m_size, MS_ASYNC);
+        madvise(m_address, m_size, MADV_DONTNEED);
+        munmap(m_address, m_size);
+        m_address = nullptr;
+    }
+}
+
+}
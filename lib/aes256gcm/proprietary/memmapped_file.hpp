@@ -1,24 +1,63 @@
 #ifndef AES256GCM_PROPRIETARY_MEMMAPPED_FILE_HPP
 #define AES256GCM_PROPRIETARY_MEMMAPPED_FILE_HPP
 
+#include "aes256gcm/proprietary/io_engine.hpp"
+
+#include <cstdint>
 #include <string>
 
 namespace aes256gcm::proprietary
 {
 
-class memmapped_file
+/// @brief Read / write memory mapping of a file using a sliding window.
+///
+/// Only a window of the file is mapped at a time. The window is
+/// prefetched when mapped, together with the range of the next window,
+/// and written back and released when the next window is mapped, so
+/// memory usage is bounded by the window size regardless of the file size.
+class memmapped_file: public inplace_file
 {
     memmapped_file(memmapped_file const &) = delete;
     memmapped_file& operator=(memmapped_file const &) = delete;
     memmapped_file(memmapped_file &&) = delete;
     memmapped_file& operator=(memmapped_file &&) = delete;
 public:
-    explicit memmapped_file(std::string const & filename);
-    ~memmapped_file();
-    char * address() const noexcept;
-    size_t size() const noexcept;
+    /// @brief Opens a file and maps its first window.
+    ///
+    /// @param filename path of the file to map
+    /// @param window_size maximum size of the mapped window; rounded up to the page size
+    /// @throws A runtime_error is thrown if the file cannot be opened or mapped.
+    memmapped_file(std::string const & filename, size_t window_size);
+    ~memmapped_file() override;
+
+    /// @brief Returns the address of the current window.
+    char * address() const noexcept override;
+
+    /// @brief Returns the size of the current window.
+    size_t size() const noexcept override;
+
+    /// @brief Returns the offset of the current window within the file.
+    uint64_t offset() const noexcept;
+
+    /// @brief Returns the size of the file.
+    uint64_t file_size() const noexcept;
+
+    /// @brief Releases the current window and maps the next one.
+    /// @return false, if there is no further window, true otherwise
+    /// @throws A runtime_error is thrown if the next window cannot be mapped.
+    bool next() override;
+
+    /// @brief Releases the current window.
+    void close() override;
+
 private:
+    void map(uint64_t offset);
+    void unmap() noexcept;
+
     int m_fd;
+    uint64_t m_file_size;
+    size_t m_window_size;
+    uint64_t m_offset;
     size_t m_size;
     char * m_address;
 };
@@ -0,0 +1,258 @@
+#include "aes256gcm/metadata_catalog.hpp"
+#include "aes256gcm/encryption_info_view.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+// A catalog starts with catalog_signature, the big-endian 32 bit version and
+// the 64 bit number of entries. Each entry consists of device, inode, size
+// and modification time (64 bit each), the size of the encryption info in the
+// file (32 bit), flags (8 bit), the size of the raw encryption info (32 bit)
+// and the raw encryption info itself.
+constexpr char const catalog_signature[8] = {'E', 'N', 'C', '-', 'C', 'T', 'L', 'G'};
+constexpr uint32_t const catalog_version = 1;
+constexpr size_t const catalog_header_size = sizeof(catalog_signature) + 4 + 8;
+constexpr size_t const entry_header_size = 4 * 8 + 4 + 1 + 4;
+constexpr uint8_t const stream_flag = 1;
+
+void put_u64(std::vector<char> & data, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        data.push_back(static_cast<char>((value >> (56 - i * 8)) & 0xff));
+    }
+}
+
+void put_u32(std::vector<char> & data, uint32_t value)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        data.push_back(static_cast<char>((value >> (24 - i * 8)) & 0xff));
+    }
+}
+
+uint64_t get_u64(char const * data)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < 8; i++)
+    {
+        result = (result << 8) | (static_cast<uint64_t>(data[i]) & 0xff);
+    }
+    return result;
+}
+
+uint32_t get_u32(char const * data)
+{
+    uint32_t result = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        result = (result << 8) | (static_cast<uint32_t>(data[i]) & 0xff);
+    }
+    return result;
+}
+
+int64_t modification_time(struct stat const & status)
+{
+    return static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+}
+
+}
+
+metadata_catalog::metadata_catalog(std::string const & filename)
+: m_filename(filename)
+, m_modified(false)
+{
+    load();
+}
+
+metadata_catalog::~metadata_catalog() = default;
+
+char const * metadata_catalog::lookup(std::string const & filename, encryption_info & info)
+{
+    struct stat status;
+    if (0 != stat(filename.c_str(), &status))
+    {
+        throw std::runtime_error("failed to get file status");
+    }
+
+    file_id id = {static_cast<uint64_t>(status.st_dev), static_cast<uint64_t>(status.st_ino)};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto const it = m_entries.find(id);
+        if ((it != m_entries.end()) && (it->second.size == static_cast<uint64_t>(status.st_size))
+            && (it->second.mtime == modification_time(status)))
+        {
+            encryption_info_view view;
+            if (nullptr == view.parse(it->second.raw_info.data(), it->second.raw_info.size()))
+            {
+                view.copy_to(info);
+                info.size = it->second.info_size;
+                info.is_stream = it->second.is_stream;
+                return nullptr;
+            }
+        }
+    }
+
+    // stale or missing entry; the status of the open file is used, so that
+    // the entry matches the encryption info read
+    file_descriptor file(filename, O_RDONLY);
+    if (0 != fstat(file.get(), &status))
+    {
+        throw std::runtime_error("failed to get file status");
+    }
+    id = {static_cast<uint64_t>(status.st_dev), static_cast<uint64_t>(status.st_ino)};
+
+    encryption_info_view view;
+    auto const error = view.read(file.get(), static_cast<uint64_t>(status.st_size));
+    if (nullptr != error)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.erase(id) > 0)
+        {
+            m_modified = true;
+        }
+        return error;
+    }
+    view.copy_to(info);
+
+    std::vector<char> raw_info;
+    create_encryption_info(raw_info, info);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[id] = {static_cast<uint64_t>(status.st_size), modification_time(status),
+        static_cast<uint32_t>(info.size), info.is_stream, std::string(raw_info.data(), raw_info.size())};
+    m_modified = true;
+    return nullptr;
+}
+
+void metadata_catalog::update(std::string const & filename, encryption_info const & info)
+{
+    struct stat status;
+    if (0 != stat(filename.c_str(), &status))
+    {
+        throw std::runtime_error("failed to get file status");
+    }
+
+    std::vector<char> raw_info;
+    create_encryption_info(raw_info, info);
+
+    file_id const id = {static_cast<uint64_t>(status.st_dev), static_cast<uint64_t>(status.st_ino)};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[id] = {static_cast<uint64_t>(status.st_size), modification_time(status),
+        static_cast<uint32_t>(info.size), info.is_stream, std::string(raw_info.data(), raw_info.size())};
+    m_modified = true;
+}
+
+void metadata_catalog::save()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_modified)
+    {
+        return;
+    }
+
+    std::vector<char> data(catalog_signature, catalog_signature + sizeof(catalog_signature));
+    put_u32(data, catalog_version);
+    put_u64(data, m_entries.size());
+    for (auto const & [id, entry]: m_entries)
+    {
+        put_u64(data, id.device);
+        put_u64(data, id.inode);
+        put_u64(data, entry.size);
+        put_u64(data, static_cast<uint64_t>(entry.mtime));
+        put_u32(data, entry.info_size);
+        data.push_back(entry.is_stream ? stream_flag : 0);
+        put_u32(data, static_cast<uint32_t>(entry.raw_info.size()));
+        data.insert(data.end(), entry.raw_info.begin(), entry.raw_info.end());
+    }
+
+    auto const temp_filename = m_filename + ".tmp";
+    {
+        std::ofstream out(temp_filename, std::ios_base::binary | std::ios_base::trunc);
+        out.write(data.data(), data.size());
+        out.close();
+        if (out.fail())
+        {
+            std::filesystem::remove(temp_filename);
+            throw std::runtime_error("failed to write catalog");
+        }
+    }
+    std::filesystem::rename(temp_filename, m_filename);
+
+    m_modified = false;
+}
+
+size_t metadata_catalog::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void metadata_catalog::load()
+{
+    std::ifstream in(m_filename, std::ios_base::binary | std::ios_base::ate);
+    if (!in.is_open())
+    {
+        return;
+    }
+
+    std::vector<char> data(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(data.data(), data.size());
+    if (static_cast<size_t>(in.gcount()) != data.size())
+    {
+        throw std::runtime_error("failed to read catalog");
+    }
+
+    if ((data.size() < catalog_header_size)
+        || (0 != memcmp(data.data(), catalog_signature, sizeof(catalog_signature)))
+        || (get_u32(&data[sizeof(catalog_signature)]) != catalog_version))
+    {
+        // rebuilt by lookups
+        m_modified = true;
+        return;
+    }
+
+    uint64_t const count = get_u64(&data[sizeof(catalog_signature) + 4]);
+    size_t pos = catalog_header_size;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (data.size() - pos < entry_header_size)
+        {
+            m_entries.clear();
+            m_modified = true;
+            return;
+        }
+
+        char const * const header = &data[pos];
+        file_id const id = {get_u64(header), get_u64(&header[8])};
+        uint32_t const raw_size = get_u32(&header[37]);
+        pos += entry_header_size;
+        if (data.size() - pos < raw_size)
+        {
+            m_entries.clear();
+            m_modified = true;
+            return;
+        }
+
+        m_entries[id] = {get_u64(&header[16]), static_cast<int64_t>(get_u64(&header[24])),
+            get_u32(&header[32]), (header[36] & stream_flag) != 0, std::string(&data[pos], raw_size)};
+        pos += raw_size;
+    }
+}
+
+}
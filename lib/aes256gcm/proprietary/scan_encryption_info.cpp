@@ -0,0 +1,56 @@
+#include "aes256gcm/encryption_info_view.hpp"
+#include "aes256gcm/metadata_catalog.hpp"
+#include "aes256gcm/parallel_for.hpp"
+
+#include <exception>
+
+namespace aes256gcm::proprietary
+{
+
+std::vector<scanned_encryption_info> scan_encryption_info(
+    std::vector<std::string> const & filenames,
+    unsigned int threads,
+    metadata_catalog * catalog)
+{
+    std::vector<scanned_encryption_info> result(filenames.size());
+    parallel_for(filenames.size(), threads, [&](size_t i)
+    {
+        auto & entry = result[i];
+        entry.filename = filenames[i];
+
+        // failures are reported per file, so that they do not abort the scan
+        try
+        {
+            if (nullptr != catalog)
+            {
+                auto const error = catalog->lookup(filenames[i], entry.info);
+                if (nullptr != error)
+                {
+                    entry.error = error;
+                }
+                return;
+            }
+
+            encryption_info_view view;
+            auto const error = view.read(filenames[i]);
+            if (nullptr != error)
+            {
+                entry.error = error;
+                return;
+            }
+            view.copy_to(entry.info);
+        }
+        catch (std::exception const & ex)
+        {
+            entry.error = ex.what();
+        }
+        catch (...)
+        {
+            entry.error = "unexpected error";
+        }
+    });
+
+    return result;
+}
+
+}
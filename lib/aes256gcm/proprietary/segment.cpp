@@ -0,0 +1,345 @@
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/context_pool.hpp"
+#include "aes256gcm/parallel_for.hpp"
+#include "aes256gcm/proprietary/transform_file.hpp"
+#include "aes256gcm/openssl_error.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+constexpr char const segment_digest_label[] = "aes256gcm segment digest";
+constexpr size_t const hmac_sha256_size = 32;
+
+EVP_MAC * fetch_hmac()
+{
+    // fetching is expensive, so the algorithm is fetched once per process
+    static auto const mac = []()
+    {
+        EVP_MAC * raw_mac = EVP_MAC_fetch(nullptr, OSSL_MAC_NAME_HMAC, nullptr);
+        if (nullptr == raw_mac)
+        {
+            throw openssl_error();
+        }
+        return std::unique_ptr<EVP_MAC, void (*) (EVP_MAC*)>(raw_mac, EVP_MAC_free);
+    }();
+
+    return mac.get();
+}
+
+void hmac_sha256(
+    std::string_view key,
+    char const * prefix,
+    size_t prefix_size,
+    char const * data,
+    size_t size,
+    unsigned char * result)
+{
+    EVP_MAC_CTX * raw_ctx = EVP_MAC_CTX_new(fetch_hmac());
+    if (nullptr == raw_ctx)
+    {
+        throw openssl_error();
+    }
+    auto ctx = std::unique_ptr<EVP_MAC_CTX, void (*) (EVP_MAC_CTX*)>(raw_ctx, EVP_MAC_CTX_free);
+
+    char digest[] = "SHA256";
+    OSSL_PARAM const params[] =
+    {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+
+    size_t result_size = 0;
+    if ((1 != EVP_MAC_init(ctx.get(), reinterpret_cast<unsigned char const*>(key.data()), key.size(), params))
+        || (1 != EVP_MAC_update(ctx.get(), reinterpret_cast<unsigned char const*>(prefix), prefix_size))
+        || (1 != EVP_MAC_update(ctx.get(), reinterpret_cast<unsigned char const*>(data), size))
+        || (1 != EVP_MAC_final(ctx.get(), result, &result_size, hmac_sha256_size)))
+    {
+        throw openssl_error();
+    }
+}
+
+}
+
+std::string segment_nonce(std::string const & base_nonce, uint64_t index)
+{
+    std::string nonce = base_nonce;
+    for (size_t i = 0; i < 8; i++)
+    {
+        nonce[nonce_size - 1 - i] ^= static_cast<char>((index >> (i * 8)) & 0xff);
+    }
+
+    return nonce;
+}
+
+std::string segment_additional_data(
+    std::string const & additional_data,
+    uint64_t index,
+    bool is_last)
+{
+    std::string result = additional_data;
+    for (size_t i = 0; i < 8; i++)
+    {
+        result.push_back(static_cast<char>((index >> ((7 - i) * 8)) & 0xff));
+    }
+    result.push_back(is_last ? 1 : 0);
+
+    return result;
+}
+
+uint64_t segment_count(uint64_t data_size, size_t segment_size)
+{
+    if (data_size == 0)
+    {
+        return 1;
+    }
+
+    return (data_size + segment_size - 1) / segment_size;
+}
+
+uint64_t stored_segment_count(uint64_t payload_size, size_t segment_size)
+{
+    uint64_t const stored_size = segment_size + segment_overhead;
+    uint64_t count = payload_size / stored_size;
+    uint64_t const remainder = payload_size % stored_size;
+    if (remainder != 0)
+    {
+        if (remainder < segment_overhead)
+        {
+            return 0;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+secure_buffer segment_digest_key(std::string_view key)
+{
+    static_assert(hmac_sha256_size == key_size);
+    auto digest_key = secure_pool::instance().allocate_key(key_size);
+    hmac_sha256(key, segment_digest_label, sizeof(segment_digest_label) - 1, nullptr, 0,
+        reinterpret_cast<unsigned char*>(digest_key.get()));
+    return digest_key;
+}
+
+void segment_digest(
+    std::string_view digest_key,
+    uint64_t index,
+    char const * data,
+    size_t size,
+    char * digest)
+{
+    char prefix[8];
+    for (size_t i = 0; i < 8; i++)
+    {
+        prefix[i] = static_cast<char>((index >> ((7 - i) * 8)) & 0xff);
+    }
+
+    unsigned char result[EVP_MAX_MD_SIZE];
+    hmac_sha256(digest_key, prefix, sizeof(prefix), data, size, result);
+    memcpy(digest, result, segment_digest_size);
+}
+
+void encrypt_segment(
+    std::string_view key,
+    std::string const & key_id,
+    std::string const & nonce,
+    std::string const & additional_data,
+    char const * in,
+    size_t size,
+    char * out,
+    std::string const & algorithm)
+{
+    auto & enc = pooled_encrypter(key_id, key, nonce, additional_data, algorithm);
+    enc.update(in, &out[nonce_size], size);
+    auto const tag = enc.finalize();
+
+    memcpy(out, nonce.data(), nonce_size);
+    memcpy(&out[nonce_size + size], tag.data(), tag_size);
+}
+
+bool decrypt_segment(
+    std::string_view key,
+    std::string const & key_id,
+    std::string const & additional_data,
+    char const * in,
+    size_t stored_size,
+    char * out,
+    std::string const & algorithm)
+{
+    if (stored_size < segment_overhead)
+    {
+        return false;
+    }
+
+    size_t const size = stored_size - segment_overhead;
+    std::string const nonce(in, nonce_size);
+    std::string const tag(&in[nonce_size + size], tag_size);
+
+    auto & dec = pooled_decrypter(key_id, key, nonce, tag, additional_data, algorithm);
+    dec.update(&in[nonce_size], out, size);
+    return dec.finalize();
+}
+
+void encrypt_segments(
+    input_file & in,
+    output_file & out,
+    std::string_view key,
+    std::string const & base_nonce,
+    std::string const & additional_data,
+    std::string const & algorithm,
+    uint64_t data_size,
+    file_options const & options,
+    std::string * digests)
+{
+    size_t const segment_size = options.segment_size;
+    std::string const key_id = context_key_id(key);
+    auto const digest_key = (nullptr != digests) ? segment_digest_key(key) : secure_buffer();
+    size_t const stored_size = segment_size + segment_overhead;
+    bool const is_size_known = (data_size != unknown_data_size);
+    uint64_t const count = is_size_known ? segment_count(data_size, segment_size) : UINT64_MAX;
+    size_t const batch_size = static_cast<size_t>(std::min<uint64_t>(count, std::max(options.threads, 1u) * segments_per_thread));
+    size_t const chunk_size = batch_size * segment_size;
+
+    uint64_t next_index = 0;
+    auto const bytes_read = transform_file(in, out, data_size, chunk_size, batch_size * stored_size,
+        [&](char const * in_buffer, size_t size, char * out_buffer)
+        {
+            // if the size is unknown, the last chunk is the first one not filled
+            // up, which ends with the last segment; it is empty, if the data
+            // ends at a chunk boundary
+            bool const is_last_chunk = (!is_size_known) && (size < chunk_size);
+            uint64_t const last_index = is_last_chunk
+                ? next_index + std::max<uint64_t>((size + segment_size - 1) / segment_size, 1) - 1
+                : count - 1;
+
+            // an empty file is stored as a single empty segment
+            size_t const segments = ((size == 0) && (last_index == next_index)) ? 1
+                : static_cast<size_t>((size + segment_size - 1) / segment_size);
+            uint64_t const first = next_index;
+            if (nullptr != digests)
+            {
+                digests->resize((first + segments) * segment_digest_size);
+            }
+
+            parallel_for(segments, options.threads, [&](size_t i)
+            {
+                uint64_t const index = first + i;
+                size_t const offset = i * segment_size;
+                size_t const plain_size = std::min(segment_size, size - std::min(size, offset));
+
+                if (nullptr != digests)
+                {
+                    segment_digest(digest_key.view(), index, &in_buffer[offset], plain_size,
+                        &(*digests)[index * segment_digest_size]);
+                }
+
+                encrypt_segment(key, key_id,
+                    segment_nonce(base_nonce, index),
+                    segment_additional_data(additional_data, index, index == last_index),
+                    &in_buffer[offset], plain_size,
+                    &out_buffer[i * stored_size], algorithm);
+            });
+
+            next_index += segments;
+            return size + segments * segment_overhead;
+        }, options);
+
+    if (is_size_known && ((bytes_read != data_size) || (next_index != count)))
+    {
+        throw std::runtime_error("failed to read from file");
+    }
+}
+
+bool decrypt_segments(
+    input_file & in,
+    output_file & out,
+    std::string_view key,
+    encryption_info const & info,
+    uint64_t payload_size,
+    file_options const & options)
+{
+    size_t const segment_size = info.segment_size;
+    size_t const stored_size = segment_size + segment_overhead;
+    std::string const key_id = context_key_id(key);
+    uint64_t const count = stored_segment_count(payload_size, segment_size);
+    if (count == 0)
+    {
+        std::cerr << "error: invalid payload size" << std::endl;
+        return false;
+    }
+
+    size_t const batch_size = static_cast<size_t>(std::min<uint64_t>(count, std::max(options.threads, 1u) * segments_per_thread));
+
+    // thrown to stop decryption at the first segment failing authentication
+    struct segment_corrupted
+    {
+        uint64_t index;
+    };
+
+    uint64_t next_index = 0;
+    try
+    {
+        auto const bytes_read = transform_file(in, out, payload_size, batch_size * stored_size, batch_size * segment_size,
+            [&](char const * in_buffer, size_t size, char * out_buffer)
+            {
+                size_t const segments = static_cast<size_t>((size + stored_size - 1) / stored_size);
+                uint64_t const first = next_index;
+
+                std::atomic<uint64_t> failed_index(count);
+                parallel_for(segments, options.threads, [&](size_t i)
+                {
+                    uint64_t const index = first + i;
+                    size_t const offset = i * stored_size;
+
+                    bool const is_authentic = decrypt_segment(key, key_id,
+                        segment_additional_data(info.additional_data, index, index + 1 == count),
+                        &in_buffer[offset], std::min(stored_size, size - offset),
+                        &out_buffer[i * segment_size], info.encryption_method);
+                    if (!is_authentic)
+                    {
+                        uint64_t expected = failed_index;
+                        while ((index < expected) && (!failed_index.compare_exchange_weak(expected, index)));
+                    }
+                });
+
+                if (failed_index < count)
+                {
+                    throw segment_corrupted{failed_index};
+                }
+
+                next_index += segments;
+                return size - segments * segment_overhead;
+            }, options);
+
+        if (bytes_read != payload_size)
+        {
+            throw std::runtime_error("failed to read from file");
+        }
+    }
+    catch (segment_corrupted const & ex)
+    {
+        std::cerr << "error: segment " << ex.index << " corrupted" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}
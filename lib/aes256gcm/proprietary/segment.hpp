@@ -0,0 +1,164 @@
+#ifndef AES256GCM_PROPRIETARY_SEGMENT_HPP
+#define AES256GCM_PROPRIETARY_SEGMENT_HPP
+
+#include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/context_pool.hpp"
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace aes256gcm::proprietary
+{
+
+// A segmented (v2) file stores its payload as a sequence of segments.
+// Each segment is stored as nonce | ciphertext | tag, where the ciphertext
+// has the size of the segment size given in the encryption info; only the
+// last segment may be shorter. Each segment is authenticated on its own,
+// using the file's additional data, the segment index and a flag marking the
+// last segment as additional authenticated data. This way reordering and
+// truncation of segments are detected.
+
+constexpr size_t const segment_overhead = nonce_size + tag_size;
+constexpr size_t const default_segment_size = 1024 * 1024;
+constexpr size_t const max_segment_size = 256 * 1024 * 1024;
+
+// passed to encrypt_segments as data size to read the input until its end
+constexpr uint64_t const unknown_data_size = UINT64_MAX;
+
+// number of segments processed per thread and batch
+constexpr size_t const segments_per_thread = 4;
+
+// Segment digests are keyed digests of the plaintext of each segment,
+// stored in the encryption info to find changed segments without
+// decrypting the file (see update_encrypted_file). The digest key is
+// derived from the encryption key and the segment index is digested
+// along with the plaintext, so equal segments have different digests.
+constexpr size_t const segment_digest_size = 16;
+constexpr size_t const max_segment_digests_size = 15 * 1024 * 1024;
+
+/// @brief Derives the nonce of a segment from the file's base nonce.
+std::string segment_nonce(std::string const & base_nonce, uint64_t index);
+
+/// @brief Returns the additional authenticated data of a segment.
+std::string segment_additional_data(
+    std::string const & additional_data,
+    uint64_t index,
+    bool is_last);
+
+/// @brief Returns the number of segments to store data_size bytes of plaintext.
+///
+/// @note There is always at least one segment, even for empty files.
+uint64_t segment_count(uint64_t data_size, size_t segment_size);
+
+/// @brief Returns the number of segments of a stored (encrypted) payload.
+///
+/// @return number of segments or 0 if the payload size is invalid.
+uint64_t stored_segment_count(uint64_t payload_size, size_t segment_size);
+
+/// @brief Derives the key of segment digests from the encryption key.
+/// @return key of key_size bytes in a key buffer of the secure pool
+secure_buffer segment_digest_key(std::string_view key);
+
+/// @brief Computes the digest of a segment's plaintext.
+///
+/// @param digest_key key returned by segment_digest_key
+/// @param index index of the segment
+/// @param data plaintext of the segment
+/// @param size size of the plaintext
+/// @param digest buffer of segment_digest_size bytes to store the digest
+void segment_digest(
+    std::string_view digest_key,
+    uint64_t index,
+    char const * data,
+    size_t size,
+    char * digest);
+
+/// @brief Encrypts a single segment.
+///
+/// @param key encryption key
+/// @param key_id id of the key returned by context_key_id
+/// @param nonce nonce of the segment
+/// @param additional_data additional authenticated data of the segment
+/// @param in plaintext of the segment
+/// @param size size of the plaintext
+/// @param out buffer of at least size + segment_overhead bytes to store the segment
+/// @param algorithm AEAD algorithm used for encryption
+void encrypt_segment(
+    std::string_view key,
+    std::string const & key_id,
+    std::string const & nonce,
+    std::string const & additional_data,
+    char const * in,
+    size_t size,
+    char * out,
+    std::string const & algorithm);
+
+/// @brief Decrypts and authenticates a single segment.
+///
+/// @param key encryption key
+/// @param key_id id of the key returned by context_key_id
+/// @param additional_data additional authenticated data of the segment
+/// @param in stored segment (nonce | ciphertext | tag)
+/// @param stored_size size of the stored segment
+/// @param out buffer of at least stored_size - segment_overhead bytes
+/// @param algorithm AEAD algorithm used for encryption
+/// @return true, if the segment is authentic, false otherwise
+bool decrypt_segment(
+    std::string_view key,
+    std::string const & key_id,
+    std::string const & additional_data,
+    char const * in,
+    size_t stored_size,
+    char * out,
+    std::string const & algorithm);
+
+/// @brief Encrypts a file into segments using multiple threads.
+///
+/// @param in file to read plaintext from
+/// @param out file to write segments to
+/// @param key encryption key
+/// @param base_nonce nonce used to derive segment nonces
+/// @param additional_data additional authenticated data of the file
+/// @param algorithm AEAD algorithm used for encryption
+/// @param data_size size of the plaintext or unknown_data_size
+/// @param options options of encryption (segment size, threads, pipelining)
+/// @param digests if not null, the segment digests are stored here
+/// @throws A runtime_error is thrown on I/O errors.
+void encrypt_segments(
+    input_file & in,
+    output_file & out,
+    std::string_view key,
+    std::string const & base_nonce,
+    std::string const & additional_data,
+    std::string const & algorithm,
+    uint64_t data_size,
+    file_options const & options,
+    std::string * digests = nullptr);
+
+/// @brief Decrypts segments of a file using multiple threads.
+///
+/// @note Decryption stops at the first segment failing authentication.
+///
+/// @param in file to read segments from
+/// @param out file to write plaintext to
+/// @param key encryption key
+/// @param info encryption info of the file
+/// @param payload_size size of all stored segments
+/// @param options options of decryption (threads, pipelining)
+/// @return true, if all segments are authentic, false otherwise
+/// @throws A runtime_error is thrown on I/O errors.
+bool decrypt_segments(
+    input_file & in,
+    output_file & out,
+    std::string_view key,
+    encryption_info const & info,
+    uint64_t payload_size,
+    file_options const & options);
+
+}
+
+#endif
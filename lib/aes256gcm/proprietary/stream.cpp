@@ -0,0 +1,273 @@
+#include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+// Each frame is stored as be32(size | flags) | nonce | ciphertext | tag,
+// where size is the size of the plaintext. Frames are encrypted like the
+// segments of a segmented file, i.e. the frame index and the last frame
+// flag are authenticated; the last frame may be empty.
+
+namespace
+{
+
+constexpr uint32_t const last_frame_flag = 0x80000000;
+constexpr size_t const frame_header_size = 4;
+
+void write_u32(std::ostream & out, uint32_t value)
+{
+    char const data[4] =
+    {
+        static_cast<char>((value >> 24) & 0xff),
+        static_cast<char>((value >> 16) & 0xff),
+        static_cast<char>((value >>  8) & 0xff),
+        static_cast<char>(value & 0xff)
+    };
+    out.write(data, sizeof(data));
+}
+
+uint32_t parse_u32(char const * data)
+{
+    uint32_t result = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        result <<= 8;
+        result |= static_cast<uint32_t>(data[i]) & 0xff;
+    }
+    return result;
+}
+
+size_t read_fully(std::istream & in, char * buffer, size_t size)
+{
+    in.read(buffer, size);
+    if (in.bad())
+    {
+        throw std::runtime_error("failed to read from stream");
+    }
+
+    return static_cast<size_t>(in.gcount());
+}
+
+}
+
+bool read_stream_header(
+    std::istream & in,
+    encryption_info & info)
+{
+    char prefix[stream_header_prefix_size];
+    if (read_fully(in, prefix, sizeof(prefix)) != sizeof(prefix))
+    {
+        std::cerr << "error: failed to read stream header" << std::endl;
+        return false;
+    }
+
+    if (0 != memcmp(prefix, stream_signature, sizeof(stream_signature)))
+    {
+        std::cerr << "error: invalid stream signature" << std::endl;
+        return false;
+    }
+
+    uint32_t const info_size = parse_u32(&prefix[sizeof(stream_signature)]);
+    if ((info_size < end_of_info_size) || (info_size > max_info_size))
+    {
+        std::cerr << "error: invalid info size: " << info_size << std::endl;
+        return false;
+    }
+
+    std::vector<char> raw_info(info_size);
+    if (read_fully(in, raw_info.data(), raw_info.size()) != info_size)
+    {
+        std::cerr << "error: failed to read stream header" << std::endl;
+        return false;
+    }
+
+    if (!parse_encryption_info(raw_info, info))
+    {
+        return false;
+    }
+
+    info.size = stream_header_prefix_size + info_size;
+    info.is_stream = true;
+    return true;
+}
+
+void encrypt_stream(
+    std::istream & in,
+    std::ostream & out,
+    std::string const & password,
+    std::string const & additional_data,
+    file_options const & options)
+{
+    size_t const frame_size = (options.segment_size > 0) ? options.segment_size : default_segment_size;
+    if (frame_size > max_segment_size)
+    {
+        throw std::logic_error("invalid segment size");
+    }
+
+    if (!options.compression.empty())
+    {
+        throw std::logic_error("streams cannot be compressed");
+    }
+
+    auto const kdf = generate_kdf_params(options.kdf, options.kdf_time_cost, options.kdf_memory_cost, options.kdf_lanes);
+    auto const key_buffer = derive_secure_key(password, kdf);
+    auto const key = key_buffer.view();
+    auto const algorithm = select_aead(options.algorithm);
+    auto const nonce = rand(nonce_size);
+
+    encryption_info info = {};
+    info.kdf = kdf;
+    info.encryption_method = algorithm;
+    info.nonce = nonce;
+    info.additional_data = additional_data;
+    info.segment_size = frame_size;
+    info.key_check = key_check_value(key);
+
+    std::vector<char> data;
+    create_encryption_info(data, info);
+    out.write(stream_signature, sizeof(stream_signature));
+    write_u32(out, static_cast<uint32_t>(data.size()));
+    out.write(data.data(), data.size());
+
+    auto const key_id = context_key_id(key);
+    std::vector<char> plain(frame_size);
+    std::vector<char> stored(frame_size + segment_overhead);
+    for (uint64_t index = 0; ; index++)
+    {
+        // a short read marks the end of the input; if the input ends at a
+        // frame boundary, an empty last frame follows
+        size_t const size = read_fully(in, plain.data(), frame_size);
+        bool const is_last = (size < frame_size);
+
+        encrypt_segment(key, key_id, segment_nonce(nonce, index),
+            segment_additional_data(additional_data, index, is_last),
+            plain.data(), size, stored.data(), algorithm);
+
+        write_u32(out, static_cast<uint32_t>(size) | (is_last ? last_frame_flag : 0));
+        out.write(stored.data(), size + segment_overhead);
+        out.flush();
+
+        if (!out)
+        {
+            throw std::runtime_error("failed to write to stream");
+        }
+
+        if (is_last)
+        {
+            break;
+        }
+    }
+}
+
+int decrypt_stream(
+    std::istream & in,
+    std::ostream & out,
+    std::string const & password)
+{
+    encryption_info info;
+    if (!read_stream_header(in, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if ((info.segment_size == 0) || (info.segment_size > max_segment_size))
+    {
+        std::cerr << "error: invalid frame size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!info.compression.empty())
+    {
+        std::cerr << "error: compressed streams are not supported" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!is_aead_available(info.encryption_method))
+    {
+        std::cerr << "error: unsupported encryption method: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto const key_buffer = derive_secure_key(password, info.kdf);
+    auto const key = key_buffer.view();
+    if (!check_key(key, info))
+    {
+        std::cerr << "error: wrong password" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto const key_id = context_key_id(key);
+    std::vector<char> stored(info.segment_size + segment_overhead);
+    std::vector<char> plain(info.segment_size);
+    for (uint64_t index = 0; ; index++)
+    {
+        char header[frame_header_size];
+        if (read_fully(in, header, frame_header_size) != frame_header_size)
+        {
+            std::cerr << "error: truncated stream" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        uint32_t const value = parse_u32(header);
+        bool const is_last = (value & last_frame_flag) != 0;
+        size_t const size = value & ~last_frame_flag;
+        if ((size > info.segment_size) || ((!is_last) && (size != info.segment_size)))
+        {
+            std::cerr << "error: invalid frame size" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        size_t const stored_size = size + segment_overhead;
+        if (read_fully(in, stored.data(), stored_size) != stored_size)
+        {
+            std::cerr << "error: truncated stream" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        bool const is_authentic = decrypt_segment(key, key_id,
+            segment_additional_data(info.additional_data, index, is_last),
+            stored.data(), stored_size, plain.data(), info.encryption_method);
+        if (!is_authentic)
+        {
+            std::cerr << "error: failed to decrypt stream" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        out.write(plain.data(), size);
+        out.flush();
+        if (!out)
+        {
+            throw std::runtime_error("failed to write to stream");
+        }
+
+        if (is_last)
+        {
+            break;
+        }
+    }
+
+    if (in.peek() != std::istream::traits_type::eof())
+    {
+        std::cerr << "error: unexpected data after last frame" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+}
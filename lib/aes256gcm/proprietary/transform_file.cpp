@@ -0,0 +1,296 @@
+#include "aes256gcm/proprietary/transform_file.hpp"
+#include "aes256gcm/spsc_ring.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+uint64_t transform_sequential(
+    input_file & in,
+    output_file & out,
+    uint64_t limit,
+    size_t in_chunk_size,
+    size_t out_chunk_size,
+    transform_function const & transform)
+{
+    // plaintext passes these buffers, so they are taken from the secure pool
+    auto const in_buffer = secure_pool::instance().allocate(in_chunk_size);
+    auto const out_buffer = secure_pool::instance().allocate(out_chunk_size);
+
+    uint64_t total = 0;
+    bool last = false;
+    while (!last)
+    {
+        size_t const size = static_cast<size_t>(std::min<uint64_t>(in_chunk_size, limit - total));
+        size_t const bytes_read = in.read(in_buffer.get(), size);
+        total += bytes_read;
+        last = (bytes_read < in_chunk_size) || (total == limit);
+
+        size_t const out_size = transform(in_buffer.get(), bytes_read, out_buffer.get());
+        if (out_size > 0)
+        {
+            out.write(out_buffer.get(), out_size);
+        }
+    }
+
+    return total;
+}
+
+struct chunk
+{
+    size_t buffer;
+    size_t size;
+    bool last;
+};
+
+// thrown by waiting stages when another stage failed
+struct pipeline_aborted { };
+
+// number of attempts before a stage waiting for a ring goes to sleep
+constexpr int const spin_count = 64;
+
+// ring with a condition variable, so that a stage waiting for it sleeps
+// instead of spinning while another stage is busy for a long time, e.g.
+// when the disk is slow
+struct channel
+{
+    explicit channel(size_t capacity)
+    : ring(capacity)
+    , waiters(0)
+    {
+    }
+
+    spsc_ring<chunk> ring;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<int> waiters;
+};
+
+class pipeline
+{
+public:
+    pipeline(size_t depth, size_t in_chunk_size, size_t out_chunk_size)
+    : m_depth(depth)
+    , m_in_chunk_size(in_chunk_size)
+    , m_out_chunk_size(out_chunk_size)
+    , m_in_buffers(secure_pool::instance().allocate(depth * in_chunk_size))
+    , m_out_buffers(secure_pool::instance().allocate(depth * out_chunk_size))
+    , m_free_in(depth)
+    , m_filled_in(depth)
+    , m_free_out(depth)
+    , m_filled_out(depth)
+    , m_aborted(false)
+    {
+        for (size_t i = 0; i < depth; i++)
+        {
+            m_free_in.ring.try_push({i, 0, false});
+            m_free_out.ring.try_push({i, 0, false});
+        }
+    }
+
+    uint64_t run(input_file & in, output_file & out, uint64_t limit, transform_function const & transform)
+    {
+        uint64_t total = 0;
+        std::thread reader([&]() { guard([&]() { total = read(in, limit); }); });
+        std::thread writer([&]() { guard([&]() { write(out); }); });
+        guard([&]() { process(transform); });
+
+        reader.join();
+        writer.join();
+
+        if (m_error)
+        {
+            std::rethrow_exception(m_error);
+        }
+
+        return total;
+    }
+
+private:
+    template <typename Stage>
+    void guard(Stage const & stage)
+    {
+        try
+        {
+            stage();
+        }
+        catch (pipeline_aborted const &)
+        {
+            // another stage failed
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_error_mutex);
+            if (!m_error)
+            {
+                m_error = std::current_exception();
+            }
+            m_aborted = true;
+        }
+
+        if (m_aborted)
+        {
+            for (auto * c: {&m_free_in, &m_filled_in, &m_free_out, &m_filled_out})
+            {
+                std::lock_guard<std::mutex> lock(c->mutex);
+                c->changed.notify_all();
+            }
+        }
+    }
+
+    void push(channel & c, chunk const & item)
+    {
+        wait(c, [&]() { return c.ring.try_push(item); });
+        notify(c);
+    }
+
+    chunk pop(channel & c)
+    {
+        chunk item;
+        wait(c, [&]() { return c.ring.try_pop(item); });
+        notify(c);
+        return item;
+    }
+
+    // retries an operation on a ring for a short while, then sleeps until
+    // the other side changed the ring
+    template <typename Operation>
+    void wait(channel & c, Operation const & operation)
+    {
+        for (int i = 0; i < spin_count; i++)
+        {
+            if (operation())
+            {
+                return;
+            }
+            if (m_aborted)
+            {
+                throw pipeline_aborted();
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(c.mutex);
+        c.waiters++;
+        // pairs with the fence in notify: either the other side sees the
+        // waiter or the operation below sees the change of the other side
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!operation())
+        {
+            if (m_aborted)
+            {
+                c.waiters--;
+                throw pipeline_aborted();
+            }
+            c.changed.wait(lock);
+        }
+        c.waiters--;
+    }
+
+    void notify(channel & c)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (c.waiters.load(std::memory_order_relaxed) > 0)
+        {
+            // taking the lock ensures the waiter is sleeping already
+            {
+                std::lock_guard<std::mutex> lock(c.mutex);
+            }
+            c.changed.notify_all();
+        }
+    }
+
+    uint64_t read(input_file & in, uint64_t limit)
+    {
+        uint64_t total = 0;
+        bool last = false;
+        while (!last)
+        {
+            chunk item = pop(m_free_in);
+            size_t const size = static_cast<size_t>(std::min<uint64_t>(m_in_chunk_size, limit - total));
+            item.size = in.read(&m_in_buffers.get()[item.buffer * m_in_chunk_size], size);
+            total += item.size;
+            item.last = last = (item.size < m_in_chunk_size) || (total == limit);
+            push(m_filled_in, item);
+        }
+        return total;
+    }
+
+    void process(transform_function const & transform)
+    {
+        bool last = false;
+        while (!last)
+        {
+            chunk const in_item = pop(m_filled_in);
+            chunk out_item = pop(m_free_out);
+
+            out_item.size = transform(&m_in_buffers.get()[in_item.buffer * m_in_chunk_size], in_item.size,
+                &m_out_buffers.get()[out_item.buffer * m_out_chunk_size]);
+            out_item.last = last = in_item.last;
+
+            push(m_free_in, in_item);
+            push(m_filled_out, out_item);
+        }
+    }
+
+    void write(output_file & out)
+    {
+        bool last = false;
+        while (!last)
+        {
+            chunk const item = pop(m_filled_out);
+            if (item.size > 0)
+            {
+                out.write(&m_out_buffers.get()[item.buffer * m_out_chunk_size], item.size);
+            }
+            last = item.last;
+            push(m_free_out, item);
+        }
+    }
+
+    size_t m_depth;
+    size_t m_in_chunk_size;
+    size_t m_out_chunk_size;
+    secure_buffer m_in_buffers;
+    secure_buffer m_out_buffers;
+    channel m_free_in;
+    channel m_filled_in;
+    channel m_free_out;
+    channel m_filled_out;
+    std::atomic<bool> m_aborted;
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+};
+
+}
+
+uint64_t transform_file(
+    input_file & in,
+    output_file & out,
+    uint64_t limit,
+    size_t in_chunk_size,
+    size_t out_chunk_size,
+    transform_function const & transform,
+    file_options const & options)
+{
+    if (!options.pipelined)
+    {
+        return transform_sequential(in, out, limit, in_chunk_size, out_chunk_size, transform);
+    }
+
+    pipeline p(std::max(options.queue_depth, 2u), in_chunk_size, out_chunk_size);
+    return p.run(in, out, limit, transform);
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef AES256GCM_PROPRIETARY_TRANSFORM_FILE_HPP
+#define AES256GCM_PROPRIETARY_TRANSFORM_FILE_HPP
+
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/constants.hpp"
+
+#include <cstdint>
+#include <functional>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Transforms a chunk of input data into a chunk of output data.
+///
+/// Called with input chunks in file order. Returns the size of the output.
+using transform_function = std::function<size_t (char const * in, size_t size, char * out)>;
+
+/// @brief Rounds a buffer size up to a non-zero multiple of the cipher block size.
+constexpr size_t align_to_block(size_t size)
+{
+    return ((size + max_block_size - 1) / max_block_size) * max_block_size + ((size == 0) ? max_block_size : 0);
+}
+
+/// @brief Reads a file in chunks, transforms each chunk and writes the result.
+///
+/// Input is read in chunks of in_chunk_size bytes; only the last chunk may
+/// be shorter (possibly empty). If options.pipelined is set, reading,
+/// transformation and writing run concurrently on three threads connected by
+/// bounded queues of options.queue_depth recycled buffers. Otherwise the
+/// stages run one after another on the calling thread.
+///
+/// @param in file to read from
+/// @param out file to write to
+/// @param limit maximum number of bytes to read
+/// @param in_chunk_size size of input chunks
+/// @param out_chunk_size maximum size of output chunks
+/// @param transform function to transform chunks; called on the calling thread
+/// @param options options selecting the pipelined mode
+/// @return number of bytes read
+/// @throws Exceptions of I/O and the transform function are re-thrown.
+uint64_t transform_file(
+    input_file & in,
+    output_file & out,
+    uint64_t limit,
+    size_t in_chunk_size,
+    size_t out_chunk_size,
+    transform_function const & transform,
+    file_options const & options);
+
+}
+
+#endif
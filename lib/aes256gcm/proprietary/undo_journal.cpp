@@ -0,0 +1,268 @@
+#include "aes256gcm/proprietary/undo_journal.hpp"
+#include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/openssl_error.hpp"
+
+#include <openssl/evp.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+constexpr char const journal_signature[8] = {'E', 'N', 'C', '-', 'U', 'N', 'D', 'O'};
+constexpr size_t const journal_header_size = sizeof(journal_signature) + 8;
+constexpr size_t const record_header_size = 16;
+constexpr size_t const record_hash_size = 32;
+
+void put_u64(char * data, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        data[i] = static_cast<char>((value >> (56 - 8 * i)) & 0xff);
+    }
+}
+
+uint64_t parse_u64(char const * data)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < 8; i++)
+    {
+        result <<= 8;
+        result |= static_cast<uint64_t>(data[i]) & 0xff;
+    }
+    return result;
+}
+
+void hash_record(char const * record, size_t size, char * hash)
+{
+    if (1 != EVP_Digest(record, size, reinterpret_cast<unsigned char*>(hash), nullptr, EVP_sha256(), nullptr))
+    {
+        throw openssl_error();
+    }
+}
+
+std::string journal_filename(std::string const & filename)
+{
+    return filename + undo_journal::journal_suffix;
+}
+
+// makes creating, renaming and removing a journal durable
+void sync_directory(std::string const & filename)
+{
+    auto directory = std::filesystem::path(filename).parent_path();
+    if (directory.empty())
+    {
+        directory = ".";
+    }
+
+    file_descriptor fd(directory.string(), O_RDONLY | O_DIRECTORY);
+    if (0 != fsync(fd.get()))
+    {
+        throw std::runtime_error("failed to sync directory");
+    }
+}
+
+uint64_t file_size(int fd)
+{
+    struct stat status;
+    if (0 != fstat(fd, &status))
+    {
+        throw std::runtime_error("failed to get file size");
+    }
+    return static_cast<uint64_t>(status.st_size);
+}
+
+file_descriptor create_journal(std::string const & filename, uint64_t original_size)
+{
+    auto const journal = journal_filename(filename);
+    if (std::filesystem::exists(journal))
+    {
+        throw std::runtime_error("journal of an interrupted update exists");
+    }
+
+    auto const temporary = journal + ".tmp";
+    file_descriptor fd(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    char header[journal_header_size];
+    memcpy(header, journal_signature, sizeof(journal_signature));
+    put_u64(&header[sizeof(journal_signature)], original_size);
+    write_at(fd.get(), header, sizeof(header), 0);
+    sync_file(fd.get());
+
+    if (0 != rename(temporary.c_str(), journal.c_str()))
+    {
+        throw std::runtime_error("failed to create journal");
+    }
+    sync_directory(filename);
+
+    return fd;
+}
+
+}
+
+undo_journal::undo_journal(std::string const & filename, int fd)
+: m_filename(filename)
+, m_fd(fd)
+, m_journal(create_journal(filename, file_size(fd)))
+, m_original_size(file_size(fd))
+, m_journal_size(journal_header_size)
+, m_is_committed(false)
+{
+}
+
+undo_journal::~undo_journal()
+{
+    if (m_is_committed)
+    {
+        return;
+    }
+
+    try
+    {
+        m_journal.close();
+        recover(m_filename);
+    }
+    catch (...)
+    {
+        // the journal is kept, so the file is restored by the next recover
+    }
+}
+
+void undo_journal::save(uint64_t offset, uint64_t size)
+{
+    if (offset >= m_original_size)
+    {
+        return;
+    }
+
+    size = std::min(size, m_original_size - offset);
+    std::vector<char> record(record_header_size + size + record_hash_size);
+    put_u64(&record[0], offset);
+    put_u64(&record[8], size);
+    if (read_at(m_fd, &record[record_header_size], size, offset) != size)
+    {
+        throw std::runtime_error("failed to read from file");
+    }
+    hash_record(record.data(), record_header_size + size, &record[record_header_size + size]);
+
+    write_at(m_journal.get(), record.data(), record.size(), m_journal_size);
+    m_journal_size += record.size();
+}
+
+void undo_journal::sync()
+{
+    sync_file(m_journal.get());
+}
+
+void undo_journal::commit()
+{
+    sync_file(m_fd);
+    m_journal.close();
+    if (0 != unlink(journal_filename(m_filename).c_str()))
+    {
+        throw std::runtime_error("failed to remove journal");
+    }
+    m_is_committed = true;
+    sync_directory(m_filename);
+}
+
+bool undo_journal::recover(std::string const & filename)
+{
+    auto const journal = journal_filename(filename);
+
+    // an incomplete journal is never renamed; the file was not touched
+    std::filesystem::remove(journal + ".tmp");
+    if (!std::filesystem::exists(journal))
+    {
+        return false;
+    }
+
+    file_descriptor fd(journal, O_RDONLY);
+    char header[journal_header_size];
+    if ((read_at(fd.get(), header, sizeof(header), 0) != sizeof(header))
+        || (0 != memcmp(header, journal_signature, sizeof(journal_signature))))
+    {
+        throw std::runtime_error("invalid journal");
+    }
+    uint64_t const original_size = parse_u64(&header[sizeof(journal_signature)]);
+
+    // collects the complete records; reading stops at a torn record
+    struct record
+    {
+        uint64_t position;
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<record> records;
+    uint64_t const journal_size = file_size(fd.get());
+    uint64_t position = journal_header_size;
+    std::vector<char> data;
+    while (journal_size - position >= record_header_size + record_hash_size)
+    {
+        char record_header[record_header_size];
+        read_at(fd.get(), record_header, sizeof(record_header), position);
+        uint64_t const offset = parse_u64(&record_header[0]);
+        uint64_t const size = parse_u64(&record_header[8]);
+        if ((size > journal_size - position - record_header_size - record_hash_size)
+            || (offset > original_size) || (size > original_size - offset))
+        {
+            break;
+        }
+
+        size_t const record_size = static_cast<size_t>(record_header_size + size + record_hash_size);
+        data.resize(record_size);
+        read_at(fd.get(), data.data(), record_size, position);
+        char hash[record_hash_size];
+        hash_record(data.data(), record_header_size + size, hash);
+        if (0 != memcmp(hash, &data[record_header_size + size], record_hash_size))
+        {
+            break;
+        }
+
+        records.push_back({position + record_header_size, offset, size});
+        position += record_size;
+    }
+
+    // later records may save data written after earlier ones,
+    // so the oldest content is restored last
+    file_descriptor file(filename, O_WRONLY);
+    for (auto it = records.rbegin(); it != records.rend(); it++)
+    {
+        data.resize(static_cast<size_t>(it->size));
+        read_at(fd.get(), data.data(), data.size(), it->position);
+        write_at(file.get(), data.data(), data.size(), it->offset);
+    }
+    if (0 != ftruncate(file.get(), static_cast<off_t>(original_size)))
+    {
+        throw std::runtime_error("failed to resize file");
+    }
+    sync_file(file.get());
+    file.close();
+    fd.close();
+
+    if (0 != unlink(journal.c_str()))
+    {
+        throw std::runtime_error("failed to remove journal");
+    }
+    sync_directory(filename);
+    return true;
+}
+
+bool recover_encrypted_file(
+    std::string const & filename)
+{
+    return undo_journal::recover(filename);
+}
+
+}
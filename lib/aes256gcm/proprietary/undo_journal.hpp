@@ -0,0 +1,76 @@
+#ifndef AES256GCM_PROPRIETARY_UNDO_JOURNAL_HPP
+#define AES256GCM_PROPRIETARY_UNDO_JOURNAL_HPP
+
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Undo journal of a file which is modified in place.
+///
+/// Before a range of the file is overwritten, its old content is saved in
+/// a journal next to the file (filename + journal_suffix), which is synced
+/// before the file is written. If the modification is interrupted, e.g. by
+/// a crash, undo_journal::recover restores the old content and size of the
+/// file; data written beyond the old end of the file is discarded.
+///
+/// Journal format: "ENC-UNDO" | be64 original size, followed by records
+/// be64 offset | be64 size | old data | SHA-256 of the preceding fields.
+/// The header is written to a temporary file which is renamed, so a journal
+/// always has a valid header; a torn last record is ignored, as the file
+/// is not written before the record is synced.
+class undo_journal
+{
+    undo_journal(undo_journal const &) = delete;
+    undo_journal& operator=(undo_journal const &) = delete;
+public:
+    /// @brief Creates the journal of a file.
+    /// @param filename path of the file
+    /// @param fd file descriptor of the file opened for reading and writing
+    /// @throws A runtime_error is thrown on I/O errors or if a journal exists.
+    undo_journal(std::string const & filename, int fd);
+
+    /// @brief Rolls the file back, unless the journal is committed.
+    ///
+    /// If the rollback fails, the journal is kept for recover.
+    ~undo_journal();
+
+    /// @brief Saves the old content of a range of the file.
+    ///
+    /// Only the part within the original size of the file is saved.
+    /// The range must not be written before sync is called.
+    ///
+    /// @throws A runtime_error is thrown on I/O errors.
+    void save(uint64_t offset, uint64_t size);
+
+    /// @brief Syncs the saved ranges to disk.
+    /// @throws A runtime_error is thrown on I/O errors.
+    void sync();
+
+    /// @brief Syncs the file and removes the journal.
+    /// @throws A runtime_error is thrown on I/O errors.
+    void commit();
+
+    /// @brief Rolls back an interrupted modification of a file.
+    /// @return true if a journal was found and the file was restored
+    /// @throws A runtime_error is thrown on I/O errors or if the journal is invalid.
+    static bool recover(std::string const & filename);
+
+    static constexpr char const journal_suffix[] = ".journal";
+
+private:
+    std::string m_filename;
+    int m_fd;
+    file_descriptor m_journal;
+    uint64_t m_original_size;
+    uint64_t m_journal_size;
+    bool m_is_committed;
+};
+
+}
+
+#endif
@@ -0,0 +1,266 @@
+#include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/file_descriptor.hpp"
+#include "aes256gcm/proprietary/undo_journal.hpp"
+#include "aes256gcm/parallel_for.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/rand.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+// writes the rewritten segments of a batch, coalescing adjacent ones;
+// the old segments are saved in the journal first
+void write_changed(
+    int fd,
+    undo_journal & journal,
+    std::vector<char> const & changed,
+    size_t count,
+    char const * segments,
+    std::vector<size_t> const & stored_sizes,
+    uint64_t offset,
+    size_t stored_size)
+{
+    std::vector<std::pair<size_t, size_t>> runs;
+    size_t begin = 0;
+    while (begin < count)
+    {
+        if (!changed[begin])
+        {
+            begin++;
+            continue;
+        }
+
+        size_t end = begin;
+        size_t size = 0;
+        while ((end < count) && (changed[end]))
+        {
+            size += stored_sizes[end];
+            end++;
+        }
+
+        runs.emplace_back(begin, size);
+        begin = end;
+    }
+
+    if (runs.empty())
+    {
+        return;
+    }
+
+    for (auto const & [first, size]: runs)
+    {
+        journal.save(offset + first * stored_size, size);
+    }
+    journal.sync();
+
+    for (auto const & [first, size]: runs)
+    {
+        write_at(fd, &segments[first * stored_size], size, offset + first * stored_size);
+    }
+}
+
+}
+
+int update_encrypted_file(
+    std::string const & plaintext_filename,
+    std::string const & encrypted_filename,
+    std::string const & password,
+    file_options const & options,
+    update_statistics * statistics)
+{
+    undo_journal::recover(encrypted_filename);
+
+    encryption_info info;
+    if (!get_encryption_info(encrypted_filename, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if ((info.is_stream) || (info.segment_size == 0) || (!info.compression.empty()))
+    {
+        std::cerr << "error: only segmented, uncompressed files can be updated" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (info.segment_size > max_segment_size)
+    {
+        std::cerr << "error: invalid segment size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!is_aead_available(info.encryption_method))
+    {
+        std::cerr << "error: unsupported encryption method: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t const segment_size = info.segment_size;
+    size_t const stored_size = segment_size + segment_overhead;
+    uint64_t const payload_size = std::filesystem::file_size(encrypted_filename) - info.size;
+    uint64_t const old_count = stored_segment_count(payload_size, segment_size);
+    if (old_count == 0)
+    {
+        std::cerr << "error: invalid payload size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint64_t const plaintext_size = std::filesystem::file_size(plaintext_filename);
+    uint64_t const new_count = segment_count(plaintext_size, segment_size);
+    if (new_count * segment_digest_size > max_segment_digests_size)
+    {
+        std::cerr << "error: too many segments to store segment digests" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto const key_buffer = derive_secure_key(password, info.kdf);
+    auto const key = key_buffer.view();
+    if (!check_key(key, info))
+    {
+        std::cerr << "error: wrong password" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    file_descriptor plaintext(plaintext_filename, O_RDONLY);
+    file_descriptor encrypted(encrypted_filename, O_RDWR);
+    auto const key_id = context_key_id(key);
+
+    auto const old_plain_size = [&](uint64_t index)
+    {
+        return (index + 1 < old_count) ? segment_size
+            : static_cast<size_t>(payload_size - index * stored_size - segment_overhead);
+    };
+
+    // checks the password using the first segment, as a wrong password
+    // would otherwise re-encrypt every segment using a different key
+    {
+        std::vector<char> stored(stored_size);
+        std::vector<char> plain(segment_size);
+        size_t const size = old_plain_size(0) + segment_overhead;
+        if ((read_at(encrypted.get(), stored.data(), size, 0) != size)
+            || (!decrypt_segment(key, key_id, segment_additional_data(info.additional_data, 0, old_count == 1),
+                    stored.data(), size, plain.data(), info.encryption_method)))
+        {
+            std::cerr << "error: failed to decrypt file" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // without digests, segments are compared to the decrypted old segments
+    bool const has_digests = (info.segment_digests.size() == old_count * segment_digest_size);
+    auto const digest_key = segment_digest_key(key);
+    std::string digests(new_count * segment_digest_size, '\0');
+
+    size_t const batch_size = static_cast<size_t>(
+        std::min<uint64_t>(new_count, std::max(options.threads, 1u) * segments_per_thread));
+    std::vector<char> plain(batch_size * segment_size);
+    std::vector<char> stored(batch_size * stored_size);
+    std::vector<char> old_plain(has_digests ? 0 : batch_size * segment_size);
+    std::vector<char> old_stored(has_digests ? 0 : batch_size * stored_size);
+    std::vector<char> changed(batch_size);
+    std::vector<size_t> stored_sizes(batch_size);
+
+    undo_journal journal(encrypted_filename, encrypted.get());
+    update_statistics stats = {new_count, 0};
+    for (uint64_t first = 0; first < new_count; first += batch_size)
+    {
+        size_t const count = static_cast<size_t>(std::min<uint64_t>(batch_size, new_count - first));
+        uint64_t const offset = first * segment_size;
+        size_t const size = static_cast<size_t>(std::min<uint64_t>(count * segment_size, plaintext_size - offset));
+        if (read_at(plaintext.get(), plain.data(), size, offset) != size)
+        {
+            throw std::runtime_error("failed to read from file");
+        }
+
+        if ((!has_digests) && (first < old_count))
+        {
+            uint64_t const old_end = std::min<uint64_t>(first + count, old_count);
+            size_t const old_size = static_cast<size_t>(
+                (old_end - first - 1) * stored_size + old_plain_size(old_end - 1) + segment_overhead);
+            if (read_at(encrypted.get(), old_stored.data(), old_size, first * stored_size) != old_size)
+            {
+                throw std::runtime_error("failed to read from file");
+            }
+        }
+
+        parallel_for(count, options.threads, [&](size_t i)
+        {
+            uint64_t const index = first + i;
+            size_t const plain_offset = i * segment_size;
+            size_t const plain_size = std::min(segment_size, size - std::min(size, plain_offset));
+            bool const is_last = (index + 1 == new_count);
+            char * digest = &digests[index * segment_digest_size];
+            segment_digest(digest_key.view(), index, &plain[plain_offset], plain_size, digest);
+
+            // segments gaining or losing the last flag are rewritten as well
+            bool is_unchanged = (index < old_count) && (is_last == (index + 1 == old_count))
+                && (plain_size == old_plain_size(index));
+            if (is_unchanged && has_digests)
+            {
+                is_unchanged = (0 == memcmp(digest, &info.segment_digests[index * segment_digest_size], segment_digest_size));
+            }
+            else if (is_unchanged)
+            {
+                is_unchanged = decrypt_segment(key, key_id, segment_additional_data(info.additional_data, index, is_last),
+                        &old_stored[i * stored_size], plain_size + segment_overhead,
+                        &old_plain[plain_offset], info.encryption_method)
+                    && (0 == memcmp(&old_plain[plain_offset], &plain[plain_offset], plain_size));
+            }
+
+            changed[i] = !is_unchanged;
+            stored_sizes[i] = plain_size + segment_overhead;
+            if (changed[i])
+            {
+                // a fresh nonce, as the segment's derived nonce was used for the old plaintext
+                encrypt_segment(key, key_id, rand(nonce_size),
+                    segment_additional_data(info.additional_data, index, is_last),
+                    &plain[plain_offset], plain_size, &stored[i * stored_size], info.encryption_method);
+            }
+        });
+
+        write_changed(encrypted.get(), journal, changed, count, stored.data(), stored_sizes, first * stored_size, stored_size);
+        stats.rewritten_segments += std::count(changed.begin(), changed.begin() + count, 1);
+    }
+
+    uint64_t const new_payload_size = (new_count - 1) * stored_size
+        + (plaintext_size - (new_count - 1) * segment_size) + segment_overhead;
+
+    uint64_t const old_file_size = payload_size + info.size;
+    info.segment_digests = digests;
+    std::vector<char> data;
+    create_encryption_info(data, info);
+    journal.save(new_payload_size, old_file_size - std::min(old_file_size, new_payload_size));
+    journal.sync();
+    write_at(encrypted.get(), data.data(), data.size(), new_payload_size);
+    if (0 != ftruncate(encrypted.get(), static_cast<off_t>(new_payload_size + data.size())))
+    {
+        throw std::runtime_error("failed to resize file");
+    }
+    journal.commit();
+    encrypted.close();
+
+    if (nullptr != statistics)
+    {
+        *statistics = stats;
+    }
+    return EXIT_SUCCESS;
+}
+
+}
@@ -0,0 +1,32 @@
+#ifndef AES256GCM_PROPRIETARY_VERIFY_HPP
+#define AES256GCM_PROPRIETARY_VERIFY_HPP
+
+#include "aes256gcm/proprietary.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace aes256gcm::proprietary
+{
+
+/// @brief Authenticates the payload of an encrypted file without writing anything.
+///
+/// Files with a single AES256-GCM tag are authenticated by a GHASH-only
+/// pass over the ciphertext. Other algorithms and segmented files are
+/// decrypted into scratch buffers, which are discarded.
+///
+/// @param filename path of the encrypted file (not in streaming format)
+/// @param key derived encryption key
+/// @param info encryption info of the file
+/// @param options options (threads, I/O engine, buffer size, pipelining)
+/// @return true, if the payload is authentic, false otherwise
+/// @throws A runtime_error is thrown on I/O errors.
+bool verify_payload(
+    std::string const & filename,
+    std::string_view key,
+    encryption_info const & info,
+    file_options const & options);
+
+}
+
+#endif
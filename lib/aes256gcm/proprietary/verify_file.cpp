@@ -0,0 +1,167 @@
+#include "aes256gcm/proprietary.hpp"
+#include "aes256gcm/proprietary/verify.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/io_engine.hpp"
+#include "aes256gcm/proprietary/transform_file.hpp"
+#include "aes256gcm/proprietary/compressed_file.hpp"
+#include "aes256gcm/parallel_gcm.hpp"
+#include "aes256gcm/decrypter.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/algorithm.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+
+namespace aes256gcm::proprietary
+{
+
+namespace
+{
+
+// verification reads large chunks, so that each thread hashes at least
+// one range of this size per chunk
+constexpr size_t const verify_chunk_size = 4 * 1024 * 1024;
+
+class discard_output: public output_file
+{
+public:
+    void write(char const *, size_t) override { }
+    void close() override { }
+};
+
+class discard_buffer: public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override
+    {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(char const *, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+}
+
+bool verify_payload(
+    std::string const & filename,
+    std::string_view key,
+    encryption_info const & info,
+    file_options const & options)
+{
+    uint64_t const payload_size = std::filesystem::file_size(filename) - info.size;
+    auto authenticated_info = info;
+    authenticated_info.additional_data = compression_additional_data(info.additional_data, info.compression);
+
+    // scrubbing reads the file once from start to end, by default using pread with readahead
+    auto read_options = options;
+    if (read_options.engine == io_engine::automatic)
+    {
+        read_options.engine = io_engine::pread;
+    }
+    read_options.buffer_size = align_to_block(std::max<size_t>(options.buffer_size,
+        std::max(options.threads, 1u) * verify_chunk_size));
+
+    auto in = open_input_file(filename, read_options);
+    discard_output out;
+
+    if (info.segment_size > 0)
+    {
+        if (info.segment_size > max_segment_size)
+        {
+            return false;
+        }
+        return decrypt_segments(*in, out, key, authenticated_info, payload_size, read_options);
+    }
+
+    uint64_t bytes_read = 0;
+    bool is_authentic = false;
+    if (info.encryption_method == algorithm_aes256_gcm)
+    {
+        // GHASH only: the tag covers the ciphertext, so there is no need to decrypt it
+        parallel_gcm gcm(key, info.nonce, authenticated_info.additional_data, options.threads);
+        bytes_read = transform_file(*in, out, payload_size, read_options.buffer_size, 0,
+            [&gcm](char const * in_buffer, size_t size, char *) -> size_t
+            {
+                gcm.authenticate(in_buffer, size);
+                return 0;
+            }, read_options);
+        is_authentic = gcm.verify(info.tag);
+    }
+    else
+    {
+        decrypter dec(key, info.nonce, info.tag, authenticated_info.additional_data, info.encryption_method);
+        bytes_read = transform_file(*in, out, payload_size, read_options.buffer_size, read_options.buffer_size,
+            [&dec](char const * in_buffer, size_t size, char * out_buffer) -> size_t
+            {
+                dec.update(in_buffer, out_buffer, size);
+                return 0;
+            }, read_options);
+        is_authentic = dec.finalize();
+    }
+
+    if (bytes_read != payload_size)
+    {
+        throw std::runtime_error("failed to read from file");
+    }
+
+    return is_authentic;
+}
+
+int verify_file(
+    std::string const & filename,
+    std::string const & password,
+    file_options const & options)
+{
+    encryption_info info;
+    if (!get_encryption_info(filename, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (info.is_stream)
+    {
+        std::ifstream in(filename, std::ios_base::binary);
+        discard_buffer buffer;
+        std::ostream out(&buffer);
+        return decrypt_stream(in, out, password);
+    }
+
+    if (!is_aead_available(info.encryption_method))
+    {
+        std::cerr << "error: unsupported encryption method: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if ((info.segment_size == 0) && is_single_update_aead(info.encryption_method))
+    {
+        std::cerr << "error: encryption method requires segments: " << info.encryption_method << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto const key_buffer = derive_secure_key(password, info.kdf);
+    auto const key = key_buffer.view();
+    if (!check_key(key, info))
+    {
+        std::cerr << "error: wrong password" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!verify_payload(filename, key, info, options))
+    {
+        std::cerr << "error: failed to verify file (file data corrupted or wrong password)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+}
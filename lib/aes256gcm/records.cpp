@@ -0,0 +1,195 @@
+#include "aes256gcm/records.hpp"
+#include "aes256gcm/cipher.hpp"
+#include "aes256gcm/constants.hpp"
+#include "aes256gcm/openssl_error.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+using cipher_context = std::unique_ptr<EVP_CIPHER_CTX, void (*) (EVP_CIPHER_CTX*)>;
+
+cipher_context create_context(std::string const & key, bool encrypt)
+{
+    if (key.size() != key_size)
+    {
+        throw std::logic_error("invalid key size");
+    }
+
+    cipher_context ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if (nullptr == ctx)
+    {
+        throw openssl_error();
+    }
+
+    // the key schedule is computed once; records only set a new nonce
+    int const rc = EVP_CipherInit_ex(ctx.get(), aes256gcm_cipher(), nullptr,
+        reinterpret_cast<unsigned char const*>(key.data()), nullptr, encrypt ? 1 : 0);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    return ctx;
+}
+
+void start_record(EVP_CIPHER_CTX * ctx, char const * nonce, std::string const & additional_data)
+{
+    int rc = EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr,
+        reinterpret_cast<unsigned char const*>(nonce), -1);
+    if (rc != 1)
+    {
+        throw openssl_error();
+    }
+
+    if (!additional_data.empty())
+    {
+        int out_size = 0;
+        rc = EVP_CipherUpdate(ctx, nullptr, &out_size,
+            reinterpret_cast<unsigned char const*>(additional_data.data()),
+            additional_data.size());
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+    }
+}
+
+void update_record(EVP_CIPHER_CTX * ctx, char const * in, char * out, size_t size)
+{
+    for (size_t pos = 0; pos < size; pos += max_update_size)
+    {
+        int const chunk_size = static_cast<int>(std::min(max_update_size, size - pos));
+        int out_size = chunk_size;
+
+        int const rc = EVP_CipherUpdate(ctx,
+            reinterpret_cast<unsigned char*>(&out[pos]), &out_size,
+            reinterpret_cast<unsigned char const*>(&in[pos]), chunk_size);
+        if ((rc != 1) || (out_size != chunk_size))
+        {
+            throw openssl_error();
+        }
+    }
+}
+
+size_t total_size(record const * records, size_t count)
+{
+    size_t result = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        result += records[i].size;
+    }
+    return result;
+}
+
+size_t total_size(sealed_record const * records, size_t count)
+{
+    size_t result = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        result += records[i].size;
+    }
+    return result;
+}
+
+}
+
+sealed_record const * encrypt_records(
+    std::string const & key,
+    record const * records,
+    size_t count,
+    arena & out,
+    std::string const & additional_data)
+{
+    auto ctx = create_context(key, true);
+
+    auto * const sealed = out.allocate_array<sealed_record>(count);
+    char * nonce = out.allocate(count * nonce_size);
+    char * tag = out.allocate(count * tag_size);
+    char * ciphertext = out.allocate(total_size(records, count));
+
+    // one call for all nonces is considerably cheaper than one per record
+    if (count > 0)
+    {
+        int const rc = RAND_bytes(reinterpret_cast<unsigned char*>(nonce), count * nonce_size);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        start_record(ctx.get(), nonce, additional_data);
+        update_record(ctx.get(), records[i].data, ciphertext, records[i].size);
+
+        int out_size = 0;
+        int rc = EVP_EncryptFinal_ex(ctx.get(), nullptr, &out_size);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+
+        rc = EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, tag_size, tag);
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+
+        sealed[i] = {nonce, ciphertext, records[i].size, tag};
+        nonce += nonce_size;
+        tag += tag_size;
+        ciphertext += records[i].size;
+    }
+
+    return sealed;
+}
+
+record const * decrypt_records(
+    std::string const & key,
+    sealed_record const * records,
+    size_t count,
+    arena & out,
+    std::string const & additional_data)
+{
+    auto ctx = create_context(key, false);
+
+    auto * const opened = out.allocate_array<record>(count);
+    char * plaintext = out.allocate(total_size(records, count));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        start_record(ctx.get(), records[i].nonce, additional_data);
+        update_record(ctx.get(), records[i].ciphertext, plaintext, records[i].size);
+
+        int rc = EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, tag_size,
+            const_cast<char*>(records[i].tag));
+        if (rc != 1)
+        {
+            throw openssl_error();
+        }
+
+        int out_size = 0;
+        rc = EVP_DecryptFinal_ex(ctx.get(), nullptr, &out_size);
+        if (rc != 1)
+        {
+            throw std::runtime_error("record " + std::to_string(i) + " failed authentication");
+        }
+
+        opened[i] = {plaintext, records[i].size};
+        plaintext += records[i].size;
+    }
+
+    return opened;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef AES256GCM_SECURE_KDF_HPP
+#define AES256GCM_SECURE_KDF_HPP
+
+#include "aes256gcm/kdf.hpp"
+#include "aes256gcm/secure_pool.hpp"
+
+#include <string>
+
+namespace aes256gcm
+{
+
+/// @brief Derives a key using PBKDF2 (see pbkdf2) into a buffer of key_size bytes.
+void pbkdf2(
+    std::string const & password,
+    std::string const & salt,
+    std::string const & digest,
+    unsigned int iterations,
+    char * key);
+
+/// @brief Derives a key using the given parameters (see derive_key).
+///
+/// The key is derived directly into a key buffer of the secure pool, which
+/// is locked into memory and wiped on release; no other copy is left on
+/// the heap or the stack.
+///
+/// @throws An invalid_argument is thrown on unknown algorithms or invalid parameters.
+///         An openssl_error is thrown on error of underlying OpenSSL function calls.
+secure_buffer derive_secure_key(
+    std::string const & password,
+    kdf_params const & params);
+
+}
+
+#endif
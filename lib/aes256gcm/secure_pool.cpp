@@ -0,0 +1,304 @@
+#include "aes256gcm/secure_pool.hpp"
+
+#include <openssl/crypto.h>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+size_t page_size()
+{
+    static size_t const size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// Rounds up to a multiple of the page size with eight size classes per power
+// of two, so that buffers of similar sizes are reused and at most an eighth
+// of a buffer is wasted.
+size_t size_class(size_t size)
+{
+    size = std::max(size, size_t(1));
+    size_t step = page_size();
+    while (step * 16 <= size)
+    {
+        step *= 2;
+    }
+    return ((size + step - 1) / step) * step;
+}
+
+}
+
+secure_buffer::secure_buffer() noexcept
+: m_pool(nullptr)
+, m_data(nullptr)
+, m_size(0)
+, m_capacity(0)
+, m_locked(false)
+{
+}
+
+secure_buffer::secure_buffer(secure_pool * pool, char * data, size_t size, size_t capacity, bool locked) noexcept
+: m_pool(pool)
+, m_data(data)
+, m_size(size)
+, m_capacity(capacity)
+, m_locked(locked)
+{
+}
+
+secure_buffer::secure_buffer(secure_buffer && other) noexcept
+: m_pool(std::exchange(other.m_pool, nullptr))
+, m_data(std::exchange(other.m_data, nullptr))
+, m_size(std::exchange(other.m_size, 0))
+, m_capacity(std::exchange(other.m_capacity, 0))
+, m_locked(std::exchange(other.m_locked, false))
+{
+}
+
+secure_buffer& secure_buffer::operator=(secure_buffer && other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        m_locked = std::exchange(other.m_locked, false);
+    }
+    return *this;
+}
+
+secure_buffer::~secure_buffer()
+{
+    release();
+}
+
+char * secure_buffer::get() const noexcept
+{
+    return m_data;
+}
+
+size_t secure_buffer::size() const noexcept
+{
+    return m_size;
+}
+
+std::string_view secure_buffer::view() const noexcept
+{
+    return std::string_view(m_data, m_size);
+}
+
+bool secure_buffer::is_locked() const noexcept
+{
+    return m_locked;
+}
+
+void secure_buffer::release() noexcept
+{
+    if (m_data != nullptr)
+    {
+        m_pool->release(m_data, m_size, m_capacity, m_locked);
+        m_data = nullptr;
+    }
+}
+
+scoped_cleanse::scoped_cleanse(std::string & value) noexcept
+: m_value(value)
+{
+}
+
+scoped_cleanse::~scoped_cleanse()
+{
+    OPENSSL_cleanse(m_value.data(), m_value.size());
+}
+
+secure_pool & secure_pool::instance()
+{
+    // never destroyed, so that buffers held by other static objects
+    // can be released at exit
+    static secure_pool * const pool = new secure_pool();
+    return *pool;
+}
+
+size_t secure_pool::memlock_limit()
+{
+    struct rlimit limit;
+    if ((0 != getrlimit(RLIMIT_MEMLOCK, &limit)) || (limit.rlim_cur == RLIM_INFINITY)
+        || (limit.rlim_cur > std::numeric_limits<size_t>::max()))
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+    return static_cast<size_t>(limit.rlim_cur);
+}
+
+secure_pool::secure_pool(size_t max_cached_size, size_t max_locked_size)
+: m_max_cached_size(max_cached_size)
+, m_max_locked_size(max_locked_size)
+, m_cached_size(0)
+, m_locked_size(0)
+, m_lock_failures(0)
+{
+}
+
+secure_pool::~secure_pool()
+{
+    trim();
+}
+
+secure_buffer secure_pool::allocate(size_t size)
+{
+    return allocate(size, false);
+}
+
+secure_buffer secure_pool::allocate_key(size_t size)
+{
+    return allocate(size, true);
+}
+
+secure_buffer secure_pool::allocate(size_t size, bool is_key)
+{
+    size_t const capacity = size_class(size);
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto const it = m_free.find(capacity);
+        if ((it != m_free.end()) && (!it->second.empty()))
+        {
+            auto & blocks = it->second;
+            auto found = std::prev(blocks.end());
+            if (is_key)
+            {
+                // keys prefer a buffer which is locked already
+                auto const locked = std::find_if(blocks.begin(), blocks.end(),
+                    [](block const & b) { return b.locked; });
+                found = (locked != blocks.end()) ? locked : found;
+            }
+            block const b = *found;
+            blocks.erase(found);
+            m_cached_size -= capacity;
+
+            bool const locked = b.locked || (is_key && lock(b.data, capacity, true));
+            return secure_buffer(this, b.data, size, capacity, locked);
+        }
+    }
+
+    void * const address = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    madvise(address, capacity, MADV_DONTDUMP);
+
+    char * const data = reinterpret_cast<char*>(address);
+    bool locked = false;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        locked = lock(data, capacity, is_key);
+    }
+    return secure_buffer(this, data, size, capacity, locked);
+}
+
+void secure_pool::trim() noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const & [capacity, blocks]: m_free)
+    {
+        for (auto const & b: blocks)
+        {
+            unmap(b.data, capacity, b.locked);
+        }
+    }
+    m_free.clear();
+    m_cached_size = 0;
+}
+
+size_t secure_pool::cached_size() const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cached_size;
+}
+
+size_t secure_pool::locked_size() const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_locked_size;
+}
+
+uint64_t secure_pool::lock_failures() const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lock_failures;
+}
+
+// expects the mutex to be held
+bool secure_pool::lock(char * data, size_t capacity, bool is_key) noexcept
+{
+    // I/O buffers must not use up the lockable memory needed for keys;
+    // locking keys is always tried, as privileged processes have no limit
+    size_t const limit = m_max_locked_size - std::min(m_max_locked_size, key_reserve);
+    bool const fits = is_key || ((m_locked_size <= limit) && (capacity <= limit - m_locked_size));
+    if (fits && (0 == mlock(data, capacity)))
+    {
+        m_locked_size += capacity;
+        return true;
+    }
+
+    if (is_key)
+    {
+        if (m_lock_failures++ == 0)
+        {
+            std::cerr << "warning: failed to lock key memory, keys may be swapped to disk"
+                " (see ulimit -l)" << std::endl;
+        }
+    }
+    return false;
+}
+
+// expects the mutex to be held
+void secure_pool::unmap(char * data, size_t capacity, bool locked) noexcept
+{
+    if (locked)
+    {
+        munlock(data, capacity);
+        m_locked_size -= capacity;
+    }
+    munmap(data, capacity);
+}
+
+void secure_pool::release(char * data, size_t size, size_t capacity, bool locked) noexcept
+{
+    // Only the first size bytes were handed out; the rest is still zero,
+    // as memory is wiped whenever it is released.
+    OPENSSL_cleanse(data, size);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_cached_size + capacity <= m_max_cached_size)
+    {
+        try
+        {
+            m_free[capacity].push_back({data, locked});
+            m_cached_size += capacity;
+            return;
+        }
+        catch (...)
+        {
+            // unmapped below
+        }
+    }
+
+    unmap(data, capacity, locked);
+}
+
+}
@@ -0,0 +1,156 @@
+#ifndef AES256GCM_SECURE_POOL_HPP
+#define AES256GCM_SECURE_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace aes256gcm
+{
+
+class secure_pool;
+
+/// @brief Memory of a secure_pool; wiped and returned to the pool on destruction.
+///
+/// The memory is page-aligned and zero-initialized.
+class secure_buffer
+{
+    secure_buffer(secure_buffer const &) = delete;
+    secure_buffer& operator=(secure_buffer const &) = delete;
+public:
+    /// @brief Creates an empty buffer.
+    secure_buffer() noexcept;
+    secure_buffer(secure_buffer && other) noexcept;
+    secure_buffer& operator=(secure_buffer && other) noexcept;
+    ~secure_buffer();
+
+    char * get() const noexcept;
+    size_t size() const noexcept;
+
+    /// @brief Returns the content, e.g. a key, without copying it.
+    std::string_view view() const noexcept;
+
+    /// @brief Returns true, if the memory is locked into memory.
+    bool is_locked() const noexcept;
+
+private:
+    friend class secure_pool;
+    secure_buffer(secure_pool * pool, char * data, size_t size, size_t capacity, bool locked) noexcept;
+    void release() noexcept;
+
+    secure_pool * m_pool;
+    char * m_data;
+    size_t m_size;
+    size_t m_capacity;
+    bool m_locked;
+};
+
+/// @brief Wipes a string holding secret data when leaving the scope.
+///
+/// Derived keys are kept in key buffers (see allocate_key); this guard
+/// is meant for copies in strings, e.g. keys returned by public functions.
+class scoped_cleanse
+{
+    scoped_cleanse(scoped_cleanse const &) = delete;
+    scoped_cleanse& operator=(scoped_cleanse const &) = delete;
+public:
+    explicit scoped_cleanse(std::string & value) noexcept;
+    ~scoped_cleanse();
+
+private:
+    std::string & m_value;
+};
+
+/// @brief Pool of locked pages for key material and I/O buffers.
+///
+/// Pages are mapped, locked into memory (if permitted) and excluded from
+/// core dumps once, when they are first allocated. Released buffers are
+/// wiped and kept for reuse, so that repeated operations, e.g. the files
+/// of a batch, neither map nor lock memory nor take page faults.
+///
+/// Lockable memory is limited (RLIMIT_MEMLOCK), so I/O buffers are only
+/// locked as long as room for key_reserve bytes of keys is left. Keys
+/// are always locked; if that fails, a warning is printed once.
+///
+/// @note Thread-safe.
+class secure_pool
+{
+    secure_pool(secure_pool const &) = delete;
+    secure_pool& operator=(secure_pool const &) = delete;
+public:
+    /// @brief Returns the pool shared by the process.
+    static secure_pool & instance();
+
+    /// @brief Lockable memory kept free for keys.
+    static constexpr size_t const key_reserve = 64 * 1024;
+
+    /// @brief Returns the soft limit of lockable memory of the process.
+    static size_t memlock_limit();
+
+    /// @brief Creates a pool.
+    /// @param max_cached_size maximum number of bytes kept for reuse;
+    ///                        memory released beyond is unmapped
+    /// @param max_locked_size maximum number of bytes locked into memory
+    explicit secure_pool(size_t max_cached_size = 256 * 1024 * 1024,
+        size_t max_locked_size = memlock_limit());
+
+    /// @brief Unmaps all memory kept for reuse.
+    /// @note All buffers of the pool have to be released before.
+    ~secure_pool();
+
+    /// @brief Allocates a buffer of at least one page, e.g. for I/O.
+    ///
+    /// The buffer is locked into memory only if this leaves room for keys.
+    ///
+    /// @throws std::bad_alloc is thrown if memory cannot be mapped.
+    secure_buffer allocate(size_t size);
+
+    /// @brief Allocates a buffer for key material, which is always locked.
+    ///
+    /// Failing to lock is counted (see lock_failures) and reported once.
+    ///
+    /// @throws std::bad_alloc is thrown if memory cannot be mapped.
+    secure_buffer allocate_key(size_t size);
+
+    /// @brief Unmaps all memory kept for reuse.
+    void trim() noexcept;
+
+    /// @brief Returns the number of bytes kept for reuse.
+    size_t cached_size() const noexcept;
+
+    /// @brief Returns the number of bytes locked into memory.
+    size_t locked_size() const noexcept;
+
+    /// @brief Returns the number of key buffers which could not be locked.
+    uint64_t lock_failures() const noexcept;
+
+private:
+    friend class secure_buffer;
+
+    struct block
+    {
+        char * data;
+        bool locked;
+    };
+
+    secure_buffer allocate(size_t size, bool is_key);
+    bool lock(char * data, size_t capacity, bool is_key) noexcept;
+    void unmap(char * data, size_t capacity, bool locked) noexcept;
+    void release(char * data, size_t size, size_t capacity, bool locked) noexcept;
+
+    size_t const m_max_cached_size;
+    size_t const m_max_locked_size;
+    size_t m_cached_size;
+    size_t m_locked_size;
+    uint64_t m_lock_failures;
+    std::unordered_map<size_t, std::vector<block>> m_free;
+    mutable std::mutex m_mutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "aes256gcm/sha256_mb.hpp"
+#include "aes256gcm/sha256_mb_impl.hpp"
+#include "aes256gcm/openssl_error.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+constexpr size_t const block_size = 64;
+constexpr size_t const digest_size = 32;
+
+constexpr uint32_t const initial_state[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// a single lane, used for the HMAC states
+struct scalar_ops
+{
+    using vector = uint32_t;
+
+    static vector set1(uint32_t value) { return value; }
+    static vector add(vector a, vector b) { return a + b; }
+    static vector xor2(vector a, vector b) { return a ^ b; }
+    static vector xor3(vector a, vector b, vector c) { return a ^ b ^ c; }
+    template <int N> static vector shr(vector a) { return a >> N; }
+    template <int N> static vector rotr(vector a) { return (a >> N) | (a << (32 - N)); }
+    static vector choose(vector e, vector f, vector g) { return (e & f) ^ (~e & g); }
+    static vector majority(vector a, vector b, vector c) { return (a & b) ^ (a & c) ^ (b & c); }
+};
+
+uint32_t load_be32(unsigned char const * data)
+{
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+}
+
+void store_be32(uint32_t value, char * data)
+{
+    data[0] = char(value >> 24);
+    data[1] = char(value >> 16);
+    data[2] = char(value >> 8);
+    data[3] = char(value);
+}
+
+void hmac_state(unsigned char const * key, unsigned char pad, uint32_t * state)
+{
+    uint32_t message[16];
+    for (size_t i = 0; i < 16; i++)
+    {
+        unsigned char const word[4] =
+        {
+            static_cast<unsigned char>(key[4 * i] ^ pad),
+            static_cast<unsigned char>(key[4 * i + 1] ^ pad),
+            static_cast<unsigned char>(key[4 * i + 2] ^ pad),
+            static_cast<unsigned char>(key[4 * i + 3] ^ pad)
+        };
+        message[i] = load_be32(word);
+    }
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        state[i] = initial_state[i];
+    }
+    sha256_mb::compress<scalar_ops>(state, message);
+    OPENSSL_cleanse(message, sizeof(message));
+}
+
+}
+
+void pbkdf2_prepare(pbkdf2_lane & lane, std::string const & password, std::string const & salt)
+{
+    // HMAC keys longer than a block are replaced by their digest
+    unsigned char key[block_size] = {};
+    if (password.size() > block_size)
+    {
+        if (1 != EVP_Digest(password.data(), password.size(), key, nullptr, EVP_sha256(), nullptr))
+        {
+            throw openssl_error();
+        }
+    }
+    else
+    {
+        std::copy(password.begin(), password.end(), key);
+    }
+
+    hmac_state(key, 0x36, lane.inner);
+    hmac_state(key, 0x5c, lane.outer);
+
+    // U_1 = HMAC(P, S || INT(1))
+    std::string message = salt;
+    message.append("\x00\x00\x00\x01", 4);
+    unsigned char u[digest_size];
+    unsigned int size = 0;
+    if (nullptr == HMAC(EVP_sha256(), key, block_size, reinterpret_cast<unsigned char const*>(message.data()),
+                        message.size(), u, &size))
+    {
+        OPENSSL_cleanse(key, sizeof(key));
+        throw openssl_error();
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        lane.u[i] = load_be32(&u[4 * i]);
+        lane.t[i] = lane.u[i];
+    }
+    OPENSSL_cleanse(u, sizeof(u));
+}
+
+std::string pbkdf2_finish(pbkdf2_lane & lane)
+{
+    std::string key(digest_size, '\0');
+    for (size_t i = 0; i < 8; i++)
+    {
+        store_be32(lane.t[i], &key[4 * i]);
+    }
+    OPENSSL_cleanse(&lane, sizeof(lane));
+    return key;
+}
+
+}
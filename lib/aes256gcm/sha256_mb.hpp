@@ -0,0 +1,42 @@
+#ifndef AES256GCM_SHA256_MB_HPP
+#define AES256GCM_SHA256_MB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aes256gcm
+{
+
+// PBKDF2-HMAC-SHA256 deriving a single 32 byte block, split into a scalar
+// setup and the iterations U_i = HMAC(P, U_i-1), which are run for many
+// derivations in lockstep (multi-buffer SHA-256). Each iteration costs two
+// SHA-256 compressions per derivation, as U_i-1 fits into a single block.
+
+/// @brief State of a single PBKDF2-HMAC-SHA256 derivation.
+struct pbkdf2_lane
+{
+    uint32_t inner[8];  ///< SHA-256 state after the block K ^ ipad
+    uint32_t outer[8];  ///< SHA-256 state after the block K ^ opad
+    uint32_t u[8];      ///< U_i as big-endian words
+    uint32_t t[8];      ///< U_1 ^ ... ^ U_i as big-endian words
+};
+
+constexpr size_t const avx2_lanes = 8;
+constexpr size_t const avx512_lanes = 16;
+
+/// @brief Computes the HMAC states and U_1.
+void pbkdf2_prepare(pbkdf2_lane & lane, std::string const & password, std::string const & salt);
+
+/// @brief Runs the remaining iterations 2 ... iterations of avx2_lanes lanes using AVX2.
+void pbkdf2_iterate_avx2(pbkdf2_lane * lanes, unsigned int iterations);
+
+/// @brief Runs the remaining iterations 2 ... iterations of avx512_lanes lanes using AVX-512.
+void pbkdf2_iterate_avx512(pbkdf2_lane * lanes, unsigned int iterations);
+
+/// @brief Returns the derived 32 byte key and wipes the lane.
+std::string pbkdf2_finish(pbkdf2_lane & lane);
+
+}
+
+#endif
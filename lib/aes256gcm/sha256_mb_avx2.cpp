@@ -0,0 +1,86 @@
+#include "aes256gcm/sha256_mb.hpp"
+
+// this translation unit is built for AVX2 (see CMakeLists.txt); its code
+// must only be reached if detect_cpu_features() reports AVX2
+#if defined(__x86_64__)
+
+#include "aes256gcm/sha256_mb_impl.hpp"
+
+#include <immintrin.h>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+struct avx2_ops
+{
+    using vector = __m256i;
+
+    static vector set1(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+    static vector add(vector a, vector b) { return _mm256_add_epi32(a, b); }
+    static vector xor2(vector a, vector b) { return _mm256_xor_si256(a, b); }
+    static vector xor3(vector a, vector b, vector c) { return _mm256_xor_si256(_mm256_xor_si256(a, b), c); }
+
+    template <int N>
+    static vector shr(vector a) { return _mm256_srli_epi32(a, N); }
+
+    template <int N>
+    static vector rotr(vector a) { return _mm256_or_si256(_mm256_srli_epi32(a, N), _mm256_slli_epi32(a, 32 - N)); }
+
+    static vector choose(vector e, vector f, vector g)
+    {
+        return _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+    }
+
+    static vector majority(vector a, vector b, vector c)
+    {
+        return _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    }
+
+    static vector gather(pbkdf2_lane const * lanes, uint32_t (pbkdf2_lane::*member)[8], size_t word)
+    {
+        alignas(32) uint32_t values[avx2_lanes];
+        for (size_t lane = 0; lane < avx2_lanes; lane++)
+        {
+            values[lane] = (lanes[lane].*member)[word];
+        }
+        return _mm256_load_si256(reinterpret_cast<vector const*>(values));
+    }
+
+    static void scatter(pbkdf2_lane * lanes, uint32_t (pbkdf2_lane::*member)[8], size_t word, vector value)
+    {
+        alignas(32) uint32_t values[avx2_lanes];
+        _mm256_store_si256(reinterpret_cast<vector*>(values), value);
+        for (size_t lane = 0; lane < avx2_lanes; lane++)
+        {
+            (lanes[lane].*member)[word] = values[lane];
+        }
+    }
+};
+
+}
+
+void pbkdf2_iterate_avx2(pbkdf2_lane * lanes, unsigned int iterations)
+{
+    sha256_mb::iterate<avx2_ops>(lanes, iterations);
+}
+
+}
+
+#else
+
+#include <stdexcept>
+
+namespace aes256gcm
+{
+
+void pbkdf2_iterate_avx2(pbkdf2_lane *, unsigned int)
+{
+    throw std::runtime_error("AVX2 is not supported");
+}
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include "aes256gcm/sha256_mb.hpp"
+
+// this translation unit is built for AVX-512 (see CMakeLists.txt); its code
+// must only be reached if detect_cpu_features() reports AVX-512F
+#if defined(__x86_64__)
+
+#include "aes256gcm/sha256_mb_impl.hpp"
+
+#include <immintrin.h>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+struct avx512_ops
+{
+    using vector = __m512i;
+
+    static vector set1(uint32_t value) { return _mm512_set1_epi32(static_cast<int>(value)); }
+    static vector add(vector a, vector b) { return _mm512_add_epi32(a, b); }
+    static vector xor2(vector a, vector b) { return _mm512_xor_si512(a, b); }
+    static vector xor3(vector a, vector b, vector c) { return _mm512_ternarylogic_epi32(a, b, c, 0x96); }
+
+    template <int N>
+    static vector shr(vector a) { return _mm512_srli_epi32(a, N); }
+
+    template <int N>
+    static vector rotr(vector a) { return _mm512_ror_epi32(a, N); }
+
+    static vector choose(vector e, vector f, vector g) { return _mm512_ternarylogic_epi32(e, f, g, 0xca); }
+    static vector majority(vector a, vector b, vector c) { return _mm512_ternarylogic_epi32(a, b, c, 0xe8); }
+
+    static vector gather(pbkdf2_lane const * lanes, uint32_t (pbkdf2_lane::*member)[8], size_t word)
+    {
+        alignas(64) uint32_t values[avx512_lanes];
+        for (size_t lane = 0; lane < avx512_lanes; lane++)
+        {
+            values[lane] = (lanes[lane].*member)[word];
+        }
+        return _mm512_load_si512(values);
+    }
+
+    static void scatter(pbkdf2_lane * lanes, uint32_t (pbkdf2_lane::*member)[8], size_t word, vector value)
+    {
+        alignas(64) uint32_t values[avx512_lanes];
+        _mm512_store_si512(values, value);
+        for (size_t lane = 0; lane < avx512_lanes; lane++)
+        {
+            (lanes[lane].*member)[word] = values[lane];
+        }
+    }
+};
+
+}
+
+void pbkdf2_iterate_avx512(pbkdf2_lane * lanes, unsigned int iterations)
+{
+    sha256_mb::iterate<avx512_ops>(lanes, iterations);
+}
+
+}
+
+#else
+
+#include <stdexcept>
+
+namespace aes256gcm
+{
+
+void pbkdf2_iterate_avx512(pbkdf2_lane *, unsigned int)
+{
+    throw std::runtime_error("AVX-512 is not supported");
+}
+
+}
+
+#endif
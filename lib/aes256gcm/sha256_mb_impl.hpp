@@ -0,0 +1,156 @@
+#ifndef AES256GCM_SHA256_MB_IMPL_HPP
+#define AES256GCM_SHA256_MB_IMPL_HPP
+
+#include "aes256gcm/sha256_mb.hpp"
+
+#include <openssl/crypto.h>
+
+// Lockstep PBKDF2 iterations over the lanes of a SIMD vector. Included by
+// the translation units compiled for a specific instruction set only; the
+// vector operations are provided by the Ops parameter, which is defined in
+// an anonymous namespace of each of them.
+
+namespace aes256gcm::sha256_mb
+{
+
+constexpr uint32_t const round_constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// padding of a 32 byte message following a 64 byte block: 0x80, zeros and
+// the length of 96 bytes in bits
+constexpr uint32_t const padding_word = 0x80000000;
+constexpr uint32_t const length_word = (64 + 32) * 8;
+
+template <typename Ops>
+void compress(typename Ops::vector * state, typename Ops::vector const * message)
+{
+    using vector = typename Ops::vector;
+
+    vector w[64];
+    for (size_t i = 0; i < 16; i++)
+    {
+        w[i] = message[i];
+    }
+    for (size_t i = 16; i < 64; i++)
+    {
+        vector const s0 = Ops::xor3(
+            Ops::template rotr<7>(w[i - 15]), Ops::template rotr<18>(w[i - 15]), Ops::template shr<3>(w[i - 15]));
+        vector const s1 = Ops::xor3(
+            Ops::template rotr<17>(w[i - 2]), Ops::template rotr<19>(w[i - 2]), Ops::template shr<10>(w[i - 2]));
+        w[i] = Ops::add(Ops::add(w[i - 16], s0), Ops::add(w[i - 7], s1));
+    }
+
+    vector a = state[0];
+    vector b = state[1];
+    vector c = state[2];
+    vector d = state[3];
+    vector e = state[4];
+    vector f = state[5];
+    vector g = state[6];
+    vector h = state[7];
+
+    for (size_t i = 0; i < 64; i++)
+    {
+        vector const s1 = Ops::xor3(
+            Ops::template rotr<6>(e), Ops::template rotr<11>(e), Ops::template rotr<25>(e));
+        vector const t1 = Ops::add(Ops::add(h, s1),
+            Ops::add(Ops::choose(e, f, g), Ops::add(Ops::set1(round_constants[i]), w[i])));
+        vector const s0 = Ops::xor3(
+            Ops::template rotr<2>(a), Ops::template rotr<13>(a), Ops::template rotr<22>(a));
+        vector const t2 = Ops::add(s0, Ops::majority(a, b, c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = Ops::add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = Ops::add(t1, t2);
+    }
+
+    state[0] = Ops::add(state[0], a);
+    state[1] = Ops::add(state[1], b);
+    state[2] = Ops::add(state[2], c);
+    state[3] = Ops::add(state[3], d);
+    state[4] = Ops::add(state[4], e);
+    state[5] = Ops::add(state[5], f);
+    state[6] = Ops::add(state[6], g);
+    state[7] = Ops::add(state[7], h);
+}
+
+template <typename Ops>
+void iterate(pbkdf2_lane * lanes, unsigned int iterations)
+{
+    using vector = typename Ops::vector;
+
+    // transpose lanes into vectors holding the same word of all lanes
+    vector inner[8];
+    vector outer[8];
+    vector u[8];
+    vector t[8];
+    for (size_t i = 0; i < 8; i++)
+    {
+        inner[i] = Ops::gather(lanes, &pbkdf2_lane::inner, i);
+        outer[i] = Ops::gather(lanes, &pbkdf2_lane::outer, i);
+        u[i] = Ops::gather(lanes, &pbkdf2_lane::u, i);
+        t[i] = Ops::gather(lanes, &pbkdf2_lane::t, i);
+    }
+
+    vector message[16];
+    for (size_t i = 8; i < 16; i++)
+    {
+        message[i] = Ops::set1(0);
+    }
+    message[8] = Ops::set1(padding_word);
+    message[15] = Ops::set1(length_word);
+
+    for (unsigned int iteration = 1; iteration < iterations; iteration++)
+    {
+        vector state[8];
+        for (size_t i = 0; i < 8; i++)
+        {
+            state[i] = inner[i];
+            message[i] = u[i];
+        }
+        compress<Ops>(state, message);
+
+        for (size_t i = 0; i < 8; i++)
+        {
+            message[i] = state[i];
+            state[i] = outer[i];
+        }
+        compress<Ops>(state, message);
+
+        for (size_t i = 0; i < 8; i++)
+        {
+            u[i] = state[i];
+            t[i] = Ops::xor2(t[i], state[i]);
+        }
+    }
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        Ops::scatter(lanes, &pbkdf2_lane::u, i, u[i]);
+        Ops::scatter(lanes, &pbkdf2_lane::t, i, t[i]);
+    }
+
+    OPENSSL_cleanse(inner, sizeof(inner));
+    OPENSSL_cleanse(outer, sizeof(outer));
+    OPENSSL_cleanse(u, sizeof(u));
+    OPENSSL_cleanse(t, sizeof(t));
+    OPENSSL_cleanse(message, sizeof(message));
+}
+
+}
+
+#endif
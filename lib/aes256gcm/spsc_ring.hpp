@@ -0,0 +1,67 @@
+#ifndef AES256GCM_SPSC_RING_HPP
+#define AES256GCM_SPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace aes256gcm
+{
+
+/// @brief Bounded lock-free single producer / single consumer queue.
+///
+/// @note push must only be called by one thread and pop by one other thread.
+template <typename T>
+class spsc_ring
+{
+    spsc_ring(spsc_ring const &) = delete;
+    spsc_ring& operator=(spsc_ring const &) = delete;
+public:
+    /// @brief Creates a queue able to hold capacity items.
+    explicit spsc_ring(size_t capacity)
+    : m_items(capacity + 1)
+    , m_head(0)
+    , m_tail(0)
+    {
+    }
+
+    /// @brief Adds an item to the queue.
+    /// @return false, if the queue is full, true otherwise
+    bool try_push(T const & item)
+    {
+        size_t const tail = m_tail.load(std::memory_order_relaxed);
+        size_t const next = (tail + 1) % m_items.size();
+        if (next == m_head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        m_items[tail] = item;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Removes an item from the queue.
+    /// @return false, if the queue is empty, true otherwise
+    bool try_pop(T & item)
+    {
+        size_t const head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = m_items[head];
+        m_head.store((head + 1) % m_items.size(), std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> m_items;
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
+
+}
+
+#endif
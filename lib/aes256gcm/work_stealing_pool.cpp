@@ -0,0 +1,164 @@
+#include "aes256gcm/work_stealing_pool.hpp"
+
+#include <algorithm>
+
+namespace aes256gcm
+{
+
+namespace
+{
+
+// identifies the pool and queue of the current worker thread
+thread_local work_stealing_pool const * current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+}
+
+work_stealing_pool::work_stealing_pool(unsigned int threads)
+: m_next_queue(0)
+, m_queued(0)
+, m_pending(0)
+, m_submitted(0)
+, m_searching(0)
+, m_stop(false)
+{
+    size_t const count = std::max(threads, 1u);
+    for (size_t i = 0; i < count; i++)
+    {
+        m_queues.push_back(std::make_unique<queue>());
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        m_workers.emplace_back([this, i]() { run(i); });
+    }
+}
+
+work_stealing_pool::~work_stealing_pool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_task_available.notify_all();
+
+    for (auto & worker: m_workers)
+    {
+        worker.join();
+    }
+}
+
+void work_stealing_pool::submit(task t)
+{
+    size_t const index = (current_pool == this) ? current_queue
+        : (m_next_queue++ % m_queues.size());
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(t));
+    }
+
+    bool has_searching = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued++;
+        m_pending++;
+        m_submitted++;
+        has_searching = (m_searching > 0);
+    }
+    m_task_available.notify_one();
+    if (has_searching)
+    {
+        m_task_added.notify_all();
+    }
+}
+
+void work_stealing_pool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_all_done.wait(lock, [this]() { return m_pending == 0; });
+}
+
+size_t work_stealing_pool::size() const noexcept
+{
+    return m_workers.size();
+}
+
+void work_stealing_pool::run(size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+
+    while (true)
+    {
+        size_t submitted = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_task_available.wait(lock, [this]() { return m_stop || (m_queued > 0); });
+            if (m_queued == 0)
+            {
+                return;
+            }
+            m_queued--;
+            submitted = m_submitted;
+        }
+
+        // A task is reserved for this worker; find it in own or other queues.
+        // The search only fails if another worker took the task while a new
+        // one was added to a queue searched before, so wait for that one.
+        task t;
+        while (!pop(index, t))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_searching++;
+            m_task_added.wait(lock, [&]() { return m_submitted != submitted; });
+            m_searching--;
+            submitted = m_submitted;
+        }
+
+        t();
+
+        bool all_done = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+            all_done = (m_pending == 0);
+        }
+        if (all_done)
+        {
+            m_all_done.notify_all();
+        }
+    }
+}
+
+bool work_stealing_pool::pop(size_t index, task & t)
+{
+    {
+        auto & own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            t = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_queues.size(); i++)
+    {
+        auto & other = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty())
+        {
+            t = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
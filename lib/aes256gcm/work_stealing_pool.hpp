@@ -0,0 +1,77 @@
+#ifndef AES256GCM_WORK_STEALING_POOL_HPP
+#define AES256GCM_WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aes256gcm
+{
+
+/// @brief Thread pool where idle workers steal tasks from busy ones.
+///
+/// Each worker owns a task queue. Workers take tasks from the front of
+/// their own queue and steal from the front of other queues when their
+/// own queue is empty, so tasks start in the order they are submitted
+/// (e.g. largest first) and a mix of long and short tasks keeps all
+/// workers busy.
+class work_stealing_pool
+{
+    work_stealing_pool(work_stealing_pool const &) = delete;
+    work_stealing_pool& operator=(work_stealing_pool const &) = delete;
+public:
+    using task = std::function<void()>;
+
+    /// @brief Starts the given number of workers (at least one).
+    explicit work_stealing_pool(unsigned int threads);
+
+    /// @brief Waits for all tasks and stops the workers.
+    ~work_stealing_pool();
+
+    /// @brief Adds a task.
+    ///
+    /// Tasks submitted by a worker are added to its own queue, other
+    /// tasks are distributed round robin.
+    ///
+    /// @note Tasks must not throw; exceptions terminate the process.
+    void submit(task t);
+
+    /// @brief Waits until all submitted tasks are done.
+    void wait();
+
+    /// @brief Returns the number of workers.
+    size_t size() const noexcept;
+
+private:
+    struct queue
+    {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    void run(size_t index);
+    bool pop(size_t index, task & t);
+
+    std::vector<std::unique_ptr<queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_next_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_task_available;
+    std::condition_variable m_all_done;
+    std::condition_variable m_task_added;
+    size_t m_queued;
+    size_t m_pending;
+    size_t m_submitted;
+    size_t m_searching;
+    bool m_stop;
+};
+
+}
+
+#endif
@@ -2,16 +2,36 @@
 
 #include <getopt.h>
 
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 #include <string>
 
 using aes256gcm::proprietary::encrypt_file;
 using aes256gcm::proprietary::encrypt_file_inplace;
 using aes256gcm::proprietary::decrypt_file;
 using aes256gcm::proprietary::decrypt_file_inplace;
+using aes256gcm::proprietary::update_encrypted_file;
+using aes256gcm::proprietary::update_statistics;
+using aes256gcm::proprietary::append_encrypted;
+using aes256gcm::proprietary::verify_file;
+using aes256gcm::proprietary::encrypt_stream;
+using aes256gcm::proprietary::decrypt_stream;
 using aes256gcm::proprietary::get_encryption_info;
 using aes256gcm::proprietary::encryption_info;
+using aes256gcm::proprietary::file_options;
+using aes256gcm::proprietary::io_engine;
+using aes256gcm::proprietary::batch_job;
+using aes256gcm::proprietary::batch_operation;
+using aes256gcm::proprietary::scan_directory;
+using aes256gcm::proprietary::read_manifest;
+using aes256gcm::proprietary::scan_encryption_info;
+using aes256gcm::proprietary::metadata_catalog;
 
 namespace
 {
@@ -22,26 +42,157 @@ void print_usage()
 
 usage:
     encrypt <command> -i INFILE [-o OUTFILE] [-k KEY]
+    encrypt <command> --recursive DIR [-o OUTDIR] [-k KEY] [-j N]
+    encrypt <command> --manifest FILE [-k KEY] [-j N]
 
 commands:
     -e, --encrypt encrypt file
     -d, --decrypt decrypt file
     -p, --print   print info of encrypted file
+    --verify      authenticate encrypted file without decrypting it
+                  reads the file once and writes nothing
+    --update      update encrypted file OUTFILE to match INFILE
+                  only changed segments are encrypted and written
+    --append      append INFILE to encrypted file OUTFILE
+                  use -i - to append data read from stdin
+    --cpu-info    print CPU features and the AES256-GCM implementation
 
 Options:
     -i, --infile  FILE specify input file name
+                       use - to read from stdin
     -o, --outfile FILE specify output file name
+                       use - to write to stdout
                        if not specified, file is encrypted / descripted inplace
+                       if either file is -, the streaming format is used:
+                       encryption info in front of individually
+                       authenticated frames of SIZE bytes (see -s)
     -k, --key     KEY  specify encryption key
                        if not specified, empty key is used
+    -s, --segment-size SIZE
+                       encrypt file in segments of SIZE bytes, each
+                       having its own tag (not supported inplace)
+                       if not specified, the file has a single tag
+    -j, --jobs    N    number of threads used to encrypt / decrypt
+                       segmented files or files inplace (default: 1)
+                       in batch mode: number of files processed in parallel
+    --recursive   DIR  encrypt / decrypt / verify / print all files in DIR recursively
+                       results are stored to OUTDIR using the same
+                       relative paths; if -o is not specified, files
+                       are encrypted / decrypted inplace
+    --manifest    FILE encrypt / decrypt / verify / print all files listed in FILE
+                       one file per line, optionally followed by a tab
+                       and the output file name
+                       -p prints one line per file, reading -j files
+                       in parallel
+    --io-engine   NAME I/O engine: auto, iostream, pread, mmap or io_uring
+                       (default: auto)
+    --direct           bypass the page cache (pread and io_uring only)
+    --pipelined        overlap reading, encryption and writing
+    --buffer-size SIZE size of I/O buffers in bytes (default: 102400)
+    --queue-depth N    number of buffers in flight (default: 4)
+    --algorithm   NAME AEAD algorithm used for encryption: auto, aes256-gcm,
+                       chacha20-poly1305, aes256-ocb or aes256-gcm-siv
+                       (default: aes256-gcm); auto selects the fastest
+                       algorithm of the current CPU; aes256-gcm-siv
+                       requires segments (see -s) or the streaming format
+    --kdf         NAME key derivation function: pbkdf2 or argon2id
+                       (default: pbkdf2)
+    --kdf-time    N    Argon2id time cost / passes (default: 3)
+    --kdf-memory  KIB  Argon2id memory cost in KiB (default: 65536)
+    --kdf-lanes   N    Argon2id lanes, derived in parallel
+                       (default: number of cores, at most 16)
+    --kdf-target  MS   use Argon2id with time and memory cost calibrated
+                       to take about MS milliseconds on this host
+    --compress    NAME compress before encryption: zstd, lz4 or zlib
+                       (if available; not supported inplace); compressed
+                       files use 1M segments unless -s is given
+    --compress-level N compression level (default: codec's default):
+                       zstd 1-22, zlib 1-9, lz4 1-12 (1 is LZ4's fast
+                       mode, higher levels use LZ4 HC)
+    --verify-inplace   verify the file before decrypting it inplace,
+                       so it is left unchanged if it is not authentic
+    --segment-digests  store digests of segments, so --update finds
+                       changed segments without decrypting the file
+                       (requires -s, not supported with compression)
+    --catalog     FILE cache the encryption info of files in FILE
+                       -e adds encrypted files, -p and batch mode
+                       read only files changed since they were cataloged
 )";
 }
 
+bool parse_io_engine(std::string const & value, io_engine & result)
+{
+    if (value == "auto")
+    {
+        result = io_engine::automatic;
+    }
+    else if (value == "iostream")
+    {
+        result = io_engine::iostream;
+    }
+    else if (value == "pread")
+    {
+        result = io_engine::pread;
+    }
+    else if (value == "mmap")
+    {
+        result = io_engine::mmap;
+    }
+    else if (value == "io_uring")
+    {
+        result = io_engine::io_uring;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_number(char const * value, unsigned long & result)
+{
+    char * end = nullptr;
+    errno = 0;
+    result = std::strtoul(value, &end, 10);
+    return (errno == 0) && (end != value) && (*end == '\0');
+}
+
+enum long_option
+{
+    opt_io_engine = 0x100,
+    opt_direct,
+    opt_pipelined,
+    opt_buffer_size,
+    opt_queue_depth,
+    opt_recursive,
+    opt_manifest,
+    opt_algorithm,
+    opt_cpu_info,
+    opt_kdf,
+    opt_kdf_time,
+    opt_kdf_memory,
+    opt_kdf_lanes,
+    opt_kdf_target,
+    opt_compress,
+    opt_compress_level,
+    opt_update,
+    opt_append,
+    opt_verify,
+    opt_verify_inplace,
+    opt_segment_digests,
+    opt_catalog
+};
+
 enum class command
 {
     encrypt,
     decrypt,
     print_info,
+    update,
+    append,
+    verify,
+    print_cpu_info,
     print_help
 };
 
@@ -56,6 +207,30 @@ struct context
             {"infile" , required_argument, nullptr, 'i'},
             {"outfile", required_argument, nullptr, 'o'},
             {"key"    , required_argument, nullptr, 'k'},
+            {"segment-size", required_argument, nullptr, 's'},
+            {"jobs"   , required_argument, nullptr, 'j'},
+            {"io-engine", required_argument, nullptr, opt_io_engine},
+            {"direct" , no_argument, nullptr, opt_direct},
+            {"pipelined", no_argument, nullptr, opt_pipelined},
+            {"buffer-size", required_argument, nullptr, opt_buffer_size},
+            {"queue-depth", required_argument, nullptr, opt_queue_depth},
+            {"recursive", required_argument, nullptr, opt_recursive},
+            {"manifest", required_argument, nullptr, opt_manifest},
+            {"algorithm", required_argument, nullptr, opt_algorithm},
+            {"cpu-info", no_argument, nullptr, opt_cpu_info},
+            {"kdf", required_argument, nullptr, opt_kdf},
+            {"kdf-time", required_argument, nullptr, opt_kdf_time},
+            {"kdf-memory", required_argument, nullptr, opt_kdf_memory},
+            {"kdf-lanes", required_argument, nullptr, opt_kdf_lanes},
+            {"kdf-target", required_argument, nullptr, opt_kdf_target},
+            {"compress", required_argument, nullptr, opt_compress},
+            {"compress-level", required_argument, nullptr, opt_compress_level},
+            {"update" , no_argument, nullptr, opt_update},
+            {"append" , no_argument, nullptr, opt_append},
+            {"verify" , no_argument, nullptr, opt_verify},
+            {"verify-inplace", no_argument, nullptr, opt_verify_inplace},
+            {"segment-digests", no_argument, nullptr, opt_segment_digests},
+            {"catalog", required_argument, nullptr, opt_catalog},
             {"help"   , no_argument, nullptr, 'h'},
             {nullptr  , 0, nullptr, 0}
         };
@@ -69,8 +244,9 @@ struct context
         bool done = false;
         while (!done)
         {
+            unsigned long number = 0;
             int idx = 0;
-            int const c = getopt_long(argc, argv, "edpi:o:k:h", long_opts, &idx);
+            int const c = getopt_long(argc, argv, "edpi:o:k:s:j:h", long_opts, &idx);
             switch (c)
             {
                 case -1:
@@ -94,6 +270,167 @@ struct context
                 case 'k':
                     key = optarg;
                     break;
+                case 's':
+                    if (!parse_number(optarg, number))
+                    {
+                        std::cerr << "error: invalid segment size" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.segment_size = number;
+                    break;
+                case 'j':
+                    if ((!parse_number(optarg, number)) || (number == 0))
+                    {
+                        std::cerr << "error: invalid number of jobs" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.threads = number;
+                    break;
+                case opt_io_engine:
+                    if (!parse_io_engine(optarg, options.engine))
+                    {
+                        std::cerr << "error: invalid I/O engine" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    break;
+                case opt_direct:
+                    options.direct_io = true;
+                    break;
+                case opt_pipelined:
+                    options.pipelined = true;
+                    break;
+                case opt_buffer_size:
+                    if ((!parse_number(optarg, number)) || (number == 0))
+                    {
+                        std::cerr << "error: invalid buffer size" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.buffer_size = number;
+                    break;
+                case opt_queue_depth:
+                    if ((!parse_number(optarg, number)) || (number == 0))
+                    {
+                        std::cerr << "error: invalid queue depth" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.queue_depth = number;
+                    break;
+                case opt_recursive:
+                    directory = optarg;
+                    break;
+                case opt_manifest:
+                    manifest = optarg;
+                    break;
+                case opt_catalog:
+                    catalog = optarg;
+                    break;
+                case opt_algorithm:
+                    try
+                    {
+                        options.algorithm = aes256gcm::select_aead(optarg);
+                    }
+                    catch (std::exception const & ex)
+                    {
+                        std::cerr << "error: " << ex.what() << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    break;
+                case opt_kdf:
+                    options.kdf = optarg;
+                    break;
+                case opt_compress:
+                    try
+                    {
+                        options.compression = aes256gcm::select_compression(optarg);
+                    }
+                    catch (std::exception const & ex)
+                    {
+                        std::cerr << "error: " << ex.what() << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    break;
+                case opt_compress_level:
+                    if ((!parse_number(optarg, number)) || (number == 0) || (number > 22))
+                    {
+                        std::cerr << "error: invalid compression level" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.compression_level = static_cast<int>(number);
+                    break;
+                case opt_kdf_time:
+                    if ((!parse_number(optarg, number)) || (number == 0) || (number > UINT32_MAX))
+                    {
+                        std::cerr << "error: invalid kdf time cost" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.kdf_time_cost = number;
+                    break;
+                case opt_kdf_memory:
+                    if ((!parse_number(optarg, number)) || (number == 0) || (number > UINT32_MAX))
+                    {
+                        std::cerr << "error: invalid kdf memory cost" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.kdf_memory_cost = number;
+                    break;
+                case opt_kdf_lanes:
+                    if ((!parse_number(optarg, number)) || (number == 0) || (number > 255))
+                    {
+                        std::cerr << "error: invalid kdf lanes" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    options.kdf_lanes = number;
+                    break;
+                case opt_kdf_target:
+                    if ((!parse_number(optarg, number)) || (number == 0))
+                    {
+                        std::cerr << "error: invalid kdf target" << std::endl;
+                        exit_code = EXIT_FAILURE;
+                        cmd = command::print_help;
+                        done = true;
+                    }
+                    kdf_target = std::chrono::milliseconds(number);
+                    break;
+                case opt_update:
+                    cmd = command::update;
+                    break;
+                case opt_append:
+                    cmd = command::append;
+                    break;
+                case opt_verify:
+                    cmd = command::verify;
+                    break;
+                case opt_verify_inplace:
+                    options.verify_inplace = true;
+                    break;
+                case opt_segment_digests:
+                    options.segment_digests = true;
+                    break;
+                case opt_cpu_info:
+                    cmd = command::print_cpu_info;
+                    break;
                 case 'h':
                     cmd = command::print_help;
                     done = true;
@@ -107,11 +444,60 @@ struct context
             }
         }
 
-        if ((cmd != command::print_help) && (infile.empty())) {
+        bool const is_batch = (!directory.empty()) || (!manifest.empty());
+        if ((is_batch) && (cmd != command::encrypt) && (cmd != command::decrypt) && (cmd != command::verify)
+            && (cmd != command::print_info)) {
+            std::cerr << "error: batch mode requires -e, -d, -p or --verify" << std::endl;
+            exit_code = EXIT_FAILURE;
+            cmd = command::print_help;
+        }
+
+        if ((cmd != command::print_help) && (cmd != command::print_cpu_info) && (!is_batch) && (infile.empty())) {
             std::cerr << "error: missing required option -i" << std::endl;
             exit_code = EXIT_FAILURE;
             cmd = command::print_help;
         }
+
+        if ((infile == "-") && (outfile.empty()) && ((cmd == command::encrypt) || (cmd == command::decrypt))) {
+            std::cerr << "error: reading from stdin requires -o" << std::endl;
+            exit_code = EXIT_FAILURE;
+            cmd = command::print_help;
+        }
+
+        if ((cmd == command::update) && ((outfile.empty()) || (is_batch))) {
+            std::cerr << "error: --update requires -o" << std::endl;
+            exit_code = EXIT_FAILURE;
+            cmd = command::print_help;
+        }
+
+        if ((cmd == command::update) && ((infile == "-") || (outfile == "-"))) {
+            std::cerr << "error: --update requires files" << std::endl;
+            exit_code = EXIT_FAILURE;
+            cmd = command::print_help;
+        }
+
+        if ((cmd == command::append) && ((outfile.empty()) || (outfile == "-") || (is_batch))) {
+            std::cerr << "error: --append requires -o FILE" << std::endl;
+            exit_code = EXIT_FAILURE;
+            cmd = command::print_help;
+        }
+
+        if ((infile == "-") && ((cmd == command::print_info) || (cmd == command::verify))) {
+            std::cerr << "error: -p and --verify require a file" << std::endl;
+            exit_code = EXIT_FAILURE;
+            cmd = command::print_help;
+        }
+
+        if (!options.compression.empty()) {
+            try {
+                aes256gcm::check_compression_level(options.compression, options.compression_level);
+            }
+            catch (std::exception const & ex) {
+                std::cerr << "error: " << ex.what() << std::endl;
+                exit_code = EXIT_FAILURE;
+                cmd = command::print_help;
+            }
+        }
     }
 
     command cmd;
@@ -119,34 +505,181 @@ struct context
     std::string infile;
     std::string outfile;
     std::string key;
+    std::string directory;
+    std::string manifest;
+    std::string catalog;
+    std::chrono::milliseconds kdf_target = std::chrono::milliseconds(0);
+    file_options options;
 };
 
+void calibrate_kdf(context & ctx)
+{
+    auto & options = ctx.options;
+    options.kdf = aes256gcm::kdf_argon2id;
+    options.kdf_lanes = aes256gcm::generate_kdf_params(options.kdf, 0, 0, options.kdf_lanes).lanes;
+
+    auto const cost = aes256gcm::calibrate_argon2id(ctx.kdf_target, options.kdf_lanes);
+    options.kdf_time_cost = cost.time_cost;
+    options.kdf_memory_cost = cost.memory_cost;
+
+    std::cerr << "Argon2id calibrated: time cost " << cost.time_cost << ", memory cost "
+        << cost.memory_cost << " KiB, lanes " << options.kdf_lanes << std::endl;
+}
+
+bool is_stdio(std::string const & filename)
+{
+    return (filename == "-");
+}
+
 void encrypt(
     std::string const & input_file,
     std::string const & output_file,
-    std::string const & key)
+    std::string const & key,
+    file_options const & options)
 {
+    if ((is_stdio(input_file)) || (is_stdio(output_file)))
+    {
+        std::ifstream in_file;
+        std::ofstream out_file;
+        if (!is_stdio(input_file))
+        {
+            in_file.open(input_file, std::ios_base::binary);
+            if (!in_file.is_open())
+            {
+                throw std::runtime_error("failed to open file: " + input_file);
+            }
+        }
+        if (!is_stdio(output_file))
+        {
+            out_file.open(output_file, std::ios_base::binary | std::ios_base::trunc);
+            if (!out_file.is_open())
+            {
+                throw std::runtime_error("failed to open file: " + output_file);
+            }
+        }
+
+        encrypt_stream(is_stdio(input_file) ? std::cin : in_file,
+            is_stdio(output_file) ? std::cout : out_file, key, "", options);
+        return;
+    }
+
     if (output_file.empty())
     {
-        encrypt_file_inplace(input_file, key);
+        encrypt_file_inplace(input_file, key, "", options);
     }
     else
     {
-        encrypt_file(input_file, output_file, key);
+        encrypt_file(input_file, output_file, key, "", options);
     }
 }
 
 int decrypt(
     std::string const & input_file,
     std::string const & output_file,
-    std::string const & key)
+    std::string const & key,
+    file_options const & options)
 {
+    if (is_stdio(output_file))
+    {
+        if (is_stdio(input_file))
+        {
+            return decrypt_stream(std::cin, std::cout, key);
+        }
+
+        std::ifstream in(input_file, std::ios_base::binary);
+        if (!in.is_open())
+        {
+            throw std::runtime_error("failed to open file: " + input_file);
+        }
+        return decrypt_stream(in, std::cout, key);
+    }
+
+    if (is_stdio(input_file))
+    {
+        std::ofstream out(output_file, std::ios_base::binary | std::ios_base::trunc);
+        if (!out.is_open())
+        {
+            throw std::runtime_error("failed to open file: " + output_file);
+        }
+        return decrypt_stream(std::cin, out, key);
+    }
+
     if (output_file.empty())
     {
-        return decrypt_file_inplace(input_file, key);
+        return decrypt_file_inplace(input_file, key, options);
     }
 
-    return decrypt_file(input_file, output_file, key);
+    return decrypt_file(input_file, output_file, key, options);
+}
+
+int update(
+    std::string const & input_file,
+    std::string const & output_file,
+    std::string const & key,
+    file_options const & options)
+{
+    update_statistics statistics = {};
+    auto const result = update_encrypted_file(input_file, output_file, key, options, &statistics);
+    if (result == EXIT_SUCCESS)
+    {
+        std::cout << "updated " << statistics.rewritten_segments << " of " << statistics.segments << " segments" << std::endl;
+    }
+    return result;
+}
+
+int append(
+    std::string const & input_file,
+    std::string const & output_file,
+    std::string const & key,
+    file_options const & options)
+{
+    if (is_stdio(input_file))
+    {
+        return append_encrypted(output_file, std::cin, key, options);
+    }
+
+    std::ifstream in(input_file, std::ios_base::binary);
+    if (!in.is_open())
+    {
+        throw std::runtime_error("failed to open file: " + input_file);
+    }
+    return append_encrypted(output_file, in, key, options);
+}
+
+std::vector<batch_job> batch_jobs(context const & ctx)
+{
+    std::vector<batch_job> jobs;
+    if (!ctx.directory.empty())
+    {
+        jobs = scan_directory(ctx.directory, ctx.outfile);
+    }
+    if (!ctx.manifest.empty())
+    {
+        auto const manifest_jobs = read_manifest(ctx.manifest);
+        jobs.insert(jobs.end(), manifest_jobs.begin(), manifest_jobs.end());
+    }
+    return jobs;
+}
+
+int run_batch(context const & ctx)
+{
+    auto const jobs = batch_jobs(ctx);
+
+    // parallelism is spent on files rather than within files
+    file_options options = ctx.options;
+    options.threads = 1;
+
+    auto const operation = (ctx.cmd == command::encrypt) ? batch_operation::encrypt
+        : (ctx.cmd == command::verify) ? batch_operation::verify : batch_operation::decrypt;
+    auto const failures = aes256gcm::proprietary::run_batch(operation, jobs, ctx.key, ctx.options.threads, options);
+
+    std::cout << "processed " << jobs.size() << " files, " << failures.size() << " failed" << std::endl;
+    for (auto const & failure: failures)
+    {
+        std::cerr << "error: " << failure.filename << ": " << failure.message << std::endl;
+    }
+
+    return failures.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 void print_hex(std::string const & caption, std::string const & value)
@@ -159,10 +692,20 @@ void print_hex(std::string const & caption, std::string const & value)
     std::cout << std::endl;
 }
 
-int print_info(std::string const & filename)
+int print_info(std::string const & filename, metadata_catalog * catalog)
 {
     encryption_info info;
-    if (!get_encryption_info(filename, info))
+    if (nullptr != catalog)
+    {
+        auto const error = catalog->lookup(filename, info);
+        if (nullptr != error)
+        {
+            std::cerr << "error: " << error << std::endl;
+            std::cerr << "error: missing encryption info" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    else if (!get_encryption_info(filename, info))
     {
         std::cerr << "error: missing encryption info" << std::endl;
         return EXIT_FAILURE;
@@ -172,13 +715,92 @@ int print_info(std::string const & filename)
     std::cout << "Key Derivation Function:" << std::endl;
     std::cout << "    Algorithm: " << info.kdf.algorithm << std::endl;
     print_hex(   "    Salt: ", info.kdf.salt);
-    std::cout << "    Digest: " << info.kdf.digest << std::endl;
-    std::cout << "    Iterations: " << std::dec << info.kdf.iterations << std::endl;
+    if (info.kdf.algorithm == aes256gcm::kdf_argon2id)
+    {
+        std::cout << "    Time Cost: " << std::dec << info.kdf.iterations << std::endl;
+        std::cout << "    Memory Cost: " << std::dec << info.kdf.memory_cost << " KiB" << std::endl;
+        std::cout << "    Lanes: " << std::dec << info.kdf.lanes << std::endl;
+    }
+    else
+    {
+        std::cout << "    Digest: " << info.kdf.digest << std::endl;
+        std::cout << "    Iterations: " << std::dec << info.kdf.iterations << std::endl;
+    }
     std::cout << "Encryption Settings:" << std::endl;
     std::cout << "    Encryption Method: " << info.encryption_method << std::endl;
     print_hex("    Nonce: ", info.nonce);
     print_hex("    Tag: ", info.tag);
     print_hex("    Additional Data: ", info.additional_data);
+    if (!info.key_check.empty())
+    {
+        print_hex("    Key Check: ", info.key_check);
+    }
+    if (info.is_stream)
+    {
+        std::cout << "    Format: stream" << std::endl;
+    }
+    if (info.segment_size > 0)
+    {
+        std::cout << "    Segment Size: " << std::dec << info.segment_size << std::endl;
+    }
+    if (!info.compression.empty())
+    {
+        std::cout << "    Compression: " << info.compression << " (level " << std::dec << info.compression_level << ")" << std::endl;
+    }
+    if (!info.segment_digests.empty())
+    {
+        std::cout << "    Segment Digests: " << std::dec << (info.segment_digests.size() / 16) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int print_batch_info(context const & ctx)
+{
+    std::vector<std::string> filenames;
+    for (auto const & job: batch_jobs(ctx))
+    {
+        filenames.push_back(job.input_filename);
+    }
+
+    size_t failures = 0;
+    for (auto const & entry: scan_encryption_info(filenames, ctx.options.threads, ctx.options.catalog))
+    {
+        if (!entry.error.empty())
+        {
+            std::cerr << "error: " << entry.filename << ": " << entry.error << std::endl;
+            failures++;
+            continue;
+        }
+
+        auto const & info = entry.info;
+        std::cout << entry.filename << '\t' << info.encryption_method << '\t' << info.kdf.algorithm
+            << '\t' << (info.is_stream ? "stream" : (info.segment_size > 0) ? "segmented" : "single tag")
+            << '\t' << std::dec << info.segment_size
+            << '\t' << (info.compression.empty() ? "-" : info.compression) << std::endl;
+    }
+
+    std::cout << "scanned " << filenames.size() << " files, " << failures << " failed" << std::endl;
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int print_cpu_info()
+{
+    auto const & features = aes256gcm::detect_cpu_features();
+    auto const print_feature = [](char const * name, bool value)
+    {
+        std::cout << "    " << name << ": " << (value ? "yes" : "no") << std::endl;
+    };
+
+    std::cout << "CPU Features:" << std::endl;
+    print_feature("AES-NI", features.aes);
+    print_feature("PCLMULQDQ", features.pclmulqdq);
+    print_feature("AVX2", features.avx2);
+    print_feature("AVX-512F", features.avx512f);
+    print_feature("AVX-512BW", features.avx512bw);
+    print_feature("VAES", features.vaes);
+    print_feature("VPCLMULQDQ", features.vpclmulqdq);
+    std::cout << "AES256-GCM Implementation: " << aes256gcm::gcm_implementation() << std::endl;
 
     return EXIT_SUCCESS;
 }
@@ -187,20 +809,66 @@ int print_info(std::string const & filename)
 
 int main(int argc, char* argv[])
 {
+    // std::cin / std::cout are used for streaming, not mixed with stdio
+    std::ios_base::sync_with_stdio(false);
+
     context ctx(argc, argv);
 
     try
     {
+        std::unique_ptr<metadata_catalog> catalog;
+        if (!ctx.catalog.empty())
+        {
+            catalog = std::make_unique<metadata_catalog>(ctx.catalog);
+            ctx.options.catalog = catalog.get();
+        }
+
         switch (ctx.cmd)
         {
             case command::encrypt:
-                encrypt(ctx.infile, ctx.outfile, ctx.key);
+                if (ctx.kdf_target.count() > 0)
+                {
+                    calibrate_kdf(ctx);
+                }
+                if ((!ctx.directory.empty()) || (!ctx.manifest.empty()))
+                {
+                    ctx.exit_code = run_batch(ctx);
+                    break;
+                }
+                encrypt(ctx.infile, ctx.outfile, ctx.key, ctx.options);
                 break;
             case command::decrypt:
-                ctx.exit_code = decrypt(ctx.infile, ctx.outfile, ctx.key);
+                if ((!ctx.directory.empty()) || (!ctx.manifest.empty()))
+                {
+                    ctx.exit_code = run_batch(ctx);
+                    break;
+                }
+                ctx.exit_code = decrypt(ctx.infile, ctx.outfile, ctx.key, ctx.options);
                 break;
             case command::print_info:
-                ctx.exit_code = print_info(ctx.infile);
+                if ((!ctx.directory.empty()) || (!ctx.manifest.empty()))
+                {
+                    ctx.exit_code = print_batch_info(ctx);
+                    break;
+                }
+                ctx.exit_code = print_info(ctx.infile, ctx.options.catalog);
+                break;
+            case command::update:
+                ctx.exit_code = update(ctx.infile, ctx.outfile, ctx.key, ctx.options);
+                break;
+            case command::verify:
+                if ((!ctx.directory.empty()) || (!ctx.manifest.empty()))
+                {
+                    ctx.exit_code = run_batch(ctx);
+                    break;
+                }
+                ctx.exit_code = verify_file(ctx.infile, ctx.key, ctx.options);
+                break;
+            case command::append:
+                ctx.exit_code = append(ctx.infile, ctx.outfile, ctx.key, ctx.options);
+                break;
+            case command::print_cpu_info:
+                ctx.exit_code = print_cpu_info();
                 break;
             case command::print_help:
                 // fall-through
@@ -208,6 +876,11 @@ int main(int argc, char* argv[])
                 print_usage();
                 break;
         }
+
+        if (catalog)
+        {
+            catalog->save();
+        }
     }
     catch (std::exception const & ex)
     {
@@ -0,0 +1,205 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/undo_journal.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+namespace
+{
+
+using aes256gcm::test::generate_data;
+
+constexpr size_t const segment_size = 4096;
+constexpr size_t const stored_size = segment_size + aes256gcm::proprietary::segment_overhead;
+
+class append_test: public aes256gcm::test::file_test
+{
+protected:
+    void encrypt(std::string const & plaintext, bool segment_digests = false)
+    {
+        write("plain", plaintext);
+        aes256gcm::proprietary::file_options options;
+        options.segment_size = segment_size;
+        options.segment_digests = segment_digests;
+        aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+    }
+
+    int decrypt()
+    {
+        return aes256gcm::proprietary::decrypt_file(path("enc"), path("dec"), "secret");
+    }
+
+};
+
+// stream buffer providing data, then failing like a broken pipe
+class failing_buffer: public std::streambuf
+{
+public:
+    explicit failing_buffer(std::string data)
+    : m_data(std::move(data))
+    {
+        setg(m_data.data(), m_data.data(), m_data.data() + m_data.size());
+    }
+
+protected:
+    int_type underflow() override
+    {
+        throw std::runtime_error("broken pipe");
+    }
+
+private:
+    std::string m_data;
+};
+
+}
+
+TEST_F(append_test, appends_data)
+{
+    for (size_t const size: {size_t(0), size_t(1), segment_size, segment_size * 3 + 5})
+    {
+        for (size_t const append_size: {size_t(1), size_t(100), segment_size - 1, segment_size, segment_size * 40 + 3})
+        {
+            for (unsigned int const threads: {1, 3})
+            {
+                auto plaintext = generate_data(size);
+                encrypt(plaintext);
+
+                auto const data = generate_data(append_size, 7);
+                aes256gcm::proprietary::file_options options;
+                options.threads = threads;
+                ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::append_encrypted(path("enc"), data, "secret", options));
+
+                plaintext += data;
+                ASSERT_EQ(EXIT_SUCCESS, decrypt()) << "size: " << size << ", append size: " << append_size;
+                ASSERT_EQ(plaintext, read("dec"));
+            }
+        }
+    }
+}
+
+TEST_F(append_test, keeps_existing_segments)
+{
+    auto plaintext = generate_data(segment_size * 10 + 17);
+    encrypt(plaintext);
+    auto const before = read("enc");
+
+    std::istringstream in(generate_data(segment_size * 2, 7));
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::append_encrypted(path("enc"), in, "secret"));
+
+    // all but the former last segment are left as they are
+    auto const after = read("enc");
+    ASSERT_EQ(before.substr(0, 10 * stored_size), after.substr(0, 10 * stored_size));
+    ASSERT_EQ(12 * stored_size + 17 + aes256gcm::proprietary::segment_overhead,
+        after.size() - (before.size() - (10 * stored_size + 17 + aes256gcm::proprietary::segment_overhead)));
+
+    // appending nothing does not change the file
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::append_encrypted(path("enc"), "", "secret"));
+    ASSERT_EQ(after, read("enc"));
+}
+
+TEST_F(append_test, updates_segment_digests)
+{
+    auto plaintext = generate_data(segment_size * 2 + 5);
+    encrypt(plaintext, true);
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::append_encrypted(path("enc"), generate_data(segment_size, 7), "secret"));
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), info));
+    ASSERT_EQ(4 * aes256gcm::proprietary::segment_digest_size, info.segment_digests.size());
+
+    // the digests match, so an update of the same plaintext does not write any segment
+    plaintext += generate_data(segment_size, 7);
+    write("plain", plaintext);
+    aes256gcm::proprietary::update_statistics statistics = {};
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::update_encrypted_file(path("plain"), path("enc"), "secret", {}, &statistics));
+    ASSERT_EQ(0u, statistics.rewritten_segments);
+}
+
+TEST_F(append_test, detects_truncation_and_reordering)
+{
+    encrypt(generate_data(segment_size * 2));
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::append_encrypted(path("enc"), generate_data(segment_size * 2, 7), "secret"));
+    auto const encrypted = read("enc");
+    size_t const info_size = encrypted.size() - 4 * stored_size;
+
+    // the former last segment is no longer marked as last
+    write("enc", encrypted.substr(0, 2 * stored_size) + encrypted.substr(4 * stored_size));
+    ASSERT_EQ(EXIT_FAILURE, decrypt());
+
+    write("enc", encrypted.substr(0, stored_size) + encrypted.substr(2 * stored_size, stored_size)
+        + encrypted.substr(stored_size, stored_size) + encrypted.substr(3 * stored_size));
+    ASSERT_EQ(EXIT_FAILURE, decrypt());
+
+    ASSERT_EQ(4 * stored_size + info_size, encrypted.size());
+    write("enc", encrypted);
+    ASSERT_EQ(EXIT_SUCCESS, decrypt());
+}
+
+TEST_F(append_test, fails_on_wrong_password_and_unsupported_files)
+{
+    encrypt(generate_data(100));
+    auto const before = read("enc");
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::append_encrypted(path("enc"), "data", "wrong"));
+    ASSERT_EQ(before, read("enc"));
+
+    write("plain", generate_data(100));
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::append_encrypted(path("enc"), "data", "secret"));
+}
+
+TEST_F(append_test, rolls_back_failed_append)
+{
+    auto const plaintext = generate_data(segment_size * 3 + 5);
+    encrypt(plaintext, true);
+    auto const before = read("enc");
+
+    // the first batch is written before reading the input fails
+    failing_buffer buffer(generate_data(segment_size * 9, 7));
+    std::istream in(&buffer);
+    aes256gcm::proprietary::file_options options;
+    options.threads = 1;
+    ASSERT_THROW(aes256gcm::proprietary::append_encrypted(path("enc"), in, "secret", options), std::runtime_error);
+
+    ASSERT_EQ(before, read("enc"));
+    ASSERT_FALSE(std::filesystem::exists(path("enc") + aes256gcm::proprietary::undo_journal::journal_suffix));
+}
+
+TEST_F(append_test, recovers_interrupted_append)
+{
+    auto const plaintext = generate_data(segment_size * 3 + 5);
+    encrypt(plaintext);
+    auto const before = read("enc");
+    size_t const tail = 3 * stored_size;
+
+    // the child is killed after overwriting the tail, leaving the journal behind
+    pid_t const pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0)
+    {
+        int const fd = open(path("enc").c_str(), O_RDWR);
+        auto * journal = new aes256gcm::proprietary::undo_journal(path("enc"), fd);
+        journal->save(tail, before.size() - tail);
+        journal->sync();
+        auto const garbage = generate_data(segment_size * 2, 7);
+        aes256gcm::proprietary::write_at(fd, garbage.data(), garbage.size(), tail);
+        _exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_NE(before, read("enc"));
+
+    // appending rolls the file back first
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::append_encrypted(path("enc"), "more", "secret"));
+    ASSERT_EQ(EXIT_SUCCESS, decrypt());
+    ASSERT_EQ(plaintext + "more", read("dec"));
+    ASSERT_FALSE(aes256gcm::proprietary::recover_encrypted_file(path("enc")));
+}
@@ -0,0 +1,144 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "aes256gcm/work_stealing_pool.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+
+namespace
+{
+
+class batch_test: public aes256gcm::test::file_test
+{
+protected:
+    void SetUp() override
+    {
+        std::filesystem::create_directories(m_dir.path() / "plain" / "sub");
+    }
+
+};
+
+}
+
+TEST(work_stealing_pool, runs_all_tasks)
+{
+    std::atomic<size_t> count(0);
+    {
+        aes256gcm::work_stealing_pool pool(4);
+        for (size_t i = 0; i < 1000; i++)
+        {
+            pool.submit([&]()
+            {
+                count++;
+            });
+        }
+        pool.wait();
+        ASSERT_EQ(1000, count);
+    }
+}
+
+TEST(work_stealing_pool, runs_tasks_submitted_by_tasks)
+{
+    std::atomic<size_t> count(0);
+    aes256gcm::work_stealing_pool pool(3);
+    for (size_t i = 0; i < 10; i++)
+    {
+        pool.submit([&]()
+        {
+            for (size_t j = 0; j < 10; j++)
+            {
+                pool.submit([&]() { count++; });
+            }
+        });
+    }
+    pool.wait();
+    ASSERT_EQ(100, count);
+}
+
+TEST(work_stealing_pool, runs_tasks_in_submission_order)
+{
+    std::vector<size_t> order;
+    std::mutex mutex;
+    aes256gcm::work_stealing_pool pool(1);
+    for (size_t i = 0; i < 100; i++)
+    {
+        pool.submit([&, i]()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(i);
+        });
+    }
+    pool.wait();
+    ASSERT_EQ(100, order.size());
+    ASSERT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST_F(batch_test, encrypts_and_decrypts_directory)
+{
+    write("plain/a", "first");
+    write("plain/sub/b", std::string(100 * 1024, 'b'));
+    write("plain/sub/c", "");
+
+    auto const jobs = aes256gcm::proprietary::scan_directory(path("plain"), path("enc"));
+    ASSERT_EQ(3, jobs.size());
+
+    auto failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::encrypt, jobs, "secret", 2);
+    ASSERT_TRUE(failures.empty());
+
+    auto const dec_jobs = aes256gcm::proprietary::scan_directory(path("enc"), path("dec"));
+    failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::decrypt, dec_jobs, "secret", 2);
+    ASSERT_TRUE(failures.empty());
+
+    ASSERT_EQ("first", read("dec/a"));
+    ASSERT_EQ(std::string(100 * 1024, 'b'), read("dec/sub/b"));
+    ASSERT_EQ("", read("dec/sub/c"));
+}
+
+TEST_F(batch_test, decrypts_more_files_than_key_cache_holds)
+{
+    for (int i = 0; i < 40; i++)
+    {
+        write("plain/" + std::to_string(i), std::string(i, 'x'));
+    }
+
+    auto failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::encrypt,
+        aes256gcm::proprietary::scan_directory(path("plain"), path("enc")), "secret", 2);
+    ASSERT_TRUE(failures.empty());
+
+    failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::decrypt,
+        aes256gcm::proprietary::scan_directory(path("enc"), path("dec")), "secret", 2);
+    ASSERT_TRUE(failures.empty());
+    for (int i = 0; i < 40; i++)
+    {
+        ASSERT_EQ(std::string(i, 'x'), read("dec/" + std::to_string(i)));
+    }
+
+    failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::decrypt,
+        aes256gcm::proprietary::scan_directory(path("enc"), path("wrong")), "wrong", 2);
+    ASSERT_EQ(40, failures.size());
+}
+
+TEST_F(batch_test, reports_failures_without_aborting)
+{
+    write("plain/a", "first");
+    write("plain/b", "second");
+    write("manifest", path("plain/a") + "\t" + path("a.enc") + "\n"
+        + path("missing") + "\t" + path("missing.enc") + "\n"
+        + path("plain/b") + "\n");
+
+    auto const jobs = aes256gcm::proprietary::read_manifest(path("manifest"));
+    ASSERT_EQ(3, jobs.size());
+    ASSERT_TRUE(jobs[2].output_filename.empty());
+
+    auto const failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::encrypt, jobs, "secret", 2);
+    ASSERT_EQ(1, failures.size());
+    ASSERT_EQ(path("missing"), failures[0].filename);
+
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(path("a.enc"), path("a.dec"), "secret"));
+    ASSERT_EQ("first", read("a.dec"));
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file_inplace(path("plain/b"), "secret"));
+    ASSERT_EQ("second", read("plain/b"));
+}
@@ -0,0 +1,243 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/compressed_file.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace
+{
+
+using aes256gcm::test::generate_data;
+
+std::string generate_text(size_t size)
+{
+    std::mt19937 rng(42);
+    std::string data;
+    while (data.size() < size)
+    {
+        data += "2024-01-01T00:00:00Z,sensor-" + std::to_string(rng() % 16) + ",value=" + std::to_string(rng() % 1000) + "\n";
+    }
+    data.resize(size);
+    return data;
+}
+
+class memory_input: public aes256gcm::proprietary::input_file
+{
+public:
+    explicit memory_input(std::string const & data): m_data(data), m_offset(0) { }
+
+    size_t read(char * buffer, size_t size) override
+    {
+        size_t const chunk = std::min(size, m_data.size() - m_offset);
+        memcpy(buffer, &m_data[m_offset], chunk);
+        m_offset += chunk;
+        return chunk;
+    }
+
+private:
+    std::string m_data;
+    size_t m_offset;
+};
+
+class memory_output: public aes256gcm::proprietary::output_file
+{
+public:
+    explicit memory_output(std::string & data): m_data(data) { }
+
+    void write(char const * data, size_t size) override
+    {
+        m_data.append(data, size);
+    }
+
+    void close() override { }
+
+private:
+    std::string & m_data;
+};
+
+using compression_test = aes256gcm::test::file_test;
+
+}
+
+TEST_F(compression_test, encrypt_and_decrypt)
+{
+    for (auto const & codec: aes256gcm::compression_codecs())
+    {
+        if (!aes256gcm::is_compression_available(codec))
+        {
+            continue;
+        }
+
+        for (size_t const size: {0, 1, 1024 * 1024, 3 * 1024 * 1024 + 17})
+        {
+            for (bool const is_text: {true, false})
+            {
+                auto const plaintext = is_text ? generate_text(size) : generate_data(size);
+                write("plain", plaintext);
+
+                for (size_t const segment_size: {0, 64 * 1024})
+                {
+                    aes256gcm::proprietary::file_options options;
+                    options.compression = codec;
+                    options.segment_size = segment_size;
+                    options.threads = 3;
+                    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+                    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(path("enc"), path("dec"), "secret"))
+                        << codec << ", size: " << size << ", segment size: " << segment_size;
+                    ASSERT_EQ(plaintext, read("dec"));
+
+                    // only authenticated segments are decompressed
+                    aes256gcm::proprietary::encryption_info info;
+                    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), info));
+                    ASSERT_NE(0u, info.segment_size);
+
+                    if (is_text && (size >= 1024 * 1024))
+                    {
+                        ASSERT_LT(std::filesystem::file_size(path("enc")), size / 2);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(compression_test, stores_incompressible_blocks)
+{
+    if (!aes256gcm::is_compression_available(aes256gcm::compression_zlib))
+    {
+        GTEST_SKIP() << "zlib not available";
+    }
+
+    size_t const size = 2 * aes256gcm::proprietary::compression_block_size + 100;
+    write("plain", generate_data(size));
+
+    aes256gcm::proprietary::file_options options;
+    options.compression = "zlib";
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "", options);
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), info));
+    ASSERT_EQ(aes256gcm::compression_zlib, info.compression);
+    ASSERT_EQ(6, info.compression_level);
+    size_t const compressed_size = size + 3 * aes256gcm::proprietary::compression_block_header_size;
+    ASSERT_EQ(compressed_size + info.size
+        + aes256gcm::proprietary::segment_count(compressed_size, info.segment_size) * aes256gcm::proprietary::segment_overhead,
+        std::filesystem::file_size(path("enc")));
+}
+
+TEST_F(compression_test, decrypt_fails_on_modified_data)
+{
+    if (!aes256gcm::is_compression_available(aes256gcm::compression_zlib))
+    {
+        GTEST_SKIP() << "zlib not available";
+    }
+
+    write("plain", generate_text(100000));
+    for (size_t const segment_size: {0, 4096})
+    {
+        aes256gcm::proprietary::file_options options;
+        options.compression = "zlib";
+        options.segment_size = segment_size;
+        aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "", options);
+
+        {
+            std::fstream file(path("enc"), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+            file.seekg(100);
+            char const c = static_cast<char>(file.get() ^ 1);
+            file.seekp(100);
+            file.put(c);
+        }
+
+        ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::decrypt_file(path("enc"), path("dec"), "secret"));
+        ASSERT_FALSE(std::filesystem::exists(path("dec")));
+    }
+}
+
+TEST_F(compression_test, rejects_unsupported_operations)
+{
+    write("plain", "data");
+
+    aes256gcm::proprietary::file_options options;
+    options.compression = "zlib";
+    ASSERT_THROW(aes256gcm::proprietary::encrypt_file_inplace(path("plain"), "secret", "", options), std::logic_error);
+
+    options.compression = "brotli";
+    ASSERT_THROW(aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "", options), std::invalid_argument);
+    ASSERT_THROW(aes256gcm::select_compression("brotli"), std::invalid_argument);
+}
+
+TEST_F(compression_test, rejects_invalid_levels)
+{
+    if (!aes256gcm::is_compression_available(aes256gcm::compression_zlib))
+    {
+        GTEST_SKIP() << "zlib not available";
+    }
+
+    ASSERT_NO_THROW(aes256gcm::check_compression_level(aes256gcm::compression_zlib, 0));
+    ASSERT_NO_THROW(aes256gcm::check_compression_level(aes256gcm::compression_zlib, 9));
+    ASSERT_THROW(aes256gcm::check_compression_level(aes256gcm::compression_zlib, 10), std::invalid_argument);
+
+    // levels out of range used to store every block uncompressed
+    write("plain", generate_text(1024 * 1024));
+    aes256gcm::proprietary::file_options options;
+    options.compression = "zlib";
+    options.compression_level = 15;
+    ASSERT_THROW(aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "", options), std::invalid_argument);
+    ASSERT_FALSE(std::filesystem::exists(path("enc")));
+
+    options.compression_level = 9;
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "", options);
+    ASSERT_LT(std::filesystem::file_size(path("enc")), 1024 * 1024 / 2);
+}
+
+TEST(segment, encrypts_data_of_unknown_size)
+{
+    // one thread processes four segments per chunk; sizes cover empty data,
+    // partial segments and data ending at segment and chunk boundaries
+    size_t const segment_size = 1024;
+    std::string const key(32, 'k');
+    std::string const nonce(12, 'n');
+    for (size_t const size: {0, 1, 1024, 3000, 4096, 4097, 8192})
+    {
+        auto const plaintext = generate_data(size);
+
+        aes256gcm::proprietary::file_options options;
+        options.segment_size = segment_size;
+        std::string encrypted;
+        {
+            memory_input in(plaintext);
+            memory_output out(encrypted);
+            aes256gcm::proprietary::encrypt_segments(in, out, key, nonce, "aad", aes256gcm::algorithm_aes256_gcm,
+                aes256gcm::proprietary::unknown_data_size, options);
+        }
+
+        std::string known_size;
+        {
+            memory_input in(plaintext);
+            memory_output out(known_size);
+            aes256gcm::proprietary::encrypt_segments(in, out, key, nonce, "aad", aes256gcm::algorithm_aes256_gcm,
+                size, options);
+        }
+
+        // data ending at a chunk boundary is followed by an empty last segment
+        size_t const extra = ((size > 0) && (size % (4 * segment_size) == 0)) ? aes256gcm::proprietary::segment_overhead : 0;
+        ASSERT_EQ(known_size.size() + extra, encrypted.size()) << "size: " << size;
+
+        aes256gcm::proprietary::encryption_info info;
+        info.segment_size = segment_size;
+        info.additional_data = "aad";
+        info.encryption_method = aes256gcm::algorithm_aes256_gcm;
+
+        std::string decrypted;
+        memory_input in(encrypted);
+        memory_output out(decrypted);
+        ASSERT_TRUE(aes256gcm::proprietary::decrypt_segments(in, out, key, info, encrypted.size(), options)) << "size: " << size;
+        ASSERT_EQ(plaintext, decrypted);
+    }
+}
@@ -0,0 +1,114 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+class encrypted_reader_test: public aes256gcm::test::file_test
+{
+protected:
+    void SetUp() override
+    {
+        m_plaintext = aes256gcm::test::generate_data(4096 * 10 + 123, 23);
+        write("plain", m_plaintext);
+
+        aes256gcm::proprietary::file_options options;
+        options.segment_size = 4096;
+        aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+    }
+
+    std::string m_plaintext;
+};
+
+}
+
+TEST_F(encrypted_reader_test, reads_ranges)
+{
+    aes256gcm::proprietary::encrypted_reader reader(path("enc"), "secret");
+    ASSERT_EQ(m_plaintext.size(), reader.size());
+
+    for (auto const & [offset, length]: std::vector<std::pair<size_t, size_t>>{
+        {0, 1}, {0, 4096}, {4095, 2}, {5000, 10000}, {4096 * 10, 123}, {0, m_plaintext.size()}})
+    {
+        std::vector<char> buffer(length);
+        ASSERT_EQ(length, reader.read(offset, length, buffer.data()));
+        ASSERT_EQ(m_plaintext.substr(offset, length), std::string(buffer.data(), length));
+    }
+}
+
+TEST_F(encrypted_reader_test, stops_at_end_of_file)
+{
+    aes256gcm::proprietary::encrypted_reader reader(path("enc"), "secret");
+
+    std::vector<char> buffer(1000);
+    ASSERT_EQ(100, reader.read(m_plaintext.size() - 100, buffer.size(), buffer.data()));
+    ASSERT_EQ(0, reader.read(m_plaintext.size(), buffer.size(), buffer.data()));
+}
+
+TEST_F(encrypted_reader_test, supports_concurrent_reads)
+{
+    aes256gcm::proprietary::encrypted_reader reader(path("enc"), "secret");
+
+    std::vector<std::thread> threads;
+    std::vector<int> results(4, 0);
+    for (size_t t = 0; t < results.size(); t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            std::vector<char> buffer(3000);
+            for (size_t offset = t * 100; offset + buffer.size() <= m_plaintext.size(); offset += 1000)
+            {
+                reader.read(offset, buffer.size(), buffer.data());
+                if (m_plaintext.substr(offset, buffer.size()) != std::string(buffer.data(), buffer.size()))
+                {
+                    return;
+                }
+            }
+            results[t] = 1;
+        });
+    }
+
+    for (auto & thread: threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(std::vector<int>(4, 1), results);
+}
+
+TEST_F(encrypted_reader_test, fails_on_modified_segment)
+{
+    {
+        std::fstream f(path("enc"), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+        f.seekg((4096 + 28) * 2 + 50);
+        char const c = static_cast<char>(f.get());
+        f.seekp((4096 + 28) * 2 + 50);
+        f.put(c + 1);
+    }
+
+    aes256gcm::proprietary::encrypted_reader reader(path("enc"), "secret");
+    std::vector<char> buffer(100);
+    ASSERT_EQ(100, reader.read(0, buffer.size(), buffer.data()));
+    ASSERT_THROW({
+        reader.read(4096 * 2, buffer.size(), buffer.data());
+    }, std::runtime_error);
+}
+
+TEST_F(encrypted_reader_test, rejects_files_with_single_tag)
+{
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc1"), "secret");
+    ASSERT_THROW({
+        aes256gcm::proprietary::encrypted_reader reader(path("enc1"), "secret");
+    }, std::runtime_error);
+}
+
+TEST_F(encrypted_reader_test, rejects_wrong_password)
+{
+    ASSERT_THROW({
+        aes256gcm::proprietary::encrypted_reader reader(path("enc"), "wrong");
+    }, std::runtime_error);
+}
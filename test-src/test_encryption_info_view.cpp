@@ -0,0 +1,128 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+class encryption_info_view_test: public aes256gcm::test::file_test
+{
+protected:
+    void SetUp() override
+    {
+        write("plain", std::string(4096 * 100 + 5, 'x'));
+    }
+
+};
+
+void expect_equal(aes256gcm::proprietary::encryption_info const & expected,
+    aes256gcm::proprietary::encryption_info_view const & actual)
+{
+    EXPECT_EQ(expected.size, actual.size);
+    EXPECT_EQ(expected.kdf.algorithm, actual.kdf.algorithm);
+    EXPECT_EQ(expected.kdf.salt, actual.kdf.salt);
+    EXPECT_EQ(expected.kdf.digest, actual.kdf.digest);
+    EXPECT_EQ(expected.kdf.iterations, actual.kdf.iterations);
+    EXPECT_EQ(expected.encryption_method, actual.encryption_method);
+    EXPECT_EQ(expected.nonce, actual.nonce);
+    EXPECT_EQ(expected.tag, actual.tag);
+    EXPECT_EQ(expected.additional_data, actual.additional_data);
+    EXPECT_EQ(expected.segment_size, actual.segment_size);
+    EXPECT_EQ(expected.is_stream, actual.is_stream);
+    EXPECT_EQ(expected.segment_digests, actual.segment_digests);
+    EXPECT_EQ(expected.key_check, actual.key_check);
+}
+
+}
+
+TEST_F(encryption_info_view_test, reads_encryption_info)
+{
+    aes256gcm::proprietary::file_options segmented;
+    segmented.segment_size = 4096;
+    aes256gcm::proprietary::file_options with_digests = segmented;
+    with_digests.segment_digests = true;
+
+    for (auto const & options: {aes256gcm::proprietary::file_options(), segmented, with_digests})
+    {
+        aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+
+        aes256gcm::proprietary::encryption_info info;
+        ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), info));
+        ASSERT_EQ(options.segment_digests, info.size > aes256gcm::proprietary::encryption_info_view::inline_size);
+
+        aes256gcm::proprietary::encryption_info_view view;
+        ASSERT_EQ(nullptr, view.read(path("enc")));
+        expect_equal(info, view);
+        ASSERT_EQ("aad", view.additional_data);
+        ASSERT_FALSE(view.key_check.empty());
+    }
+}
+
+TEST_F(encryption_info_view_test, reads_stream_header)
+{
+    std::istringstream in("some data");
+    {
+        std::ofstream out(path("enc"), std::ios_base::binary);
+        aes256gcm::proprietary::encrypt_stream(in, out, "secret", "aad");
+    }
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), info));
+
+    aes256gcm::proprietary::encryption_info_view view;
+    ASSERT_EQ(nullptr, view.read(path("enc")));
+    ASSERT_TRUE(view.is_stream);
+    expect_equal(info, view);
+}
+
+TEST_F(encryption_info_view_test, rejects_files_without_encryption_info)
+{
+    aes256gcm::proprietary::encryption_info_view view;
+    ASSERT_NE(nullptr, view.read(path("plain")));
+
+    write("small", "data");
+    ASSERT_NE(nullptr, view.read(path("small")));
+
+    ASSERT_THROW(view.read(path("missing")), std::runtime_error);
+
+    // truncated fields are rejected instead of being read beyond the data
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret");
+    std::ifstream in(path("enc"), std::ios_base::binary);
+    std::string const data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(nullptr, view.read(path("enc")));
+    std::string const raw_info = data.substr(data.size() - view.size);
+    for (size_t size = 0; size < raw_info.size() - 12; size++)
+    {
+        ASSERT_NE(nullptr, view.parse(raw_info.data(), size)) << size;
+    }
+}
+
+TEST_F(encryption_info_view_test, scans_files_in_parallel)
+{
+    std::vector<std::string> filenames;
+    for (int i = 0; i < 20; i++)
+    {
+        auto const filename = path("enc" + std::to_string(i));
+        aes256gcm::proprietary::file_options options;
+        options.segment_size = (i % 2) ? 4096 : 0;
+        aes256gcm::proprietary::encrypt_file(path("plain"), filename, "secret", std::to_string(i), options);
+        filenames.push_back(filename);
+    }
+    filenames.push_back(path("plain"));
+    filenames.push_back(path("missing"));
+
+    auto const result = aes256gcm::proprietary::scan_encryption_info(filenames, 4);
+    ASSERT_EQ(filenames.size(), result.size());
+    for (size_t i = 0; i < 20; i++)
+    {
+        ASSERT_EQ(filenames[i], result[i].filename);
+        ASSERT_EQ("", result[i].error);
+        ASSERT_EQ(std::to_string(i), result[i].info.additional_data);
+        ASSERT_EQ((i % 2) ? 4096u : 0u, result[i].info.segment_size);
+    }
+    ASSERT_NE("", result[20].error);
+    ASSERT_NE("", result[21].error);
+}
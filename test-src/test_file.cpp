@@ -0,0 +1,454 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "aes256gcm/proprietary/encryption_info.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+
+namespace
+{
+
+using aes256gcm::test::temp_dir;
+using aes256gcm::test::generate_data;
+using aes256gcm::test::write_file;
+using aes256gcm::test::read_file;
+
+}
+
+TEST(file, encrypt_and_decrypt)
+{
+    temp_dir dir;
+    auto const plaintext = generate_data(300 * 1024 + 7);
+    write_file(dir.file("plain"), plaintext);
+
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad");
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+
+    ASSERT_EQ(EXIT_SUCCESS, rc);
+    ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+}
+
+TEST(file, encrypt_and_decrypt_segmented)
+{
+    for (size_t const size: {0, 1, 4096, 4096 * 3, 4096 * 37 + 5})
+    {
+        temp_dir dir;
+        auto const plaintext = generate_data(size);
+        write_file(dir.file("plain"), plaintext);
+
+        aes256gcm::proprietary::file_options options;
+        options.segment_size = 4096;
+        options.threads = 4;
+        aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad", options);
+
+        aes256gcm::proprietary::encryption_info info;
+        ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+        ASSERT_EQ(4096, info.segment_size);
+        ASSERT_EQ("aad", info.additional_data);
+
+        int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret", options);
+        ASSERT_EQ(EXIT_SUCCESS, rc);
+        ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+    }
+}
+
+TEST(file, decrypt_segmented_fails_on_modified_segment)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), generate_data(4096 * 8));
+
+    aes256gcm::proprietary::file_options options;
+    options.segment_size = 4096;
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "", options);
+
+    auto encrypted = read_file(dir.file("enc"));
+    encrypted[5 * 4096 + 100]++;
+    write_file(dir.file("enc"), encrypted);
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, rc);
+    ASSERT_FALSE(std::filesystem::exists(dir.file("dec")));
+}
+
+TEST(file, decrypt_segmented_fails_on_reordered_segments)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), generate_data(4096 * 4));
+
+    aes256gcm::proprietary::file_options options;
+    options.segment_size = 4096;
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "", options);
+
+    auto encrypted = read_file(dir.file("enc"));
+    size_t const stored_size = 4096 + 12 + 16;
+    std::swap_ranges(&encrypted[0], &encrypted[stored_size], &encrypted[stored_size]);
+    write_file(dir.file("enc"), encrypted);
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, rc);
+}
+
+TEST(file, decrypt_segmented_fails_on_truncated_file)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), generate_data(4096 * 4));
+
+    aes256gcm::proprietary::file_options options;
+    options.segment_size = 4096;
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "", options);
+
+    auto encrypted = read_file(dir.file("enc"));
+    size_t const stored_size = 4096 + 12 + 16;
+    encrypted.erase(3 * stored_size, stored_size);
+    write_file(dir.file("enc"), encrypted);
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, rc);
+}
+
+TEST(file, encrypt_and_decrypt_inplace_using_multiple_threads)
+{
+    temp_dir dir;
+    auto const plaintext = generate_data(3 * 1024 * 1024 + 9);
+    write_file(dir.file("file"), plaintext);
+
+    aes256gcm::proprietary::file_options options;
+    options.threads = 4;
+    aes256gcm::proprietary::encrypt_file_inplace(dir.file("file"), "secret", "aad", options);
+
+    // single threaded decryption produces the same result
+    aes256gcm::proprietary::decrypt_file(dir.file("file"), dir.file("dec"), "secret");
+    ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+
+    int const rc = aes256gcm::proprietary::decrypt_file_inplace(dir.file("file"), "secret", options);
+    ASSERT_EQ(EXIT_SUCCESS, rc);
+    ASSERT_EQ(plaintext, read_file(dir.file("file")));
+}
+
+TEST(file, encrypt_and_decrypt_inplace_using_small_window)
+{
+    for (unsigned int const threads: {1, 2})
+    {
+        temp_dir dir;
+        auto const plaintext = generate_data(100 * 1024 + 3);
+        write_file(dir.file("file"), plaintext);
+
+        aes256gcm::proprietary::file_options options;
+        options.window_size = 16 * 1024;
+        options.threads = threads;
+        aes256gcm::proprietary::encrypt_file_inplace(dir.file("file"), "secret", "", options);
+
+        aes256gcm::proprietary::decrypt_file(dir.file("file"), dir.file("dec"), "secret");
+        ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+
+        int const rc = aes256gcm::proprietary::decrypt_file_inplace(dir.file("file"), "secret", options);
+        ASSERT_EQ(EXIT_SUCCESS, rc);
+        ASSERT_EQ(plaintext, read_file(dir.file("file")));
+    }
+}
+
+TEST(file, encrypt_and_decrypt_empty_file_inplace)
+{
+    temp_dir dir;
+    write_file(dir.file("file"), "");
+
+    aes256gcm::proprietary::encrypt_file_inplace(dir.file("file"), "secret");
+    int const rc = aes256gcm::proprietary::decrypt_file_inplace(dir.file("file"), "secret");
+
+    ASSERT_EQ(EXIT_SUCCESS, rc);
+    ASSERT_EQ("", read_file(dir.file("file")));
+}
+
+namespace
+{
+
+struct io_engine_param
+{
+    aes256gcm::proprietary::io_engine engine;
+    bool direct_io;
+};
+
+class file_io_engine: public ::testing::TestWithParam<io_engine_param>
+{
+protected:
+    aes256gcm::proprietary::file_options options() const
+    {
+        aes256gcm::proprietary::file_options options;
+        options.engine = GetParam().engine;
+        options.direct_io = GetParam().direct_io;
+        options.buffer_size = 8 * 1024;
+        options.window_size = 64 * 1024;
+        return options;
+    }
+};
+
+}
+
+TEST_P(file_io_engine, encrypt_and_decrypt)
+{
+    for (size_t const segment_size: {0, 4096})
+    {
+        temp_dir dir;
+        auto const plaintext = generate_data(200 * 1024 + 17);
+        write_file(dir.file("plain"), plaintext);
+
+        auto opts = options();
+        opts.segment_size = segment_size;
+        aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad", opts);
+
+        // files are compatible across engines
+        aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec1"), "secret");
+        ASSERT_EQ(plaintext, read_file(dir.file("dec1")));
+
+        int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec2"), "secret", opts);
+        ASSERT_EQ(EXIT_SUCCESS, rc);
+        ASSERT_EQ(plaintext, read_file(dir.file("dec2")));
+    }
+}
+
+TEST_P(file_io_engine, encrypt_and_decrypt_inplace)
+{
+    temp_dir dir;
+    auto const plaintext = generate_data(200 * 1024 + 17);
+    write_file(dir.file("file"), plaintext);
+
+    aes256gcm::proprietary::encrypt_file_inplace(dir.file("file"), "secret", "", options());
+    aes256gcm::proprietary::decrypt_file(dir.file("file"), dir.file("dec"), "secret");
+    ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+
+    int const rc = aes256gcm::proprietary::decrypt_file_inplace(dir.file("file"), "secret", options());
+    ASSERT_EQ(EXIT_SUCCESS, rc);
+    ASSERT_EQ(plaintext, read_file(dir.file("file")));
+}
+
+INSTANTIATE_TEST_SUITE_P(engines, file_io_engine, ::testing::Values(
+    io_engine_param{aes256gcm::proprietary::io_engine::iostream, false},
+    io_engine_param{aes256gcm::proprietary::io_engine::pread, false},
+    io_engine_param{aes256gcm::proprietary::io_engine::mmap, false},
+    io_engine_param{aes256gcm::proprietary::io_engine::io_uring, false},
+    io_engine_param{aes256gcm::proprietary::io_engine::pread, true},
+    io_engine_param{aes256gcm::proprietary::io_engine::io_uring, true}));
+
+TEST(file, encrypt_and_decrypt_pipelined)
+{
+    for (size_t const segment_size: {0, 4096})
+    {
+        for (size_t const size: {0, 8 * 1024, 200 * 1024 + 17})
+        {
+            temp_dir dir;
+            auto const plaintext = generate_data(size);
+            write_file(dir.file("plain"), plaintext);
+
+            aes256gcm::proprietary::file_options options;
+            options.pipelined = true;
+            options.buffer_size = 8 * 1024;
+            options.queue_depth = 3;
+            options.segment_size = segment_size;
+            options.threads = 2;
+            aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad", options);
+
+            // pipelined mode does not change the file format
+            aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec1"), "secret");
+            ASSERT_EQ(plaintext, read_file(dir.file("dec1")));
+
+            int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec2"), "secret", options);
+            ASSERT_EQ(EXIT_SUCCESS, rc);
+            ASSERT_EQ(plaintext, read_file(dir.file("dec2")));
+        }
+    }
+}
+
+TEST(file, decrypt_pipelined_fails_on_modified_data)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), generate_data(100 * 1024));
+
+    aes256gcm::proprietary::file_options options;
+    options.pipelined = true;
+    options.buffer_size = 8 * 1024;
+    options.segment_size = 4096;
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "", options);
+
+    auto encrypted = read_file(dir.file("enc"));
+    encrypted[50 * 1024]++;
+    write_file(dir.file("enc"), encrypted);
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret", options);
+    ASSERT_EQ(EXIT_FAILURE, rc);
+    ASSERT_FALSE(std::filesystem::exists(dir.file("dec")));
+}
+
+namespace
+{
+
+class file_algorithm: public ::testing::TestWithParam<char const *>
+{
+protected:
+    void SetUp() override
+    {
+        if (!aes256gcm::is_aead_available(GetParam()))
+        {
+            GTEST_SKIP() << GetParam() << " is not available";
+        }
+    }
+};
+
+}
+
+TEST_P(file_algorithm, encrypt_and_decrypt)
+{
+    for (size_t const segment_size: {0, 4096})
+    {
+        temp_dir dir;
+        auto const plaintext = generate_data(200 * 1024 + 17);
+        write_file(dir.file("plain"), plaintext);
+
+        aes256gcm::proprietary::file_options options;
+        options.algorithm = GetParam();
+        options.segment_size = segment_size;
+        options.buffer_size = 1000;
+        options.threads = 2;
+        aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad", options);
+
+        aes256gcm::proprietary::encryption_info info;
+        ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+        ASSERT_EQ(GetParam(), info.encryption_method);
+
+        int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+        ASSERT_EQ(EXIT_SUCCESS, rc);
+        ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+    }
+}
+
+TEST_P(file_algorithm, encrypt_and_decrypt_inplace)
+{
+    temp_dir dir;
+    auto const plaintext = generate_data(200 * 1024 + 17);
+    write_file(dir.file("file"), plaintext);
+
+    aes256gcm::proprietary::file_options options;
+    options.algorithm = GetParam();
+    options.threads = 2;
+    options.window_size = 64 * 1024;
+    aes256gcm::proprietary::encrypt_file_inplace(dir.file("file"), "secret", "", options);
+
+    int const rc = aes256gcm::proprietary::decrypt_file_inplace(dir.file("file"), "secret", options);
+    ASSERT_EQ(EXIT_SUCCESS, rc);
+    ASSERT_EQ(plaintext, read_file(dir.file("file")));
+}
+
+TEST_P(file_algorithm, decrypt_fails_on_modified_data)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), generate_data(10 * 1024 + 3));
+
+    aes256gcm::proprietary::file_options options;
+    options.algorithm = GetParam();
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "", options);
+
+    auto data = read_file(dir.file("enc"));
+    data[100] ^= 1;
+    write_file(dir.file("enc"), data);
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, rc);
+}
+
+INSTANTIATE_TEST_SUITE_P(algorithms, file_algorithm, ::testing::Values(
+    aes256gcm::algorithm_aes256_gcm,
+    aes256gcm::algorithm_chacha20_poly1305,
+    aes256gcm::algorithm_aes256_ocb));
+
+TEST(file, gcm_siv_requires_segments)
+{
+    if (!aes256gcm::is_aead_available(aes256gcm::algorithm_aes256_gcm_siv))
+    {
+        GTEST_SKIP() << aes256gcm::algorithm_aes256_gcm_siv << " is not available";
+    }
+
+    temp_dir dir;
+    auto const plaintext = generate_data(200 * 1024 + 17);
+    write_file(dir.file("plain"), plaintext);
+
+    aes256gcm::proprietary::file_options options;
+    options.algorithm = aes256gcm::algorithm_aes256_gcm_siv;
+    options.threads = 2;
+    ASSERT_THROW(aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad", options),
+        std::logic_error);
+    ASSERT_THROW(aes256gcm::proprietary::encrypt_file_inplace(dir.file("plain"), "secret", "aad", options),
+        std::logic_error);
+    ASSERT_EQ(plaintext, read_file(dir.file("plain")));
+
+    for (bool const pipelined: {false, true})
+    {
+        options.segment_size = 4096;
+        options.buffer_size = 1000;
+        options.pipelined = pipelined;
+        aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "aad", options);
+
+        aes256gcm::proprietary::encryption_info info;
+        ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+        ASSERT_EQ(aes256gcm::algorithm_aes256_gcm_siv, info.encryption_method);
+
+        ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::verify_file(dir.file("enc"), "secret", options));
+        ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret", options));
+        ASSERT_EQ(plaintext, read_file(dir.file("dec")));
+
+        auto data = read_file(dir.file("enc"));
+        data[100] ^= 1;
+        write_file(dir.file("enc"), data);
+        ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret", options));
+    }
+}
+
+TEST(file, decrypt_fails_on_unknown_encryption_method)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), "some data");
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret");
+
+    auto data = read_file(dir.file("enc"));
+    auto const pos = data.rfind("AES256-GCM");
+    ASSERT_NE(std::string::npos, pos);
+    data.replace(pos, 10, "AES256-XYZ");
+    write_file(dir.file("enc"), data);
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, rc);
+}
+
+TEST(file, decrypt_fails_on_wrong_password_before_writing_output)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), "some data");
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret");
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+    ASSERT_EQ(16u, info.key_check.size());
+
+    int const rc = aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "wrong");
+    ASSERT_EQ(EXIT_FAILURE, rc);
+    ASSERT_FALSE(std::filesystem::exists(dir.file("dec")));
+}
+
+TEST(file, decrypt_files_without_key_check)
+{
+    temp_dir dir;
+    write_file(dir.file("plain"), "some data");
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret");
+
+    // files written before the key check was introduced lack the field
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+    auto const data = read_file(dir.file("enc"));
+    info.key_check.clear();
+    std::vector<char> trailer;
+    aes256gcm::proprietary::create_encryption_info(trailer, info);
+    write_file(dir.file("enc"), data.substr(0, data.size() - info.size) + std::string(trailer.data(), trailer.size()));
+
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret"));
+    ASSERT_EQ("some data", read_file(dir.file("dec")));
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "wrong"));
+}
@@ -0,0 +1,96 @@
+#ifndef AES256GCM_TEST_HELPERS_HPP
+#define AES256GCM_TEST_HELPERS_HPP
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+namespace aes256gcm::test
+{
+
+/// @brief Temporary directory, which is removed with its content.
+class temp_dir
+{
+    temp_dir(temp_dir const &) = delete;
+    temp_dir& operator=(temp_dir const &) = delete;
+public:
+    temp_dir()
+    : m_path(std::filesystem::temp_directory_path() / ("aes256gcm_test_" + std::to_string(std::random_device()())))
+    {
+        std::filesystem::create_directories(m_path);
+    }
+
+    ~temp_dir()
+    {
+        std::filesystem::remove_all(m_path);
+    }
+
+    std::filesystem::path const & path() const
+    {
+        return m_path;
+    }
+
+    /// @brief Returns the path of a file in the directory.
+    std::string file(std::string const & name) const
+    {
+        return (m_path / name).string();
+    }
+
+private:
+    std::filesystem::path m_path;
+};
+
+/// @brief Returns reproducible random data.
+inline std::string generate_data(size_t size, unsigned int seed = 42)
+{
+    std::mt19937 rng(seed);
+    std::string data(size, '\0');
+    for (auto & c: data)
+    {
+        c = static_cast<char>(rng() & 0xff);
+    }
+    return data;
+}
+
+inline void write_file(std::string const & filename, std::string const & data)
+{
+    std::ofstream out(filename, std::ios_base::binary | std::ios_base::trunc);
+    out.write(data.data(), data.size());
+}
+
+inline std::string read_file(std::string const & filename)
+{
+    std::ifstream in(filename, std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/// @brief Fixture providing a temporary directory for the files of a test.
+class file_test: public ::testing::Test
+{
+protected:
+    std::string path(std::string const & name) const
+    {
+        return m_dir.file(name);
+    }
+
+    void write(std::string const & name, std::string const & data) const
+    {
+        write_file(path(name), data);
+    }
+
+    std::string read(std::string const & name) const
+    {
+        return read_file(path(name));
+    }
+
+    temp_dir m_dir;
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "aes256gcm/kdf.hpp"
+#include "aes256gcm/argon2.hpp"
+#include "aes256gcm/secure_kdf.hpp"
+#include "aes256gcm/aes256gcm.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+namespace
+{
+
+std::string to_hex(std::string const & value)
+{
+    static char const digits[] = "0123456789abcdef";
+    std::string result;
+    for (char const c: value)
+    {
+        result.push_back(digits[(c >> 4) & 0x0f]);
+        result.push_back(digits[c & 0x0f]);
+    }
+    return result;
+}
+
+}
+
+TEST(kdf, argon2id_matches_rfc9106_test_vector)
+{
+    // RFC 9106, section 5.3
+    std::string const password(32, '\x01');
+    std::string const salt(16, '\x02');
+    std::string const secret(8, '\x03');
+    std::string const associated_data(12, '\x04');
+
+    for (unsigned int const threads: {1, 4})
+    {
+        auto const tag = aes256gcm::argon2id_native(password, salt, secret, associated_data, 3, 32, 4, 32, threads);
+        ASSERT_EQ("0d640df58d78766c08c037a34a8b53c9d01ef0452d75b65eb52520e96b01e659", to_hex(tag));
+    }
+}
+
+TEST(kdf, argon2id_does_not_depend_on_threads)
+{
+    std::string const salt(16, 's');
+    auto const expected = aes256gcm::argon2id_native("secret", salt, "", "", 2, 1024, 4, 32, 1);
+    ASSERT_EQ(expected, aes256gcm::argon2id_native("secret", salt, "", "", 2, 1024, 4, 32, 4));
+    ASSERT_EQ(expected, aes256gcm::argon2id("secret", salt, 2, 1024, 4));
+    ASSERT_NE(expected, aes256gcm::argon2id("secret", salt, 2, 1024, 2));
+}
+
+TEST(kdf, argon2id_rejects_invalid_parameters)
+{
+    std::string const salt(16, 's');
+    ASSERT_THROW(aes256gcm::argon2id("secret", salt, 0, 1024, 1), std::invalid_argument);
+    ASSERT_THROW(aes256gcm::argon2id("secret", salt, 1, 31, 4), std::invalid_argument);
+    ASSERT_THROW(aes256gcm::argon2id("secret", salt, 1, 1024, 0), std::invalid_argument);
+    ASSERT_THROW(aes256gcm::argon2id("secret", "short", 1, 1024, 1), std::invalid_argument);
+}
+
+TEST(kdf, generates_params)
+{
+    auto const pbkdf2 = aes256gcm::generate_kdf_params();
+    ASSERT_EQ(aes256gcm::kdf_pbkdf2, pbkdf2.algorithm);
+    ASSERT_EQ("sha256", pbkdf2.digest);
+    ASSERT_EQ(0, pbkdf2.lanes);
+
+    auto const argon2 = aes256gcm::generate_kdf_params("argon2id", 0, 0, 0);
+    ASSERT_EQ(aes256gcm::kdf_argon2id, argon2.algorithm);
+    ASSERT_EQ(16, argon2.salt.size());
+    ASSERT_EQ(3, argon2.iterations);
+    ASSERT_EQ(64 * 1024, argon2.memory_cost);
+    ASSERT_GE(argon2.lanes, 1);
+
+    ASSERT_THROW(aes256gcm::generate_kdf_params("scrypt"), std::invalid_argument);
+}
+
+TEST(kdf, derive_key_dispatches_on_algorithm)
+{
+    auto params = aes256gcm::generate_kdf_params("ARGON2ID", 1, 256, 2);
+    auto const key = aes256gcm::derive_key("secret", params);
+    ASSERT_EQ(32, key.size());
+    ASSERT_EQ(aes256gcm::argon2id("secret", params.salt, 1, 256, 2), key);
+
+    params.algorithm = "SCRYPT";
+    ASSERT_THROW(aes256gcm::derive_key("secret", params), std::invalid_argument);
+}
+
+TEST(kdf, derives_key_into_key_buffer)
+{
+    for (auto const * algorithm: {"PBKDF2", "ARGON2ID"})
+    {
+        auto const params = aes256gcm::generate_kdf_params(algorithm, 1, 256, 2);
+        auto const key = aes256gcm::derive_secure_key("secret", params);
+        ASSERT_EQ(32, key.size());
+        ASSERT_EQ(aes256gcm::derive_key("secret", params), key.view());
+    }
+}
+
+TEST(kdf, calibrates_argon2id)
+{
+    auto const cost = aes256gcm::calibrate_argon2id(std::chrono::milliseconds(50), 2, 32 * 1024);
+    ASSERT_GE(cost.time_cost, 1);
+    ASSERT_GE(cost.memory_cost, 8 * 1024);
+    ASSERT_LE(cost.memory_cost, 32 * 1024);
+}
+
+TEST(kdf, encrypt_and_decrypt_file_using_argon2id)
+{
+    aes256gcm::test::temp_dir dir;
+    aes256gcm::test::write_file(dir.file("plain"), std::string(10000, 'x'));
+
+    aes256gcm::proprietary::file_options options;
+    options.kdf = "argon2id";
+    options.kdf_time_cost = 1;
+    options.kdf_memory_cost = 1024;
+    options.kdf_lanes = 2;
+    aes256gcm::proprietary::encrypt_file(dir.file("plain"), dir.file("enc"), "secret", "", options);
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+    ASSERT_EQ(aes256gcm::kdf_argon2id, info.kdf.algorithm);
+    ASSERT_EQ(1, info.kdf.iterations);
+    ASSERT_EQ(1024, info.kdf.memory_cost);
+    ASSERT_EQ(2, info.kdf.lanes);
+    ASSERT_TRUE(info.kdf.digest.empty());
+
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret"));
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "wrong"));
+}
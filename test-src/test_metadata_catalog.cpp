@@ -0,0 +1,131 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+
+namespace
+{
+
+class metadata_catalog_test: public aes256gcm::test::file_test
+{
+protected:
+    void SetUp() override
+    {
+        write("plain", std::string(10000, 'x'));
+    }
+
+};
+
+}
+
+TEST_F(metadata_catalog_test, caches_encrypted_files)
+{
+    {
+        aes256gcm::proprietary::metadata_catalog catalog(path("catalog"));
+        aes256gcm::proprietary::file_options options;
+        options.catalog = &catalog;
+        options.segment_size = 4096;
+        aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+        ASSERT_EQ(1u, catalog.size());
+        catalog.save();
+    }
+
+    aes256gcm::proprietary::encryption_info expected;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), expected));
+
+    aes256gcm::proprietary::metadata_catalog catalog(path("catalog"));
+    ASSERT_EQ(1u, catalog.size());
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_EQ(nullptr, catalog.lookup(path("enc"), info));
+    ASSERT_EQ(expected.size, info.size);
+    ASSERT_EQ(expected.nonce, info.nonce);
+    ASSERT_EQ(expected.key_check, info.key_check);
+    ASSERT_EQ(4096u, info.segment_size);
+    ASSERT_EQ("aad", info.additional_data);
+}
+
+TEST_F(metadata_catalog_test, revalidates_changed_files)
+{
+    aes256gcm::proprietary::metadata_catalog catalog(path("catalog"));
+    aes256gcm::proprietary::file_options options;
+    options.catalog = &catalog;
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+
+    // a change keeping size and modification time is not noticed ...
+    auto const mtime = std::filesystem::last_write_time(path("enc"));
+    auto data = read("enc");
+    auto const pos = data.rfind("aad");
+    ASSERT_NE(std::string::npos, pos);
+    data.replace(pos, 3, "xyz");
+    write("enc", data);
+    std::filesystem::last_write_time(path("enc"), mtime);
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_EQ(nullptr, catalog.lookup(path("enc"), info));
+    ASSERT_EQ("aad", info.additional_data);
+
+    // ... but any other change is
+    std::filesystem::last_write_time(path("enc"), mtime + std::chrono::seconds(1));
+    ASSERT_EQ(nullptr, catalog.lookup(path("enc"), info));
+    ASSERT_EQ("xyz", info.additional_data);
+
+    // files without encryption info are removed
+    write("enc", "not encrypted");
+    ASSERT_NE(nullptr, catalog.lookup(path("enc"), info));
+    ASSERT_EQ(0u, catalog.size());
+
+    // files unknown to the catalog are added on lookup
+    options.catalog = nullptr;
+    aes256gcm::proprietary::encrypt_file_inplace(path("plain"), "secret", "other", options);
+    ASSERT_EQ(nullptr, catalog.lookup(path("plain"), info));
+    ASSERT_EQ("other", info.additional_data);
+    ASSERT_EQ(1u, catalog.size());
+}
+
+TEST_F(metadata_catalog_test, scans_using_catalog)
+{
+    aes256gcm::proprietary::metadata_catalog catalog(path("catalog"));
+    aes256gcm::proprietary::file_options options;
+    options.catalog = &catalog;
+
+    std::vector<std::string> filenames;
+    for (int i = 0; i < 10; i++)
+    {
+        filenames.push_back(path("enc" + std::to_string(i)));
+        aes256gcm::proprietary::encrypt_file(path("plain"), filenames.back(), "secret", std::to_string(i), options);
+    }
+    filenames.push_back(path("plain"));
+
+    auto const result = aes256gcm::proprietary::scan_encryption_info(filenames, 3, &catalog);
+    ASSERT_EQ(filenames.size(), result.size());
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ("", result[i].error);
+        ASSERT_EQ(std::to_string(i), result[i].info.additional_data);
+    }
+    ASSERT_NE("", result[10].error);
+}
+
+TEST_F(metadata_catalog_test, ignores_invalid_catalog)
+{
+    write("catalog", "no catalog");
+    aes256gcm::proprietary::metadata_catalog catalog(path("catalog"));
+    ASSERT_EQ(0u, catalog.size());
+
+    aes256gcm::proprietary::file_options options;
+    options.catalog = &catalog;
+    aes256gcm::proprietary::encrypt_file_inplace(path("plain"), "secret", "aad", options);
+    catalog.save();
+
+    // a truncated catalog is dropped as a whole
+    auto const data = read("catalog");
+    write("catalog", data.substr(0, data.size() - 1));
+    aes256gcm::proprietary::metadata_catalog truncated(path("catalog"));
+    ASSERT_EQ(0u, truncated.size());
+
+    write("catalog", data);
+    aes256gcm::proprietary::metadata_catalog restored(path("catalog"));
+    ASSERT_EQ(1u, restored.size());
+}
@@ -0,0 +1,102 @@
+#include "aes256gcm/native_gcm.hpp"
+#include "aes256gcm/cpu_info.hpp"
+#include "aes256gcm/rand.hpp"
+#include <gtest/gtest.h>
+
+#include <openssl/evp.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// reference implementation using OpenSSL directly
+std::vector<char> openssl_encrypt(std::string const & key, std::string const & nonce,
+    std::string const & additional_data, std::string const & plaintext, std::string & tag)
+{
+    std::unique_ptr<EVP_CIPHER_CTX, void (*) (EVP_CIPHER_CTX*)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_gcm(), nullptr,
+        reinterpret_cast<unsigned char const*>(key.data()),
+        reinterpret_cast<unsigned char const*>(nonce.data()));
+
+    int out_size = 0;
+    if (!additional_data.empty())
+    {
+        EVP_EncryptUpdate(ctx.get(), nullptr, &out_size,
+            reinterpret_cast<unsigned char const*>(additional_data.data()), additional_data.size());
+    }
+
+    std::vector<char> ciphertext(plaintext.size());
+    if (!plaintext.empty())
+    {
+        EVP_EncryptUpdate(ctx.get(), reinterpret_cast<unsigned char*>(ciphertext.data()), &out_size,
+            reinterpret_cast<unsigned char const*>(plaintext.data()), plaintext.size());
+    }
+    EVP_EncryptFinal_ex(ctx.get(), nullptr, &out_size);
+
+    tag.resize(16);
+    EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, 16, &tag[0]);
+    return ciphertext;
+}
+
+}
+
+TEST(native_gcm, detects_cpu_features)
+{
+    auto const & features = aes256gcm::detect_cpu_features();
+    bool const expected = features.aes && features.pclmulqdq && features.avx512f
+        && features.avx512bw && features.vaes && features.vpclmulqdq;
+    ASSERT_EQ(expected, aes256gcm::native_gcm::is_supported());
+
+    auto const implementation = aes256gcm::gcm_implementation();
+    ASSERT_TRUE((implementation == "openssl") || (expected && (implementation == "native-vaes-avx512")));
+}
+
+TEST(native_gcm, matches_openssl)
+{
+    if (!aes256gcm::native_gcm::is_supported())
+    {
+        GTEST_SKIP() << "VAES / VPCLMULQDQ not supported";
+    }
+
+    std::mt19937 random(42);
+    for (size_t i = 0; i < 200; i++)
+    {
+        size_t const size = (i < 100) ? i * 7 : random() % (64 * 1024);
+        size_t const offset = random() % 64;
+        auto const key = aes256gcm::rand(32);
+        auto const nonce = aes256gcm::rand(12);
+        auto const additional_data = aes256gcm::rand(random() % 70);
+        auto const plaintext = aes256gcm::rand(size);
+
+        std::string expected_tag;
+        auto const expected = openssl_encrypt(key, nonce, additional_data, plaintext, expected_tag);
+
+        // split the data at random, unaligned positions
+        std::vector<char> buffer(size + 64);
+        char * ciphertext = &buffer[offset];
+        aes256gcm::native_gcm gcm(key.data());
+        gcm.start(nonce.data(), additional_data.data(), additional_data.size());
+        size_t pos = 0;
+        while (pos < size)
+        {
+            size_t const chunk_size = std::min<size_t>(size - pos, random() % 1200);
+            gcm.encrypt(&plaintext[pos], &ciphertext[pos], chunk_size);
+            pos += chunk_size;
+        }
+        char tag[16];
+        gcm.finish(tag);
+
+        ASSERT_EQ(expected, std::vector<char>(ciphertext, ciphertext + size)) << "size: " << size;
+        ASSERT_EQ(expected_tag, std::string(tag, 16)) << "size: " << size;
+
+        gcm.start(nonce.data(), additional_data.data(), additional_data.size());
+        gcm.decrypt(ciphertext, ciphertext, size);
+        gcm.finish(tag);
+
+        ASSERT_EQ(plaintext, std::string(ciphertext, size));
+        ASSERT_EQ(expected_tag, std::string(tag, 16));
+    }
+}
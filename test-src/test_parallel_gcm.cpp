@@ -0,0 +1,111 @@
+#include "aes256gcm/parallel_gcm.hpp"
+#include "aes256gcm/encrypter.hpp"
+#include "aes256gcm/decrypter.hpp"
+#include "aes256gcm/rand.hpp"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+std::string const key(32, 'k');
+
+}
+
+TEST(parallel_gcm, produces_same_ciphertext_and_tag_as_encrypter)
+{
+    for (size_t const size: {0, 1, 15, 16, 17, 1000, 3 * 1024 * 1024 + 5})
+    {
+        for (unsigned int const threads: {1, 3, 8})
+        {
+            auto const plaintext = aes256gcm::rand(size);
+            auto const additional_data = aes256gcm::rand(size % 37);
+
+            aes256gcm::encrypter enc(key, additional_data);
+            std::vector<char> expected(size);
+            enc.update(plaintext.data(), expected.data(), size);
+            auto const expected_tag = enc.finalize();
+
+            aes256gcm::parallel_gcm gcm(key, enc.nonce(), additional_data, threads);
+            std::vector<char> actual(plaintext.begin(), plaintext.end());
+            gcm.encrypt_inplace(actual.data(), actual.size());
+
+            ASSERT_EQ(expected, actual);
+            ASSERT_EQ(expected_tag, gcm.tag());
+        }
+    }
+}
+
+TEST(parallel_gcm, supports_multiple_updates)
+{
+    size_t const size = 2 * 1024 * 1024 + 3;
+    auto const plaintext = aes256gcm::rand(size);
+
+    aes256gcm::encrypter enc(key);
+    std::vector<char> expected(size);
+    enc.update(plaintext.data(), expected.data(), size);
+    auto const expected_tag = enc.finalize();
+
+    aes256gcm::parallel_gcm gcm(key, enc.nonce(), "", 4);
+    std::vector<char> actual(plaintext.begin(), plaintext.end());
+    gcm.encrypt_inplace(actual.data(), 64 * 1024);
+    gcm.encrypt_inplace(&actual[64 * 1024], 1024 * 1024);
+    gcm.encrypt_inplace(&actual[64 * 1024 + 1024 * 1024], size - 64 * 1024 - 1024 * 1024);
+
+    ASSERT_EQ(expected, actual);
+    ASSERT_EQ(expected_tag, gcm.tag());
+}
+
+TEST(parallel_gcm, rejects_unaligned_updates)
+{
+    std::vector<char> buffer(32);
+    aes256gcm::parallel_gcm gcm(key, std::string(12, 'n'), "", 2);
+    gcm.encrypt_inplace(buffer.data(), 15);
+
+    ASSERT_THROW({
+        gcm.encrypt_inplace(buffer.data(), 16);
+    }, std::logic_error);
+}
+
+TEST(parallel_gcm, decrypts_data_of_encrypter)
+{
+    size_t const size = 5 * 1024 * 1024 + 11;
+    auto const plaintext = aes256gcm::rand(size);
+
+    aes256gcm::encrypter enc(key, "aad");
+    std::vector<char> buffer(size);
+    enc.update(plaintext.data(), buffer.data(), size);
+    auto tag = enc.finalize();
+
+    aes256gcm::parallel_gcm gcm(key, enc.nonce(), "aad", 4);
+    gcm.decrypt_inplace(buffer.data(), buffer.size());
+
+    ASSERT_TRUE(gcm.verify(tag));
+    ASSERT_EQ(plaintext, std::string(buffer.data(), buffer.size()));
+
+    tag[0]++;
+    ASSERT_FALSE(gcm.verify(tag));
+}
+
+TEST(parallel_gcm, authenticates_without_decrypting)
+{
+    for (size_t const size: {0, 1, 16, 1000, 3 * 1024 * 1024 + 5})
+    {
+        auto const plaintext = aes256gcm::rand(size);
+
+        aes256gcm::encrypter enc(key, "aad");
+        std::vector<char> ciphertext(size);
+        enc.update(plaintext.data(), ciphertext.data(), size);
+        auto tag = enc.finalize();
+
+        aes256gcm::parallel_gcm gcm(key, enc.nonce(), "aad", 4);
+        auto const copy = ciphertext;
+        gcm.authenticate(ciphertext.data(), ciphertext.size());
+        ASSERT_EQ(copy, ciphertext);
+        ASSERT_TRUE(gcm.verify(tag));
+
+        tag[0] ^= 1;
+        ASSERT_FALSE(gcm.verify(tag));
+    }
+}
@@ -1,6 +1,42 @@
 #include "aes256gcm/pbkdf2.hpp"
+#include "aes256gcm/key_cache.hpp"
+#include "aes256gcm/cpu_info.hpp"
+#include "aes256gcm/sha256_mb.hpp"
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
+namespace
+{
+
+std::vector<aes256gcm::pbkdf2_job> make_jobs(size_t count)
+{
+    std::mt19937 random(42);
+    size_t const password_sizes[] = {0, 6, 55, 64, 65, 200};
+    unsigned int const iterations[] = {1, 2, 2048};
+
+    std::vector<aes256gcm::pbkdf2_job> jobs(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        jobs[i].password.resize(password_sizes[i % 6]);
+        for (auto & c: jobs[i].password)
+        {
+            c = static_cast<char>(random());
+        }
+        jobs[i].salt.resize(8 + (i % 3) * 28);
+        for (auto & c: jobs[i].salt)
+        {
+            c = static_cast<char>(random());
+        }
+        jobs[i].digest = (i % 7 == 6) ? "sha512" : "sha256";
+        jobs[i].iterations = iterations[(i / 2) % 3];
+    }
+    return jobs;
+}
+
+}
+
 TEST(pbsdf2, derive_key)
 {
     auto const key = aes256gcm::pbkdf2("secret", {1,2,3,4,5,6,7,8}, "sha256", 2048);
@@ -54,3 +90,120 @@ TEST(pbsdf2, generates_different_keys_for_different_digests)
     ASSERT_NE(key1, key2);
 }
 
+
+TEST(pbsdf2, caches_derived_keys)
+{
+    aes256gcm::pbkdf2_cache_clear();
+
+    auto const key1 = aes256gcm::pbkdf2("secret", {1,2,3,4,5,6,7,8}, "sha256", 4096);
+    auto const key2 = aes256gcm::pbkdf2("secret", {1,2,3,4,5,6,7,8}, "sha256", 4096);
+    auto const key3 = aes256gcm::pbkdf2("secret", {1,2,3,4,5,6,7,8}, "sha512", 4096);
+
+    ASSERT_EQ(key1, key2);
+    ASSERT_NE(key1, key3);
+
+    auto const stats = aes256gcm::pbkdf2_cache_statistics();
+    ASSERT_EQ(1, stats.hits);
+    ASSERT_EQ(2, stats.misses);
+}
+
+TEST(pbsdf2, batch_derives_same_keys_as_pbkdf2)
+{
+    for (size_t const count: {1, 2, 9, 17, 40})
+    {
+        auto jobs = make_jobs(count);
+        std::vector<std::string> expected;
+        aes256gcm::pbkdf2_cache_clear();
+        for (auto const & job: jobs)
+        {
+            expected.push_back(aes256gcm::pbkdf2(job.password, job.salt, job.digest, job.iterations));
+        }
+
+        aes256gcm::pbkdf2_cache_clear();
+        aes256gcm::pbkdf2_batch(jobs.data(), jobs.size(), 2);
+        for (size_t i = 0; i < count; i++)
+        {
+            ASSERT_EQ(expected[i], jobs[i].key) << "count " << count << ", job " << i;
+        }
+    }
+}
+
+TEST(pbsdf2, batch_uses_cache)
+{
+    aes256gcm::pbkdf2_cache_clear();
+    auto const key = aes256gcm::pbkdf2("secret", {1,2,3,4,5,6,7,8}, "sha256", 2048);
+
+    aes256gcm::pbkdf2_job job{"secret", {1,2,3,4,5,6,7,8}, "sha256", 2048, ""};
+    aes256gcm::pbkdf2_batch(&job, 1);
+    ASSERT_EQ(key, job.key);
+    ASSERT_EQ(1, aes256gcm::pbkdf2_cache_statistics().hits);
+}
+
+TEST(pbsdf2, batch_fails_with_invalid_digest)
+{
+    aes256gcm::pbkdf2_job job{"secret", {1,2,3,4,5,6,7,8}, "invalid-digest", 2048, ""};
+    ASSERT_ANY_THROW(aes256gcm::pbkdf2_batch(&job, 1));
+}
+
+TEST(pbsdf2, lockstep_kernels_match_pbkdf2)
+{
+    auto const & features = aes256gcm::detect_cpu_features();
+    auto jobs = make_jobs(aes256gcm::avx512_lanes);
+
+    std::vector<std::string> expected;
+    for (auto const & job: jobs)
+    {
+        expected.push_back(aes256gcm::pbkdf2(job.password, job.salt, "sha256", 100));
+    }
+
+    std::vector<aes256gcm::pbkdf2_lane> lanes(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        aes256gcm::pbkdf2_prepare(lanes[i], jobs[i].password, jobs[i].salt);
+    }
+
+    if (features.avx2)
+    {
+        auto avx2 = lanes;
+        aes256gcm::pbkdf2_iterate_avx2(avx2.data(), 100);
+        for (size_t i = 0; i < aes256gcm::avx2_lanes; i++)
+        {
+            ASSERT_EQ(expected[i], aes256gcm::pbkdf2_finish(avx2[i]));
+        }
+    }
+
+    if (features.avx512f)
+    {
+        auto avx512 = lanes;
+        aes256gcm::pbkdf2_iterate_avx512(avx512.data(), 100);
+        for (size_t i = 0; i < aes256gcm::avx512_lanes; i++)
+        {
+            ASSERT_EQ(expected[i], aes256gcm::pbkdf2_finish(avx512[i]));
+        }
+    }
+}
+
+TEST(key_cache, evicts_least_recently_used_key)
+{
+    aes256gcm::key_cache cache(2);
+    std::string const key_a(32, 'a');
+    std::string const key_b(32, 'b');
+    std::string const key_c(32, 'c');
+    std::string key;
+
+    cache.insert("a", "salt", "sha256", 1, key_a);
+    cache.insert("b", "salt", "sha256", 1, key_b);
+    ASSERT_TRUE(cache.find("a", "salt", "sha256", 1, key));
+    ASSERT_EQ(key_a, key);
+
+    cache.insert("c", "salt", "sha256", 1, key_c);
+    ASSERT_FALSE(cache.find("b", "salt", "sha256", 1, key));
+    ASSERT_TRUE(cache.find("c", "salt", "sha256", 1, key));
+    ASSERT_EQ(key_c, key);
+    ASSERT_TRUE(cache.find("a", "salt", "sha256", 1, key));
+    ASSERT_EQ(key_a, key);
+    ASSERT_FALSE(cache.find("a", "salt", "sha256", 2, key));
+
+    ASSERT_EQ(3, cache.hits());
+    ASSERT_EQ(2, cache.misses());
+}
@@ -0,0 +1,88 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::string> generate_records()
+{
+    std::vector<std::string> result;
+    for (size_t i = 0; i < 100; i++)
+    {
+        result.push_back(std::string(i * 41 % 4096, static_cast<char>(i)));
+    }
+    return result;
+}
+
+std::vector<aes256gcm::record> to_records(std::vector<std::string> const & data)
+{
+    std::vector<aes256gcm::record> result;
+    for (auto const & item: data)
+    {
+        result.push_back({item.data(), item.size()});
+    }
+    return result;
+}
+
+}
+
+TEST(records, encrypt_and_decrypt)
+{
+    std::string const key(32, 'k');
+    auto const data = generate_records();
+    auto const records = to_records(data);
+
+    aes256gcm::arena arena(4096);
+    auto const * sealed = aes256gcm::encrypt_records(key, records.data(), records.size(), arena, "aad");
+    auto const * opened = aes256gcm::decrypt_records(key, sealed, records.size(), arena, "aad");
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        ASSERT_EQ(data[i].size(), sealed[i].size);
+        ASSERT_EQ(data[i], std::string(opened[i].data, opened[i].size));
+
+        aes256gcm::decrypter dec(key, std::string(sealed[i].nonce, 12), std::string(sealed[i].tag, 16), "aad");
+        std::string decrypted(sealed[i].size, '\0');
+        dec.update(sealed[i].ciphertext, &decrypted[0], decrypted.size());
+        ASSERT_TRUE(dec.finalize());
+        ASSERT_EQ(data[i], decrypted);
+    }
+
+    ASSERT_NE(0, memcmp(sealed[0].nonce, sealed[1].nonce, 12));
+}
+
+TEST(records, decrypt_fails_on_tampered_record)
+{
+    std::string const key(32, 'k');
+    auto const data = generate_records();
+    auto const records = to_records(data);
+
+    aes256gcm::arena arena;
+    auto * sealed = aes256gcm::encrypt_records(key, records.data(), records.size(), arena);
+    const_cast<char*>(sealed[7].ciphertext)[0] ^= 1;
+
+    ASSERT_THROW({
+        aes256gcm::decrypt_records(key, sealed, records.size(), arena);
+    }, std::runtime_error);
+}
+
+TEST(records, reset_arena_reuses_memory)
+{
+    std::string const key(32, 'k');
+    auto const data = generate_records();
+    auto const records = to_records(data);
+
+    aes256gcm::arena arena;
+    aes256gcm::encrypt_records(key, records.data(), records.size(), arena);
+    auto const capacity = arena.capacity();
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        arena.reset();
+        aes256gcm::encrypt_records(key, records.data(), records.size(), arena);
+    }
+    ASSERT_EQ(capacity, arena.capacity());
+}
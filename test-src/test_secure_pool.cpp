@@ -0,0 +1,113 @@
+#include "aes256gcm/secure_pool.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+TEST(secure_pool, reuses_released_buffers)
+{
+    aes256gcm::secure_pool pool;
+    char * address = nullptr;
+    {
+        auto const buffer = pool.allocate(100 * 1024);
+        ASSERT_EQ(100u * 1024, buffer.size());
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(buffer.get()) % 4096);
+        address = buffer.get();
+    }
+    ASSERT_LT(0u, pool.cached_size());
+
+    // buffers of similar size share a size class
+    auto const buffer = pool.allocate(100 * 1024 - 1);
+    ASSERT_EQ(address, buffer.get());
+    ASSERT_EQ(0u, pool.cached_size());
+}
+
+TEST(secure_pool, wipes_released_buffers)
+{
+    aes256gcm::secure_pool pool;
+    {
+        auto const buffer = pool.allocate(5000);
+        std::memset(buffer.get(), 0x5a, buffer.size());
+    }
+
+    auto const buffer = pool.allocate(5000);
+    ASSERT_TRUE(std::all_of(buffer.get(), buffer.get() + buffer.size(), [](char c) { return c == 0; }));
+}
+
+TEST(secure_pool, moves_buffers)
+{
+    aes256gcm::secure_pool pool;
+    auto first = pool.allocate(10);
+    char * const address = first.get();
+
+    aes256gcm::secure_buffer second(std::move(first));
+    ASSERT_EQ(nullptr, first.get());
+    ASSERT_EQ(address, second.get());
+
+    aes256gcm::secure_buffer third;
+    third = std::move(second);
+    ASSERT_EQ(address, third.get());
+    ASSERT_EQ(10u, third.size());
+    ASSERT_EQ(0u, pool.cached_size());
+
+    third = aes256gcm::secure_buffer();
+    ASSERT_LT(0u, pool.cached_size());
+}
+
+TEST(secure_pool, limits_cached_memory)
+{
+    aes256gcm::secure_pool pool(64 * 1024);
+    {
+        auto const small = pool.allocate(4096);
+        auto const large = pool.allocate(1024 * 1024);
+    }
+    ASSERT_LE(pool.cached_size(), 64u * 1024);
+    ASSERT_LT(0u, pool.cached_size());
+
+    pool.trim();
+    ASSERT_EQ(0u, pool.cached_size());
+}
+
+TEST(secure_pool, reserves_locked_memory_for_keys)
+{
+    // room for two pages of I/O buffers besides the reserve for keys
+    aes256gcm::secure_pool pool(1024 * 1024, aes256gcm::secure_pool::key_reserve + 8192);
+    auto const large = pool.allocate(1024 * 1024);
+    ASSERT_FALSE(large.is_locked());
+
+    auto const small = pool.allocate(8192);
+    auto const other = pool.allocate(4096);
+    ASSERT_FALSE(other.is_locked());
+
+    // keys are locked even if I/O buffers used up their share; failing
+    // to lock them is reported
+    auto const key = pool.allocate_key(32);
+    ASSERT_EQ(key.is_locked(), pool.lock_failures() == 0);
+    ASSERT_EQ((small.is_locked() ? 8192u : 0u) + (key.is_locked() ? 4096u : 0u), pool.locked_size());
+}
+
+TEST(secure_pool, locks_reused_buffers_for_keys)
+{
+    aes256gcm::secure_pool pool(1024 * 1024, aes256gcm::secure_pool::key_reserve);
+    char * address = nullptr;
+    {
+        auto const buffer = pool.allocate(32);
+        ASSERT_FALSE(buffer.is_locked());
+        address = buffer.get();
+    }
+
+    auto const key = pool.allocate_key(32);
+    ASSERT_EQ(address, key.get());
+    ASSERT_EQ(key.is_locked(), pool.lock_failures() == 0);
+}
+
+TEST(scoped_cleanse, wipes_string)
+{
+    std::string key(32, 'k');
+    {
+        aes256gcm::scoped_cleanse const wipe(key);
+    }
+    ASSERT_EQ(std::string(32, '\0'), key);
+}
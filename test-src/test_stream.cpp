@@ -0,0 +1,112 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+
+using aes256gcm::test::generate_data;
+
+std::string encrypt(std::string const & plaintext, size_t frame_size)
+{
+    aes256gcm::proprietary::file_options options;
+    options.segment_size = frame_size;
+
+    std::istringstream in(plaintext);
+    std::ostringstream out;
+    aes256gcm::proprietary::encrypt_stream(in, out, "secret", "aad", options);
+    return out.str();
+}
+
+int decrypt(std::string const & encrypted, std::string & plaintext, std::string const & password = "secret")
+{
+    std::istringstream in(encrypted);
+    std::ostringstream out;
+    int const rc = aes256gcm::proprietary::decrypt_stream(in, out, password);
+    plaintext = out.str();
+    return rc;
+}
+
+}
+
+TEST(stream, encrypt_and_decrypt)
+{
+    for (size_t const size: {0, 1, 4095, 4096, 4097, 4096 * 3, 4096 * 37 + 5})
+    {
+        auto const plaintext = generate_data(size);
+        auto const encrypted = encrypt(plaintext, 4096);
+
+        std::string decrypted;
+        ASSERT_EQ(EXIT_SUCCESS, decrypt(encrypted, decrypted)) << "size: " << size;
+        ASSERT_EQ(plaintext, decrypted);
+    }
+}
+
+TEST(stream, decrypt_fails_on_wrong_password)
+{
+    auto const encrypted = encrypt(generate_data(10000), 4096);
+
+    std::string decrypted;
+    ASSERT_EQ(EXIT_FAILURE, decrypt(encrypted, decrypted, "wrong"));
+    ASSERT_TRUE(decrypted.empty());
+}
+
+TEST(stream, decrypt_fails_on_modified_frame)
+{
+    auto encrypted = encrypt(generate_data(10000), 4096);
+    encrypted[encrypted.size() - 100] ^= 0x01;
+
+    // frames authenticated before the modification are written
+    std::string decrypted;
+    ASSERT_EQ(EXIT_FAILURE, decrypt(encrypted, decrypted));
+    ASSERT_EQ(2 * 4096, decrypted.size());
+}
+
+TEST(stream, decrypt_fails_on_truncated_stream)
+{
+    size_t const stored_frame_size = 4 + 12 + 4096 + 16;
+    auto const encrypted = encrypt(generate_data(3 * 4096), 4096);
+
+    std::string decrypted;
+    // missing empty last frame
+    ASSERT_EQ(EXIT_FAILURE, decrypt(encrypted.substr(0, encrypted.size() - (4 + 12 + 16)), decrypted));
+    // missing full frame
+    ASSERT_EQ(EXIT_FAILURE, decrypt(encrypted.substr(0, encrypted.size() - (4 + 12 + 16) - stored_frame_size), decrypted));
+    // trailing data
+    ASSERT_EQ(EXIT_FAILURE, decrypt(encrypted + "x", decrypted));
+}
+
+TEST(stream, decrypt_fails_on_reordered_frames)
+{
+    size_t const stored_frame_size = 4 + 12 + 4096 + 16;
+    auto const encrypted = encrypt(generate_data(3 * 4096 + 10), 4096);
+    size_t const payload_pos = encrypted.size() - (4 + 12 + 10 + 16) - 3 * stored_frame_size;
+
+    auto reordered = encrypted;
+    reordered.replace(payload_pos, stored_frame_size, encrypted, payload_pos + stored_frame_size, stored_frame_size);
+    reordered.replace(payload_pos + stored_frame_size, stored_frame_size, encrypted, payload_pos, stored_frame_size);
+
+    std::string decrypted;
+    ASSERT_EQ(EXIT_FAILURE, decrypt(reordered, decrypted));
+}
+
+TEST(stream, decrypt_file_supports_streams)
+{
+    aes256gcm::test::temp_dir dir;
+    auto const plaintext = generate_data(5000);
+    aes256gcm::test::write_file(dir.file("enc"), encrypt(plaintext, 1024));
+
+    aes256gcm::proprietary::encryption_info info;
+    ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(dir.file("enc"), info));
+    ASSERT_TRUE(info.is_stream);
+    ASSERT_EQ(1024, info.segment_size);
+    ASSERT_EQ("aad", info.additional_data);
+
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(dir.file("enc"), dir.file("dec"), "secret"));
+    ASSERT_EQ(plaintext, aes256gcm::test::read_file(dir.file("dec")));
+
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::decrypt_file_inplace(dir.file("enc"), "secret"));
+}
@@ -0,0 +1,181 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "aes256gcm/proprietary/segment.hpp"
+#include "aes256gcm/proprietary/undo_journal.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+
+namespace
+{
+
+using aes256gcm::test::generate_data;
+
+constexpr size_t const segment_size = 4096;
+constexpr size_t const stored_size = segment_size + aes256gcm::proprietary::segment_overhead;
+
+class update_test: public aes256gcm::test::file_test
+{
+protected:
+    void encrypt(std::string const & plaintext, bool segment_digests)
+    {
+        write("plain", plaintext);
+        aes256gcm::proprietary::file_options options;
+        options.segment_size = segment_size;
+        options.segment_digests = segment_digests;
+        aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+    }
+
+    aes256gcm::proprietary::update_statistics update(std::string const & plaintext, unsigned int threads = 1)
+    {
+        write("plain", plaintext);
+        aes256gcm::proprietary::file_options options;
+        options.threads = threads;
+        aes256gcm::proprietary::update_statistics statistics = {};
+        EXPECT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::update_encrypted_file(path("plain"), path("enc"), "secret", options, &statistics));
+        return statistics;
+    }
+
+    std::string decrypt()
+    {
+        EXPECT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file(path("enc"), path("dec"), "secret"));
+        return read("dec");
+    }
+
+};
+
+}
+
+TEST_F(update_test, rewrites_changed_segments_only)
+{
+    for (bool const segment_digests: {true, false})
+    {
+        auto plaintext = generate_data(segment_size * 20 + 100);
+        encrypt(plaintext, segment_digests);
+        auto const before = read("enc");
+
+        plaintext[segment_size * 3 + 10] ^= 1;
+        plaintext[segment_size * 10] ^= 1;
+        plaintext[segment_size * 12 - 1] ^= 1;
+        auto const statistics = update(plaintext, 3);
+        ASSERT_EQ(21u, statistics.segments);
+        ASSERT_EQ(3u, statistics.rewritten_segments);
+
+        auto const after = read("enc");
+        for (size_t index = 0; index < 21; index++)
+        {
+            size_t const size = (index < 20) ? stored_size : (100 + aes256gcm::proprietary::segment_overhead);
+            bool const is_changed = (index == 3) || (index == 10) || (index == 11);
+            ASSERT_EQ(is_changed, before.compare(index * stored_size, size, after, index * stored_size, size) != 0) << index;
+            if (is_changed)
+            {
+                // a fresh nonce is used
+                ASSERT_NE(before.substr(index * stored_size, aes256gcm::nonce_size),
+                    after.substr(index * stored_size, aes256gcm::nonce_size));
+            }
+        }
+
+        ASSERT_EQ(plaintext, decrypt());
+
+        aes256gcm::proprietary::encryption_info info;
+        ASSERT_TRUE(aes256gcm::proprietary::get_encryption_info(path("enc"), info));
+        ASSERT_EQ(21 * aes256gcm::proprietary::segment_digest_size, info.segment_digests.size());
+
+        // an update without changes does not write any segment
+        ASSERT_EQ(0u, update(plaintext).rewritten_segments);
+        ASSERT_EQ(after, read("enc"));
+    }
+}
+
+TEST_F(update_test, grows_and_shrinks_file)
+{
+    auto plaintext = generate_data(segment_size * 5 + 7);
+    encrypt(plaintext, true);
+
+    // the former last segment and the new segments are written
+    plaintext += generate_data(segment_size * 2, 7);
+    ASSERT_EQ(3u, update(plaintext).rewritten_segments);
+    ASSERT_EQ(plaintext, decrypt());
+
+    // the new last segment is written to set its last flag
+    plaintext.resize(segment_size * 3);
+    ASSERT_EQ(1u, update(plaintext).rewritten_segments);
+    ASSERT_EQ(plaintext, decrypt());
+
+    plaintext.clear();
+    ASSERT_EQ(1u, update(plaintext).rewritten_segments);
+    ASSERT_EQ(plaintext, decrypt());
+
+    plaintext = generate_data(segment_size * 2 + 1, 9);
+    ASSERT_EQ(3u, update(plaintext).rewritten_segments);
+    ASSERT_EQ(plaintext, decrypt());
+}
+
+TEST_F(update_test, fails_on_wrong_password)
+{
+    auto const plaintext = generate_data(segment_size * 3);
+    encrypt(plaintext, true);
+    auto const before = read("enc");
+
+    write("plain", generate_data(segment_size * 3, 7));
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::update_encrypted_file(path("plain"), path("enc"), "wrong"));
+    ASSERT_EQ(before, read("enc"));
+}
+
+TEST_F(update_test, rejects_unsupported_files)
+{
+    write("plain", generate_data(1000));
+    aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret");
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::update_encrypted_file(path("plain"), path("enc"), "secret"));
+
+    aes256gcm::proprietary::file_options options;
+    options.segment_digests = true;
+    ASSERT_THROW(aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "", options), std::logic_error);
+}
+
+TEST_F(update_test, recovers_interrupted_update)
+{
+    auto const plaintext = generate_data(segment_size * 8 + 100);
+    encrypt(plaintext, true);
+    auto const before = read("enc");
+
+    // the child is killed after rewriting a segment and shrinking the file,
+    // leaving the journal behind
+    pid_t const pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0)
+    {
+        int const fd = open(path("enc").c_str(), O_RDWR);
+        auto * journal = new aes256gcm::proprietary::undo_journal(path("enc"), fd);
+        journal->save(2 * stored_size, stored_size);
+        journal->save(5 * stored_size, before.size() - 5 * stored_size);
+        journal->sync();
+        auto const garbage = generate_data(stored_size, 7);
+        aes256gcm::proprietary::write_at(fd, garbage.data(), garbage.size(), 2 * stored_size);
+        if (0 != ftruncate(fd, 5 * stored_size))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+
+    ASSERT_TRUE(aes256gcm::proprietary::recover_encrypted_file(path("enc")));
+    ASSERT_EQ(before, read("enc"));
+    ASSERT_EQ(plaintext, decrypt());
+
+    // the restored digests are valid, so a shorter plaintext is found to change the tail only
+    auto const shorter = plaintext.substr(0, segment_size * 3 + 7);
+    auto const statistics = update(shorter);
+    ASSERT_EQ(1u, statistics.rewritten_segments);
+    ASSERT_EQ(shorter, decrypt());
+    ASSERT_FALSE(std::filesystem::exists(path("enc") + aes256gcm::proprietary::undo_journal::journal_suffix));
+}
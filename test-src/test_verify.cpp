@@ -0,0 +1,121 @@
+#include "aes256gcm/aes256gcm.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+using aes256gcm::test::generate_data;
+
+class verify_test: public aes256gcm::test::file_test
+{
+protected:
+    void flip_bit(std::string const & name, size_t offset) const
+    {
+        auto data = read(name);
+        data[offset] ^= 1;
+        write(name, data);
+    }
+
+};
+
+}
+
+TEST_F(verify_test, verifies_files)
+{
+    struct variant
+    {
+        std::string algorithm;
+        size_t segment_size;
+        std::string compression;
+    };
+
+    std::vector<variant> variants = {
+        {aes256gcm::algorithm_aes256_gcm, 0, ""},
+        {aes256gcm::algorithm_aes256_gcm, 64 * 1024, ""},
+        {aes256gcm::algorithm_chacha20_poly1305, 0, ""},
+    };
+    if (aes256gcm::is_compression_available(aes256gcm::compression_zlib))
+    {
+        variants.push_back({aes256gcm::algorithm_aes256_gcm, 0, aes256gcm::compression_zlib});
+    }
+
+    for (size_t const size: {0, 1, 5 * 1024 * 1024 + 3})
+    {
+        write("plain", generate_data(size));
+        for (auto const & v: variants)
+        {
+            for (unsigned int const threads: {1, 4})
+            {
+                aes256gcm::proprietary::file_options options;
+                options.algorithm = v.algorithm;
+                options.segment_size = v.segment_size;
+                options.compression = v.compression;
+                options.threads = threads;
+                aes256gcm::proprietary::encrypt_file(path("plain"), path("enc"), "secret", "aad", options);
+                auto const encrypted = read("enc");
+
+                ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::verify_file(path("enc"), "secret", options))
+                    << v.algorithm << ", size: " << size << ", segment size: " << v.segment_size;
+                ASSERT_EQ(encrypted, read("enc"));
+                ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::verify_file(path("enc"), "wrong", options));
+
+                if (size > 0)
+                {
+                    flip_bit("enc", size / 2);
+                    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::verify_file(path("enc"), "secret", options));
+                }
+            }
+        }
+    }
+}
+
+TEST_F(verify_test, verifies_streams)
+{
+    auto const plaintext = generate_data(100000);
+    {
+        std::istringstream in(plaintext);
+        std::ofstream out(path("enc"), std::ios_base::binary);
+        aes256gcm::proprietary::encrypt_stream(in, out, "secret");
+    }
+
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::verify_file(path("enc"), "secret"));
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::verify_file(path("enc"), "wrong"));
+}
+
+TEST_F(verify_test, keeps_file_on_failed_inplace_decryption)
+{
+    auto const plaintext = generate_data(1024 * 1024 + 5);
+    write("file", plaintext);
+    aes256gcm::proprietary::encrypt_file_inplace(path("file"), "secret");
+    auto const encrypted = read("file");
+
+    aes256gcm::proprietary::file_options options;
+    options.verify_inplace = true;
+    ASSERT_EQ(EXIT_FAILURE, aes256gcm::proprietary::decrypt_file_inplace(path("file"), "wrong", options));
+    ASSERT_EQ(encrypted, read("file"));
+
+    ASSERT_EQ(EXIT_SUCCESS, aes256gcm::proprietary::decrypt_file_inplace(path("file"), "secret", options));
+    ASSERT_EQ(plaintext, read("file"));
+}
+
+TEST_F(verify_test, verifies_batch)
+{
+    std::vector<aes256gcm::proprietary::batch_job> jobs;
+    for (size_t i = 0; i < 5; i++)
+    {
+        auto const name = "file" + std::to_string(i);
+        write(name, generate_data(1000 * i));
+        aes256gcm::proprietary::encrypt_file_inplace(path(name), "secret");
+        jobs.push_back({path(name), ""});
+    }
+    flip_bit("file3", 10);
+
+    auto const failures = aes256gcm::proprietary::run_batch(aes256gcm::proprietary::batch_operation::verify, jobs, "secret", 2);
+    ASSERT_EQ(1u, failures.size());
+    ASSERT_EQ(path("file3"), failures[0].filename);
+}
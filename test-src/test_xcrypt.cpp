@@ -155,3 +155,147 @@ TEST(aes256gcm, decrypt_fails_with_invalid_nonce)
     
     ASSERT_FALSE(is_okay);
 }
+
+TEST(aes256gcm, reset_matches_fresh_context)
+{
+    std::string salt;
+    auto const key = generate_key("secret", salt);
+    std::string const nonce1(12, '\x01');
+    std::string const nonce2(12, '\x02');
+    std::string const plaintext = "some plain text";
+
+    aes256gcm::encrypter encrypter(key, nonce1, "aad");
+    std::string encrypted1(plaintext.size(), '\0');
+    encrypter.update(plaintext.data(), &encrypted1[0], plaintext.size());
+    auto const tag1 = encrypter.finalize();
+
+    encrypter.reset(nonce2, "other aad");
+    std::string encrypted2(plaintext.size(), '\0');
+    encrypter.update(plaintext.data(), &encrypted2[0], plaintext.size());
+    auto const tag2 = encrypter.finalize();
+    ASSERT_EQ(nonce2, encrypter.nonce());
+
+    aes256gcm::encrypter fresh(key, nonce2, "other aad");
+    std::string expected(plaintext.size(), '\0');
+    fresh.update(plaintext.data(), &expected[0], plaintext.size());
+    ASSERT_EQ(expected, encrypted2);
+    ASSERT_EQ(fresh.finalize(), tag2);
+
+    aes256gcm::decrypter decrypter(key, nonce2, tag2, "other aad");
+    std::string decrypted(plaintext.size(), '\0');
+    decrypter.update(encrypted2.data(), &decrypted[0], decrypted.size());
+    ASSERT_TRUE(decrypter.finalize());
+    ASSERT_EQ(plaintext, decrypted);
+
+    decrypter.reset(nonce1, tag1, "aad");
+    decrypter.update(encrypted1.data(), &decrypted[0], decrypted.size());
+    ASSERT_TRUE(decrypter.finalize());
+    ASSERT_EQ(plaintext, decrypted);
+
+    decrypter.reset(nonce1, tag2, "aad");
+    decrypter.update(encrypted1.data(), &decrypted[0], decrypted.size());
+    ASSERT_FALSE(decrypter.finalize());
+}
+
+TEST(aes256gcm, context_key_id_identifies_keys)
+{
+    std::string const key1(32, 'a');
+    std::string const key2(32, 'b');
+
+    auto const id1 = aes256gcm::context_key_id(key1);
+    ASSERT_EQ(id1, aes256gcm::context_key_id(key1));
+    ASSERT_NE(id1, aes256gcm::context_key_id(key2));
+    ASSERT_NE(key1, id1);
+}
+
+TEST(aes256gcm, pooled_contexts_are_reused_per_key)
+{
+    std::string const key1(32, 'a');
+    std::string const key2(32, 'b');
+    std::string const nonce(12, '\x01');
+
+    auto & enc1 = aes256gcm::pooled_encrypter("key1", key1, nonce);
+    auto & enc2 = aes256gcm::pooled_encrypter("key2", key2, nonce);
+    auto & enc3 = aes256gcm::pooled_encrypter("key1", key1, nonce);
+    ASSERT_EQ(&enc1, &enc3);
+    ASSERT_NE(&enc1, &enc2);
+
+    std::string const plaintext = "pooled";
+    std::string encrypted(plaintext.size(), '\0');
+    enc3.update(plaintext.data(), &encrypted[0], plaintext.size());
+    auto const tag = enc3.finalize();
+
+    auto & dec = aes256gcm::pooled_decrypter("key1", key1, nonce, tag);
+    std::string decrypted(plaintext.size(), '\0');
+    dec.update(encrypted.data(), &decrypted[0], decrypted.size());
+    ASSERT_TRUE(dec.finalize());
+    ASSERT_EQ(plaintext, decrypted);
+
+    aes256gcm::context_pool_clear();
+}
+
+TEST(aes256gcm, encrypt_and_decrypt_using_other_algorithms)
+{
+    std::string const key(32, 'k');
+    std::string const nonce(12, 'n');
+    std::string const plaintext(1000, 'p');
+
+    for (auto const & algorithm: {aes256gcm::algorithm_chacha20_poly1305, aes256gcm::algorithm_aes256_ocb})
+    {
+        // partial blocks are only allowed at the end
+        aes256gcm::encrypter enc(key, nonce, "aad", algorithm);
+        std::string encrypted(plaintext.size(), '\0');
+        enc.update(plaintext.data(), &encrypted[0], 512);
+        enc.update(&plaintext[512], &encrypted[512], 488);
+        auto const tag = enc.finalize();
+        ASSERT_NE(plaintext, encrypted);
+
+        aes256gcm::encrypter gcm(key, nonce, "aad");
+        std::string gcm_encrypted(plaintext.size(), '\0');
+        gcm.update(plaintext.data(), &gcm_encrypted[0], plaintext.size());
+        ASSERT_NE(gcm_encrypted, encrypted);
+
+        aes256gcm::decrypter dec(key, nonce, tag, "aad", algorithm);
+        std::string decrypted(plaintext.size(), '\0');
+        dec.update(encrypted.data(), &decrypted[0], decrypted.size());
+        ASSERT_TRUE(dec.finalize());
+        ASSERT_EQ(plaintext, decrypted);
+
+        aes256gcm::decrypter wrong(key, nonce, tag, "aad");
+        wrong.update(encrypted.data(), &decrypted[0], decrypted.size());
+        ASSERT_FALSE(wrong.finalize());
+    }
+}
+
+TEST(aes256gcm, update_after_partial_block_fails)
+{
+    std::string const key(32, 'k');
+    std::string const nonce(12, 'n');
+    char buffer[32] = {0};
+
+    aes256gcm::encrypter enc(key, nonce, "", aes256gcm::algorithm_aes256_ocb);
+    enc.update_inplace(buffer, 7);
+    enc.update_inplace(buffer, 0);
+    ASSERT_THROW(enc.update_inplace(buffer, 16), std::logic_error);
+}
+
+TEST(aes256gcm, select_algorithm)
+{
+    ASSERT_EQ(aes256gcm::algorithm_chacha20_poly1305, aes256gcm::select_aead("chacha20-poly1305"));
+    ASSERT_THROW(aes256gcm::select_aead("rot13"), std::invalid_argument);
+
+    auto const selected = aes256gcm::select_aead("auto");
+    ASSERT_TRUE((selected == aes256gcm::algorithm_aes256_gcm) || (selected == aes256gcm::algorithm_chacha20_poly1305));
+
+    ASSERT_TRUE(aes256gcm::is_single_update_aead(aes256gcm::algorithm_aes256_gcm_siv));
+    ASSERT_FALSE(aes256gcm::is_single_update_aead(aes256gcm::algorithm_aes256_gcm));
+    ASSERT_FALSE(aes256gcm::is_single_update_aead(aes256gcm::algorithm_chacha20_poly1305));
+    ASSERT_FALSE(aes256gcm::is_single_update_aead(aes256gcm::algorithm_aes256_ocb));
+
+    if (!aes256gcm::is_aead_available(aes256gcm::algorithm_aes256_gcm_siv))
+    {
+        ASSERT_THROW(aes256gcm::select_aead("aes256-gcm-siv"), std::runtime_error);
+        ASSERT_THROW(aes256gcm::encrypter(std::string(32, 'k'), std::string(12, 'n'), "",
+            aes256gcm::algorithm_aes256_gcm_siv), std::runtime_error);
+    }
+}